@@ -751,7 +751,8 @@ struct peer_conn
 		"    -p <dst-port>      the port the target listens on\n"
 		"    -t <torrent-file>  the torrent file previously generated by gen-torrent\n"
 		"    -C                 send corrupt pieces sometimes (applies to upload and dual)\n"
-		"    -r <reconnects>    churn - number of reconnects per second\n\n"
+		"    -r <reconnects>    churn - number of reconnects per second\n"
+		"    -j <num-threads>   number of I/O threads to spread connections over (default 2)\n\n"
 		"examples:\n\n"
 		"connection_tester gen-torrent -s 1024 -n 4 -t test.torrent\n"
 		"connection_tester upload -c 200 -d 127.0.0.1 -p 6881 -t test.torrent\n"
@@ -986,6 +987,7 @@ int main(int argc, char* argv[])
 	char const* destination_ip = "127.0.0.1";
 	int destination_port = 6881;
 	int churn = 0;
+	int num_threads = 2;
 	std::vector<std::string> trackers;
 
 	argv += 2;
@@ -1031,6 +1033,7 @@ int main(int argc, char* argv[])
 			case 'p': destination_port = atoi(opt); break;
 			case 'd': destination_ip = opt; break;
 			case 'r': churn = atoi(opt); break;
+			case 'j': num_threads = atoi(opt); break;
 			default: std::fprintf(stderr, "unknown option: %s\n", optname);
 		}
 	}
@@ -1167,25 +1170,36 @@ int main(int argc, char* argv[])
 
 	std::vector<peer_conn*> conns;
 	conns.reserve(std::size_t(num_connections));
-	int const num_threads = 2;
-	io_context ios[num_threads];
+
+	// the connections only speak TCP. A uTP mode has been considered, but
+	// the uTP implementation (aux::utp_socket_manager) is internal to the
+	// library and tied to the session object, it cannot be driven from a
+	// stand-alone load generator without exporting a lot of internals
+	if (num_threads < 1) num_threads = 1;
+	std::vector<std::unique_ptr<io_context>> ios;
+	ios.reserve(std::size_t(num_threads));
+	for (int i = 0; i < num_threads; ++i)
+		ios.emplace_back(new io_context);
+
 	for (int i = 0; i < num_connections; ++i)
 	{
 		bool corrupt = test_corruption && (i & 1) == 0;
 		bool seed = false;
 		if (test_mode == upload_test) seed = true;
 		else if (test_mode == dual_test) seed = (i & 1);
-		conns.push_back(new peer_conn(ios[i % num_threads], ti.num_pieces(), ti.piece_length() / 16 / 1024
+		conns.push_back(new peer_conn(*ios[i % num_threads], ti.num_pieces(), ti.piece_length() / 16 / 1024
 			, ep, ti.info_hash().data(), seed, churn, corrupt));
 		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		ios[i % num_threads].poll_one();
+		ios[i % num_threads]->poll_one();
 	}
 
-	std::thread t1(&io_thread, &ios[0]);
-	std::thread t2(&io_thread, &ios[1]);
+	std::vector<std::thread> threads;
+	threads.reserve(std::size_t(num_threads));
+	for (int i = 0; i < num_threads; ++i)
+		threads.emplace_back(&io_thread, ios[i].get());
 
-	t1.join();
-	t2.join();
+	for (auto& t : threads)
+		t.join();
 
 	double up = 0.0;
 	double down = 0.0;
@@ -41,6 +41,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <map>
 #include <functional>
 #include <ctime>
+#include <utility>
 
 #include "libtorrent/storage_defs.hpp"
 #include "libtorrent/sha1_hash.hpp"
@@ -317,6 +318,17 @@ TORRENT_VERSION_NAMESPACE_3
 		// peer requests it.
 		typed_bitfield<piece_index_t> verified_pieces;
 
+		// per-file fingerprints, i.e. pairs of (file size, posix modification
+		// time), in the same order as the files in the torrent. They are
+		// recorded when the resume data is written. When resume data is
+		// loaded in a state that would otherwise require a full recheck,
+		// pieces contained in files whose size and modification time still
+		// match their fingerprint are trusted without re-hashing them. This
+		// list may be shorter than the number of files in the torrent, or
+		// empty, in which case the files without fingerprints are not
+		// trusted.
+		aux::noexcept_movable<std::vector<std::pair<std::int64_t, std::int64_t>>> file_sizes;
+
 		// this sets the priorities for each individual piece in the torrent. Each
 		// element in the vector represent the piece with the same index. If you
 		// set both file- and piece priorities, file priorities will take
@@ -67,6 +67,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/tracker_manager.hpp" // for event_t
 #include "libtorrent/socket_type.hpp"
 #include "libtorrent/client_data.hpp"
+#include "libtorrent/disk_buffer_holder.hpp"
 #include "libtorrent/aux_/deprecated.hpp"
 
 #include "libtorrent/aux_/disable_warnings_push.hpp"
@@ -96,7 +97,7 @@ namespace libtorrent {
 	constexpr int user_alert_id = 10000;
 
 	// this constant represents "max_alert_index" + 1
-	constexpr int num_alert_types = 97;
+	constexpr int num_alert_types = 99;
 
 	// internal
 	constexpr int abi_alert_count = 128;
@@ -493,6 +494,16 @@ TORRENT_VERSION_NAMESPACE_3
 
 			too_few_file_descriptors,
 
+			// This is posted when the network thread's tick timer fired
+			// later than ``settings_pack::tick_lag_warning_threshold``
+			// milliseconds past its deadline. It means some event handler
+			// stalled the event loop for that long, degrading everything the
+			// session does. The ``ses.tick_lag_*`` counters in the session
+			// stats histogram how late ticks run over time; to attribute the
+			// stall to a specific handler, attach a profiler or use the
+			// tracing instrumentation
+			network_thread_stalled,
+
 			num_warnings
 		};
 
@@ -2938,6 +2949,69 @@ TORRENT_VERSION_NAMESPACE_3
 		aux::noexcept_movable<tcp::endpoint> ip;
 	};
 
+	// This alert is posted in response to a torrent_handle::read_piece_blocks()
+	// call. It is the zero-copy counterpart of read_piece_alert. Instead of
+	// assembling the piece into one freshly allocated contiguous buffer, the
+	// alert hands over the disk buffers the piece was read into, one per
+	// block, in piece order. This saves one copy of every byte of the piece,
+	// at the cost of holding on to the disk buffers until the alert is
+	// destructed.
+	//
+	// If the operation fails, ``error`` will indicate what went wrong and
+	// ``buffers`` will be empty.
+	struct TORRENT_EXPORT read_piece_blocks_alert final : torrent_alert
+	{
+		// internal
+		TORRENT_UNEXPORT read_piece_blocks_alert(aux::stack_allocator& alloc
+			, torrent_handle const& h, piece_index_t p
+			, std::vector<disk_buffer_holder> bufs, int s);
+		TORRENT_UNEXPORT read_piece_blocks_alert(aux::stack_allocator& alloc
+			, torrent_handle h, piece_index_t p, error_code e);
+
+		TORRENT_DEFINE_ALERT_PRIO(read_piece_blocks_alert, 97, alert_priority::critical)
+
+		static constexpr alert_category_t static_category = alert_category::storage;
+		std::string message() const override;
+
+		error_code const error;
+
+		// the disk buffers holding the piece data, in piece order. Each
+		// buffer holds one block (16 kiB except possibly the last one). The
+		// buffers are returned to the disk subsystem when the alert is
+		// destructed
+		std::vector<disk_buffer_holder> buffers;
+
+		// the piece that was read
+		piece_index_t const piece;
+
+		// the total number of bytes across all buffers
+		int const size;
+	};
+
+	// posted every time the performance autotuner (see
+	// settings_pack::enable_autotune) adjusts a setting, so operators can
+	// audit what the controller is doing and why a setting no longer holds
+	// the value they configured
+	struct TORRENT_EXPORT autotune_alert final : alert
+	{
+		// internal
+		TORRENT_UNEXPORT autotune_alert(aux::stack_allocator& alloc
+			, int s, int prev, int val);
+
+		TORRENT_DEFINE_ALERT(autotune_alert, 98)
+
+		static constexpr alert_category_t static_category = alert_category::performance_warning;
+		std::string message() const override;
+
+		// the setting that was adjusted, one of the settings_pack::int_types
+		// values. Its name can be looked up with name_for_setting()
+		int const tuned_setting;
+
+		// the value the setting had before and after the adjustment
+		int const prev_value;
+		int const new_value;
+	};
+
 TORRENT_VERSION_NAMESPACE_3_END
 
 	// internal
@@ -41,7 +41,9 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/stack_allocator.hpp"
 #include "libtorrent/alert_types.hpp" // for abi_alert_count
 #include "libtorrent/aux_/array.hpp"
+#include "libtorrent/time.hpp"
 
+#include <cstdint>
 #include <functional>
 #include <utility> // for std::forward
 #include <mutex>
@@ -60,6 +62,26 @@ namespace aux {
 
 	struct TORRENT_EXTRA_EXPORT alert_manager
 	{
+		// per-alert-type accounting, to attribute queue and allocation
+		// pressure to the alert type causing it
+		struct alert_type_stats_t
+		{
+			// the number of alerts of this type posted and dropped,
+			// respectively, over the lifetime of the alert manager
+			std::int64_t posted = 0;
+			std::int64_t dropped = 0;
+
+			// the cumulative number of bytes of variable length content
+			// (strings, buffers) alerts of this type have allocated from the
+			// stack allocator
+			std::int64_t bytes = 0;
+
+			// the number of alerts of this type currently in the post queue,
+			// and the all-time high-water mark of that number
+			int queued = 0;
+			int peak_queued = 0;
+		};
+
 		explicit alert_manager(int queue_limit
 			, alert_category_t alert_mask = alert_category::error);
 
@@ -68,6 +90,19 @@ namespace aux {
 
 		~alert_manager();
 
+		// filtering of masked categories is meant to happen *before* calling
+		// this, via should_post<T>(), which is just a relaxed atomic load
+		// and keeps masked-out chatty alerts entirely off the network
+		// thread's critical path. Call sites that post without checking do
+		// so deliberately: those alerts (resume data, errors and other
+		// responses to explicit API calls) must be delivered regardless of
+		// the mask, so the check can't be folded in here. The mutex below
+		// is less contended than it looks, too. get_all() swaps the two
+		// generations of the queue under the lock but the client processes
+		// the alerts outside of it, so the network thread is only ever
+		// blocked for the buffer handoff. A lock-free ring
+		// would also be at odds with constructing variable-size alerts in
+		// place and handing out stable pointers from get_all()
 		template <class T, typename... Args>
 		void emplace_alert(Args&&... args) try
 		{
@@ -75,19 +110,31 @@ namespace aux {
 
 			heterogeneous_queue<alert>& queue = m_alerts[m_generation];
 
+			alert_type_stats_t& stats = m_alert_type_stats[T::alert_type];
+			int const type_limit = m_type_queue_limit[T::alert_type];
+
 			// don't add more than this number of alerts, unless it's a
 			// high priority alert, in which case we try harder to deliver it
 			// for high priority alerts, double the upper limit
-			if (queue.size() / (1 + static_cast<int>(T::priority)) >= m_queue_size_limit)
+			if (queue.size() / (1 + static_cast<int>(T::priority)) >= m_queue_size_limit
+				|| (type_limit > 0 && stats.queued >= type_limit))
 			{
 				// record that we dropped an alert of this type
 				m_dropped.set(T::alert_type);
+				++stats.dropped;
 				return;
 			}
 
+			int const size_before = m_allocations[m_generation].size();
+
 			T& alert = queue.emplace_back<T>(
 				m_allocations[m_generation], std::forward<Args>(args)...);
 
+			++stats.posted;
+			stats.bytes += m_allocations[m_generation].size() - size_before;
+			++stats.queued;
+			if (stats.queued > stats.peak_queued) stats.peak_queued = stats.queued;
+
 			maybe_notify(&alert);
 		}
 		catch (std::bad_alloc const&)
@@ -95,6 +142,7 @@ namespace aux {
 			// record that we dropped an alert of this type
 			std::unique_lock<std::recursive_mutex> lock(m_mutex);
 			m_dropped.set(T::alert_type);
+			++m_alert_type_stats[T::alert_type].dropped;
 		}
 
 		bool pending() const;
@@ -121,8 +169,35 @@ namespace aux {
 		int alert_queue_size_limit() const noexcept { return m_queue_size_limit; }
 		int set_alert_queue_size_limit(int queue_size_limit_);
 
+		// returns a snapshot of the accounting for the given alert type (one
+		// of the static alert_type members of the alert classes)
+		alert_type_stats_t alert_type_stats(int type) const;
+
+		// caps the number of alerts of the given type allowed in the post
+		// queue at once. Additional ones are dropped (and reported via
+		// alerts_dropped_alert), just like when the whole queue fills up.
+		// 0 means no per-type limit. This is meant for chatty,
+		// individually-expendable alert types, like progress updates
+		void set_alert_type_queue_limit(int type, int limit);
+
 		void set_notify_function(std::function<void()> const& fun);
 
+		// configure coalescing of the user notify callback. With a
+		// ``batch_size`` greater than 1, posting an alert to an empty queue
+		// no longer calls the notify function right away; it's deferred
+		// until that many alerts are queued, a ``max_delay`` has passed
+		// since the first one, or an alert in one of the ``bypass``
+		// categories is posted. Waiters in wait_for_alert() are always
+		// woken immediately; only the notify callback is coalesced
+		void set_notify_coalescing(int batch_size, time_duration max_delay
+			, alert_category_t bypass);
+
+		// deliver a deferred notification whose max-delay deadline has
+		// passed. Called periodically (from the session tick), which is
+		// what bounds the added latency when the alert stream pauses
+		// mid-batch
+		void flush_pending_notify();
+
 #ifndef TORRENT_DISABLE_EXTENSIONS
 		void add_extension(std::shared_ptr<plugin> ext);
 #endif
@@ -153,6 +228,19 @@ namespace aux {
 		// posted to the queue
 		std::function<void()> m_notify;
 
+		// notify coalescing configuration (see set_notify_coalescing()).
+		// With the default batch size of 1 every 0 -> 1 queue transition
+		// notifies immediately, matching the historical behavior
+		int m_notify_batch_size = 1;
+		time_duration m_notify_max_delay = milliseconds(500);
+		alert_category_t m_notify_bypass = alert_category::error;
+
+		// whether an undelivered notification is owed to the client, and
+		// when the first alert it covers was posted (for the max-delay
+		// deadline)
+		bool m_notify_pending = false;
+		time_point m_notify_first_pending = min_time();
+
 		// this is either 0 or 1, it indicates which m_alerts and m_allocations
 		// the alert_manager is allowed to use right now. This is swapped when
 		// the client calls get_all(), at which point all of the alert objects
@@ -170,6 +258,15 @@ namespace aux {
 		// such as strings, to go with the alerts.
 		aux::array<stack_allocator, 2> m_allocations;
 
+		// accounting per alert type, indexed by the alert's type ID. The
+		// queued counts refer to m_alerts[m_generation]; they are reset when
+		// the generations are swapped in get_all()
+		aux::array<alert_type_stats_t, abi_alert_count> m_alert_type_stats;
+
+		// per-type caps on the number of queued alerts. 0 means no limit.
+		// zeroed in the constructor
+		aux::array<int, abi_alert_count> m_type_queue_limit;
+
 #ifndef TORRENT_DISABLE_EXTENSIONS
 		std::list<std::shared_ptr<plugin>> m_ses_extensions;
 #endif
@@ -43,6 +43,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/socket.hpp"
 #include "libtorrent/aux_/listen_socket_handle.hpp"
 #include "libtorrent/aux_/array.hpp"
+#include "libtorrent/aux_/small_vector.hpp"
 #include "libtorrent/info_hash.hpp"
 
 #include <string>
@@ -175,6 +176,13 @@ namespace aux {
 		announce_entry& operator=(announce_entry const&) &;
 
 		// tracker URL as it appeared in the torrent file
+		// this string is deliberately owned rather than interned in a
+		// session-level pool. Most of the footprint of an announce_entry is
+		// the per-listen-socket, per-protocol announce state in "endpoints",
+		// which is inherently per-torrent and cannot be shared. Deduplicating
+		// just the URL bytes would save little, while threading refcounted
+		// handles through tracker_manager, the alert types and the public
+		// announce_entry conversion would complicate all of them
 		std::string url;
 
 		// the current ``&trackerid=`` argument passed to the tracker.
@@ -183,8 +191,9 @@ namespace aux {
 		std::string trackerid;
 
 		// each local listen socket (endpoint) will announce to the tracker. This
-		// list contains state per endpoint.
-		std::vector<announce_endpoint> endpoints;
+		// list contains state per endpoint. The common case is a single listen
+		// socket, so one entry is stored inline
+		aux::small_vector<announce_endpoint, 1> endpoints;
 
 		// the tier this tracker belongs to
 		std::uint8_t tier = 0;
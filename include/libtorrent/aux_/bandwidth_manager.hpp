@@ -78,6 +78,11 @@ private:
 
 	// these are the consumers that want bandwidth
 	std::vector<bw_request> m_queue;
+
+	// scratch space for update_quotas(). Kept as members so their capacity
+	// is retained across ticks, instead of reallocating every time
+	std::vector<bandwidth_channel*> m_scratch_channels;
+	std::vector<bw_request> m_scratch_completed;
 	// the number of bytes all the requests in queue are for
 	std::int64_t m_queued_bytes;
 
@@ -73,8 +73,15 @@ namespace aux {
 		// set the maximum number of I/O threads which may be running
 		// the actual number of threads will be <= this number
 		void set_max_threads(int i);
+
+		// set the minimum number of I/O threads to keep running. The reaper
+		// never shrinks the pool below this number, so a pool that's kept
+		// warm doesn't pay the thread start-up cost when load returns.
+		// Threads are still only started on demand
+		void set_min_threads(int i);
 		void abort(bool wait);
 		int max_threads() const { return m_max_threads; }
+		int min_threads() const { return m_min_threads; }
 
 		// thread_idle, thread_active, and job_queued are NOT thread safe
 		// all calls to them must be serialized
@@ -123,6 +130,7 @@ namespace aux {
 		pool_thread_interface& m_thread_iface;
 
 		std::atomic<int> m_max_threads;
+		std::atomic<int> m_min_threads;
 		// the number of threads the reaper decided should exit
 		std::atomic<int> m_threads_to_exit;
 
@@ -0,0 +1,91 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TORRENT_EVENT_TRACE_HPP_INCLUDED
+#define TORRENT_EVENT_TRACE_HPP_INCLUDED
+
+#include "libtorrent/config.hpp"
+
+#include <cstdint>
+#include <string>
+
+// an opt-in, in-process lifecycle tracer. Unlike the USDT probes in
+// tracepoint.hpp (which need an external tracer attached), this records
+// timestamped events into a fixed-size ring buffer that can be dumped as
+// chrome://tracing JSON at any point, to see where a stalled piece or
+// disk job spent its time. It's a diagnostic for developers, enabled at
+// build time with TORRENT_USE_EVENT_TRACE=1. When disabled (the default)
+// the macros expand to nothing and no buffer is allocated
+
+#ifndef TORRENT_USE_EVENT_TRACE
+#define TORRENT_USE_EVENT_TRACE 0
+#endif
+
+namespace libtorrent {
+namespace aux {
+
+	// records one event. ``name`` must be a string literal (it is stored by
+	// pointer). ``phase`` follows the chrome trace event format: 'B'/'E'
+	// open and close a synchronous span on the calling thread, 'b'/'e' open
+	// and close an asynchronous span correlated by ``id`` (which may cross
+	// threads) and 'i' is an instant event. Safe to call from any thread
+	TORRENT_EXTRA_EXPORT void trace_event(char phase, char const* name
+		, std::int64_t id);
+
+	// renders the current contents of the trace ring buffer as a JSON
+	// document in the chrome trace event format, loadable in
+	// chrome://tracing or https://ui.perfetto.dev. Events that have been
+	// overwritten by newer ones are gone; a span whose begin event was
+	// overwritten shows up as unmatched and is clipped by the viewer
+	TORRENT_EXPORT std::string render_chrome_trace();
+}
+}
+
+#if TORRENT_USE_EVENT_TRACE
+
+#define TORRENT_TRACE_BEGIN(name, id) libtorrent::aux::trace_event('B', name, id)
+#define TORRENT_TRACE_END(name, id) libtorrent::aux::trace_event('E', name, id)
+#define TORRENT_TRACE_ASYNC_BEGIN(name, id) libtorrent::aux::trace_event('b', name, id)
+#define TORRENT_TRACE_ASYNC_END(name, id) libtorrent::aux::trace_event('e', name, id)
+#define TORRENT_TRACE_INSTANT(name, id) libtorrent::aux::trace_event('i', name, id)
+
+#else
+
+#define TORRENT_TRACE_BEGIN(name, id) do {} while (false)
+#define TORRENT_TRACE_END(name, id) do {} while (false)
+#define TORRENT_TRACE_ASYNC_BEGIN(name, id) do {} while (false)
+#define TORRENT_TRACE_ASYNC_END(name, id) do {} while (false)
+#define TORRENT_TRACE_INSTANT(name, id) do {} while (false)
+
+#endif // TORRENT_USE_EVENT_TRACE
+
+#endif // TORRENT_EVENT_TRACE_HPP_INCLUDED
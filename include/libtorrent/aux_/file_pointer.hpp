@@ -34,6 +34,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #define TORRENT_FILE_POINTER_HPP
 
 #include <cstdio>
+#include <utility> // for swap
 
 namespace libtorrent {
 namespace aux {
@@ -45,7 +46,11 @@ struct file_pointer
 	file_pointer(file_pointer const&) = delete;
 	file_pointer(file_pointer&& f) : ptr(f.ptr) { f.ptr = nullptr; }
 	file_pointer& operator=(file_pointer const&) = delete;
-	file_pointer& operator=(file_pointer&&) = delete;
+	file_pointer& operator=(file_pointer&& f)
+	{
+		std::swap(ptr, f.ptr);
+		return *this;
+	}
 	FILE* file() const { return ptr; }
 private:
 	FILE* ptr;
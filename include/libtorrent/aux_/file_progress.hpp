@@ -80,7 +80,16 @@ namespace aux {
 		// downloaded (as in passed-hash-check) in each file.
 		// this lets us trigger on individual files completing
 		// the vector is allocated lazily, when file progress
-		// is first queried by the client
+		// is first queried by the client.
+		// a flat vector (rather than, say, a fenwick tree over file
+		// boundaries) is the right structure for this access pattern:
+		// updates are point-increments of the few files a verified piece
+		// spans, and queries read per-file totals directly or copy the
+		// whole vector out. Neither operation needs prefix sums, which is
+		// the only query a fenwick tree would speed up. The remaining
+		// per-piece work when querying accurate progress is proportional
+		// to the number of pieces currently being downloaded, not the
+		// total number of pieces
 		vector<std::int64_t, file_index_t> m_file_progress;
 
 #if TORRENT_USE_INVARIANT_CHECKS
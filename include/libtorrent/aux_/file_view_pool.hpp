@@ -39,6 +39,8 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #if TORRENT_HAVE_MMAP || TORRENT_HAVE_MAP_VIEW_OF_FILE
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <vector>
@@ -57,6 +59,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/optional.hpp>
 
 #include "libtorrent/aux_/disable_warnings_pop.hpp"
 
@@ -92,6 +95,12 @@ namespace aux {
 #endif
 			);
 
+		// return the view for the file at ``file_index`` in storage ``st``,
+		// if the pool is already holding that file open. Never opens a file,
+		// so it's cheap enough to call from latency sensitive contexts. A
+		// hit counts as a use for the purposes of LRU eviction
+		boost::optional<file_view> lookup(storage_index_t st, file_index_t file_index);
+
 		// release all file views belonging to the specified storage_interface
 		// (``st``) the overload that takes ``file_index`` releases only the file
 		// with that index in storage ``st``.
@@ -112,9 +121,10 @@ namespace aux {
 
 	private:
 
-		std::shared_ptr<file_mapping> remove_oldest(std::unique_lock<std::mutex>&);
+		std::shared_ptr<file_mapping> remove_oldest();
 
-		int m_size;
+		// the number of open files allowed in total, across all shards
+		std::atomic<int> m_size;
 
 		using file_id = std::pair<storage_index_t, file_index_t>;
 
@@ -153,16 +163,36 @@ namespace aux {
 			>
 		>;
 
-		// maps storage pointer, file index pairs to the lru entry for the file
-		files_container m_files;
-		mutable std::mutex m_mutex;
+		// the pool is sharded by storage index, so threads working on
+		// different torrents don't contend on one mutex. Each shard has its
+		// own LRU; eviction picks the shard holding the (approximately)
+		// globally least recently used file
+		static constexpr int num_shards = 16;
+
+		struct shard
+		{
+			// maps storage pointer, file index pairs to the lru entry for the
+			// file
+			files_container files;
+			mutable std::mutex mutex;
+
+			// the boost.multi-index container is not no-throw move
+			// constructable. In order to destruct ``files`` without holding
+			// the mutex, we need this separate pre-allocated container to
+			// move it into before releasing the mutex and clearing it.
+			files_container deferred_destruction;
+			mutable std::mutex destruction_mutex;
+		};
+
+		shard& shard_for(storage_index_t const st)
+		{ return m_shards[std::size_t(static_cast<std::uint32_t>(st)) & (num_shards - 1)]; }
+		shard const& shard_for(storage_index_t const st) const
+		{ return m_shards[std::size_t(static_cast<std::uint32_t>(st)) & (num_shards - 1)]; }
+
+		std::array<shard, num_shards> m_shards;
 
-		// the boost.multi-index container is not no-throw move constructable. In
-		// order to destruct m_files without holding the mutex, we need this
-		// separate pre-allocated container to move it into before releasing the
-		// mutex and clearing it.
-		files_container m_deferred_destruction;
-		mutable std::mutex m_destruction_mutex;
+		// the total number of files currently held open, across all shards
+		std::atomic<int> m_num_files{0};
 	};
 
 }
@@ -60,7 +60,7 @@ namespace aux {
 	template <class T>
 	struct heterogeneous_queue
 	{
-		heterogeneous_queue() : m_storage(nullptr, aux::free_deleter()) {}
+		heterogeneous_queue() = default;
 		heterogeneous_queue(heterogeneous_queue const&) = delete;
 		heterogeneous_queue& operator=(heterogeneous_queue const&) = delete;
 
@@ -69,11 +69,16 @@ namespace aux {
 		emplace_back(Args&&... args)
 		{
 			// make the conservative assumption that we'll need the maximum padding
-			// for this object, just for purposes of growing the storage
-			if (std::size_t(m_size) + sizeof(header_t) + alignof(U) + sizeof(U) > std::size_t(m_capacity))
-				grow_capacity(sizeof(header_t) + alignof(U) + sizeof(U));
+			// for this object, just for purposes of sizing the storage. Elements
+			// are never relocated; when the current slab is full we just open a
+			// new one and leave the old elements where they are
+			std::size_t const max_required = sizeof(header_t) + alignof(U) + sizeof(U);
+			if (m_slabs.empty()
+				|| std::size_t(m_slabs.back().capacity - m_slabs.back().size) < max_required)
+				add_slab(int(max_required));
 
-			char* ptr = m_storage.get() + m_size;
+			slab_t& s = m_slabs.back();
+			char* ptr = s.storage.get() + s.size;
 
 			std::size_t const pad_bytes = aux::calculate_pad_bytes(ptr + sizeof(header_t), alignof(U));
 
@@ -85,7 +90,7 @@ namespace aux {
 			// if this assert triggers, the type being added to the queue has
 			// alignment requirements stricter than what malloc() returns. This is
 			// not supported
-			TORRENT_ASSERT((reinterpret_cast<std::uintptr_t>(m_storage.get())
+			TORRENT_ASSERT((reinterpret_cast<std::uintptr_t>(s.storage.get())
 				& (alignof(U) - 1)) == 0);
 
 			// make sure the current position in the storage is aligned for
@@ -96,7 +101,6 @@ namespace aux {
 			// length prefix
 			header_t* hdr = new (ptr) header_t;
 			hdr->pad_bytes = static_cast<std::uint8_t>(pad_bytes);
-			hdr->move = &move<U>;
 			ptr += sizeof(header_t) + pad_bytes;
 			hdr->len = static_cast<std::uint16_t>(sizeof(U)
 				+ aux::calculate_pad_bytes(ptr + sizeof(U),  alignof(header_t)));
@@ -112,31 +116,34 @@ namespace aux {
 			// if we constructed the object without throwing any exception
 			// update counters to indicate the new item is in there
 			++m_num_items;
-			m_size += int(sizeof(header_t) + pad_bytes + hdr->len);
+			s.size += int(sizeof(header_t) + pad_bytes + hdr->len);
 			return *ret;
 		}
 
 		void get_pointers(std::vector<T*>& out)
 		{
 			out.clear();
+			out.reserve(std::size_t(m_num_items));
 
-			char* ptr = m_storage.get();
-			char const* const end = m_storage.get() + m_size;
-			while (ptr < end)
+			for (auto const& s : m_slabs)
 			{
-				header_t* hdr = reinterpret_cast<header_t*>(ptr);
-				ptr += sizeof(header_t) + hdr->pad_bytes;
-				TORRENT_ASSERT(ptr + hdr->len <= end);
-				out.push_back(reinterpret_cast<T*>(ptr));
-				ptr += hdr->len;
+				char* ptr = s.storage.get();
+				char const* const end = ptr + s.size;
+				while (ptr < end)
+				{
+					header_t* hdr = reinterpret_cast<header_t*>(ptr);
+					ptr += sizeof(header_t) + hdr->pad_bytes;
+					TORRENT_ASSERT(ptr + hdr->len <= end);
+					out.push_back(reinterpret_cast<T*>(ptr));
+					ptr += hdr->len;
+				}
 			}
 		}
 
 		void swap(heterogeneous_queue& rhs)
 		{
-			std::swap(m_storage, rhs.m_storage);
+			std::swap(m_slabs, rhs.m_slabs);
 			std::swap(m_capacity, rhs.m_capacity);
-			std::swap(m_size, rhs.m_size);
 			std::swap(m_num_items, rhs.m_num_items);
 		}
 
@@ -145,31 +152,45 @@ namespace aux {
 
 		void clear()
 		{
-			char* ptr = m_storage.get();
-			char const* const end = m_storage.get() + m_size;
-			while (ptr < end)
+			for (auto& s : m_slabs)
 			{
-				header_t* hdr = reinterpret_cast<header_t*>(ptr);
-				ptr += sizeof(header_t) + hdr->pad_bytes;
-				TORRENT_ASSERT(ptr + hdr->len <= end);
-				T* a = reinterpret_cast<T*>(ptr);
-				a->~T();
-				ptr += hdr->len;
-				hdr->~header_t();
+				char* ptr = s.storage.get();
+				char const* const end = ptr + s.size;
+				while (ptr < end)
+				{
+					header_t* hdr = reinterpret_cast<header_t*>(ptr);
+					ptr += sizeof(header_t) + hdr->pad_bytes;
+					TORRENT_ASSERT(ptr + hdr->len <= end);
+					T* a = reinterpret_cast<T*>(ptr);
+					a->~T();
+					ptr += hdr->len;
+					hdr->~header_t();
+				}
+				s.size = 0;
+			}
+
+			// now that the queue is empty, coalesce the storage to a single
+			// slab, so the whole capacity is contiguous again. The last slab is
+			// always the largest one
+			if (m_slabs.size() > 1)
+			{
+				slab_t keep = std::move(m_slabs.back());
+				m_capacity = keep.capacity;
+				m_slabs.clear();
+				m_slabs.push_back(std::move(keep));
 			}
-			m_size = 0;
 			m_num_items = 0;
 		}
 
 		T* front()
 		{
-			if (m_size == 0) return nullptr;
+			if (m_num_items == 0) return nullptr;
 
-			TORRENT_ASSERT(m_size > 1);
-			char* ptr = m_storage.get();
+			// the first slab is never empty as long as the queue isn't
+			char* ptr = m_slabs.front().storage.get();
 			header_t* hdr = reinterpret_cast<header_t*>(ptr);
-			TORRENT_ASSERT(sizeof(header_t) + hdr->pad_bytes + hdr->len
-				<= std::size_t(m_size));
+			TORRENT_ASSERT(int(sizeof(header_t) + hdr->pad_bytes + hdr->len)
+				<= m_slabs.front().size);
 			ptr += sizeof(header_t) + hdr->pad_bytes;
 			return reinterpret_cast<T*>(ptr);
 		}
@@ -179,9 +200,7 @@ namespace aux {
 	private:
 
 		// this header is put in front of every element. It tells us
-		// how many bytes it's using for its allocation, and it
-		// also tells us how to move this type if we need to grow our
-		// allocation.
+		// how many bytes it's using for its allocation
 		struct header_t
 		{
 			// the size of the object. From the start of the object, skip this many
@@ -193,66 +212,44 @@ namespace aux {
 			// header and the start of the object. This supports allocating types with
 			// stricter alignment requirements
 			std::uint8_t pad_bytes;
+		};
 
-			void (*move)(char* dst, char* src);
+		// one contiguous allocation, holding a sequence of elements, each
+		// preceded by a header_t
+		struct slab_t
+		{
+			std::unique_ptr<char, aux::free_deleter> storage;
+			// the number of bytes used in this slab
+			int size = 0;
+			// the number of bytes allocated for this slab
+			int capacity = 0;
 		};
 
-		void grow_capacity(int const size)
+		void add_slab(int const min_size)
 		{
-			int const amount_to_grow = (std::max)(size
+			// grow geometrically, just like a single reallocated buffer would,
+			// but without ever having to move the existing elements
+			int const alloc_size = (std::max)(min_size
 				, (std::max)(m_capacity * 3 / 2, 128));
 
 			// we use malloc() to guarantee alignment
-			std::unique_ptr<char, aux::free_deleter> new_storage(
-				static_cast<char*>(std::malloc(std::size_t(m_capacity + amount_to_grow)))
+			std::unique_ptr<char, aux::free_deleter> storage(
+				static_cast<char*>(std::malloc(std::size_t(alloc_size)))
 				, aux::free_deleter());
 
-			if (!new_storage)
+			if (!storage)
 				aux::throw_ex<std::bad_alloc>();
 
-			char* src = m_storage.get();
-			char* dst = new_storage.get();
-			char const* const end = m_storage.get() + m_size;
-			while (src < end)
-			{
-				header_t* src_hdr = reinterpret_cast<header_t*>(src);
-				new (dst) header_t(*src_hdr);
-				src += sizeof(header_t) + src_hdr->pad_bytes;
-				dst += sizeof(header_t) + src_hdr->pad_bytes;
-				int const len = src_hdr->len;
-				TORRENT_ASSERT(src + len <= end);
-				// this is no-throw
-				src_hdr->move(dst, src);
-				src_hdr->~header_t();
-				src += len ;
-				dst += len;
-			}
-
-			m_storage.swap(new_storage);
-			m_capacity += amount_to_grow;
-		}
-
-		template <class U>
-		static void move(char* dst, char* src) noexcept
-		{
-			static_assert(std::is_nothrow_move_constructible<U>::value
-				, "heterogeneous queue only supports noexcept move constructible types");
-			static_assert(std::is_nothrow_destructible<U>::value
-				, "heterogeneous queue only supports noexcept destructible types");
-			U& rhs = *reinterpret_cast<U*>(src);
-
-			TORRENT_ASSERT((reinterpret_cast<std::uintptr_t>(dst) & (alignof(U) - 1)) == 0);
-
-			new (dst) U(std::move(rhs));
-			rhs.~U();
+			m_slabs.emplace_back();
+			m_slabs.back().storage = std::move(storage);
+			m_slabs.back().capacity = alloc_size;
+			m_capacity += alloc_size;
 		}
 
-		std::unique_ptr<char, aux::free_deleter> m_storage;
-		// number of bytes of storage allocated
+		std::vector<slab_t> m_slabs;
+		// total number of bytes of storage allocated, across all slabs
 		int m_capacity = 0;
-		// the number of bytes used under m_storage
-		int m_size = 0;
-		// the number of objects allocated in m_storage
+		// the number of objects allocated across all slabs
 		int m_num_items = 0;
 	};
 } // namespace libtorrent
@@ -75,6 +75,26 @@ namespace libtorrent {
 	TORRENT_EXTRA_EXPORT void merkle_fill_tree(span<sha256_hash> tree, int num_leafs, int level_start);
 	TORRENT_EXTRA_EXPORT void merkle_fill_tree(span<sha256_hash> tree, int num_leafs);
 
+	// recomputes the ancestors of the leaf range [first_dirty, end_dirty)
+	// (indices relative to the first leaf) in the sub-tree whose leaf layer
+	// has num_leafs nodes and starts at level_start. All other nodes in the
+	// sub-tree are expected to be up to date already; they are read where a
+	// dirty node's sibling falls outside the range. This computes the same
+	// hashes merkle_fill_tree() would, but only along the paths from the
+	// updated leaves to the sub-tree root.
+	TORRENT_EXTRA_EXPORT void merkle_update_tree(span<sha256_hash> tree
+		, int num_leafs, int level_start, int first_dirty, int end_dirty);
+
+	// fills every node to the right of the payload with pad hashes: leaf
+	// layer nodes [end_payload, num_leafs) are set to ``pad``, and each level
+	// above gets the hash of two pads from the level below. All-pad sub-trees
+	// are identical within a level, so this is O(num_leafs) writes but only
+	// O(log(num_leafs)) hash computations. Following up with
+	// merkle_update_tree() over the payload range is equivalent to calling
+	// merkle_fill_tree() with the pad leaves filled in.
+	TORRENT_EXTRA_EXPORT void merkle_fill_pad(span<sha256_hash> tree
+		, int num_leafs, int level_start, int end_payload, sha256_hash pad);
+
 	// fills in nodes that can be computed from a tree with arbitrary nodes set
 	// all "orphan" hashes, i.e ones that do not contribute towards computing
 	// the root, will be cleared.
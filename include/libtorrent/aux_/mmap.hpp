@@ -171,6 +171,29 @@ namespace aux {
 			return m_mapping->memory();
 		}
 
+		// hint to the operating system that the specified byte range of this
+		// mapping is about to be read, so it can start faulting in the pages
+		// asynchronously. This is best-effort, failures are ignored
+		void hint_read_ahead(std::int64_t offset, std::int64_t length) const;
+
+		// returns whether any part of the specified byte range is backed by
+		// actual data on disk, as opposed to a hole in a sparse file.
+		// Returns true when the filesystem can't tell
+		bool has_data(std::int64_t offset, std::int64_t length) const;
+
+		// returns whether all pages covering the specified byte range are
+		// resident in the page cache, i.e. whether reading them would
+		// complete without blocking on disk I/O. Returns false when the
+		// operating system can't tell. The answer is inherently racy; pages
+		// may be evicted right after the probe, so it's only useful as an
+		// opportunistic hint
+		bool is_resident(std::int64_t offset, std::int64_t length) const;
+
+		// hint to the operating system to start writing the dirty pages in
+		// the specified byte range back to disk, without waiting for the
+		// writes to complete. This is best-effort, failures are ignored
+		void flush_async(std::int64_t offset, std::int64_t length) const;
+
 	private:
 		explicit file_view(std::shared_ptr<file_mapping> m) : m_mapping(std::move(m)) {}
 		std::shared_ptr<file_mapping> m_mapping;
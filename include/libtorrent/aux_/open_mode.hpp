@@ -53,6 +53,10 @@ namespace aux {
 		constexpr open_mode_t sparse = 6_bit;
 		constexpr open_mode_t executable = 7_bit;
 		constexpr open_mode_t allow_set_file_valid_data = 8_bit;
+		// hint the kernel to back the mapping with transparent huge pages
+		constexpr open_mode_t hugepage = 9_bit;
+		// pre-fault the entire mapping when it's created
+		constexpr open_mode_t populate = 10_bit;
 	}
 } // aux
 
@@ -94,6 +94,12 @@ namespace aux {
 
 		void reserve(std::uint32_t size);
 
+		// the initial capacity allocated for the slot array. Note that the
+		// array is not allocated at all until the first packet is inserted,
+		// so idle sockets don't pay for it. This is also the floor capacity
+		// below which the buffer never shrinks
+		static constexpr std::uint32_t default_capacity = 16;
+
 		index_type cursor() const { return m_first; }
 
 		index_type span() const { return (m_last - m_first) & 0xffff; }
@@ -103,9 +109,21 @@ namespace aux {
 #endif
 
 	private:
+
+		// halves the capacity of the slot array. The current window (span())
+		// must fit in the new capacity
+		void shrink();
+
 		aux::unique_ptr<packet_ptr[], index_type> m_storage;
 		std::uint32_t m_capacity = 0;
 
+		// the number of consecutive removals where the buffer used no more
+		// than a quarter of its capacity. Once this exceeds the capacity
+		// itself, the slot array is halved. This hysteresis makes sure one
+		// deep-window burst doesn't leave the socket holding a large
+		// allocation forever, without thrashing on short-lived dips
+		std::uint32_t m_shrink_timer = 0;
+
 		// this is the total number of elements that are occupied
 		// in the array
 		int m_size = 0;
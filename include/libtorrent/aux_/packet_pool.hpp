@@ -44,6 +44,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/assert.hpp"
 #include "libtorrent/debug.hpp" // for single_threaded
 
+#include <cstddef> // for ptrdiff_t
 #include <cstdlib>
 #include <memory> // for unique_ptr
 
@@ -152,7 +153,10 @@ namespace aux {
 		void decay()
 		{
 			if (m_storage.empty()) return;
-			m_storage.erase(m_storage.end() - 1);
+			// trim a quarter of the cached packets (at least one) per call,
+			// so even a large cache drains in a bounded number of ticks
+			m_storage.erase(m_storage.end()
+				- std::ptrdiff_t((m_storage.size() + 3) / 4), m_storage.end());
 		}
 
 	private:
@@ -167,10 +171,10 @@ namespace aux {
 		// there's a bug in GCC where allocating these in
 		// member initializer expressions won't propagate exceptions.
 		// https://gcc.gnu.org/bugzilla/show_bug.cgi?id=80683
-		packet_pool()
-			: m_syn_slab(TORRENT_UTP_HEADER)
-			, m_mtu_floor_slab(mtu_floor_size)
-			, m_mtu_ceiling_slab(mtu_ceiling_size)
+		explicit packet_pool(std::size_t const slab_limit = 10)
+			: m_syn_slab(TORRENT_UTP_HEADER, slab_limit)
+			, m_mtu_floor_slab(mtu_floor_size, slab_limit)
+			, m_mtu_ceiling_slab(mtu_ceiling_size, slab_limit)
 		{}
 		packet_pool(packet_pool&&) = default;
 
@@ -68,6 +68,12 @@ namespace aux {
 			, piece_index_t const piece, int const offset
 			, storage_error& error);
 
+		// returns whether any part of the piece is backed by data on disk,
+		// probing the filesystem for holes in sparse files. Returns true if
+		// in doubt. Lets a recheck skip reading and hashing pieces that
+		// haven't been downloaded at all
+		bool piece_has_data(piece_index_t piece, int len);
+
 		bool has_any_file(storage_error& error);
 		void set_file_priority(aux::vector<download_priority_t, file_index_t>& prio
 			, storage_error& ec);
@@ -91,6 +97,15 @@ namespace aux {
 		file_pointer open_file(file_index_t idx, open_mode_t mode, std::int64_t offset
 			, storage_error& ec);
 
+#ifdef TORRENT_LINUX
+		// write through O_DIRECT, bypassing the OS page cache. Used when
+		// disk_io_write_mode is set to disable_os_cache. Returns a sentinel
+		// when the request or file system can't do direct I/O, in which case
+		// the caller falls back to the buffered path
+		int write_direct(file_index_t idx, std::int64_t file_offset
+			, span<iovec_t const> vec, storage_error& ec);
+#endif
+
 		void need_partfile();
 		bool use_partfile(file_index_t index) const;
 		void use_partfile(file_index_t index, bool b);
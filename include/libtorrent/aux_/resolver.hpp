@@ -74,8 +74,17 @@ private:
 	{
 		time_point last_seen;
 		std::vector<address> addresses;
+
+		// set if this is a negative entry, i.e. the lookup failed. Negative
+		// entries are cached for a much shorter time than successful ones,
+		// but still long enough to keep a wave of announces to a
+		// non-resolving tracker from each stalling on a full lookup timeout
+		error_code error;
 	};
 
+	// if the cache has grown past its size limit, remove the oldest entries
+	void prune_cache();
+
 	std::unordered_map<std::string, dns_cache_entry> m_cache;
 	io_context& m_ios;
 
@@ -44,7 +44,6 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/aux_/session_udp_sockets.hpp"
 #include "libtorrent/aux_/socket_type.hpp"
 #include "libtorrent/torrent_peer.hpp"
-#include "libtorrent/torrent_peer_allocator.hpp"
 #include "libtorrent/performance_counters.hpp" // for counters
 #include "libtorrent/aux_/allocating_handler.hpp"
 #include "libtorrent/aux_/time.hpp"
@@ -76,6 +75,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/socket_io.hpp" // for print_address
 #include "libtorrent/address.hpp"
 #include "libtorrent/aux_/utp_socket_manager.hpp"
+#include "libtorrent/aux_/packet_pool.hpp"
 #include "libtorrent/bloom_filter.hpp"
 #include "libtorrent/peer_class.hpp"
 #include "libtorrent/peer_class_type_filter.hpp"
@@ -409,13 +409,19 @@ namespace aux {
 			void on_error(error_code const& ec) override;
 
 			void on_ip_change(error_code const& ec);
+			void on_ip_change_settled(error_code const& ec);
 			void reopen_listen_sockets(bool map_ports = true);
+
+			// enumerating the network interfaces and routes can be expensive
+			// on hosts with many (virtual) interfaces. These return a cached
+			// snapshot, refreshed whenever the ip_notifier reports a change.
+			// When the notifier isn't running there's nothing to invalidate
+			// the cache, so every call enumerates afresh
+			std::vector<ip_interface> const& net_interfaces(error_code& ec);
+			std::vector<ip_route> const& net_routes(error_code& ec);
 			void reopen_outgoing_sockets();
 			void reopen_network_sockets(reopen_network_flags_t options);
 
-			torrent_peer_allocator_interface& get_peer_allocator() override
-			{ return m_peer_allocator; }
-
 			io_context& get_context() override { return m_io_context; }
 			resolver_interface& get_resolver() override { return m_host_resolver; }
 
@@ -606,6 +612,7 @@ namespace aux {
 			std::tuple<std::shared_ptr<torrent>, info_hash_t, bool>
 			add_torrent_impl(add_torrent_params const& p, error_code& ec) = delete;
 			void async_add_torrent(add_torrent_params* params);
+			void async_add_torrents(std::vector<add_torrent_params>* params);
 
 			void remove_torrent(torrent_handle const& h, remove_flags_t options) override;
 			void remove_torrent_impl(std::shared_ptr<torrent> tptr, remove_flags_t options) override;
@@ -618,6 +625,7 @@ namespace aux {
 			void post_torrent_updates(status_flags_t flags);
 			void post_session_stats();
 			void post_dht_stats();
+			void save_all_resume_data(resume_data_flags_t flags);
 
 			std::vector<torrent_handle> get_torrents() const;
 
@@ -729,6 +737,7 @@ namespace aux {
 
 #if TORRENT_USE_I2P
 			char const* i2p_session() const override { return m_i2p_conn.session_id(); }
+			i2p_connection& i2p_conn() override { return m_i2p_conn; }
 			proxy_settings i2p_proxy() const override;
 
 			void on_i2p_open(error_code const& ec);
@@ -856,7 +865,9 @@ namespace aux {
 			void update_upload_rate();
 			void update_connections_limit();
 			void update_alert_mask();
+			void update_alert_notify_coalescing();
 			void update_validate_https();
+			void update_autotune_state();
 
 			void trigger_auto_manage() override;
 
@@ -887,16 +898,22 @@ namespace aux {
 
 			counters m_stats_counters;
 
-			// this is a pool allocator for torrent_peer objects
-			// torrents and the disk cache (implicitly by holding references to the
-			// torrents) depend on this outliving them.
-			torrent_peer_allocator m_peer_allocator;
-
 			// this vector is used to store the block_info
 			// objects pointed to by partial_piece_info returned
 			// by torrent::get_download_queue.
 			std::vector<block_info> m_block_info_storage;
 
+			// all protocol work runs on this single io_context thread; the
+			// single-thread invariant (is_single_thread() asserts) is
+			// assumed by essentially every data structure in the session.
+			// Scaling protocol work across cores is done by running
+			// multiple session objects, one per core, with torrents
+			// partitioned between them by info-hash; SO_REUSEPORT-style
+			// sharding *inside* one session (per-shard peer sets sharing a
+			// disk_interface and DHT) would mean either locking or
+			// migrating the choker, rate limiters, peer list and stats,
+			// all of which are cross-torrent and currently lock-free by
+			// virtue of thread confinement
 			io_context& m_io_context;
 
 #if TORRENT_USE_SSL
@@ -962,9 +979,8 @@ namespace aux {
 
 			tracker_manager m_tracker_manager;
 
-			// the torrents must be destructed after the torrent_peer_allocator,
-			// since the torrents hold the peer lists that own the torrent_peers
-			// (which are allocated in the torrent_peer_allocator)
+			// each torrent owns its own torrent_peer_allocator, which its
+			// peer_list allocates the torrent_peers from
 			aux::torrent_list<torrent> m_torrents;
 
 			// all torrents that are downloading or queued,
@@ -1013,6 +1029,19 @@ namespace aux {
 			// posts a notification when the set of local IPs changes
 			std::unique_ptr<ip_change_notifier> m_ip_notifier;
 
+			// cached network interface and route enumeration results, served
+			// by net_interfaces()/net_routes() and invalidated by
+			// on_ip_change()
+			std::vector<ip_interface> m_net_interfaces_cache;
+			std::vector<ip_route> m_net_routes_cache;
+			bool m_net_interfaces_cached = false;
+			bool m_net_routes_cached = false;
+
+			// the (name, address) pairs of the interfaces as of the last
+			// IP change we acted on, used to suppress rebinding the listen
+			// sockets when a burst of change events turns out to be a no-op
+			std::vector<std::pair<std::string, address>> m_last_if_state;
+
 			// the addresses or device names of the interfaces we are supposed to
 			// listen on. if empty, it means that we should let the os decide
 			// which interface to listen on
@@ -1101,6 +1130,11 @@ namespace aux {
 
 			void on_tick(error_code const& e);
 
+			// one round of the closed-loop performance tuner (see
+			// settings_pack::enable_autotune). Called once per second from
+			// on_tick(), but only acts every autotune_interval seconds
+			void update_autotune(time_point now);
+
 			void try_connect_more_peers();
 			void auto_manage_checking_torrents(std::vector<torrent*>& list
 				, int& limit);
@@ -1132,6 +1166,21 @@ namespace aux {
 			time_point m_last_tick;
 			time_point m_last_second_tick;
 
+			// state for the performance autotuner. The baselines are the
+			// operator-configured values captured when the tuner was
+			// (re-)enabled; they bound how far each knob may be moved.
+			// m_next_autotune at min_time() means the baselines need to be
+			// (re-)captured. The *_snapshot values are the cumulative
+			// counter readings from the previous tuner round, used to
+			// compute per-interval deltas
+			time_point m_next_autotune = min_time();
+			int m_autotune_aio_threads_base = 0;
+			int m_autotune_watermark_base = 0;
+			int m_autotune_connections_base = 0;
+			std::int64_t m_autotune_ticks_snapshot = 0;
+			std::int64_t m_autotune_slow_ticks_snapshot = 0;
+			std::int64_t m_autotune_stalls_snapshot = 0;
+
 			// the last time we went through the peers
 			// to decide which ones to choke/unchoke
 			time_point m_last_choke;
@@ -1225,6 +1274,13 @@ namespace aux {
 				, std::weak_ptr<listen_socket_t> ls
 				, transport ssl, error_code const& ec);
 
+			// the packet buffer pool backing the uTP socket managers. All
+			// uTP sockets in the session recycle their packet buffers
+			// through this one pool, which also makes the warm buffers
+			// shared between the SSL and non-SSL managers. Must be declared
+			// before the managers, which hold references to it
+			libtorrent::aux::packet_pool m_utp_packet_pool{32};
+
 			libtorrent::aux::utp_socket_manager m_utp_socket_manager;
 
 #ifdef TORRENT_SSL_PEERS
@@ -1237,6 +1293,26 @@ namespace aux {
 			// this is deducted from the connect speed
 			int m_boost_connections = 0;
 
+			// the adaptive rate of outgoing connection attempts, in
+			// attempts per second. It starts out at
+			// settings_pack::connection_speed and is grown additively while
+			// connect timeouts stay rare, and halved when they spike. 0
+			// means it hasn't been initialized from the setting yet
+			int m_connect_rate = 0;
+
+			// token bucket of connection attempts, refilled at
+			// m_connect_rate per second by try_connect_more_peers().
+			// Unspent attempts carry over (capped at one extra second's
+			// worth) so that a tick with an empty candidate list doesn't
+			// permanently forfeit its quota
+			int m_connect_quota = 0;
+
+			// snapshots of the connection_attempts and connect_timeouts
+			// counters from the previous tick, to compute the per-tick
+			// deltas the connect rate feedback is based on
+			std::int64_t m_last_connect_attempts = 0;
+			std::int64_t m_last_connect_timeouts = 0;
+
 			// mask is a bitmask of which protocols to remap on:
 			enum remap_port_mask_t
 			{
@@ -1290,6 +1366,11 @@ namespace aux {
 			// time it's called, to force the windows disk cache to be flushed
 			deadline_timer m_close_file_timer;
 
+			// when network change events arrive in a burst (e.g. a flapping
+			// VPN reconnecting), this timer defers reacting until the
+			// interface set has settled
+			deadline_timer m_ip_change_timer;
+
 			// the index of the torrent that will be offered to
 			// connect to a peer next time on_tick is called.
 			// This implements a round robin peer connections among
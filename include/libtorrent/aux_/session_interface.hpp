@@ -69,8 +69,10 @@ namespace libtorrent {
 	struct tracker_request;
 	struct request_callback;
 	struct external_ip;
-	struct torrent_peer_allocator_interface;
 	struct counters;
+#if TORRENT_USE_I2P
+	class i2p_connection;
+#endif
 
 namespace aux {
 	struct utp_socket_manager;
@@ -153,7 +155,6 @@ namespace aux {
 
 		virtual alert_manager& alerts() = 0;
 
-		virtual torrent_peer_allocator_interface& get_peer_allocator() = 0;
 		virtual io_context& get_context() = 0;
 		virtual aux::resolver_interface& get_resolver() = 0;
 
@@ -215,6 +216,7 @@ namespace aux {
 #if TORRENT_USE_I2P
 		virtual proxy_settings i2p_proxy() const = 0;
 		virtual char const* i2p_session() const = 0;
+		virtual i2p_connection& i2p_conn() = 0;
 #endif
 
 		virtual void prioritize_connections(std::weak_ptr<torrent> t) = 0;
@@ -33,15 +33,15 @@ POSSIBILITY OF SUCH DAMAGE.
 #ifndef TORRENT_STORE_BUFFER
 #define TORRENT_STORE_BUFFER
 
+#include <cstdint>
 #include <unordered_map>
 #include <mutex>
+#include <vector>
 
+#include "libtorrent/assert.hpp"
 #include "libtorrent/storage_defs.hpp"
-
-#include "libtorrent/aux_/disable_warnings_push.hpp"
-#include <boost/functional/hash.hpp>
-#include "libtorrent/aux_/disable_warnings_pop.hpp"
-
+#include "libtorrent/disk_interface.hpp"
+#include "libtorrent/disk_buffer_holder.hpp"
 
 namespace libtorrent {
 namespace aux {
@@ -62,31 +62,129 @@ struct torrent_location
 	}
 };
 
+// a torrent_location packed into a single 64 bit word, so blocks can be
+// tracked with one-word keys. Piece indices are 31 bit ints and a piece
+// holds at most 2^15 blocks (piece_picker::max_blocks_per_piece), which
+// leaves 18 bits for the storage index. That bounds the number of
+// simultaneously loaded torrents at 262144, far beyond what a session
+// can sensibly hold
+inline std::uint64_t pack_location(torrent_location const loc)
+{
+	TORRENT_ASSERT(static_cast<std::uint32_t>(loc.torrent) < (1 << 18));
+	TORRENT_ASSERT(static_cast<std::int32_t>(loc.piece) >= 0);
+	TORRENT_ASSERT(loc.offset % default_block_size == 0);
+	TORRENT_ASSERT(loc.offset / default_block_size < (1 << 15));
+	return (std::uint64_t(static_cast<std::uint32_t>(loc.torrent)) << 46)
+		| (std::uint64_t(static_cast<std::int32_t>(loc.piece)) << 15)
+		| std::uint64_t(loc.offset / default_block_size);
 }
-}
-
-namespace std {
 
-template <>
-struct hash<libtorrent::aux::torrent_location>
+// maps packed location keys to dirty blocks. This sits on the hot path
+// of every write and every read hit, so instead of std::unordered_map
+// it's an open-addressing table with linear probing: a lookup touches a
+// single contiguous array and compares one 64 bit word per probe, with
+// no pointer chasing. Erasing uses backward-shift deletion, so there
+// are no tombstones to degrade probe lengths. An empty slot is
+// represented by a nullptr buffer
+struct packed_location_map
 {
-	using argument_type = libtorrent::aux::torrent_location;
-	using result_type = std::size_t;
-	std::size_t operator()(argument_type const& l) const
+	char* find(std::uint64_t const key) const
 	{
-		using namespace libtorrent;
-		std::size_t ret = 0;
-		boost::hash_combine(ret, std::hash<storage_index_t>{}(l.torrent));
-		boost::hash_combine(ret, std::hash<piece_index_t>{}(l.piece));
-		boost::hash_combine(ret, std::hash<int>{}(l.offset));
-		return ret;
+		if (m_size == 0) return nullptr;
+		for (std::size_t i = home_slot(key);; i = next_slot(i))
+		{
+			slot_t const& s = m_table[i];
+			if (s.buf == nullptr) return nullptr;
+			if (s.key == key) return s.buf;
+		}
 	}
-};
 
-}
+	bool contains(std::uint64_t const key) const
+	{ return find(key) != nullptr; }
 
-namespace libtorrent {
-namespace aux {
+	// just like std::unordered_map::insert(), this does not overwrite an
+	// existing entry for the same key
+	void insert(std::uint64_t const key, char* const buf)
+	{
+		TORRENT_ASSERT(buf != nullptr);
+		if ((m_size + 1) * 4 > m_table.size() * 3) grow();
+		for (std::size_t i = home_slot(key);; i = next_slot(i))
+		{
+			slot_t& s = m_table[i];
+			if (s.buf == nullptr)
+			{
+				s.key = key;
+				s.buf = buf;
+				++m_size;
+				return;
+			}
+			if (s.key == key) return;
+		}
+	}
+
+	bool erase(std::uint64_t const key)
+	{
+		if (m_size == 0) return false;
+		std::size_t i = home_slot(key);
+		for (;; i = next_slot(i))
+		{
+			if (m_table[i].buf == nullptr) return false;
+			if (m_table[i].key == key) break;
+		}
+
+		// backward-shift deletion. Move later entries of the probe
+		// sequence into the hole, as long as doing so doesn't move them
+		// before their home slot
+		for (std::size_t j = next_slot(i);; j = next_slot(j))
+		{
+			if (m_table[j].buf == nullptr) break;
+			std::size_t const home = home_slot(m_table[j].key);
+			// the entry at j may fill the hole at i only if its home slot
+			// does not lie in the cyclic interval (i, j]
+			bool const reachable = (j > i)
+				? (home <= i || home > j)
+				: (home <= i && home > j);
+			if (!reachable) continue;
+			m_table[i] = m_table[j];
+			i = j;
+		}
+		m_table[i].buf = nullptr;
+		--m_size;
+		return true;
+	}
+
+private:
+
+	struct slot_t
+	{
+		std::uint64_t key = 0;
+		char* buf = nullptr;
+	};
+
+	// fibonacci hashing. The packed keys are dense in the low bits, a
+	// multiplicative hash spreads them across the table
+	std::size_t home_slot(std::uint64_t const key) const
+	{
+		return std::size_t((key * 0x9e3779b97f4a7c15ULL) >> 32)
+			& (m_table.size() - 1);
+	}
+
+	std::size_t next_slot(std::size_t const i) const
+	{ return (i + 1) & (m_table.size() - 1); }
+
+	void grow()
+	{
+		std::vector<slot_t> old_table(m_table.empty() ? 64 : m_table.size() * 2);
+		old_table.swap(m_table);
+		m_size = 0;
+		for (slot_t const& s : old_table)
+			if (s.buf != nullptr) insert(s.key, s.buf);
+	}
+
+	// the table size is always a power of two
+	std::vector<slot_t> m_table;
+	std::size_t m_size = 0;
+};
 
 struct store_buffer
 {
@@ -94,33 +192,185 @@ struct store_buffer
 	bool get(torrent_location const loc, Fun f)
 	{
 		std::unique_lock<std::mutex> l(m_mutex);
-		auto it = m_store_buffer.find(loc);
-		if (it != m_store_buffer.end())
+		char* const buf = m_store_buffer.find(pack_location(loc));
+		if (buf != nullptr)
 		{
-			f(it->second);
+			f(buf);
 			return true;
 		}
 		return false;
 	}
 
+	// whether there's a dirty block at this location. Note that a block may
+	// be inserted right after this returns false, callers need to tolerate
+	// that, just like a get() that misses
+	bool contains(torrent_location const loc)
+	{
+		std::unique_lock<std::mutex> l(m_mutex);
+		return m_store_buffer.contains(pack_location(loc));
+	}
+
 	void insert(torrent_location const loc, char* buf)
 	{
 		std::lock_guard<std::mutex> l(m_mutex);
-		m_store_buffer.insert({loc, buf});
+		std::uint64_t const key = pack_location(loc);
+		m_store_buffer.insert(key, buf);
+		// this dirty block supersedes whatever we may have cached for this
+		// location
+		erase_cached(key);
 	}
 
 	void erase(torrent_location const loc)
 	{
 		std::lock_guard<std::mutex> l(m_mutex);
-		auto it = m_store_buffer.find(loc);
-		TORRENT_ASSERT(it != m_store_buffer.end());
-		m_store_buffer.erase(it);
+		bool const erased = m_store_buffer.erase(pack_location(loc));
+		TORRENT_ASSERT(erased);
+		TORRENT_UNUSED(erased);
+	}
+
+	// --- the read cache ---
+	// in addition to the dirty blocks above (which only live until they are
+	// flushed), clean blocks can be cached here, so hot pieces are served
+	// without touching the file at all. Eviction is by the CLOCK
+	// (second-chance) policy, which approximates LRU without having to
+	// maintain an ordered list on every hit
+
+	// look up a clean block. Returns true and calls f with the block
+	// contents if it's in the cache
+	template <typename Fun>
+	bool get_cached(torrent_location const loc, Fun f)
+	{
+		std::unique_lock<std::mutex> l(m_mutex);
+		auto it = m_cache_map.find(pack_location(loc));
+		if (it == m_cache_map.end()) return false;
+		cache_entry& e = m_cache[it->second];
+		e.referenced = true;
+		f(e.buf.data());
+		return true;
+	}
+
+	// hand a clean copy of a block over to the cache. If the budget is
+	// exceeded, another block is evicted. If the budget is 0, the block is
+	// freed immediately
+	void cache(torrent_location const loc, disk_buffer_holder buf)
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		if (m_cache_budget <= 0) return;
+
+		std::uint64_t const key = pack_location(loc);
+
+		// never cache a block that also exists as a dirty block. The dirty
+		// copy is newer
+		if (m_store_buffer.contains(key)) return;
+
+		auto it = m_cache_map.find(key);
+		if (it != m_cache_map.end())
+		{
+			cache_entry& e = m_cache[it->second];
+			e.buf = std::move(buf);
+			e.referenced = true;
+			return;
+		}
+
+		while (int(m_cache.size()) >= m_cache_budget) evict_one();
+		m_cache_map[key] = m_cache.size();
+		m_cache.emplace_back(cache_entry{loc, std::move(buf), false});
+	}
+
+	void set_cache_size(int const blocks)
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		m_cache_budget = blocks;
+		while (int(m_cache.size()) > std::max(m_cache_budget, 0)) evict_one();
+	}
+
+	// drop all cached blocks belonging to the specified torrent, or a single
+	// piece of it
+	void clear_cache(storage_index_t const st)
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		for (std::size_t i = 0; i < m_cache.size();)
+		{
+			if (m_cache[i].loc.torrent == st) remove_cache_entry(i);
+			else ++i;
+		}
+	}
+
+	void clear_cache(storage_index_t const st, piece_index_t const p)
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		for (std::size_t i = 0; i < m_cache.size();)
+		{
+			if (m_cache[i].loc.torrent == st && m_cache[i].loc.piece == p)
+				remove_cache_entry(i);
+			else ++i;
+		}
+	}
+
+	int cache_blocks() const
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		return int(m_cache.size());
 	}
 
 private:
 
-	std::mutex m_mutex;
-	std::unordered_map<torrent_location, char*> m_store_buffer;
+	struct cache_entry
+	{
+		torrent_location loc;
+		disk_buffer_holder buf;
+		// the CLOCK reference bit, set on every cache hit
+		bool referenced;
+	};
+
+	void erase_cached(std::uint64_t const key)
+	{
+		auto it = m_cache_map.find(key);
+		if (it == m_cache_map.end()) return;
+		remove_cache_entry(it->second);
+	}
+
+	// remove the entry at index i, by swapping the last entry into its slot
+	void remove_cache_entry(std::size_t const i)
+	{
+		m_cache_map.erase(pack_location(m_cache[i].loc));
+		if (i != m_cache.size() - 1)
+		{
+			m_cache[i] = std::move(m_cache.back());
+			m_cache_map[pack_location(m_cache[i].loc)] = i;
+		}
+		m_cache.pop_back();
+		if (m_clock_hand >= m_cache.size()) m_clock_hand = 0;
+	}
+
+	// evict the first block the clock hand finds whose reference bit is
+	// clear, clearing bits as it sweeps past
+	void evict_one()
+	{
+		TORRENT_ASSERT(!m_cache.empty());
+		for (;;)
+		{
+			if (m_clock_hand >= m_cache.size()) m_clock_hand = 0;
+			cache_entry& e = m_cache[m_clock_hand];
+			if (!e.referenced)
+			{
+				remove_cache_entry(m_clock_hand);
+				return;
+			}
+			e.referenced = false;
+			++m_clock_hand;
+		}
+	}
+
+	mutable std::mutex m_mutex;
+	packed_location_map m_store_buffer;
+
+	// clean blocks. m_cache_map indexes into the m_cache vector, which the
+	// clock hand sweeps over
+	std::unordered_map<std::uint64_t, std::size_t> m_cache_map;
+	std::vector<cache_entry> m_cache;
+	std::size_t m_clock_hand = 0;
+	int m_cache_budget = 0;
 };
 
 }
@@ -39,10 +39,19 @@ POSSIBILITY OF SUCH DAMAGE.
 
 namespace libtorrent { namespace aux {
 
-	// returns the current time, as represented by time_point. The
-	// resolution of this timer is about 100 ms.
+	// returns the current time, as represented by time_point. This is a
+	// coarse timestamp, cached by the last call to update_time_now(). The
+	// network thread refreshes the cache at every event handler entry
+	// point, so within one handler invocation all calls return the same
+	// value without touching the clock. If update_time_now() has never
+	// been called (no session main loop is running), the clock is read
+	// directly. Code that needs precise timestamps (uTP packet timing)
+	// should call clock_type::now() instead
 	TORRENT_EXTRA_EXPORT time_point time_now();
 	TORRENT_EXTRA_EXPORT time_point32 time_now32();
+
+	// read the clock and refresh the timestamp returned by time_now()
+	TORRENT_EXTRA_EXPORT time_point update_time_now();
 } }
 
 #endif
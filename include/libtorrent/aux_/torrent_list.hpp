@@ -51,6 +51,12 @@ template <typename T>
 struct torrent_list
 {
 	// These are non-owning pointers. Lifetime is managed by the `torrent_array`
+	// note that lookups here are cheaper than they may appear: the
+	// std::hash specialization for sha1_hash just copies the first 8 bytes
+	// of the (already uniformly distributed) digest, so no hashing happens
+	// per lookup. Replacing the map with a bespoke open-addressing table
+	// would only save the bucket indirection, which isn't worth a custom
+	// container for a handshake-rate operation
 	using torrent_map = std::unordered_map<sha1_hash, T*>;
 	using torrent_array = std::vector<std::shared_ptr<T>>;
 
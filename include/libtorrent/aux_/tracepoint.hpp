@@ -0,0 +1,69 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TORRENT_TRACEPOINT_HPP_INCLUDED
+#define TORRENT_TRACEPOINT_HPP_INCLUDED
+
+#include "libtorrent/config.hpp"
+
+// USDT static tracepoints for observing hot paths on production builds
+// with bpftrace/perf, without rebuilding. When built with
+// TORRENT_USE_SDT=1 (requires <sys/sdt.h> from systemtap), each probe
+// compiles to a single nop instruction that the tracer patches when
+// attached. When disabled (the default) the macros expand to nothing.
+// The probe names and argument layouts are a tracing interface; don't
+// change the meaning or order of existing arguments, add a new probe
+// instead
+
+#ifndef TORRENT_USE_SDT
+#define TORRENT_USE_SDT 0
+#endif
+
+#if TORRENT_USE_SDT
+
+#include <sys/sdt.h>
+
+#define TORRENT_PROBE(name) DTRACE_PROBE(libtorrent, name)
+#define TORRENT_PROBE1(name, a1) DTRACE_PROBE1(libtorrent, name, a1)
+#define TORRENT_PROBE2(name, a1, a2) DTRACE_PROBE2(libtorrent, name, a1, a2)
+#define TORRENT_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(libtorrent, name, a1, a2, a3)
+
+#else
+
+#define TORRENT_PROBE(name) do {} while (false)
+#define TORRENT_PROBE1(name, a1) do {} while (false)
+#define TORRENT_PROBE2(name, a1, a2) do {} while (false)
+#define TORRENT_PROBE3(name, a1, a2, a3) do {} while (false)
+
+#endif // TORRENT_USE_SDT
+
+#endif // TORRENT_TRACEPOINT_HPP_INCLUDED
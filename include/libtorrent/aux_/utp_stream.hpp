@@ -596,7 +596,15 @@ struct utp_socket_impl
 		, std::uint16_t seq_nr);
 	void write_sack(std::uint8_t* buf, int size) const;
 	void incoming(std::uint8_t const* buf, int size, packet_ptr p, time_point now);
+	// congestion control. cwnd_adjust() is the seam between the socket and
+	// the congestion controller: it dispatches on the
+	// settings_pack::utp_congestion_control setting to one of the
+	// controllers below, which are handed the same three inputs (bytes
+	// acked by this packet, the one-way delay sample and the bytes that
+	// were in flight) and adjust m_cwnd
+	void cwnd_adjust(int acked_bytes, int delay, int in_flight);
 	void do_ledbat(int acked_bytes, int delay, int in_flight);
+	void do_ledbat_pp(int acked_bytes, int delay, int in_flight);
 	int packet_timeout() const;
 	bool test_socket_state();
 	void maybe_trigger_receive_callback();
@@ -781,6 +789,15 @@ private:
 	// 100 ms
 	time_point m_next_loss;
 
+	// these two drive the LEDBAT++ periodic slowdown. Once slow-start is
+	// over, every nine round-trips (m_next_slowdown) the window is held at
+	// two packets for two round-trips (until m_slowdown_until), to drain
+	// any standing queue we built ourselves and let the base-delay
+	// measurement recover. min_time() means inactive. Only used when the
+	// utp_ledbat_pp congestion controller is selected
+	time_point m_next_slowdown = min_time();
+	time_point m_slowdown_until = min_time();
+
 	// the max number of bytes in-flight. This is a fixed point
 	// value, to get the true number of bytes, shift right 16 bits
 	// the value is always >= 0, but the calculations performed on
@@ -452,6 +452,12 @@ TORRENT_EXPORT std::string print_entry(bdecode_node const& e
 // must also remain valid while the bdecoded tree is used. The parsed tree
 // produced by this function does not copy any data out of the buffer, but
 // simply produces references back into it.
+//
+// The overload taking a ``bdecode_node`` reference re-uses the node's token
+// buffer, only growing it when a buffer needs more tokens than any previous
+// one. When parsing many small buffers in a loop (e.g. one network packet at
+// a time), pass the same node into every call to avoid per-buffer
+// allocations.
 TORRENT_EXPORT int bdecode(char const* start, char const* end, bdecode_node& ret
 	, error_code& ec, int* error_pos = nullptr, int depth_limit = 100
 	, int token_limit = 2000000);
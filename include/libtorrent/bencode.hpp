@@ -62,6 +62,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/assert.hpp"
 #include "libtorrent/io.hpp" // for write_string
 #include "libtorrent/string_util.hpp" // for is_digit
+#include "libtorrent/span.hpp"
 
 namespace libtorrent {
 
@@ -99,6 +100,31 @@ namespace aux {
 		++out;
 	}
 
+	// the number of characters write_integer() would produce for val,
+	// including a minus sign
+	inline int integer_str_size(entry::integer_type const val)
+	{
+		// negate as unsigned, since the most negative value has no positive
+		// counterpart in int64
+		std::uint64_t v;
+		int ret = 1;
+		if (val < 0)
+		{
+			v = std::uint64_t(0) - std::uint64_t(val);
+			++ret;
+		}
+		else
+		{
+			v = std::uint64_t(val);
+		}
+		while (v >= 10)
+		{
+			v /= 10;
+			++ret;
+		}
+		return ret;
+	}
+
 	template <class InIt>
 	std::string read_until(InIt& in, InIt end, char end_token, bool& err)
 	{
@@ -376,6 +402,55 @@ namespace aux {
 		return aux::bencode_recursive(out, e);
 	}
 
+	// Returns the number of bytes the bencoded form of ``e`` occupies. This
+	// makes it possible to allocate (or re-use) an exactly sized buffer up
+	// front and fill it with the ``span<char>`` overload of bencode(),
+	// instead of growing the output through a back_insert_iterator.
+	inline std::int64_t bencoded_size(entry const& e)
+	{
+		std::int64_t ret = 0;
+		switch (e.type())
+		{
+		case entry::int_t:
+			ret += aux::integer_str_size(e.integer()) + 2;
+			break;
+		case entry::string_t:
+			ret += aux::integer_str_size(entry::integer_type(e.string().length()))
+				+ 1 + std::int64_t(e.string().length());
+			break;
+		case entry::list_t:
+			for (auto const& i : e.list())
+				ret += bencoded_size(i);
+			ret += 2;
+			break;
+		case entry::dictionary_t:
+			for (auto const& i : e.dict())
+			{
+				ret += aux::integer_str_size(entry::integer_type(i.first.length()))
+					+ 1 + std::int64_t(i.first.length());
+				ret += bencoded_size(i.second);
+			}
+			ret += 2;
+			break;
+		case entry::preformatted_t:
+			ret += std::int64_t(e.preformatted().size());
+			break;
+		case entry::undefined_t:
+			ret += 2;
+			break;
+		}
+		return ret;
+	}
+
+	// Encodes ``e`` directly into ``buf``, which must be at least
+	// bencoded_size(e) bytes big. Returns the number of bytes written.
+	inline int bencode(span<char> buf, const entry& e)
+	{
+		TORRENT_ASSERT(std::int64_t(buf.size()) >= bencoded_size(e));
+		char* out = buf.data();
+		return aux::bencode_recursive(out, e);
+	}
+
 #if TORRENT_ABI_VERSION == 1
 	template<class InIt>
 	TORRENT_DEPRECATED
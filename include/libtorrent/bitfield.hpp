@@ -168,6 +168,12 @@ namespace libtorrent {
 		// returns the index of the first set bit in the bitfield, i.e. 1 bit.
 		int find_first_set() const noexcept;
 
+		// returns the index of the first set bit at, or after, bit index
+		// ``start``. Returns -1 if all bits from ``start`` onwards are
+		// cleared. This allows iterating over just the set bits a word at a
+		// time, rather than testing each bit individually
+		int find_first_set(int start) const noexcept;
+
 		// returns the index to the last cleared bit in the bitfield, i.e. 0 bit.
 		int find_last_clear() const noexcept;
 
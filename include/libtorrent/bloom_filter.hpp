@@ -45,6 +45,12 @@ namespace libtorrent {
 	TORRENT_EXTRA_EXPORT bool has_bits(std::uint8_t const* k, std::uint8_t const* bits, int len);
 	TORRENT_EXTRA_EXPORT int count_zero_bits(std::uint8_t const* bits, int len);
 
+	// a bloom filter of N bytes, using 2 bits per key, as specified by
+	// BEP 33. The bit positions are derived from the first 4 bytes of the
+	// (SHA-1) key, so both the hashing scheme and the filter sizes used on
+	// the wire (256 bytes for scrape responses) are part of the protocol
+	// and cannot be changed. For internal uses, N is free to be as large
+	// as the expected number of keys calls for, and size() scales with it
 	template <int N>
 	struct bloom_filter
 	{
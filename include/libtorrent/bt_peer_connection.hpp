@@ -59,6 +59,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/pe_crypto.hpp"
 #include "libtorrent/io.hpp"
 #include "libtorrent/hash_picker.hpp"
+#include "libtorrent/sliding_average.hpp"
 
 namespace libtorrent {
 
@@ -211,6 +212,10 @@ namespace libtorrent {
 		// be called. i.e. most handlers need
 		// to check how much of the packet they
 		// have received before any processing
+		// the signature of all message handlers. dispatch_message() selects
+		// the handler for a message through a jump table of these
+		using message_handler = void (bt_peer_connection::*)(int received);
+
 		void on_choke(int received);
 		void on_unchoke(int received);
 		void on_interested(int received);
@@ -337,10 +342,28 @@ namespace libtorrent {
 
 		// helper to cut down on boilerplate
 		void rc4_decrypt(span<char> buf);
+
+		// the crypto handler the payload stream was negotiated to use,
+		// i.e. AES-128-CTR when both ends support it, RC4 otherwise
+		std::shared_ptr<crypto_plugin> payload_crypto_handler();
+
+		// decrypt payload-stream bytes with the negotiated cipher. Only
+		// used for bytes that arrive before the crypto handler has been
+		// installed in the receive buffer
+		void payload_decrypt(span<char> buf);
 #endif
 
 	public:
 
+		bool is_send_plaintext() const override
+		{
+#if !defined TORRENT_DISABLE_ENCRYPTION
+			return m_enc_handler.is_send_plaintext();
+#else
+			return true;
+#endif
+		}
+
 		// these functions encrypt the send buffer if m_rc4_encrypted
 		// is true, otherwise it passes the call to the
 		// peer_connection functions of the same names
@@ -418,6 +441,10 @@ namespace libtorrent {
 		// true if rc4, false if plaintext
 		bool m_rc4_encrypted:1;
 
+		// true if the AES-128-CTR upgrade to RC4 was negotiated for the
+		// payload stream. Only meaningful when m_rc4_encrypted is true
+		bool m_aes_encrypted:1;
+
 // this is a legitimate use of a shadow field
 #ifdef __clang__
 #pragma clang diagnostic push
@@ -459,7 +486,16 @@ namespace libtorrent {
 
 		std::vector<range> m_payloads;
 
-		std::vector<hash_request> m_hash_requests;
+		// hash requests sent to this peer that haven't been responded to
+		// yet, and the time each one was sent, to measure the peer's
+		// hash-delivery latency
+		std::vector<std::pair<hash_request, time_point>> m_hash_requests;
+
+		// how long this peer takes to respond to a hash request, in
+		// milliseconds. Used to size the hash request pipeline; high
+		// latency peers need more requests in flight to keep hashes
+		// flowing between round-trips
+		sliding_average<int, 10> m_hash_time;
 
 #if !defined TORRENT_DISABLE_ENCRYPTION
 		// initialized during write_pe1_2_dhkey, and destroyed on
@@ -472,6 +508,12 @@ namespace libtorrent {
 		// otherwise it is destroyed when the handshake completes
 		std::shared_ptr<rc4_handler> m_rc4;
 
+#ifdef TORRENT_USE_LIBCRYPTO
+		// set up alongside m_rc4 and switched into m_enc_handler instead of
+		// the RC4 handler if the AES-128-CTR upgrade is negotiated
+		std::shared_ptr<aes_ctr_handler> m_aes;
+#endif
+
 		// if encryption is negotiated, this is used for
 		// encryption/decryption during the entire session.
 		encryption_handler m_enc_handler;
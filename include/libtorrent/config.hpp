@@ -159,6 +159,14 @@ POSSIBILITY OF SUCH DAMAGE.
 #define TORRENT_HAS_SALEN 0
 #define TORRENT_USE_FDATASYNC 1
 
+// if the kernel headers are new enough, enable the io_uring disk I/O
+// back-end
+#if !defined TORRENT_USE_IOURING && defined __has_include
+#if __has_include(<linux/io_uring.h>)
+#define TORRENT_USE_IOURING 1
+#endif
+#endif
+
 // ===== ANDROID ===== (almost linux, sort of)
 #if defined __ANDROID__
 #define TORRENT_ANDROID
@@ -423,6 +431,10 @@ POSSIBILITY OF SUCH DAMAGE.
 #define TORRENT_USE_FDATASYNC 0
 #endif
 
+#ifndef TORRENT_USE_IOURING
+#define TORRENT_USE_IOURING 0
+#endif
+
 #ifndef TORRENT_USE_UNC_PATHS
 #define TORRENT_USE_UNC_PATHS 0
 #endif
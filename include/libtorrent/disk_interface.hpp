@@ -159,6 +159,13 @@ namespace file_open_mode {
 		// access to the previous content.
 		static constexpr disk_job_flags_t force_copy = 0_bit;
 
+		// the caller of async_read() promises not to modify the returned
+		// buffer and to release it promptly. This allows the disk backend to
+		// hand out a reference directly into a file mapping, avoiding a copy
+		// of the block on the upload path. Backends that cannot do this
+		// safely ignore the flag.
+		static constexpr disk_job_flags_t zero_copy = 1_bit;
+
 		// hint that there may be more disk operations with sequential access to
 		// the file
 		static constexpr disk_job_flags_t sequential_access = 3_bit;
@@ -472,6 +472,8 @@ namespace errors {
 		torrent_inconsistent_hashes,
 		// a file in the v2 metadata has the pad attribute set
 		torrent_invalid_pad_file,
+		// the torrent has more files than allowed by the file count limit
+		too_many_files_in_torrent,
 
 		// the number of error codes
 		error_code_max
@@ -385,6 +385,31 @@ TORRENT_VERSION_NAMESPACE_3_END
 		// hidden
 		virtual ~peer_plugin() {}
 
+		// include this bit if your plugin needs to have on_piece()
+		// called. It fires for every incoming block
+		static constexpr feature_flags_t on_piece_feature = 1_bit;
+
+		// include this bit if your plugin needs to have on_have() called
+		static constexpr feature_flags_t on_have_feature = 2_bit;
+
+		// include this bit if your plugin needs to have on_request()
+		// called
+		static constexpr feature_flags_t on_request_feature = 3_bit;
+
+		// include this bit if your plugin needs to have sent_payload()
+		// called. It fires for every batch of payload bytes written to the
+		// socket
+		static constexpr feature_flags_t sent_payload_feature = 4_bit;
+
+		// This function is expected to return a bitmask indicating which of
+		// the per-message callbacks above this plugin implements. These
+		// callbacks sit on the peer message hot path and fire once per block
+		// or message transferred, so the peer connection skips the whole
+		// plugin chain for them unless some attached plugin has declared an
+		// interest here. All other callbacks are invoked unconditionally;
+		// they are rare enough that filtering them buys nothing.
+		virtual feature_flags_t implemented_features() { return {}; }
+
 		// This function is expected to return the name of
 		// the plugin.
 		virtual string_view type() const { return {}; }
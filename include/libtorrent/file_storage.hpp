@@ -558,6 +558,11 @@ namespace aux {
 		// returns the piece index the given file starts at
 		piece_index_t piece_index_at_file(file_index_t f) const;
 
+		// the approximate number of bytes of heap this file_storage
+		// occupies, based on container capacities and owned filename
+		// strings. Used for per-torrent memory accounting
+		std::int64_t memory_usage() const;
+
 #if TORRENT_USE_INVARIANT_CHECKS
 		// internal
 		bool owns_name(file_index_t const f) const
@@ -242,6 +242,9 @@ struct counters;
 // include/libtorrent/piece_block.hpp
 struct piece_block;
 
+// include/libtorrent/resume_data_store.hpp
+struct resume_data_store;
+
 // include/libtorrent/session.hpp
 struct session_proxy;
 struct session;
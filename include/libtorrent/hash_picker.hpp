@@ -234,6 +234,11 @@ namespace libtorrent
 		// the granularity with which we send hash requests. The number of layers
 		// all the way down the the block level.
 		int const m_piece_tree_root_layer;
+
+		// scratch buffer for the sub-tree built to validate each incoming
+		// hashes message, kept around to reuse the allocation between
+		// messages
+		aux::vector<sha256_hash> m_tree_scratch;
 	};
 } // namespace libtorrent
 
@@ -161,6 +161,14 @@ TORRENT_CRYPTO_NAMESPACE
 		// default constructed.
 		void reset();
 
+		// hashes each buffer in ``bufs`` independently, as if by
+		// ``hasher256(bufs[i]).final()``, writing one digest per buffer into
+		// ``digests`` (which must be at least as long as ``bufs``). When the
+		// CPU supports it, several buffers are hashed in lockstep with SIMD,
+		// which is considerably faster than hashing them one at a time.
+		static void hash_blocks(span<span<char const> const> bufs
+			, span<sha256_hash> digests);
+
 		~hasher256();
 
 	private:
@@ -180,6 +188,34 @@ TORRENT_CRYPTO_NAMESPACE
 	};
 
 TORRENT_CRYPTO_NAMESPACE_END
+
+namespace aux {
+
+	// identifies the SHA-1 implementation the hasher uses on this machine.
+	// The library backend is selected at build time, and the built-in
+	// backend additionally dispatches on CPU features at runtime. Reported
+	// by the ``ses.sha1_backend`` session stats gauge
+	enum sha1_backend_t : int
+	{
+		sha1_backend_builtin = 0,
+		sha1_backend_sha_ni = 1,
+		sha1_backend_arm = 2,
+		sha1_backend_libcrypto = 3,
+		sha1_backend_gcrypt = 4,
+		sha1_backend_commoncrypto = 5,
+		sha1_backend_cng = 6,
+		sha1_backend_cryptoapi = 7
+	};
+
+	TORRENT_EXTRA_EXPORT int sha1_backend();
+
+	// returns the digest of a buffer of ``size`` zero bytes, without
+	// needing such a buffer. The results are cached (shared between
+	// threads), since the disk I/O subsystems ask for the same few sizes
+	// over and over when checking pieces that lie in holes of sparse files
+	TORRENT_EXTRA_EXPORT sha1_hash hash_of_zeroes(int size);
+	TORRENT_EXTRA_EXPORT sha256_hash hash2_of_zeroes(int size);
+}
 }
 
 #endif // TORRENT_HASHER_HPP_INCLUDED
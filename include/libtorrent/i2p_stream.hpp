@@ -128,6 +128,17 @@ struct i2p_stream : proxy_base
 	void set_destination(string_view d) { m_dest = d.to_string(); }
 	std::string const& destination() { return m_dest; }
 
+	// hand over a socket that is already connected to the SAM bridge and
+	// has completed the HELLO handshake (see
+	// i2p_connection::take_warm_socket()). async_connect() will skip
+	// straight to issuing the command, saving the name resolution, TCP
+	// connect and HELLO round-trips
+	void set_sam_socket(tcp::socket s)
+	{
+		m_sock = std::move(s);
+		m_warm_start = true;
+	}
+
 	template <class Handler>
 	void async_connect(endpoint_type const&, Handler h)
 	{
@@ -139,6 +150,15 @@ struct i2p_stream : proxy_base
 		// 2. connect to SAM bridge
 		// 4 send command message (CONNECT/ACCEPT)
 
+		// a warm standby socket has already gone through the resolve,
+		// connect and HELLO steps. Go straight to the command
+		if (m_warm_start && m_sock.is_open())
+		{
+			m_warm_start = false;
+			send_command(error_code(), std::move(h));
+			return;
+		}
+
 		m_resolver.async_resolve(m_hostname, to_string(m_port).data(), wrap_allocator(
 			[this](error_code const& ec, tcp::resolver::results_type ips, Handler hn) {
 				do_connect(ec, std::move(ips), std::move(hn));
@@ -357,23 +377,7 @@ private:
 		switch (m_state)
 		{
 		case read_hello_response:
-			switch (m_command)
-			{
-				case cmd_create_session:
-					send_session_create(std::move(h));
-					break;
-				case cmd_accept:
-					send_accept(std::move(h));
-					break;
-				case cmd_connect:
-					send_connect(std::move(h));
-					break;
-				case cmd_none:
-				case cmd_name_lookup:
-				case cmd_incoming:
-					h(e);
-					std::vector<char>().swap(m_buffer);
-			}
+			send_command(e, std::move(h));
 			break;
 		case read_connect_response:
 		case read_session_create_response:
@@ -397,6 +401,29 @@ private:
 		}
 	}
 
+	template <typename Handler>
+	void send_command(error_code const& e, Handler h)
+	{
+		TORRENT_ASSERT(m_magic == 0x1337);
+		switch (m_command)
+		{
+			case cmd_create_session:
+				send_session_create(std::move(h));
+				break;
+			case cmd_accept:
+				send_accept(std::move(h));
+				break;
+			case cmd_connect:
+				send_connect(std::move(h));
+				break;
+			case cmd_none:
+			case cmd_name_lookup:
+			case cmd_incoming:
+				h(e);
+				std::vector<char>().swap(m_buffer);
+		}
+	}
+
 	template <typename Handler>
 	void send_connect(Handler h)
 	{
@@ -458,6 +485,11 @@ private:
 
 	command_t m_command;
 	state_t m_state;
+
+	// set when a warm standby socket has been moved into this stream with
+	// set_sam_socket(). Tells async_connect() that the HELLO handshake is
+	// already out of the way
+	bool m_warm_start = false;
 #if TORRENT_USE_ASSERTS
 	int m_magic;
 #endif
@@ -516,6 +548,12 @@ public:
 	char const* session_id() const { return m_session_id.c_str(); }
 	std::string const& local_endpoint() const { return m_i2p_local_endpoint; }
 
+	// move a standby socket to the SAM bridge, with the HELLO handshake
+	// already completed, into s (if one is available). Returns true if s
+	// was primed, in which case its async_connect() goes straight to
+	// issuing the command. Either way, the pool starts replenishing itself
+	bool take_warm_socket(i2p_stream& s);
+
 	template <typename Handler>
 	void async_name_lookup(char const* name, Handler handler)
 	{
@@ -540,6 +578,9 @@ private:
 			return;
 		}
 
+		// now that the session is up, start warming up standby sockets
+		refresh_warm_sockets();
+
 		do_name_lookup("ME", wrap_allocator(
 			[this](error_code const& e, char const* dst, Handler hn) {
 				set_local_endpoint(e, dst, std::move(hn));
@@ -594,8 +635,18 @@ private:
 		h(ec);
 	}
 
+	void refresh_warm_sockets();
+	void on_warm_connect(error_code const& ec, std::shared_ptr<i2p_stream> s);
+
 	// to talk to i2p SAM bridge
 	std::shared_ptr<i2p_stream> m_sam_socket;
+
+	// standby sockets to the SAM bridge with the HELLO handshake already
+	// completed, plus the ones still working on it. Handed out via
+	// take_warm_socket() to cut round-trips out of peer connection setup
+	std::vector<std::shared_ptr<i2p_stream>> m_warm_sockets;
+	std::vector<std::shared_ptr<i2p_stream>> m_warm_connecting;
+
 	std::string m_hostname;
 	int m_port;
 
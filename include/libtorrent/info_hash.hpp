@@ -67,6 +67,13 @@ namespace {
 	//
 	//	If ``has_v2()`` is false then the v1 hash might actually be a truncated
 	//	v2 hash
+	//
+	// the two digests are stored inline, with no heap allocation. For hybrid
+	// torrents they are independent values (the v1 hash is not a truncation
+	// of the v2 hash), so the 52 bytes cannot be packed any tighter. Hash
+	// tables keyed on these digests don't pay for the full width per probe
+	// either: std::hash of a digest is just its first 8 bytes, so the full
+	// compare only happens within a matching bucket
 	struct TORRENT_EXPORT info_hash_t
 	{
 		// The default constructor creates an object that has neither a v1 or v2
@@ -120,6 +120,15 @@ namespace aux {
 		};
 
 		std::set<range> m_access_list;
+
+		// a flattened copy of m_access_list, rebuilt lazily by access() after
+		// rules have changed. Per-connection lookups binary search this
+		// compact contiguous array instead of chasing tree nodes, which
+		// matters for large blocklists. The node-based set is kept as the
+		// canonical store because add_rule() relies on cheap insertion and
+		// erasure in the middle of the sequence
+		mutable std::vector<range> m_flattened;
+		mutable bool m_dirty = true;
 	};
 
 	extern template class filter_impl<address_v4::bytes_type>;
@@ -69,6 +69,14 @@ namespace dht {
 		// the bootstrap nodes saved from the IPv6 buckets node
 		std::vector<udp::endpoint> nodes6;
 
+		// the routing table nodes saved together with their node IDs.
+		// Nodes restored with an ID can be placed straight back into the
+		// routing table on startup (they enter unconfirmed and are
+		// validated lazily by the table's regular maintenance), instead
+		// of having to be re-discovered through a bootstrap traversal
+		std::vector<std::pair<node_id, udp::endpoint>> table_nodes;
+		std::vector<std::pair<node_id, udp::endpoint>> table_nodes6;
+
 		void clear();
 	};
 
@@ -117,6 +117,10 @@ namespace dht {
 		void announce(sha1_hash const& ih, int listen_port, announce_flags_t flags
 			, std::function<void(std::vector<tcp::endpoint> const&)> f);
 
+		// the number of lookup traversals currently running across all
+		// nodes. Used by the session to pace torrent announces
+		int num_active_lookups() const;
+
 		void sample_infohashes(udp::endpoint const& ep, sha1_hash const& target
 			, std::function<void(node_id
 				, time_duration
@@ -39,6 +39,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/address.hpp"
 #include "libtorrent/assert.hpp"
 
+#include <cstdint>
+
 namespace libtorrent {
 namespace dht {
 
@@ -67,7 +69,7 @@ namespace dht {
 
 	private:
 
-		// used to ignore abusive dht nodes
+		// a dht node we're currently ignoring
 		struct node_ban_entry
 		{
 			node_ban_entry(): count(0) {}
@@ -78,6 +80,11 @@ namespace dht {
 
 		static constexpr int num_ban_nodes = 20;
 
+		// dimensions of the count-min sketch. The width must be a power of
+		// two. 4 rows of 1024 16-bit counters is 8 kiB
+		static constexpr int sketch_rows = 4;
+		static constexpr int sketch_width = 1024;
+
 		// the max number of packets we can receive per second from a node before
 		// we block it.
 		int m_message_rate_limit;
@@ -86,7 +93,20 @@ namespace dht {
 		// limit
 		int m_block_timeout;
 
+		// the sources currently being ignored. Since packets from banned
+		// sources don't make it into the sketch, this doubles as the list
+		// of the heaviest hitters we've seen
 		node_ban_entry m_ban_nodes[num_ban_nodes];
+
+		// approximate per-source packet counts for the current sampling
+		// window, in constant space. Each source increments one counter per
+		// row and its count is estimated as the minimum of them, so counts
+		// can only be over-estimated, and only when a source collides with
+		// heavier ones in every row
+		std::uint16_t m_sketch[sketch_rows][sketch_width];
+
+		// when the current sampling window ends and the sketch is cleared
+		time_point m_window_end;
 	};
 }
 }
@@ -206,6 +206,12 @@ public:
 		m_running_requests.erase(a);
 	}
 
+	int num_traversal_algorithms() const
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		return int(m_running_requests.size());
+	}
+
 	dht_status status() const;
 
 	std::tuple<int, int, int> get_stats_counters() const;
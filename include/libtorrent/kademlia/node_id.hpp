@@ -39,6 +39,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <libtorrent/config.hpp>
 #include <libtorrent/sha1_hash.hpp>
 #include <libtorrent/address.hpp>
+#include <libtorrent/span.hpp>
 
 namespace libtorrent {
 namespace dht {
@@ -52,6 +53,11 @@ TORRENT_EXTRA_EXPORT node_id distance(node_id const& n1, node_id const& n2);
 // returns true if: distance(n1, ref) < distance(n2, ref)
 TORRENT_EXTRA_EXPORT bool compare_ref(node_id const& n1, node_id const& n2, node_id const& ref);
 
+struct node_entry;
+
+// sorts the node entries in-place by distance(id, ref), closest first
+TORRENT_EXTRA_EXPORT void sort_by_distance(span<node_entry> l, node_id const& ref);
+
 // returns n in: 2^n <= distance(n1, n2) < 2^(n+1)
 // useful for finding out which bucket a node belongs to
 // the value that's returned is the number of trailing bits
@@ -302,6 +302,16 @@ private:
 	// closest to us (m_buckets.back()) has more than
 	// bucket size nodes in it, another bucket is
 	// added to the end and it's split up between them
+	// the bucket array is, in effect, a compressed trie over the XOR
+	// metric: bucket i holds the nodes sharing an i-bit prefix with our
+	// ID (the last bucket covers the rest), so find_bucket() indexes
+	// straight into it via distance_exp() without walking anything, and
+	// each bucket is a contiguous vector of a handful of entries. A
+	// k-closest query therefore reads the target bucket plus, rarely, a
+	// neighbour or two: a few cache lines. An explicit flat-arena trie
+	// index over node IDs would add pointer maintenance on every
+	// add/remove for the same access pattern we already get from this
+	// layout
 	table_t m_buckets;
 
 	node_id m_id; // our own node id
@@ -37,6 +37,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #define RPC_MANAGER_HPP
 
 #include <unordered_map>
+#include <deque>
+#include <utility>
 #include <cstdint>
 
 #include "libtorrent/aux_/disable_warnings_push.hpp"
@@ -132,6 +134,16 @@ private:
 
 	std::unordered_multimap<int, observer_ptr> m_transactions;
 
+	// transactions waiting for their short timeout and full timeout
+	// respectively, in the order they were sent. Every transaction has
+	// the same timeout constants and send timestamps are monotonic, so
+	// each queue is in expiry order and tick() only inspects the fronts,
+	// instead of scanning all outstanding transactions. Entries whose
+	// transaction completed in the meantime are recognized by no longer
+	// being in m_transactions, and dropped lazily
+	std::deque<std::pair<int, observer_ptr>> m_short_timeout_queue;
+	std::deque<std::pair<int, observer_ptr>> m_timeout_queue;
+
 	aux::listen_socket_handle m_sock;
 	socket_manager* m_sock_man;
 #ifndef TORRENT_DISABLE_LOGGING
@@ -130,6 +130,16 @@ private:
 	node_id const m_target;
 	std::int8_t m_invoke_count = 0;
 	std::int8_t m_branch_factor = 3;
+
+	// adaptive adjustment to the branch factor, based on how this lookup
+	// has been going. It grows (up to one extra branch factor, i.e. double
+	// concurrency) while responses keep coming back with few timeouts,
+	// and shrinks below zero when timeouts dominate, so a lookup into a
+	// responsive part of the network finishes quicker while one probing
+	// dead address space doesn't flood it with parallel queries. It's
+	// kept separate from m_branch_factor, whose increments and decrements
+	// are paired with individual short-timed-out observers
+	std::int8_t m_adaptive_branch = 0;
 	// the number of elements at the beginning of m_results that are sorted by
 	// node_id.
 	std::int8_t m_sorted_results = 0;
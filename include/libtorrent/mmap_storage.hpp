@@ -40,6 +40,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <mutex>
 #include <atomic>
+#include <deque>
 #include <memory>
 
 #include "libtorrent/fwd.hpp"
@@ -114,6 +115,44 @@ namespace aux {
 		int hashv2(settings_interface const&, hasher256& ph, std::ptrdiff_t len
 			, piece_index_t piece, int offset, aux::open_mode_t flags, storage_error&);
 
+		// hint the OS to start paging in the given range of the piece,
+		// without blocking. Lets a hash job overlap the read of the next
+		// block with hashing the current one
+		void prefetch(settings_interface const&, piece_index_t piece
+			, int offset, int len, aux::open_mode_t flags);
+
+		// returns whether any part of the piece is backed by data on disk,
+		// probing the filesystem for holes in sparse files. Returns true if
+		// in doubt. Lets a recheck skip reading and hashing pieces that
+		// haven't been downloaded at all
+		bool piece_has_data(settings_interface const&, piece_index_t piece
+			, int len, aux::open_mode_t flags);
+
+		// attempt to serve a read directly out of a file mapping, without
+		// copying into a buffer. On success, returns a pointer into the
+		// mapping and sets ``view`` to a handle keeping the mapping alive.
+		// Returns nullptr if the range isn't backed by a single mapped
+		// file, in which case the caller falls back to readv()
+		char* map_read(settings_interface const&, piece_index_t piece
+			, int offset, int len, aux::open_mode_t flags
+			, boost::optional<aux::file_view>& view);
+
+		// like map_read(), but never opens a file and never blocks on disk
+		// I/O. Only succeeds if the range is backed by a single file that's
+		// already mapped and whose pages are resident in the page cache.
+		// Meant to be called inline from latency sensitive contexts, to
+		// serve page-cache-hot reads without a round-trip through the disk
+		// threads
+		char* resident_read(piece_index_t piece, int offset, int len
+			, boost::optional<aux::file_view>& view);
+
+		// hand extents recorded by writev() over to the operating system
+		// for asynchronous write-back, up to ``budget`` bytes. Returns the
+		// number of bytes handed over. Called by the write-back governor in
+		// mmap_disk_io, to smooth the flushing of dirty pages into a steady
+		// rate
+		std::int64_t write_back_dirty(settings_interface const&, std::int64_t budget);
+
 		// if the files in this storage are mapped, returns the mapped
 		// file_storage, otherwise returns the original file_storage object.
 		file_storage const& files() const { return m_mapped_files ? *m_mapped_files : m_files; }
@@ -190,6 +229,31 @@ namespace aux {
 		// to make all storage instances share the pool
 		aux::file_view_pool& m_pool;
 
+		// detects sequential read patterns, to issue read-ahead hints for the
+		// pages ahead of the read cursor. The tracking is approximate. It may
+		// lose an update when multiple threads read from the same storage
+		// concurrently, that just means a missed (or duplicate) hint
+		void maybe_read_ahead(settings_interface const&, piece_index_t piece
+			, int offset, int len, aux::open_mode_t flags);
+		std::atomic<std::int64_t> m_seq_read_cursor{-1};
+		std::atomic<int> m_seq_read_run{0};
+		std::atomic<std::int64_t> m_read_ahead_pos{0};
+
+		// extents written through the mapping since they were last handed to
+		// the OS for write-back, recorded by writev() when the write-back
+		// governor is enabled. Adjacent writes are coalesced. Guarded by
+		// m_dirty_extents_mutex
+		struct dirty_extent
+		{
+			file_index_t file;
+			std::int64_t offset;
+			std::int64_t length;
+		};
+		void record_dirty_extent(file_index_t file, std::int64_t offset
+			, std::int64_t len);
+		std::deque<dirty_extent> m_dirty_extents;
+		std::mutex m_dirty_extents_mutex;
+
 		// used for skipped files
 		std::unique_ptr<part_file> m_part_file;
 
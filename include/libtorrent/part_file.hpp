@@ -83,7 +83,7 @@ namespace libtorrent {
 
 	private:
 
-		file open_file(aux::open_mode_t mode, error_code& ec);
+		std::shared_ptr<file> open_file(aux::open_mode_t mode, error_code& ec);
 		void flush_metadata_impl(error_code& ec);
 
 		std::int64_t slot_offset(slot_index_t const slot) const
@@ -130,6 +130,24 @@ namespace libtorrent {
 		// need to flush the metadata before closing the file
 		bool m_dirty_metadata = false;
 
+		// the cached open part file handle. All reads and writes through it
+		// are positional, so multiple disk threads can use it concurrently.
+		// Callers copy the shared_ptr under the mutex and perform the I/O
+		// after releasing it; re-opening (e.g. upgrading from read-only to
+		// writable) just swaps in a new handle and lets the old one live
+		// until the last operation using it completes
+		std::shared_ptr<file> m_file;
+		aux::open_mode_t m_file_mode{};
+
+		// the pieces whose slot entries changed since the header was last
+		// flushed. As long as a full header exists on disk, flushing only
+		// writes these 4-byte entries instead of rebuilding the whole header
+		std::vector<piece_index_t> m_dirty_slots;
+
+		// whether the file currently holds a full, valid header. If it
+		// doesn't, the next metadata flush has to write the whole header
+		bool m_header_written = false;
+
 		// maps a piece index to the part-file slot it is stored in
 		std::unordered_map<piece_index_t, slot_index_t> m_piece_map;
 	};
@@ -67,9 +67,11 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/piece_block.hpp"
 #include "libtorrent/peer_info.hpp"
 #include "libtorrent/aux_/vector.hpp"
+#include "libtorrent/aux_/small_vector.hpp"
 #include "libtorrent/disk_interface.hpp"
 #include "libtorrent/piece_picker.hpp" // for picker_options_t
 #include "libtorrent/units.hpp"
+#include "libtorrent/flags.hpp"
 #include "libtorrent/aux_/socket_type.hpp"
 
 #include <ctime>
@@ -440,7 +442,7 @@ namespace aux {
 
 		std::vector<pending_block> const& download_queue() const;
 		std::vector<pending_block> const& request_queue() const;
-		std::vector<peer_request> const& upload_queue() const;
+		aux::small_vector<peer_request, 4> const& upload_queue() const;
 
 		void clear_request_queue();
 		void clear_download_queue();
@@ -580,8 +582,18 @@ namespace aux {
 		void incoming_interested();
 		void incoming_not_interested();
 		void incoming_have(piece_index_t piece_index);
+
+		// applies any HAVE messages that incoming_have() has buffered, as a
+		// single piece picker update and interest check. Called when a
+		// message other than HAVE arrives, and at the end of each receive
+		// quantum
+		void flush_haves();
+
 		void incoming_dont_have(piece_index_t piece_index);
-		void incoming_bitfield(typed_bitfield<piece_index_t> const& bits);
+		// takes the bitfield by value; it's moved into m_have_piece rather
+		// than copied, so the buffer parsed off the wire is handed straight
+		// to this connection
+		void incoming_bitfield(typed_bitfield<piece_index_t> bits);
 		void incoming_request(peer_request const& r);
 		void incoming_piece(peer_request const& p, char const* data);
 		void incoming_piece_fragment(int bytes);
@@ -705,6 +717,10 @@ namespace aux {
 
 		int num_reading_bytes() const { return m_reading_bytes; }
 
+		// the number of bytes sent to the disk-io thread that haven't
+		// been written yet
+		int outstanding_writing_bytes() const { return m_outstanding_writing_bytes; }
+
 		void setup_receive();
 
 		std::shared_ptr<peer_connection> self()
@@ -733,6 +749,12 @@ namespace aux {
 		virtual void write_dont_have(piece_index_t index) = 0;
 		virtual void write_keepalive() = 0;
 		virtual void write_piece(peer_request const& r, disk_buffer_holder buffer) = 0;
+
+		// returns true if payload buffers handed to the send buffer are
+		// transmitted as-is, without being mutated (e.g. encrypted) in
+		// place. When true, the disk layer is allowed to hand out
+		// references straight into file mappings for uploaded blocks
+		virtual bool is_send_plaintext() const { return true; }
 		virtual void write_suggest(piece_index_t piece) = 0;
 		virtual void write_bitfield() = 0;
 
@@ -765,6 +787,10 @@ namespace aux {
 
 		void update_desired_queue_size();
 
+		// grow the socket's send and receive buffers to match the measured
+		// bandwidth-delay product of this connection
+		void tune_socket_buffers();
+
 		void set_send_barrier(int bytes)
 		{
 			TORRENT_ASSERT(bytes == INT_MAX || bytes <= send_buffer_size());
@@ -816,8 +842,15 @@ namespace aux {
 
 		// the queue of requests we have got
 		// from this peer that haven't been issued
-		// to the disk thread yet
-		aux::vector<peer_request> m_requests;
+		// to the disk thread yet. The queue is almost always shorter than 4
+		// entries, which are stored inline
+		aux::small_vector<peer_request, 4> m_requests;
+
+		// pieces the peer has announced with HAVE messages, that have not
+		// been applied to the piece picker yet. A burst of consecutive HAVE
+		// messages (common right after connecting) is collapsed into a
+		// single refcount update and interest check in flush_haves()
+		std::vector<piece_index_t> m_pending_haves;
 
 		// this peer's peer info struct. This may
 		// be 0, in case the connection is incoming
@@ -874,6 +907,15 @@ namespace aux {
 	protected:
 #ifndef TORRENT_DISABLE_EXTENSIONS
 		std::list<std::shared_ptr<peer_plugin>> m_extensions;
+
+		// the union of implemented_features() of all plugins in
+		// m_extensions, used to skip the plugin chain entirely on the
+		// per-message hot paths. This may overstate the interest after a
+		// plugin has been removed from the chain, which is benign; the
+		// callbacks just iterate the remaining plugins
+		// (mirrors the feature_flags_t declaration in extensions.hpp)
+		flags::bitfield_flag<std::uint8_t, struct feature_flags_tag>
+			m_extension_features{};
 #endif
 	private:
 
@@ -883,6 +925,23 @@ namespace aux {
 		// receive a payload message after it has been requested.
 		sliding_average<int, 20> m_request_time;
 
+		// the lowest request-to-piece latency we have seen on this
+		// connection, in milliseconds, or 0 if we haven't completed any
+		// request yet. Outstanding requests queued ahead of a block inflate
+		// m_request_time by the pipeline drain time, so the minimum over
+		// the connection's lifetime is the best estimate we have of the
+		// actual round-trip delay to this peer. It's used to size the
+		// request queue to the bandwidth-delay product of the link
+		int m_request_time_min = 0;
+
+		// the socket send and receive buffer sizes (SO_SNDBUF / SO_RCVBUF)
+		// we have requested for this connection via buffer autotuning, or 0
+		// if we're still on the OS default. The totals across all
+		// connections are tracked in the socket_send_buffer_bytes and
+		// socket_recv_buffer_bytes counters
+		int m_socket_send_buf = 0;
+		int m_socket_recv_buf = 0;
+
 		// keep the io_context running as long as we
 		// have peer connections
 		executor_work_guard<io_context::executor_type> m_work;
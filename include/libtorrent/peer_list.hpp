@@ -192,6 +192,11 @@ namespace libtorrent {
 		int num_seeds() const { return int(m_num_seeds); }
 		int num_connect_candidates() const { return m_num_connect_candidates; }
 
+		// the approximate number of bytes of heap occupied by the peer
+		// list and the torrent_peer entries it points to, used for
+		// per-torrent memory accounting
+		std::int64_t memory_usage() const;
+
 		void erase_peer(torrent_peer* p, torrent_state* state);
 		void erase_peer(iterator i, torrent_state* state);
 
@@ -223,6 +228,8 @@ namespace libtorrent {
 		static constexpr erase_peer_flags_t force_erase = 1_bit;
 		void erase_peers(torrent_state* state, erase_peer_flags_t flags = {});
 
+		void free_all_peers();
+
 		peers_t m_peers;
 
 		// this should be nullptr for the most part. It's set
@@ -234,7 +241,9 @@ namespace libtorrent {
 		torrent_peer* m_locked_peer;
 
 		// the peer allocator, as stored from the constructor
-		// this must be available in the destructor to free all peers
+		// this must be available in the destructor to free all peers.
+		// It is exclusive to this peer_list, which is what makes the
+		// wholesale release in free_all_peers() sound
 		torrent_peer_allocator_interface& m_peer_allocator;
 
 		// the number of seeds in the torrent_peer list
@@ -203,11 +203,55 @@ namespace libtorrent {
 			num_read_ops,
 			num_read_back,
 
+			// the number of blocks served out of the in-process read cache
+			num_read_cache_hits,
+
 			disk_read_time,
 			disk_write_time,
 			disk_hash_time,
 			disk_job_time,
 
+			// log-scale latency histograms of completed disk jobs, one set
+			// of buckets per job class. Bucket N counts jobs that took less
+			// than 4^N milliseconds (1ms, 4ms, 16ms, 64ms, 256ms, 1s); the
+			// last bucket counts everything slower. The buckets of each
+			// class must stay contiguous and in this order
+			disk_read_lat_1ms,
+			disk_read_lat_4ms,
+			disk_read_lat_16ms,
+			disk_read_lat_64ms,
+			disk_read_lat_256ms,
+			disk_read_lat_1s,
+			disk_read_lat_inf,
+
+			disk_write_lat_1ms,
+			disk_write_lat_4ms,
+			disk_write_lat_16ms,
+			disk_write_lat_64ms,
+			disk_write_lat_256ms,
+			disk_write_lat_1s,
+			disk_write_lat_inf,
+
+			disk_hash_lat_1ms,
+			disk_hash_lat_4ms,
+			disk_hash_lat_16ms,
+			disk_hash_lat_64ms,
+			disk_hash_lat_256ms,
+			disk_hash_lat_1s,
+			disk_hash_lat_inf,
+
+			// log-scale histogram of how late the network thread's tick
+			// timer fired, using the same bucket scheme as the disk job
+			// latency histograms above. Lag in the higher buckets means an
+			// event handler stalled the event loop
+			tick_lag_1ms,
+			tick_lag_4ms,
+			tick_lag_16ms,
+			tick_lag_64ms,
+			tick_lag_256ms,
+			tick_lag_1s,
+			tick_lag_inf,
+
 			waste_piece_timed_out,
 			waste_piece_cancelled,
 			waste_piece_unknown,
@@ -324,6 +368,12 @@ namespace libtorrent {
 			socket_recv_size19,
 			socket_recv_size20,
 
+			// the number of times a peer's send buffer ran dry while
+			// requests were pending and the disk hadn't refilled it yet,
+			// i.e. uploads were capped by send_buffer_watermark rather than
+			// by the link or the peer
+			num_send_buffer_stalls,
+
 			num_stats_counters
 		};
 
@@ -401,6 +451,8 @@ namespace libtorrent {
 			request_latency,
 
 			disk_blocks_in_use,
+			// the number of blocks currently held by the in-process read cache
+			disk_read_cache_blocks,
 			queued_disk_jobs,
 			num_running_disk_jobs,
 			num_read_jobs,
@@ -445,6 +497,12 @@ namespace libtorrent {
 			limiter_up_bytes,
 			limiter_down_bytes,
 
+			// the total number of bytes of socket send and receive buffer
+			// space (SO_SNDBUF / SO_RCVBUF) requested by the per-connection
+			// buffer autotuning
+			socket_send_buffer_bytes,
+			socket_recv_buffer_bytes,
+
 			// the number of uTP connections in each respective state
 			// these must be defined in the same order as the state_t enum
 			// in utp_stream
@@ -459,6 +517,26 @@ namespace libtorrent {
 
 			num_queued_tracker_announces,
 
+			// which SHA-1 implementation the hasher uses on this machine.
+			// The values are the aux::sha1_backend_t enum in hasher.hpp
+			sha1_backend,
+
+			// the approximate number of bytes of heap allocated for piece
+			// picker state, peer list entries and torrent metadata
+			// (torrent_info), summed over all torrents. Updated when
+			// session stats are posted
+			picker_memory,
+			peer_list_memory,
+			metadata_memory,
+
+			// the cumulative number of page faults taken by this process, as
+			// reported by the operating system. Minor faults are served from
+			// memory (e.g. a first touch of an already-cached mapped page),
+			// major faults had to read from disk. Updated when session stats
+			// are posted. 0 on platforms where this can't be queried
+			minor_page_faults,
+			major_page_faults,
+
 			num_counters,
 			num_gauges_counters = num_counters - num_stats_counters
 		};
@@ -485,7 +563,14 @@ namespace libtorrent {
 		// TODO: some space could be saved here by making gauges 32 bits
 		// TODO: restore these to regular integers. Instead have one copy
 		// of the counters per thread and collect them at convenient
-		// synchronization points
+		// synchronization points. Note that this is harder than it sounds:
+		// several counters and gauges are read synchronously and used for
+		// control decisions (e.g. num_unchoke_slots in the unchoke logic),
+		// so they can't be lazily aggregated, and set_value() on gauges
+		// has no meaningful per-thread decomposition. In the meantime the
+		// false sharing is mitigated by the layout: network, disk and
+		// hashing threads mostly increment disjoint index ranges of this
+		// array, so they rarely share cache lines to begin with
 #ifdef ATOMIC_LLONG_LOCK_FREE
 		aux::array<std::atomic<std::int64_t>, num_counters> m_stats_counter;
 #else
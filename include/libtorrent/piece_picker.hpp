@@ -225,6 +225,11 @@ namespace libtorrent {
 		void get_availability(aux::vector<int, piece_index_t>& avail) const;
 		int get_availability(piece_index_t piece) const;
 
+		// fills the vector with the number of pieces at each availability
+		// level. i.e. entry n is the number of pieces n of our peers have.
+		// the vector is sized to the highest availability level plus one
+		void get_availability_histogram(aux::vector<int>& hist) const;
+
 		// increases the peer count for the given piece
 		// (is used when a HAVE message is received)
 		void inc_refcount(piece_index_t, torrent_peer const*);
@@ -282,6 +287,15 @@ namespace libtorrent {
 		// or vice versa
 		bool set_piece_priority(piece_index_t, download_priority_t);
 
+		// applies a whole vector of piece priorities in one call, starting
+		// at the first piece. Equivalent to calling set_piece_priority() on
+		// each piece, except that when many pieces move between priority
+		// buckets, the ordered priority list is rebuilt once afterwards
+		// instead of being restructured for every piece. Returns true if
+		// any piece changed from priority 0 to non-0 or vice versa
+		bool set_piece_priorities(aux::vector<download_priority_t
+			, piece_index_t> const& priorities);
+
 		// returns the priority for the piece at 'index'
 		download_priority_t piece_priority(piece_index_t) const;
 
@@ -517,6 +531,11 @@ namespace libtorrent {
 
 		std::pair<int, int> distributed_copies() const;
 
+		// the number of bytes of heap the picker's internal data
+		// structures occupy. This is an approximation based on container
+		// capacities, used for per-torrent memory accounting
+		std::int64_t memory_usage() const;
+
 		// return the array of block_info objects for a given downloading_piece.
 		// this array has m_blocks_per_piece elements in it
 		span<block_info const> blocks_for_piece(downloading_piece const& dp) const;
@@ -766,6 +785,11 @@ namespace libtorrent {
 		std::vector<downloading_piece>::const_iterator find_dl_piece(download_queue_t, piece_index_t) const;
 		std::vector<downloading_piece>::iterator find_dl_piece(download_queue_t, piece_index_t);
 
+		// re-records, in m_downloads_index, the positions of the entries at
+		// or past ``from`` in the specified queue, after an insert or erase
+		// has shifted them
+		void update_download_index(download_queue_t queue, int from);
+
 		// returns an iterator to the downloading piece, whichever
 		// download list it may live in now
 		std::vector<downloading_piece>::iterator update_piece_state(
@@ -829,7 +853,14 @@ namespace libtorrent {
 
 		// this vector contains all piece indices that are pickable
 		// sorted by priority. Pieces are in random random order
-		// among pieces with the same priority
+		// among pieces with the same priority.
+		// together with m_priority_boundaries this forms the rarity
+		// buckets: each bucket is a contiguous range, a piece's position
+		// is tracked in piece_pos::index, and inc_refcount()/
+		// dec_refcount() move a piece to its neighboring bucket with a
+		// constant number of swaps. Picks iterate buckets in order without
+		// re-deriving any ordering; a full rebuild only happens when
+		// priorities change wholesale (m_dirty)
 		mutable aux::vector<piece_index_t, prio_index_t> m_pieces;
 
 		// these are indices to the priority boundaries inside
@@ -849,6 +880,12 @@ namespace libtorrent {
 			, static_cast<std::uint8_t>(piece_pos::num_download_categories)
 			, download_queue_t> m_downloads;
 
+		// maps piece index to the position of its downloading_piece entry
+		// in whichever m_downloads queue the piece currently lives in (the
+		// queue itself is recorded in piece_pos::download_state). This is
+		// what makes find_dl_piece() constant time
+		std::unordered_map<piece_index_t, int> m_downloads_index;
+
 		// this holds the information of the blocks in partially downloaded
 		// pieces. the downloading_piece::info index point into this vector for
 		// its storage
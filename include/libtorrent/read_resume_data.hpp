@@ -58,6 +58,16 @@ namespace libtorrent {
 	// In order to support large torrents, it may also be necessary to raise the
 	// settings_pack::max_piece_count setting and pass a higher limit to calls
 	// to torrent_info::parse_info_section().
+	//
+	// These functions are pure and reentrant: they touch no shared state,
+	// so clients starting up with a large number of resume files can read
+	// and parse them from as many threads as they like, concurrently with
+	// the session running, and pass the resulting add_torrent_params
+	// objects to session::async_add_torrents(). Where resume files live
+	// and what they are named is client policy, which is why libtorrent
+	// does not offer to load the files itself. For sessions with very
+	// many torrents, resume_data_store offers a single-file alternative
+	// to one resume file per torrent.
 	TORRENT_EXPORT add_torrent_params read_resume_data(bdecode_node const& rd
 		, error_code& ec, int piece_limit = 0x200000);
 	TORRENT_EXPORT add_torrent_params read_resume_data(span<char const> buffer
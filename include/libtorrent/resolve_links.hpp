@@ -49,7 +49,14 @@ namespace libtorrent {
 
 #ifndef TORRENT_DISABLE_MUTABLE_TORRENTS
 	// this class is used for mutable torrents, to discover identical files
-	// in other torrents.
+	// in other torrents. It matches files on disk (by piece hash), it does
+	// not attempt to share in-memory metadata (file_storage, merkle trees)
+	// between torrent_info instances. Torrents whose info dictionaries are
+	// identical have identical info-hashes, and cannot be added to the same
+	// session in the first place. Torrents that merely overlap per-file have
+	// different file_storage contents (paths include the torrent name, and
+	// the piece mapping depends on file order and padding), so there is no
+	// shared immutable structure to collapse.
 	struct TORRENT_EXTRA_EXPORT resolve_links
 	{
 		struct TORRENT_EXTRA_EXPORT link_t
@@ -0,0 +1,156 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef TORRENT_RESUME_DATA_STORE_HPP_INCLUDED
+#define TORRENT_RESUME_DATA_STORE_HPP_INCLUDED
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "libtorrent/config.hpp"
+#include "libtorrent/aux_/export.hpp"
+#include "libtorrent/aux_/file_pointer.hpp"
+#include "libtorrent/error_code.hpp"
+#include "libtorrent/info_hash.hpp"
+#include "libtorrent/span.hpp"
+
+namespace libtorrent {
+
+	// a single-file store for resume data, as an alternative to one file per
+	// torrent. With a large number of torrents, per-torrent resume files make
+	// every checkpoint a metadata-heavy operation (create, write, fsync,
+	// rename) and startup a full directory scan. The store appends each blob
+	// to one journal file instead, so checkpointing a whole session is a
+	// sequential write, and loading is a single sequential read of the
+	// journal.
+	//
+	// The store holds opaque byte buffers keyed by info-hash; the intended
+	// payload is the output of write_resume_data_buf(), loaded back via
+	// read_resume_data(). Superseded and removed records leave dead bytes
+	// behind in the journal. These are reclaimed by compact(), which is also
+	// invoked internally once more than half the journal (and at least 1 MiB)
+	// is dead, so the file size stays proportional to the live data.
+	//
+	// A truncated tail record (e.g. from a crash mid-append) is discarded on
+	// open() and the journal is truncated back to the last intact record.
+	// Every preceding record is unaffected, which is the property that makes
+	// appending cheap: no rename dance is needed for crash safety.
+	//
+	// The store is not thread safe. It is expected to be owned by the thread
+	// that pops alerts (typically feeding it save_resume_data_alert
+	// payloads), and it never blocks on anything but its own file I/O.
+	struct TORRENT_EXPORT resume_data_store
+	{
+		resume_data_store();
+		~resume_data_store();
+		resume_data_store(resume_data_store const&) = delete;
+		resume_data_store& operator=(resume_data_store const&) = delete;
+
+		// opens the journal at the given path, creating it if it does not
+		// exist, and reads it front to back to build the in-memory index
+		// (info-hash and file offset per torrent; the blobs themselves stay
+		// on disk). Fails with ec set if the file cannot be opened or its
+		// header is not a resume journal
+		void open(std::string const& path, error_code& ec);
+
+		// closes the journal file. The store is empty until open() is called
+		// again. Pending appends are flushed to the operating system, but
+		// close() does not fsync; call flush() first if durability is needed
+		void close();
+
+		bool is_open() const { return m_file.file() != nullptr; }
+
+		// appends a record holding the given buffer to the journal, replacing
+		// any previous record for the same info-hash. May trigger a
+		// compaction when enough of the journal is dead bytes
+		void put(info_hash_t const& ih, span<char const> buf, error_code& ec);
+
+		// appends a tombstone record for the given info-hash, so it will no
+		// longer be visible after a reload. Removing an info-hash that is not
+		// in the store is a no-op
+		void remove(info_hash_t const& ih, error_code& ec);
+
+		// reads back the most recent blob stored for the given info-hash. An
+		// empty vector with ec set to boost::system::errc::no_such_file_or_directory
+		// means the info-hash is not in the store
+		std::vector<char> get(info_hash_t const& ih, error_code& ec);
+
+		// calls f once per torrent in the store, with its info-hash and blob.
+		// Records are visited in journal order, so the reads are one
+		// sequential sweep of the file. This is the bulk load path at
+		// startup; the blobs can be handed to worker threads for parsing
+		// (read_resume_data() is reentrant) as they are read
+		void for_each(std::function<void(info_hash_t const&
+			, std::vector<char>)> const& f, error_code& ec);
+
+		// the number of torrents in the store
+		int size() const { return int(m_index.size()); }
+
+		// makes all records appended so far durable (fsync)
+		void flush(error_code& ec);
+
+		// rewrites the journal with only the live records, dropping dead
+		// bytes left by superseded and removed entries. The new journal is
+		// built in a temporary file and atomically renamed into place
+		void compact(error_code& ec);
+
+	private:
+
+		struct record_t
+		{
+			std::int64_t offset;
+			std::int32_t length;
+		};
+
+		// scans the journal building m_index, truncating a torn tail record
+		void load(error_code& ec);
+
+		void append_record(std::uint8_t type, info_hash_t const& ih
+			, span<char const> buf, error_code& ec);
+
+		aux::file_pointer m_file{nullptr};
+		std::string m_path;
+
+		// offset and length of the most recent record per info-hash
+		std::map<info_hash_t, record_t> m_index;
+
+		// the size of the journal and how many of those bytes belong to
+		// superseded or removed records. Their ratio drives compaction
+		std::int64_t m_file_size = 0;
+		std::int64_t m_dead_bytes = 0;
+	};
+}
+
+#endif
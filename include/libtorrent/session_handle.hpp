@@ -233,6 +233,20 @@ namespace libtorrent {
 		// This will cause a dht_stats_alert to be posted.
 		void post_dht_stats();
 
+		// Generates resume data for every torrent in the session, posting a
+		// save_resume_data_alert or save_resume_data_failed_alert per
+		// torrent, just as if torrent_handle::save_resume_data() had been
+		// called on each of them. The ``flags`` argument is also the same.
+		// One call replaces tens of thousands of per-handle round trips to
+		// the session thread when shutting down a large session, and the
+		// alerts are posted as they are generated, so a client can encode
+		// (write_resume_data_buf() is safe to call from several threads on
+		// distinct add_torrent_params) and write the resume files
+		// concurrently with the session tearing down its connections.
+		// Exactly one alert is posted per torrent, which is what to count
+		// when waiting for the flush to complete.
+		void save_all_resume_data(resume_data_flags_t flags = {});
+
 		// internal
 		io_context& get_context();
 
@@ -290,6 +304,14 @@ namespace libtorrent {
 		void async_add_torrent(add_torrent_params&& params);
 		void async_add_torrent(add_torrent_params const& params);
 
+		// Adds a whole batch of torrents in a single call into the session
+		// thread. This is equivalent to calling async_add_torrent() for
+		// each entry, but only pays for one cross-thread post regardless
+		// of how many torrents are added, which matters when loading a
+		// large session at startup. One add_torrent_alert is posted per
+		// torrent, just as with async_add_torrent().
+		void async_add_torrents(std::vector<add_torrent_params> params);
+
 #ifndef BOOST_NO_EXCEPTIONS
 #if TORRENT_ABI_VERSION == 1
 		// deprecated in 0.14
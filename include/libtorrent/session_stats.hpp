@@ -35,7 +35,10 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "libtorrent/config.hpp"
 #include "libtorrent/string_view.hpp"
+#include "libtorrent/span.hpp"
 
+#include <cstdint>
+#include <string>
 #include <vector>
 
 namespace libtorrent {
@@ -74,6 +77,16 @@ namespace libtorrent {
 	// or -1 if it could not be found. The counter index is the index into the
 	// values array returned by session_stats_alert.
 	TORRENT_EXPORT int find_metric_idx(string_view name);
+
+	// renders a session stats sample, ``values``, in the Prometheus text
+	// exposition format. ``values`` is the array of counter and gauge values
+	// posted in a session_stats_alert (i.e. what its counters() member
+	// returns). Metric names have their ``.`` replaced by ``_`` and are
+	// prefixed by ``libtorrent_``, each preceded by a ``# TYPE`` line
+	// declaring it a counter or gauge. The returned string can be served
+	// as-is to a scraper by the client's own HTTP listener.
+	TORRENT_EXPORT std::string prometheus_session_stats(
+		span<std::int64_t const> values);
 }
 
 #endif
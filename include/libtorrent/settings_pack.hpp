@@ -952,6 +952,17 @@ namespace aux {
 			// previously deleted information from the disk.
 			enable_set_file_valid_data,
 
+			// when set, a closed-loop controller continuously adjusts
+			// ``aio_threads``, ``send_buffer_watermark`` and
+			// ``connections_limit`` from observed performance counters
+			// (disk queue depth, send buffer stalls and tick lag), instead
+			// of relying on a static preset. The values configured when the
+			// tuner is enabled act as the operator-set bounds: each knob
+			// only moves within a documented multiple of its configured
+			// value (see ``autotune_interval``). Every adjustment is
+			// reported in an autotune_alert
+			enable_autotune,
+
 			max_bool_setting_internal
 		};
 
@@ -1267,7 +1278,10 @@ namespace aux {
 			// these limits.
 			//
 			// ``active_checking`` is the limit of number of simultaneous checking
-			// torrents.
+			// torrents. The disk I/O of checking torrents is scheduled fairly
+			// between them and yields to the I/O of active torrents, so on
+			// storage with enough parallelism (e.g. SSDs) this can be raised
+			// to speed up mass-rechecks without hurting peers being served.
 			//
 			// ``active_limit`` is a hard limit on the number of active (auto
 			// managed) torrents. This limit also applies to slow torrents.
@@ -1954,6 +1968,116 @@ namespace aux {
 			// torrent_info::parse_info_section(), if those are used.
 			max_piece_count,
 
+			// ``disk_read_cache_size`` is the budget, in 16 kiB blocks, for
+			// the in-process read cache kept by the disk I/O back-end. Blocks
+			// in this cache are served to peers without going back to the
+			// file (or the kernel page cache). Set to 0 to disable the cache.
+			disk_read_cache_size,
+
+			// ``aio_threads_min`` is the number of disk I/O threads to keep
+			// running even when idle. The pool grows on demand up to
+			// ``aio_threads`` and idle threads are reaped over time; this
+			// sets the floor it may shrink back to. Keeping a few threads
+			// warm avoids paying thread start-up cost every time a burst of
+			// disk jobs arrives
+			aio_threads_min,
+
+			// ``disk_write_back_rate`` is the number of bytes per second of
+			// recently written data to hand over to the operating system for
+			// asynchronous write-back. Pacing the flushing of dirty pages
+			// smooths writes into the disk's sustained rate, instead of
+			// letting them accumulate until the kernel flushes them in large
+			// bursts (which spikes read latency). 0 means the operating
+			// system flushes on its own schedule. This is only used by the
+			// memory mapped disk I/O back-end
+			disk_write_back_rate,
+
+			// ``dht_max_concurrent_lookups`` is the maximum number of DHT
+			// lookup traversals (get_peers/announce and friends) to run in
+			// parallel across the whole session. With many torrents, the
+			// announce scheduler holds back further torrent announces while
+			// this many lookups are in flight, instead of flooding the
+			// network (and NAT routers' connection tracking) with
+			// uncoordinated bursts of UDP requests. 0 means unlimited
+			dht_max_concurrent_lookups,
+
+			// if the network thread's tick timer fires later than this
+			// number of milliseconds past its deadline, a performance_alert
+			// with code ``network_thread_stalled`` is posted. A late tick
+			// means some event handler (a disk job completion, an alert
+			// observer, a hostile message burst) stalled the event loop,
+			// which degrades everything the session does. The tick lag is
+			// also always recorded in the ``ses.tick_lag_*`` histogram
+			// counters. 0 disables the alert
+			tick_lag_warning_threshold,
+
+			// the congestion controller to use for uTP connections. The
+			// values are the ``utp_congestion_control_t`` enum.
+			// ``utp_ledbat_pp`` (the default) follows the LEDBAT++ scheme:
+			// it uses a lower delay target, leaves slow-start before the
+			// queue builds to the full target, and periodically slows down
+			// to two packets for two round-trips so the base-delay
+			// measurement recovers from self-induced queueing delay.
+			// ``utp_ledbat`` is the original controller
+			utp_congestion_control,
+
+			// files of at least this many MiB are mapped with a hint to the
+			// kernel to back the mapping with transparent huge pages
+			// (``MADV_HUGEPAGE``). Large hot files cover fewer TLB entries
+			// that way, cutting TLB misses when seeding large amounts of
+			// data. 0 disables the hint. This is only used by the memory
+			// mapped disk I/O back-end, on systems that support it
+			mmap_hugepage_cutoff,
+
+			// files up to this many MiB are mapped with ``MAP_POPULATE``,
+			// pre-faulting the entire mapping when the file is opened
+			// instead of taking a page-fault storm on first access. Mapping
+			// a file this way blocks until the pages are read, so it's only
+			// sensible for files expected to be served in their entirety,
+			// and the limit guards against stalling a disk thread for the
+			// time it takes to read a huge file. 0 (the default) disables
+			// it. This is only used by the memory mapped disk I/O back-end
+			mmap_populate_limit,
+
+			// the number of 16 kiB blocks a single disk read job reads from
+			// storage in one operation. The blocks past the requested one
+			// are handed to the in-memory read cache, so subsequent requests
+			// for them are served without another disk job. The wire
+			// protocol and piece accounting stay at 16 kiB granularity; this
+			// only batches the disk I/O and its per-block bookkeeping. The
+			// default of 4 reads 64 kiB at a time. 1 disables read batching
+			disk_read_coalesce_blocks,
+
+			// the number of seconds between adjustments by the performance
+			// autotuner (see ``enable_autotune``). Each round moves a knob
+			// by at most one step: ``aio_threads`` between its configured
+			// value and 3x that value, ``send_buffer_watermark`` between its
+			// configured value and 4x, and ``connections_limit`` between a
+			// quarter of its configured value and the configured value
+			autotune_interval,
+
+			// the minimum number of queued alerts before the alert notify
+			// function (see session_handle::set_alert_notify()) is called.
+			// The default of 1 notifies on every transition from an empty
+			// to a non-empty alert queue, which under load means one wakeup
+			// of the client's message loop per alert. Raising this delivers
+			// alert bursts in a single wakeup. Threads blocked in
+			// wait_for_alert() are always woken immediately, regardless
+			alert_notify_batch_size,
+
+			// when alert notifications are batched (see
+			// ``alert_notify_batch_size``), an incomplete batch is delivered
+			// once this many milliseconds have passed since its first alert.
+			// The deadline is enforced from the session's tick, so the
+			// effective granularity is ``tick_interval``
+			alert_notify_max_delay,
+
+			// a bitmask of alert categories (the same bits as
+			// ``alert_mask``) that bypass notification batching. An alert in
+			// any of these categories triggers the notify function
+			// immediately. Defaults to the error category
+			alert_notify_bypass_categories,
+
 			max_int_setting_internal
 		};
 
@@ -2016,6 +2140,17 @@ namespace aux {
 			disable_os_cache = 2
 		};
 
+		// the options for settings_pack::utp_congestion_control
+		enum utp_congestion_control_t : std::uint8_t
+		{
+			// the original LEDBAT controller (BEP 29)
+			utp_ledbat = 0,
+
+			// a LEDBAT++-style controller, with modified slow-start and
+			// periodic slowdowns to keep the base-delay measurement honest
+			utp_ledbat_pp = 1
+		};
+
 		enum bandwidth_mixed_algo_t : std::uint8_t
 		{
 			// disables the mixed mode bandwidth balancing
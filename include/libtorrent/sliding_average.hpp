@@ -62,16 +62,29 @@ struct sliding_average
 		Int const deviation = (m_num_samples > 0) ? std::abs(m_mean - s) : 0;
 
 		if (m_num_samples < inverted_gain)
+		{
+			// warming up. The gain is the number of samples we have so far,
+			// so the divisors are only known at run time
 			++m_num_samples;
 
-		m_mean += (s - m_mean) / m_num_samples;
+			m_mean += (s - m_mean) / m_num_samples;
 
-		if (m_num_samples > 1) {
-			// the exact same thing for deviation off the mean except -1 on
-			// the samples, because the number of deviation samples always lags
-			// behind by 1 (you need to actual samples to have a single deviation
-			// sample).
-			m_average_deviation += (deviation - m_average_deviation) / (m_num_samples - 1);
+			if (m_num_samples > 1) {
+				// the exact same thing for deviation off the mean except -1 on
+				// the samples, because the number of deviation samples always lags
+				// behind by 1 (you need to actual samples to have a single deviation
+				// sample).
+				m_average_deviation += (deviation - m_average_deviation) / (m_num_samples - 1);
+			}
+		}
+		else
+		{
+			// steady state. The divisors are compile time constants here,
+			// which lets the compiler strength-reduce the divisions into
+			// multiply and shift. This is the path taken for every sample
+			// past the first inverted_gain ones, e.g. each packet's RTT
+			m_mean += (s - m_mean) / inverted_gain;
+			m_average_deviation += (deviation - m_average_deviation) / (inverted_gain - 1);
 		}
 	}
 
@@ -190,6 +190,61 @@ struct udp : boost::asio::ip::udp {
 		tos_t m_value;
 	};
 
+#ifdef TCP_FASTOPEN
+	// enables TCP fast open on a listen socket. The value is the length of
+	// the queue of connections whose cookie validation is still pending
+	struct tcp_fastopen
+	{
+		explicit tcp_fastopen(int val) : m_value(val) {}
+		template<class Protocol>
+		int level(Protocol const&) const { return IPPROTO_TCP; }
+		template<class Protocol>
+		int name(Protocol const&) const { return TCP_FASTOPEN; }
+		template<class Protocol>
+		int const* data(Protocol const&) const { return &m_value; }
+		template<class Protocol>
+		size_t size(Protocol const&) const { return sizeof(m_value); }
+		int m_value;
+	};
+#endif
+
+#ifdef TCP_FASTOPEN_CONNECT
+	// enables transparent TCP fast open on an outgoing socket. When the
+	// kernel has a cached cookie for the destination, the first bytes
+	// written are carried in the SYN
+	struct tcp_fastopen_connect
+	{
+		explicit tcp_fastopen_connect(bool val) : m_value(val) {}
+		template<class Protocol>
+		int level(Protocol const&) const { return IPPROTO_TCP; }
+		template<class Protocol>
+		int name(Protocol const&) const { return TCP_FASTOPEN_CONNECT; }
+		template<class Protocol>
+		int const* data(Protocol const&) const { return &m_value; }
+		template<class Protocol>
+		size_t size(Protocol const&) const { return sizeof(m_value); }
+		int m_value;
+	};
+#endif
+
+#ifdef TCP_DEFER_ACCEPT
+	// defer waking up the accepting process until data has arrived on the
+	// connection. The value is the maximum time to defer, in seconds
+	struct tcp_defer_accept
+	{
+		explicit tcp_defer_accept(int val) : m_value(val) {}
+		template<class Protocol>
+		int level(Protocol const&) const { return IPPROTO_TCP; }
+		template<class Protocol>
+		int name(Protocol const&) const { return TCP_DEFER_ACCEPT; }
+		template<class Protocol>
+		int const* data(Protocol const&) const { return &m_value; }
+		template<class Protocol>
+		size_t size(Protocol const&) const { return sizeof(m_value); }
+		int m_value;
+	};
+#endif
+
 #if defined IP_DONTFRAG || defined IP_MTU_DISCOVER || defined IP_DONTFRAGMENT
 #define TORRENT_HAS_DONT_FRAGMENT
 #endif
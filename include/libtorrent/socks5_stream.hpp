@@ -93,6 +93,14 @@ inline boost::system::error_category& get_socks_category()
 { return socks_category(); }
 #endif
 
+// each outgoing TCP connection through the proxy performs its own SOCKS5
+// handshake on the stream it's established over. That's inherent to the
+// protocol: a CONNECT request binds the destination at handshake time and
+// the same TCP connection then carries the payload, so there is no
+// separate control channel whose authentication could be shared, and an
+// idle pre-authenticated connection can't be repurposed for a peer we
+// didn't know about when it was set up. UDP is different; see the socks5
+// struct in udp_socket.cpp for the shared UDP ASSOCIATE tunnel
 class socks5_stream : public proxy_base
 {
 public:
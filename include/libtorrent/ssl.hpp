@@ -177,6 +177,28 @@ TORRENT_EXTRA_EXPORT void set_context(stream_handle_type s, context_handle_type
 TORRENT_EXTRA_EXPORT bool has_context(stream_handle_type s, context_handle_type c);
 TORRENT_EXTRA_EXPORT context_handle_type get_context(stream_handle_type s);
 
+// attaches a client-side TLS session cache to this context, bounded to
+// max_sessions entries (LRU). Streams created from the context that are
+// primed with prime_client_session() will have the session they negotiate
+// cached, keyed by the prime string, for later resumption. The cache lives
+// and dies with the context and is not thread safe; it's meant for
+// contexts whose streams are all driven by the network thread.
+// Only implemented for OpenSSL; with GnuTLS this is a no-op and every
+// handshake is a full one
+TORRENT_EXTRA_EXPORT void enable_client_session_cache(context& ctx
+	, int max_sessions = 512);
+
+// call before initiating a client handshake on s. If the context's session
+// cache (see enable_client_session_cache()) holds a session under this
+// key, the stream offers it for resumption, turning the handshake into an
+// abbreviated one. The session negotiated by the handshake is stored in
+// the cache under the same key. Keys are typically the host name the
+// connection is for, or the remote endpoint when there is no meaningful
+// host name. A cached session is only offered once (TLS 1.3 tickets are
+// single-use); the server hands out a fresh ticket on each connection
+TORRENT_EXTRA_EXPORT void prime_client_session(stream_handle_type s
+	, context_handle_type c, std::string const& key);
+
 } // ssl
 } // libtorrent
 
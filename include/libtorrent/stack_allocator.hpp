@@ -82,12 +82,23 @@ namespace aux {
 		allocation_slot allocate(int bytes);
 		char* ptr(allocation_slot idx);
 		char const* ptr(allocation_slot idx) const;
+
+		// the number of bytes currently allocated from this stack. Sampling
+		// this around an allocation yields the size of that allocation
+		int size() const { return int(m_storage.size()); }
+
 		void swap(stack_allocator& rhs);
 		void reset();
 
 	private:
 
 		vector<char> m_storage;
+
+		// decaying high-water mark of storage actually used between calls to
+		// reset(). Used to release excess capacity left behind by a one-off
+		// burst of alerts, while letting steady-state bursts recycle their
+		// buffer allocation-free
+		int m_watermark = 0;
 	};
 
 }
@@ -106,6 +106,13 @@ namespace libtorrent {
 		std::int32_t m_5_sec_average;
 	};
 
+	// a set of transfer accounting channels for one peer connection, torrent
+	// or session. These are not rolled up by walking children at tick time;
+	// every transfer is recorded at write time in the stat object at each
+	// level (peer_connection::sent_bytes() forwards to the torrent, which
+	// forwards to the session), all on the network thread. The per-second
+	// tick only rotates each object's rate windows, and only for torrents in
+	// the want-tick list, so idle torrents cost nothing
 	class TORRENT_EXTRA_EXPORT stat
 	{
 	public:
@@ -58,6 +58,13 @@ namespace libtorrent {
 		std::int64_t get_filesize(file_index_t i, file_storage const& fs
 			, std::string const& save_path, error_code& ec);
 
+		// stat all files that aren't already in the cache, in a single pass.
+		// Consecutive files in the same directory are stat'ed relative to a
+		// cached directory descriptor, where supported, so each directory is
+		// only resolved once. Call this before a burst of get_filesize()
+		// calls (e.g. checking resume data for a freshly added torrent)
+		void bulk_stat(file_storage const& fs, std::string const& save_path);
+
 		void set_dirty(file_index_t i);
 
 		void clear();
@@ -118,6 +118,7 @@ namespace libtorrent {
 	class http_parser;
 	struct tracker_request;
 	struct bt_peer_connection;
+	struct torrent_peer_allocator;
 
 	using web_seed_flag_t = flags::bitfield_flag<std::uint8_t, struct web_seed_flag_tag>;
 
@@ -263,6 +264,18 @@ namespace libtorrent {
 
 		// TODO: make this a raw pointer. perhaps keep the shared_ptr
 		// around further down the object to maintain an owner
+		// this object pins the full metadata (info section buffer, file
+		// tree, v1 piece hashes) for the torrent's lifetime. libtorrent
+		// 1.x had an "unload" feature that evicted metadata of dormant
+		// torrents and reloaded it on demand; it was removed deliberately,
+		// because handing out shared_ptr/reference views of torrent_info
+		// through the public API (torrent_handle::torrent_file(), alerts,
+		// extensions) makes eviction unsound, and every reload had to
+		// re-parse and re-validate against the info-hash anyway. Sessions
+		// with very large mostly-idle fleets should keep dormant torrents
+		// removed and re-add them from resume data on demand, which is the
+		// same tradeoff with the bookkeeping in the client, where the
+		// policy belongs
 		std::shared_ptr<torrent_info> m_torrent_file;
 
 		// a back reference to the session
@@ -333,6 +346,12 @@ namespace libtorrent {
 		// the state of this torrent (queued, checking, downloading, etc.)
 		std::uint32_t m_state:3;
 
+		// each torrent has its own peer allocator, so that its peers are
+		// contiguous in memory and can be released wholesale when the
+		// torrent is removed. Declared before m_peer_list since the
+		// peer_list frees its peers into it on destruction
+		std::unique_ptr<torrent_peer_allocator> m_peer_allocator;
+
 		std::unique_ptr<peer_list> m_peer_list;
 	};
 
@@ -426,6 +445,10 @@ namespace libtorrent {
 		void files_checked();
 		void start_checking();
 
+		// marks the piece at m_checking_piece as passed without re-hashing
+		// it, because its bit is set in m_trusted_pieces
+		void skip_trusted_piece();
+
 		void start_announcing();
 		void stop_announcing();
 
@@ -466,6 +489,17 @@ namespace libtorrent {
 		void on_disk_read_complete(disk_buffer_holder, storage_error const&
 			, peer_request const&, std::shared_ptr<read_piece_struct>);
 
+		struct read_piece_blocks_struct
+		{
+			std::vector<disk_buffer_holder> blocks;
+			int blocks_left;
+			bool fail;
+			error_code error;
+		};
+		void read_piece_blocks(piece_index_t);
+		void on_disk_read_blocks_complete(disk_buffer_holder, storage_error const&
+			, peer_request const&, std::shared_ptr<read_piece_blocks_struct>);
+
 		storage_mode_t storage_mode() const;
 
 		// this will flag the torrent as aborted. The main
@@ -564,11 +598,11 @@ namespace libtorrent {
 		void force_recheck();
 		void save_resume_data(resume_data_flags_t flags);
 
-		bool need_save_resume_data() const { return m_need_save_resume_data; }
+		bool need_save_resume_data() const { return bool(m_need_save_resume_data); }
 
-		void set_need_save_resume()
+		void set_need_save_resume(resume_data_flags_t const flag)
 		{
-			m_need_save_resume_data = true;
+			m_need_save_resume_data |= flag;
 		}
 
 		bool is_auto_managed() const { return m_auto_managed; }
@@ -586,6 +620,7 @@ namespace libtorrent {
 #endif // TORRENT_ABI_VERSION
 
 		void piece_availability(aux::vector<int, piece_index_t>& avail) const;
+		void piece_availability_histogram(aux::vector<int>& hist) const;
 
 		void set_piece_priority(piece_index_t index, download_priority_t priority);
 		download_priority_t piece_priority(piece_index_t index) const;
@@ -606,6 +641,8 @@ namespace libtorrent {
 		void set_piece_deadline(piece_index_t piece, int t, deadline_flags_t flags);
 		void reset_piece_deadline(piece_index_t piece);
 		void clear_time_critical();
+		void set_streaming_cursor(std::int64_t offset);
+		void clear_streaming_cursor();
 #endif // TORRENT_DISABLE_STREAMING
 
 		void update_piece_priorities(
@@ -613,6 +650,15 @@ namespace libtorrent {
 
 		void status(torrent_status* st, status_flags_t flags);
 
+		// the approximate heap usage of the torrent's subsystems, for the
+		// memory accounting in torrent_status and the session-wide gauges
+		std::int64_t picker_memory_usage() const
+		{ return m_picker ? m_picker->memory_usage() : 0; }
+		std::int64_t peer_list_memory_usage() const
+		{ return m_peer_list ? m_peer_list->memory_usage() : 0; }
+		std::int64_t metadata_memory_usage() const
+		{ return valid_metadata() ? m_torrent_file->memory_usage() : 0; }
+
 		// this torrent changed state, if the user is subscribing to
 		// it, add it to the m_state_updates list in session_impl
 		void state_updated();
@@ -1151,6 +1197,23 @@ namespace libtorrent {
 		{ return m_verified.get_bit(piece); }
 		void verified(piece_index_t piece);
 
+		// applies the outcome of a seed-mode hash job to the verified
+		// state. shared between request-triggered verification
+		// (peer_connection) and the background verifier. returns true if
+		// the piece was verified successfully, false if it failed and we
+		// left seed mode (or the torrent errored)
+		bool seed_mode_piece_hashed(piece_index_t piece, sha1_hash const& piece_hash
+			, aux::vector<sha256_hash> const& block_hashes);
+
+		// starts one background hash job for the next unverified piece, if
+		// we're in seed mode and no background job is in flight. This slowly
+		// walks the whole torrent so long-running seed-mode torrents
+		// converge to fully verified, without waiting for peers to request
+		// every piece
+		void kick_background_verification();
+		void on_background_seed_hash(piece_index_t piece, sha1_hash const& piece_hash
+			, aux::vector<sha256_hash> block_hashes, storage_error const& error);
+
 		// this is called once periodically for torrents
 		// that are not private
 		void lsd_announce();
@@ -1355,8 +1418,29 @@ namespace libtorrent {
 		aux::vector<aux::announce_entry> m_trackers;
 
 #ifndef TORRENT_DISABLE_STREAMING
-		// this list is sorted by time_critical_piece::deadline
+		// this list is sorted by time_critical_piece::deadline. It is
+		// effectively an earliest-deadline-first queue: insertions binary
+		// search for their slot, deadline adjustments bubble the entry to
+		// its new position, and the request logic consumes entries from
+		// the front. The list only ever holds the pieces inside the
+		// player's deadline window, so a contiguous sorted vector beats a
+		// heap both on lookup (erase by piece index is common) and on
+		// iteration order
 		std::vector<time_critical_piece> m_time_critical_pieces;
+
+		// the byte offset into the torrent a streaming consumer has read
+		// up to, or -1 when no cursor is set. The deadline window is
+		// maintained relative to this offset
+		std::int64_t m_streaming_cursor = -1;
+
+		// the time the cursor was last advanced. Together with the byte
+		// distance the cursor moved, this is used to estimate the
+		// consumption rate
+		time_point m_streaming_cursor_time = min_time();
+
+		// exponentially smoothed estimate of how fast the consumer reads,
+		// in bytes per second. 0 until we've seen two cursor updates
+		std::int64_t m_streaming_rate = 0;
 #endif
 
 		std::string m_trackerid;
@@ -1398,6 +1482,17 @@ namespace libtorrent {
 		// to verify each piece that has a 1
 		typed_bitfield<piece_index_t> m_verifying;
 
+		// the next piece the background seed-mode verifier will consider.
+		// every piece below this has either been verified, or has a hash
+		// job in flight. only used in seed mode
+		piece_index_t m_verify_cursor{0};
+
+		// true while the background seed-mode verifier has a hash job
+		// outstanding. It never has more than one, to keep background
+		// verification from competing with request-triggered hash checks
+		// for disk time
+		bool m_background_verifying = false;
+
 		// set if there's an error on this torrent
 		error_code m_error;
 
@@ -1472,6 +1567,12 @@ namespace libtorrent {
 		// the number of pieces we completed the check of
 		piece_index_t m_num_checked_pieces{0};
 
+		// pieces that don't need to be re-hashed while checking, because the
+		// resume data proved (via per-file size/mtime fingerprints) that the
+		// files containing them are unchanged since the resume data was
+		// written. Only non-empty while checking
+		typed_bitfield<piece_index_t> m_trusted_pieces;
+
 		// if the error occurred on a file, this is the index of that file
 		// there are a few special cases, when this is negative. See
 		// set_error()
@@ -1608,10 +1709,6 @@ namespace libtorrent {
 		// from a non-downloading/seeding state, the torrent is paused.
 		bool m_stop_when_ready:1;
 
-		// set to false when saving resume data. Set to true
-		// whenever something is downloaded
-		bool m_need_save_resume_data:1;
-
 		// when this is true, this torrent participates in the DHT
 		bool m_enable_dht:1;
 
@@ -1632,7 +1729,11 @@ namespace libtorrent {
 		// the maximum number of uploads for this torrent
 		std::uint32_t m_max_uploads:24;
 
-		// 8 bits free
+		// cleared when saving resume data. Each flag is set whenever the
+		// corresponding part of the resume data is changed, so that
+		// save_resume_data() can tell whether a new checkpoint is warranted.
+		// The flags are the torrent_handle::if_* resume_data_flags_t bits
+		resume_data_flags_t m_need_save_resume_data{};
 
 // ----
 
@@ -299,6 +299,14 @@ namespace aux {
 		// guaranteed to finish in the same order as you initiated them.
 		void read_piece(piece_index_t piece) const;
 
+		// Like read_piece(), but the resulting read_piece_blocks_alert hands
+		// over the disk buffers the piece was read into rather than copying
+		// the data into a single contiguous buffer. This avoids one copy of
+		// every byte of the piece, which matters when serving piece data at
+		// high rates. The buffers are held by the alert and returned to the
+		// disk subsystem when the alert is popped.
+		void read_piece_blocks(piece_index_t piece) const;
+
 		// Returns true if this piece has been completely downloaded and written
 		// to disk, and false otherwise.
 		bool have_piece(piece_index_t piece) const;
@@ -342,6 +350,16 @@ namespace aux {
 		// includes ``save_path``, the path to the directory the files of the
 		// torrent are saved to.
 		static constexpr status_flags_t query_save_path = 7_bit;
+		// includes ``current_tracker``. Populating it copies a URL string
+		// and, when no tracker has responded yet, scans the tracker list.
+		// status loops that poll many torrents for rates and state can
+		// leave this flag out to avoid that work.
+		static constexpr status_flags_t query_current_tracker = 8_bit;
+		// includes the ``*_memory_usage`` and ``queued_write_bytes``
+		// members. Computing them walks the torrent's internal containers
+		// and peer connections, so status loops that don't do memory
+		// accounting should leave this flag out.
+		static constexpr status_flags_t query_memory_usage = 9_bit;
 
 		// ``status()`` will return a structure with information about the status
 		// of this torrent. If the torrent_handle is invalid, it will throw
@@ -393,6 +411,22 @@ namespace aux {
 		void reset_piece_deadline(piece_index_t index) const;
 		void clear_piece_deadlines() const;
 
+		// ``set_streaming_cursor()`` is a convenience layer on top of
+		// piece deadlines for feeding a sequential consumer, such as a
+		// media player. ``offset`` is the byte offset into the torrent the
+		// consumer has read up to. Call it periodically as playback
+		// advances (and on seeks). libtorrent estimates the consumption
+		// rate from successive calls and maintains a deadline window ahead
+		// of the cursor sized to the rate, with deadlines matching when
+		// each piece is expected to be consumed. Deadlines behind the
+		// cursor are cancelled, so requests aren't wasted on data that has
+		// already been played.
+		//
+		// ``clear_streaming_cursor()`` stops streaming mode and removes
+		// all deadlines, like clear_piece_deadlines().
+		void set_streaming_cursor(std::int64_t offset) const;
+		void clear_streaming_cursor() const;
+
 #if TORRENT_ABI_VERSION == 1
 		// This sets the bandwidth priority of this torrent. The priority of a
 		// torrent determines how much bandwidth its peers are assigned when
@@ -645,6 +679,33 @@ namespace aux {
 		// resume_data_not_modified.
 		static constexpr resume_data_flags_t only_if_modified = 2_bit;
 
+		// these flags make the ``only_if_modified`` check more fine grained.
+		// When any of them is specified, only changes to the corresponding
+		// parts of the resume data count as "modified". This makes it cheap
+		// to run frequent periodic checkpoints that skip torrents where only
+		// uninteresting fields (like the transfer counters) have changed.
+
+		// the stats counters, like the total amount of payload uploaded and
+		// downloaded, changed
+		static constexpr resume_data_flags_t if_counters_changed = 3_bit;
+
+		// the download progressed. i.e. we downloaded and verified more
+		// pieces, or completed checking files
+		static constexpr resume_data_flags_t if_download_progress = 4_bit;
+
+		// the configuration of the torrent changed. e.g. rate- and connection
+		// limits, file- and piece priorities, trackers, web seeds or the save
+		// path
+		static constexpr resume_data_flags_t if_config_changed = 5_bit;
+
+		// the state of the torrent changed. e.g. it was paused, resumed or
+		// its auto-managed flag was toggled
+		static constexpr resume_data_flags_t if_state_changed = 6_bit;
+
+		// we received the metadata (info dictionary) for the torrent. This is
+		// mostly relevant for torrents added by magnet link
+		static constexpr resume_data_flags_t if_metadata_changed = 7_bit;
+
 		// ``save_resume_data()`` asks libtorrent to generate fast-resume data for
 		// this torrent.
 		//
@@ -960,6 +1021,15 @@ namespace aux {
 		// that libtorrent uses in order to prefer picking rare pieces.
 		void piece_availability(std::vector<int>& avail) const;
 
+		// Fills the specified ``std::vector<int>`` with the piece
+		// availability distribution: entry *n* is the number of pieces that
+		// *n* of our connected peers have advertised. The vector is sized
+		// to the highest availability level plus one. This is a lot cheaper
+		// than calling piece_availability() and computing the distribution
+		// client-side, since only the small histogram is copied out of the
+		// network thread.
+		void piece_availability_histogram(std::vector<int>& hist) const;
+
 		// These functions are used to set and get the priority of individual
 		// pieces. By default all pieces have priority 4. That means that the
 		// random rarest first algorithm is effectively active for all pieces.
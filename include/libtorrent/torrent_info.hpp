@@ -136,6 +136,12 @@ namespace aux {
 		// the max number of pieces allowed in the torrent
 		int max_pieces = 0x200000;
 
+		// the max number of files allowed in the torrent. Building the
+		// in-memory file list is proportional to the number of files, so
+		// this bounds the memory a hostile or degenerate (v2) torrent can
+		// make us commit before we get a chance to inspect it
+		int max_file_count = 0x100000;
+
 		// the max recursion depth in the bdecoded structure
 		int max_decode_depth = 100;
 
@@ -574,6 +580,12 @@ TORRENT_VERSION_NAMESPACE_3
 		span<char const> info_section() const
 		{ return span<char const>(m_info_section.get(), m_info_section_size); }
 
+		// the approximate number of bytes of heap this torrent_info
+		// occupies, including the info section buffer, the file list,
+		// trackers and piece layers. Used for per-torrent memory
+		// accounting
+		std::int64_t memory_usage() const;
+
 #if TORRENT_ABI_VERSION <= 2
 		// swap the content of this and ``ti``.
 		TORRENT_DEPRECATED
@@ -631,7 +643,11 @@ TORRENT_VERSION_NAMESPACE_3
 		// populate the piece layers from the metadata
 		bool parse_piece_layers(bdecode_node const& e, error_code& ec);
 
-		bool parse_torrent_file(bdecode_node const& torrent_file, error_code& ec, int piece_limit);
+		bool parse_torrent_file(bdecode_node const& torrent_file, error_code& ec
+			, load_torrent_limits const& cfg);
+
+		bool parse_info_section_impl(bdecode_node const& info, error_code& ec
+			, int max_pieces, int max_file_count);
 
 		void resolve_duplicate_filenames();
 
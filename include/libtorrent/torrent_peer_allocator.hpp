@@ -55,6 +55,11 @@ namespace libtorrent {
 
 		virtual torrent_peer* allocate_peer_entry(int type) = 0;
 		virtual void free_peer_entry(torrent_peer* p) = 0;
+
+		// release every live allocation in one go, without walking the
+		// objects. No destructors are run, so any entries that own heap
+		// allocations (i2p_peer) must be freed individually first
+		virtual void free_all_peer_entries() = 0;
 	protected:
 		~torrent_peer_allocator_interface() {}
 	};
@@ -70,6 +75,7 @@ namespace libtorrent {
 
 		torrent_peer* allocate_peer_entry(int type) override;
 		void free_peer_entry(torrent_peer* p) override;
+		void free_all_peer_entries() override;
 
 		std::uint64_t total_bytes() const { return m_total_bytes; }
 		std::uint64_t total_allocations() const { return m_total_allocations; }
@@ -78,10 +84,13 @@ namespace libtorrent {
 
 	private:
 
-		// this is a shared pool where torrent_peer objects
-		// are allocated. It's a pool since we're likely
-		// to have tens of thousands of peers, and a pool
-		// saves significant overhead
+		// this is a pool where torrent_peer objects are allocated. It's a
+		// pool since we're likely to have tens of thousands of peers, and a
+		// pool saves significant overhead. Each torrent has its own
+		// allocator, so its peers are contiguous in the pool's slabs (good
+		// for the linear scans peer_list does over them) and tearing a
+		// torrent down releases the slabs wholesale instead of freeing
+		// 100k entries one by one
 
 		boost::pool<> m_ipv4_peer_pool{sizeof(libtorrent::ipv4_peer), 500};
 		boost::pool<> m_ipv6_peer_pool{sizeof(libtorrent::ipv6_peer), 500};
@@ -589,6 +589,17 @@ TORRENT_VERSION_NAMESPACE_3
 		// reflects several of the torrent's flags. For more
 		// information, see ``torrent_handle::flags()``.
 		torrent_flags_t flags{};
+
+		// the approximate number of bytes of heap memory attributable to
+		// this torrent, broken down by subsystem: the piece picker's
+		// state, the list of known peers, the torrent metadata
+		// (torrent_info) and payload blocks queued for writing to disk.
+		// These are only populated when calling torrent_handle::status()
+		// with the query_memory_usage flag set
+		std::int64_t picker_memory_usage = 0;
+		std::int64_t peer_list_memory_usage = 0;
+		std::int64_t metadata_memory_usage = 0;
+		std::int64_t queued_write_bytes = 0;
 	};
 
 TORRENT_VERSION_NAMESPACE_3_END
@@ -90,6 +90,11 @@ namespace aux { struct alert_manager; }
 			error_code error;
 		};
 
+		// the number of packets we attempt to drain from the socket in a
+		// single call to read(). This is also the number of receive buffers
+		// we keep, since each returned packet needs its own buffer
+		static constexpr int max_packets_per_read = 50;
+
 		int read(span<packet> pkts, error_code& ec);
 
 		// this is only valid when using a socks5 proxy
@@ -154,7 +159,7 @@ namespace aux { struct alert_manager; }
 
 		io_context& m_ioc;
 
-		using receive_buffer = std::array<char, 1500>;
+		using receive_buffer = std::array<std::array<char, 1500>, max_packets_per_read>;
 		std::unique_ptr<receive_buffer> m_buf;
 		aux::listen_socket_handle m_listen_socket;
 
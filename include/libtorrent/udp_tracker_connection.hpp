@@ -113,6 +113,13 @@ namespace libtorrent {
 		{
 			std::int64_t connection_id;
 			time_point expires;
+			// when an announce to this endpoint times out, this is set a
+			// short while into the future. Until then, other announces to
+			// the same tracker fail immediately rather than each waiting
+			// out its own timeout. With many torrents on one tracker, the
+			// first announce learns the tracker is down on behalf of all
+			// of them
+			time_point unreachable_until;
 		};
 
 		static std::map<address, connection_cache_entry> m_connection_cache;
@@ -0,0 +1,161 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "test.hpp"
+#include "utils.hpp"
+#include "libtorrent/alert.hpp"
+#include "libtorrent/alert_types.hpp"
+#include "libtorrent/session.hpp"
+#include "libtorrent/settings_pack.hpp"
+#include "libtorrent/add_torrent_params.hpp"
+#include "libtorrent/torrent_status.hpp"
+#include "create_torrent.hpp"
+#include "settings.hpp"
+#include "fake_peer.hpp"
+#include "setup_transfer.hpp" // for ep()
+#include "simulator/utils.hpp"
+
+#include <cstdio> // for snprintf
+#include <ctime> // for clock
+#include <memory>
+#include <vector>
+
+// a deterministic scalability scenario. The functional swarm tests use a
+// handful of peers, which never exercises the algorithmic scaling of
+// piece_picker, peer_list and the choker. This connects a large number
+// of scripted peers (with deterministic, skewed piece availability) to a
+// single session and asserts that the peer bookkeeping stays within its
+// configured bounds and that the whole run stays within a generous CPU
+// budget. The CPU bound is a canary for super-linear blowups (an O(n^2)
+// pass over the peer list trips it by an order of magnitude), not a
+// precise performance assertion. When investigating scaling behavior,
+// bump num_peers to 10000 and run it manually; the default is sized for
+// the CI time budget
+
+namespace {
+
+// every fake peer gets a distinct IP, so the peer list treats them as
+// distinct peers
+std::string peer_ip(int const i)
+{
+	char buf[30];
+	std::snprintf(buf, sizeof(buf), "60.0.%d.%d", (i >> 8) + 1, i & 0xff);
+	return buf;
+}
+
+} // anonymous namespace
+
+TORRENT_TEST(large_swarm)
+{
+	int const num_peers = 1000;
+	int const num_pieces = 500;
+
+	sim::default_config cfg;
+	sim::simulation sim{cfg};
+
+	sim::asio::io_context ios(sim, lt::make_address_v4("50.0.0.1"));
+	lt::session_proxy zombie;
+
+	lt::settings_pack pack = settings();
+	pack.set_str(lt::settings_pack::listen_interfaces, "0.0.0.0:6881");
+	pack.set_int(lt::settings_pack::connections_limit, num_peers + 100);
+	pack.set_int(lt::settings_pack::max_peerlist_size, num_peers + 100);
+
+	std::shared_ptr<lt::session> ses = std::make_shared<lt::session>(pack, ios);
+
+	std::vector<std::unique_ptr<fake_peer>> peers;
+	peers.reserve(std::size_t(num_peers));
+	for (int i = 0; i < num_peers; ++i)
+		peers.push_back(std::make_unique<fake_peer>(sim, peer_ip(i).c_str()));
+
+	lt::add_torrent_params params = ::create_torrent(0, false, num_pieces);
+	params.flags &= ~lt::torrent_flags::auto_managed;
+	params.flags &= ~lt::torrent_flags::paused;
+	ses->async_add_torrent(params);
+
+	int num_connected = 0;
+	int list_peers = 0;
+
+	print_alerts(*ses, [&](lt::session&, lt::alert const* a) {
+		auto const* at = lt::alert_cast<lt::add_torrent_alert>(a);
+		if (at == nullptr) return;
+		lt::torrent_handle h = at->handle;
+		lt::sha1_hash const ih = h.torrent_file()->info_hashes().v1;
+		for (int i = 0; i < num_peers; ++i)
+		{
+			// a deterministic, skewed availability distribution, so
+			// rarest-first has real work to do across a large swarm
+			std::vector<bool> pieces(std::size_t(num_pieces));
+			for (int p = 0; p < num_pieces; ++p)
+				pieces[std::size_t(p)] = ((i * 7919 + p) % 4) != 0;
+			peers[std::size_t(i)]->send_bitfield(pieces);
+			peers[std::size_t(i)]->send_interested();
+			peers[std::size_t(i)]->connect_to(ep("50.0.0.1", 6881), ih);
+		}
+	});
+
+	// let the session tick with the full swarm connected for a while. This
+	// is where the choker and the picker do per-peer work every tick
+	sim::timer t(sim, lt::seconds(30)
+		, [&](boost::system::error_code const&)
+	{
+		for (auto const& p : peers)
+			num_connected += p->connected() && !p->disconnected();
+
+		lt::torrent_status const st = ses->get_torrents().at(0).status();
+		list_peers = st.list_peers;
+
+		// shut down
+		zombie = ses->abort();
+		for (auto& p : peers) p->close();
+		ses.reset();
+	});
+
+	std::clock_t const start_cpu = std::clock();
+	sim.run();
+	double const cpu_seconds
+		= double(std::clock() - start_cpu) / CLOCKS_PER_SEC;
+
+	std::printf("connected: %d list_peers: %d cpu: %.2fs (%.2fms per peer)\n"
+		, num_connected, list_peers, cpu_seconds
+		, cpu_seconds * 1000.0 / num_peers);
+
+	// the swarm actually has to form for the run to mean anything
+	TEST_CHECK(num_connected >= num_peers * 9 / 10);
+
+	// the peer list must respect its configured cap
+	TEST_CHECK(list_peers <= num_peers + 100);
+
+	// canary bound, with an order of magnitude of headroom over what this
+	// scenario costs on a developer machine
+	TEST_CHECK(cpu_seconds < 60.0);
+}
@@ -346,7 +346,8 @@ namespace libtorrent {
 			"outstanding AIO operations limit reached",
 			"",
 			"too few ports allowed for outgoing connections",
-			"too few file descriptors are allowed for this process. connection limit lowered"
+			"too few file descriptors are allowed for this process. connection limit lowered",
+			"the network thread event loop stalled"
 		};
 
 		TORRENT_ASSERT(i >= 0);
@@ -3041,6 +3042,63 @@ namespace {
 #endif
 	}
 
+	read_piece_blocks_alert::read_piece_blocks_alert(aux::stack_allocator& alloc
+		, torrent_handle const& h
+		, piece_index_t p, std::vector<disk_buffer_holder> bufs, int s)
+		: torrent_alert(alloc, h)
+		, buffers(std::move(bufs))
+		, piece(p)
+		, size(s)
+	{}
+
+	read_piece_blocks_alert::read_piece_blocks_alert(aux::stack_allocator& alloc
+		, torrent_handle h, piece_index_t p, error_code e)
+		: torrent_alert(alloc, h)
+		, error(e)
+		, piece(p)
+		, size(0)
+	{}
+
+	std::string read_piece_blocks_alert::message() const
+	{
+#ifdef TORRENT_DISABLE_ALERT_MSG
+		return {};
+#else
+		char msg[200];
+		if (error)
+		{
+			std::snprintf(msg, sizeof(msg), "%s: read_piece_blocks %d failed: %s"
+				, torrent_alert::message().c_str(), static_cast<int>(piece)
+				, convert_from_native(error.message()).c_str());
+		}
+		else
+		{
+			std::snprintf(msg, sizeof(msg), "%s: read_piece_blocks %d successful"
+				, torrent_alert::message().c_str(), static_cast<int>(piece));
+		}
+		return msg;
+#endif
+	}
+
+	autotune_alert::autotune_alert(aux::stack_allocator&
+		, int const s, int const prev, int const val)
+		: tuned_setting(s)
+		, prev_value(prev)
+		, new_value(val)
+	{}
+
+	std::string autotune_alert::message() const
+	{
+#ifdef TORRENT_DISABLE_ALERT_MSG
+		return {};
+#else
+		char msg[200];
+		std::snprintf(msg, sizeof(msg), "autotune: %s: %d -> %d"
+			, name_for_setting(tuned_setting), prev_value, new_value);
+		return msg;
+#endif
+	}
+
 	// this will no longer be necessary in C++17
 	constexpr alert_category_t torrent_removed_alert::static_category;
 	constexpr alert_category_t read_piece_alert::static_category;
@@ -3132,6 +3190,8 @@ namespace {
 	constexpr alert_category_t block_uploaded_alert::static_category;
 	constexpr alert_category_t alerts_dropped_alert::static_category;
 	constexpr alert_category_t socks5_alert::static_category;
+	constexpr alert_category_t read_piece_blocks_alert::static_category;
+	constexpr alert_category_t autotune_alert::static_category;
 #if TORRENT_ABI_VERSION == 1
 	constexpr alert_category_t anonymous_mode_alert::static_category;
 	constexpr alert_category_t mmap_cache_alert::static_category;
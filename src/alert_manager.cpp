@@ -35,6 +35,8 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "libtorrent/config.hpp"
 #include "libtorrent/aux_/alert_manager.hpp"
+#include "libtorrent/aux_/tracepoint.hpp"
+#include "libtorrent/aux_/time.hpp" // for time_now()
 #include "libtorrent/alert_types.hpp"
 
 #ifndef TORRENT_DISABLE_EXTENSIONS
@@ -48,7 +50,9 @@ namespace aux {
 	alert_manager::alert_manager(int const queue_limit, alert_category_t const alert_mask)
 		: m_alert_mask(alert_mask)
 		, m_queue_size_limit(queue_limit)
-	{}
+	{
+		m_type_queue_limit.fill(0);
+	}
 
 	alert_manager::~alert_manager() = default;
 
@@ -69,17 +73,37 @@ namespace aux {
 
 	void alert_manager::maybe_notify(alert* a)
 	{
+		TORRENT_PROBE1(alert_posted, a->type());
 		if (m_alerts[m_generation].size() == 1)
 		{
 			// we just posted to an empty queue. If anyone is waiting for
-			// alerts, we need to notify them. Also (potentially) call the
-			// user supplied m_notify callback to let the client wake up its
-			// message loop to poll for alerts.
-			if (m_notify) m_notify();
+			// alerts, we need to notify them. The user supplied m_notify
+			// callback is owed a call too, but it may be coalesced below.
 
 			// TODO: 2 keep a count of the number of threads waiting. Only if it's
 			// > 0 notify them
 			m_condition.notify_all();
+
+			m_notify_pending = true;
+			m_notify_first_pending = aux::time_now();
+		}
+
+		if (m_notify_pending && m_notify)
+		{
+			// under load, notifying the client on every 0 -> 1 transition
+			// means one wakeup (typically a futex cycle) per alert, since
+			// the client keeps draining the queue as fast as we fill it.
+			// Defer the callback until a batch has built up, but let
+			// configured latency-sensitive categories and the max-delay
+			// deadline cut the batching short
+			if (m_notify_batch_size <= 1
+				|| m_alerts[m_generation].size() >= m_notify_batch_size
+				|| (a->category() & m_notify_bypass)
+				|| aux::time_now() >= m_notify_first_pending + m_notify_max_delay)
+			{
+				m_notify_pending = false;
+				m_notify();
+			}
 		}
 
 #ifndef TORRENT_DISABLE_EXTENSIONS
@@ -96,10 +120,30 @@ namespace aux {
 		m_notify = fun;
 		if (!m_alerts[m_generation].empty())
 		{
+			m_notify_pending = false;
 			if (m_notify) m_notify();
 		}
 	}
 
+	void alert_manager::set_notify_coalescing(int const batch_size
+		, time_duration const max_delay, alert_category_t const bypass)
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_mutex);
+		m_notify_batch_size = std::max(1, batch_size);
+		m_notify_max_delay = max_delay;
+		m_notify_bypass = bypass;
+	}
+
+	void alert_manager::flush_pending_notify()
+	{
+		std::unique_lock<std::recursive_mutex> lock(m_mutex);
+		if (!m_notify_pending || !m_notify) return;
+		if (aux::time_now() < m_notify_first_pending + m_notify_max_delay)
+			return;
+		m_notify_pending = false;
+		m_notify();
+	}
+
 #ifndef TORRENT_DISABLE_EXTENSIONS
 	void alert_manager::add_extension(std::shared_ptr<plugin> ext)
 	{
@@ -124,11 +168,18 @@ namespace aux {
 
 		m_alerts[m_generation].get_pointers(alerts);
 
+		// the client is taking every queued alert; any deferred
+		// notification is moot now
+		m_notify_pending = false;
+
 		// swap buffers
 		m_generation = (m_generation + 1) & 1;
 		// clear the one we will start writing to now
 		m_alerts[m_generation].clear();
 		m_allocations[m_generation].reset();
+
+		// every queued alert was just handed to the client
+		for (auto& st : m_alert_type_stats) st.queued = 0;
 	}
 
 	bool alert_manager::pending() const
@@ -144,5 +195,20 @@ namespace aux {
 		std::swap(m_queue_size_limit, queue_size_limit_);
 		return queue_size_limit_;
 	}
+
+	alert_manager::alert_type_stats_t alert_manager::alert_type_stats(int const type) const
+	{
+		TORRENT_ASSERT(type >= 0 && type < abi_alert_count);
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		return m_alert_type_stats[type];
+	}
+
+	void alert_manager::set_alert_type_queue_limit(int const type, int const limit)
+	{
+		TORRENT_ASSERT(type >= 0 && type < abi_alert_count);
+		TORRENT_ASSERT(limit >= 0);
+		std::lock_guard<std::recursive_mutex> lock(m_mutex);
+		m_type_queue_limit[type] = limit;
+	}
 }
 }
@@ -137,6 +137,16 @@ namespace aux {
 	}
 #endif
 
+	// quota is handed out in tick-sized chunks rather than being paced
+	// across the tick interval. Spreading each grant evenly (deadline
+	// scheduling per peer) would need sub-tick timers, which the session
+	// event loop doesn't have, and the fast path in
+	// bandwidth_channel::need_queueing() deliberately bypasses the queue
+	// altogether when a channel has more than a second of quota built up.
+	// The amount of queued-but-unsent bytes per connection is instead
+	// bounded at the socket level, via the send_not_sent_low_watermark
+	// setting (TCP_NOTSENT_LOWAT), which is what keeps deep kernel send
+	// buffers from inflating the RTT for competing flows
 	void bandwidth_manager::update_quotas(time_duration const& dt)
 	{
 		if (m_abort) return;
@@ -149,9 +159,11 @@ namespace aux {
 
 		// for each bandwidth channel, call update_quota(dt)
 
-		std::vector<bandwidth_channel*> channels;
+		std::vector<bandwidth_channel*>& channels = m_scratch_channels;
+		channels.clear();
 
-		std::vector<bw_request> queue;
+		std::vector<bw_request>& queue = m_scratch_completed;
+		queue.clear();
 
 		for (auto i = m_queue.begin(); i != m_queue.end();)
 		{
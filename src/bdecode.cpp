@@ -156,6 +156,18 @@ namespace aux {
 	char const* parse_int(char const* start, char const* end, char delimiter
 		, std::int64_t& val, bdecode_errors::error_code_enum& ec)
 	{
+		// as long as the accumulated value is below 10^17, appending another
+		// digit cannot overflow an int64, so no per-digit overflow checks
+		// are needed. Only the (at most two) digits past that point take the
+		// checked path below. Note that digit runs in bencoding are at most
+		// 19 bytes and the string payloads they delimit are skipped without
+		// being scanned, so there is nothing here long enough for
+		// vectorized scanning to pay off
+		while (start < end && numeric(*start) && val < 100000000000000000)
+		{
+			val = val * 10 + (*start - '0');
+			++start;
+		}
 		while (start < end && *start != delimiter)
 		{
 			if (!numeric(*start))
@@ -775,13 +787,6 @@ namespace aux {
 	goto done; \
 	} TORRENT_WHILE_0
 
-	int bdecode(char const* start, char const* end, bdecode_node& ret
-		, error_code& ec, int* error_pos, int const depth_limit, int token_limit)
-	{
-		ret = bdecode({start, end - start}, ec, error_pos, depth_limit, token_limit);
-		return ec ? -1 : 0;
-	}
-
 	bdecode_node bdecode(span<char const> buffer, int depth_limit, int token_limit)
 	{
 		error_code ec;
@@ -794,13 +799,25 @@ namespace aux {
 		, error_code& ec, int* error_pos, int depth_limit, int token_limit)
 	{
 		bdecode_node ret;
+		bdecode(buffer.data(), buffer.data() + buffer.size(), ret
+			, ec, error_pos, depth_limit, token_limit);
+		return ret;
+	}
+
+	int bdecode(char const* start, char const* end, bdecode_node& ret
+		, error_code& ec, int* error_pos, int const depth_limit, int token_limit)
+	{
 		ec.clear();
+		// this resets the node, but the token buffer keeps its capacity, so
+		// a bdecode_node re-used for parsing in a loop (such as one packet
+		// at a time) doesn't allocate a new arena for every buffer
+		ret.clear();
 
-		if (buffer.size() > bdecode_token::max_offset)
+		if (end - start > bdecode_token::max_offset)
 		{
 			if (error_pos) *error_pos = 0;
 			ec = bdecode_errors::limit_exceeded;
-			return ret;
+			return -1;
 		}
 
 		// this is the stack of bdecode_token indices, into m_tokens.
@@ -809,8 +826,6 @@ namespace aux {
 		TORRENT_ALLOCA(stack, stack_frame, depth_limit);
 
 		// TODO: 2 attempt to simplify this implementation by embracing the span
-		char const* start = buffer.data();
-		char const* end = start + buffer.size();
 		char const* const orig_start = start;
 
 		if (start == end)
@@ -1008,7 +1023,7 @@ done:
 		ret.m_buffer_size = int(start - orig_start);
 		ret.m_root_tokens = ret.m_tokens.data();
 
-		return ret;
+		return ec ? -1 : 0;
 	}
 
 	namespace {
@@ -203,6 +203,24 @@ namespace libtorrent {
 		return count != num * 32 ? count : -1;
 	}
 
+	int bitfield::find_first_set(int const start) const noexcept
+	{
+		TORRENT_ASSERT(start >= 0);
+		if (start >= size()) return -1;
+		int const word = start / 32;
+		int const num = num_words();
+		// mask out the bits before "start" in the first word. They are the
+		// high order bits, since the buffer is in network byte order
+		std::uint32_t const first = m_buf[1 + word]
+			& aux::host_to_network(0xffffffff >> (start & 31));
+		if (first != 0)
+			return word * 32 + aux::count_leading_zeros({&first, 1});
+		int const rest = num - word - 1;
+		if (rest == 0) return -1;
+		int const count = aux::count_leading_zeros({&m_buf[2 + word], rest});
+		return count != rest * 32 ? (word + 1) * 32 + count : -1;
+	}
+
 	int bitfield::find_last_clear() const noexcept
 	{
 		int const num = num_words();
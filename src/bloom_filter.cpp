@@ -33,6 +33,13 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "libtorrent/bloom_filter.hpp"
 #include "libtorrent/aux_/numeric_cast.hpp"
+#include "libtorrent/aux_/cpuid.hpp"
+
+#include <cstring> // for std::memcpy
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace libtorrent {
 
@@ -67,7 +74,34 @@ namespace libtorrent {
 			3, 2, 2, 1, 2, 1, 1, 0
 		};
 		int ret = 0;
-		for (int i = 0; i < len; ++i)
+		int i = 0;
+
+#if TORRENT_HAS_SSE
+		// count set bits a word at a time, like bitfield::count(), and
+		// derive the number of zero bits from that. The filter is a byte
+		// array so the words are loaded unaligned
+		if (aux::mmx_support)
+		{
+			int set = 0;
+			for (; i + 4 <= len; i += 4)
+			{
+				std::uint32_t w;
+				std::memcpy(&w, bits + i, 4);
+#ifdef __GNUC__
+				std::uint32_t cnt = 0;
+				__asm__("popcnt %1, %0"
+					: "=r"(cnt)
+					: "r"(w));
+				set += cnt;
+#else
+				set += _mm_popcnt_u32(w);
+#endif
+			}
+			ret += i * 8 - set;
+		}
+#endif // TORRENT_HAS_SSE
+
+		for (; i < len; ++i)
 		{
 			ret += bitcount[bits[i] & 0xf];
 			ret += bitcount[(bits[i] >> 4) & 0xf];
@@ -70,6 +70,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/aux_/alert_manager.hpp" // for alert_manager
 #include "libtorrent/string_util.hpp" // for search
 #include "libtorrent/aux_/generate_peer_id.hpp"
+#include "libtorrent/aux_/time.hpp" // for aux::time_now
 
 #if !defined TORRENT_DISABLE_ENCRYPTION
 #include "libtorrent/pe_crypto.hpp"
@@ -84,20 +85,20 @@ namespace {
 	constexpr std::size_t handshake_len = 68;
 	constexpr std::size_t dh_key_len = 96;
 
-	// stream key (info hash of attached torrent)
-	// secret is the DH shared secret
-	// initializes m_enc_handler
-	std::shared_ptr<rc4_handler> init_pe_rc4_handler(key_t const& secret
+	// derives the session keys for an encrypted connection
+	// encryption longkeys
+	// outgoing connection : hash ('keyA',S,SKEY)
+	// incoming connection : hash ('keyB',S,SKEY)
+	// decryption longkeys
+	// outgoing connection : hash ('keyB',S,SKEY)
+	// incoming connection : hash ('keyA',S,SKEY)
+	std::pair<sha1_hash, sha1_hash> pe_session_keys(key_t const& secret
 		, sha1_hash const& stream_key, bool const outgoing)
 	{
 		hasher h;
 		static const char keyA[] = {'k', 'e', 'y', 'A'};
 		static const char keyB[] = {'k', 'e', 'y', 'B'};
 
-		// encryption rc4 longkeys
-		// outgoing connection : hash ('keyA',S,SKEY)
-		// incoming connection : hash ('keyB',S,SKEY)
-
 		std::array<char, dh_key_len> const secret_buf = export_key(secret);
 
 		if (outgoing) h.update(keyA); else h.update(keyB);
@@ -107,23 +108,57 @@ namespace {
 
 		h.reset();
 
-		// decryption rc4 longkeys
-		// outgoing connection : hash ('keyB',S,SKEY)
-		// incoming connection : hash ('keyA',S,SKEY)
-
 		if (outgoing) h.update(keyB); else h.update(keyA);
 		h.update(secret_buf);
 		h.update(stream_key);
 		sha1_hash const remote_key = h.final();
 
+		return {local_key, remote_key};
+	}
+
+	// stream key (info hash of attached torrent)
+	// secret is the DH shared secret
+	// initializes m_enc_handler
+	std::shared_ptr<rc4_handler> init_pe_rc4_handler(key_t const& secret
+		, sha1_hash const& stream_key, bool const outgoing)
+	{
+		std::pair<sha1_hash, sha1_hash> const keys
+			= pe_session_keys(secret, stream_key, outgoing);
+
 		auto ret = std::make_shared<rc4_handler>();
 
-		ret->set_incoming_key(remote_key);
-		ret->set_outgoing_key(local_key);
+		ret->set_incoming_key(keys.second);
+		ret->set_outgoing_key(keys.first);
 
 		return ret;
 	}
 
+#ifdef TORRENT_USE_LIBCRYPTO
+	// the crypto_field bit advertising the AES-128-CTR upgrade to RC4.
+	// 0x01 (plaintext) and 0x02 (RC4) are the standard values; peers that
+	// don't know this bit simply never select it
+	constexpr std::uint32_t pe_aes_ctr = 0x04;
+
+	std::shared_ptr<aes_ctr_handler> init_pe_aes_handler(key_t const& secret
+		, sha1_hash const& stream_key, bool const outgoing)
+	{
+		std::pair<sha1_hash, sha1_hash> const keys
+			= pe_session_keys(secret, stream_key, outgoing);
+
+		// re-hash the session keys with a domain separator, so the AES keys
+		// are distinct from the RC4 keys the handshake itself is
+		// obfuscated with
+		static const char sep[4] = {'a', 'e', 's', '1'};
+
+		auto ret = std::make_shared<aes_ctr_handler>();
+
+		ret->set_incoming_key(hasher(sep).update(keys.second).final());
+		ret->set_outgoing_key(hasher(sep).update(keys.first).final());
+
+		return ret;
+	}
+#endif
+
 } // anonymous namespace
 #endif
 
@@ -156,6 +191,7 @@ namespace {
 #if !defined TORRENT_DISABLE_ENCRYPTION
 		, m_encrypted(false)
 		, m_rc4_encrypted(false)
+		, m_aes_encrypted(false)
 		, m_recv_buffer(peer_connection::m_recv_buffer)
 #endif
 		, m_our_peer_id(pack.our_peer_id)
@@ -301,6 +337,11 @@ namespace {
 			return;
 		}
 
+		// make sure the upload-only, bitfield, DHT port and hash request
+		// messages all end up in the same packet, or at least back-to-back
+		// packets, instead of being flushed as separate small writes
+		cork c_(*this);
+
 		// connections that are still in the handshake
 		// will send their bitfield when the handshake
 		// is done
@@ -612,6 +653,9 @@ namespace {
 
 		// Discard DH key exchange data, setup RC4 keys
 		m_rc4 = init_pe_rc4_handler(secret_key, info_hash, is_outgoing());
+#ifdef TORRENT_USE_LIBCRYPTO
+		m_aes = init_pe_aes_handler(secret_key, info_hash, is_outgoing());
+#endif
 #ifndef TORRENT_DISABLE_LOGGING
 		peer_log(peer_log_alert::info, "ENCRYPTION", "computed RC4 keys");
 #endif
@@ -622,14 +666,22 @@ namespace {
 
 		// this is an invalid setting, but let's just make the best of the situation
 		int const enc_level = m_settings.get_int(settings_pack::allowed_enc_level);
-		std::uint8_t const crypto_provide = ((enc_level & settings_pack::pe_both) == 0)
-			? std::uint8_t(settings_pack::pe_both)
-			: std::uint8_t(enc_level);
+		std::uint32_t crypto_provide = ((enc_level & settings_pack::pe_both) == 0)
+			? std::uint32_t(settings_pack::pe_both)
+			: std::uint32_t(enc_level);
+
+#ifdef TORRENT_USE_LIBCRYPTO
+		// whenever RC4 would be acceptable, also advertise the AES-128-CTR
+		// upgrade. Peers that don't understand the bit won't select it
+		if (crypto_provide & settings_pack::pe_rc4)
+			crypto_provide |= pe_aes_ctr;
+#endif
 
 #ifndef TORRENT_DISABLE_LOGGING
-		static char const* level[] = {"plaintext", "rc4", "plaintext rc4"};
-		peer_log(peer_log_alert::info, "ENCRYPTION"
-			, "%s", level[crypto_provide - 1]);
+		peer_log(peer_log_alert::info, "ENCRYPTION", "provide : [%s%s%s ]"
+			, (crypto_provide & 1) ? " plaintext" : ""
+			, (crypto_provide & 2) ? " rc4" : ""
+			, (crypto_provide & 4) ? " aes-ctr" : "");
 #endif
 
 		write_pe_vc_cryptofield({ptr, encrypt_size}, crypto_provide, pad_size);
@@ -645,7 +697,12 @@ namespace {
 		TORRENT_ASSERT(!is_outgoing());
 		TORRENT_ASSERT(!m_encrypted);
 		TORRENT_ASSERT(!m_rc4_encrypted);
+#ifdef TORRENT_USE_LIBCRYPTO
+		TORRENT_ASSERT(crypto_select == 0x04 || crypto_select == 0x02
+			|| crypto_select == 0x01);
+#else
 		TORRENT_ASSERT(crypto_select == 0x02 || crypto_select == 0x01);
+#endif
 		TORRENT_ASSERT(!m_sent_handshake);
 
 		int const pad_size = int(random(512));
@@ -659,14 +716,18 @@ namespace {
 		send_buffer(vec);
 
 		// encryption method has been negotiated
-		if (crypto_select == 0x02)
-			m_rc4_encrypted = true;
-		else // 0x01
+		if (crypto_select == 0x01)
 			m_rc4_encrypted = false;
+		else // 0x02 or 0x04
+			m_rc4_encrypted = true;
+#ifdef TORRENT_USE_LIBCRYPTO
+		m_aes_encrypted = (crypto_select == 0x04);
+#endif
 
 #ifndef TORRENT_DISABLE_LOGGING
 		peer_log(peer_log_alert::info, "ENCRYPTION", " crypto select: %s"
-			, (crypto_select == 0x01) ? "plaintext" : "rc4");
+			, (crypto_select == 0x01) ? "plaintext"
+			: (crypto_select == 0x04) ? "aes-ctr" : "rc4");
 #endif
 	}
 
@@ -677,7 +738,7 @@ namespace {
 	{
 		INVARIANT_CHECK;
 
-		TORRENT_ASSERT(crypto_field <= 0x03 && crypto_field > 0);
+		TORRENT_ASSERT(crypto_field <= 0x07 && crypto_field > 0);
 		// vc,crypto_field,len(pad),pad, (len(ia))
 		TORRENT_ASSERT((write_buf.size() >= 8+4+2+pad_size+2
 				&& is_outgoing())
@@ -707,6 +768,26 @@ namespace {
 		m_rc4->decrypt(buf);
 	}
 
+	std::shared_ptr<crypto_plugin> bt_peer_connection::payload_crypto_handler()
+	{
+#ifdef TORRENT_USE_LIBCRYPTO
+		if (m_aes_encrypted) return m_aes;
+#endif
+		return m_rc4;
+	}
+
+	void bt_peer_connection::payload_decrypt(span<char> buf)
+	{
+#ifdef TORRENT_USE_LIBCRYPTO
+		if (m_aes_encrypted)
+		{
+			m_aes->decrypt(buf);
+			return;
+		}
+#endif
+		rc4_decrypt(buf);
+	}
+
 #endif // #if !defined TORRENT_DISABLE_ENCRYPTION
 
 	void bt_peer_connection::write_handshake()
@@ -1003,7 +1084,7 @@ namespace {
 		bits.assign(recv_buffer.data() + 1
 			, t->valid_metadata()?get_bitfield().size():(m_recv_buffer.packet_size()-1)*CHAR_BIT);
 
-		incoming_bitfield(bits);
+		incoming_bitfield(std::move(bits));
 	}
 
 	// -----------------------------
@@ -1280,8 +1361,13 @@ namespace {
 
 		if (!m_recv_buffer.packet_finished()) return;
 
-		auto new_end = std::remove(m_hash_requests.begin(), m_hash_requests.end(), hr);
-		m_hash_requests.erase(new_end, m_hash_requests.end());
+		auto const it = std::find_if(m_hash_requests.begin(), m_hash_requests.end()
+			, [&hr](std::pair<hash_request, time_point> const& e) { return e.first == hr; });
+		if (it != m_hash_requests.end())
+		{
+			m_hash_time.add_sample(int(total_milliseconds(aux::time_now() - it->second)));
+			m_hash_requests.erase(it);
+		}
 
 		std::vector<sha256_hash> hashes;
 		while (ptr != recv_buffer.end())
@@ -1350,9 +1436,13 @@ namespace {
 		}
 #endif
 
-		auto new_end = std::remove(m_hash_requests.begin(), m_hash_requests.end(), hr);
-		if (new_end == m_hash_requests.end()) return;
-		m_hash_requests.erase(new_end, m_hash_requests.end());
+		auto const it = std::find_if(m_hash_requests.begin(), m_hash_requests.end()
+			, [&hr](std::pair<hash_request, time_point> const& e) { return e.first == hr; });
+		if (it == m_hash_requests.end()) return;
+		// a reject is still a response, it measures this peer's
+		// responsiveness just like a batch of hashes does
+		m_hash_time.add_sample(int(total_milliseconds(aux::time_now() - it->second)));
+		m_hash_requests.erase(it);
 
 		t->hashes_rejected(hr);
 
@@ -1734,7 +1824,7 @@ namespace {
 
 		stats_counters().inc_stats_counter(counters::num_outgoing_hash_request);
 
-		m_hash_requests.push_back(req);
+		m_hash_requests.emplace_back(req, aux::time_now());
 
 #ifndef TORRENT_DISABLE_LOGGING
 		if (should_log(peer_log_alert::outgoing_message))
@@ -1821,7 +1911,7 @@ namespace {
 
 	void bt_peer_connection::maybe_send_hash_request()
 	{
-		if (is_disconnecting() || m_hash_requests.size() > 1) return;
+		if (is_disconnecting()) return;
 		if (!peer_info_struct()->protocol_v2) return;
 
 		std::shared_ptr<torrent> t = associated_torrent().lock();
@@ -1829,8 +1919,16 @@ namespace {
 
 		if (!t->valid_metadata()) return;
 
-		auto req = t->pick_hashes(this);
-		if (req.count > 0) write_hash_request(req);
+		// pipeline enough requests to cover this peer's hash-delivery
+		// latency, so validation doesn't stall a full round-trip between
+		// batches. Peers we haven't measured yet get the baseline depth
+		int const depth = std::min(2 + m_hash_time.mean() / 500, 8);
+		while (int(m_hash_requests.size()) < depth)
+		{
+			auto const req = t->pick_hashes(this);
+			if (req.count == 0) break;
+			write_hash_request(req);
+		}
 	}
 
 	// -----------------------------
@@ -2104,54 +2202,66 @@ namespace {
 		TORRENT_ASSERT(int(recv_buffer.size()) >= 1);
 		int const packet_type = static_cast<std::uint8_t>(recv_buffer[0]);
 
+		// a run of HAVE messages is buffered up and applied to the piece
+		// picker in one go. Any other message ends the run
+		if (packet_type != msg_have) flush_haves();
+		if (is_disconnecting()) return false;
+
 #if TORRENT_USE_ASSERTS
 		std::int64_t const cur_payload_dl = statistics().last_payload_downloaded();
 		std::int64_t const cur_protocol_dl = statistics().last_protocol_downloaded();
 #endif
 
-		// call the handler for this packet type
-		switch (packet_type)
-		{
-			// original BitTorrent message
-			case msg_choke: on_choke(received); break;
-			case msg_unchoke: on_unchoke(received); break;
-			case msg_interested: on_interested(received); break;
-			case msg_not_interested: on_not_interested(received); break;
-			case msg_have: on_have(received); break;
-			case msg_bitfield: on_bitfield(received); break;
-			case msg_request: on_request(received); break;
-			case msg_piece: on_piece(received); break;
-			case msg_cancel: on_cancel(received); break;
-
+		// the jump table of message handlers, indexed by the message type
+		// byte. The gaps in the message type space are nullptr entries
+		static message_handler const handlers[num_supported_messages] =
+		{
+			// original BitTorrent messages
+			&bt_peer_connection::on_choke,
+			&bt_peer_connection::on_unchoke,
+			&bt_peer_connection::on_interested,
+			&bt_peer_connection::on_not_interested,
+			&bt_peer_connection::on_have,
+			&bt_peer_connection::on_bitfield,
+			&bt_peer_connection::on_request,
+			&bt_peer_connection::on_piece,
+			&bt_peer_connection::on_cancel,
 			// DHT extension
-			case msg_dht_port: on_dht_port(received); break;
-
+			&bt_peer_connection::on_dht_port,
+			nullptr, nullptr, nullptr,
 			// FAST extension messages
-			case msg_suggest_piece: on_suggest_piece(received); break;
-			case msg_have_all: on_have_all(received); break;
-			case msg_have_none: on_have_none(received); break;
-			case msg_reject_request: on_reject_request(received); break;
-			case msg_allowed_fast: on_allowed_fast(received); break;
-			case msg_extended: on_extended(received); break;
-			case msg_hash_request: on_hash_request(received); break;
-			case msg_hashes: on_hashes(received); break;
-			case msg_hash_reject: on_hash_reject(received); break;
-			default:
-			{
+			&bt_peer_connection::on_suggest_piece,
+			&bt_peer_connection::on_have_all,
+			&bt_peer_connection::on_have_none,
+			&bt_peer_connection::on_reject_request,
+			&bt_peer_connection::on_allowed_fast,
+			nullptr, nullptr,
+			// extension protocol message
+			&bt_peer_connection::on_extended,
+			&bt_peer_connection::on_hash_request,
+			&bt_peer_connection::on_hashes,
+			&bt_peer_connection::on_hash_reject,
+		};
+
+		if (packet_type >= num_supported_messages
+			|| handlers[packet_type] == nullptr)
+		{
 #ifndef TORRENT_DISABLE_EXTENSIONS
-				for (auto const& e : m_extensions)
-				{
-					if (e->on_unknown_message(m_recv_buffer.packet_size(), packet_type
-						, recv_buffer.subspan(1)))
-						return m_recv_buffer.packet_finished();
-				}
-#endif
-				received_bytes(0, received);
-				disconnect(errors::invalid_message, operation_t::bittorrent);
-				return m_recv_buffer.packet_finished();
+			for (auto const& e : m_extensions)
+			{
+				if (e->on_unknown_message(m_recv_buffer.packet_size(), packet_type
+					, recv_buffer.subspan(1)))
+					return m_recv_buffer.packet_finished();
 			}
+#endif
+			received_bytes(0, received);
+			disconnect(errors::invalid_message, operation_t::bittorrent);
+			return m_recv_buffer.packet_finished();
 		}
 
+		// call the correct handler for this packet type
+		(this->*handlers[packet_type])(received);
+
 #if TORRENT_USE_ASSERTS
 		TORRENT_ASSERT(statistics().last_payload_downloaded() - cur_payload_dl >= 0);
 		TORRENT_ASSERT(statistics().last_protocol_downloaded() - cur_protocol_dl >= 0);
@@ -2926,6 +3036,10 @@ namespace {
 
 				m_rc4 = init_pe_rc4_handler(m_dh_key_exchange->get_secret()
 					, associated_info_hash(), is_outgoing());
+#ifdef TORRENT_USE_LIBCRYPTO
+				m_aes = init_pe_aes_handler(m_dh_key_exchange->get_secret()
+					, associated_info_hash(), is_outgoing());
+#endif
 #ifndef TORRENT_DISABLE_LOGGING
 				peer_log(peer_log_alert::info, "ENCRYPTION", "computed RC4 keys");
 				peer_log(peer_log_alert::info, "ENCRYPTION", "stream key found, torrent located");
@@ -3052,16 +3166,22 @@ namespace {
 			std::uint32_t crypto_field = aux::read_uint32(recv_buffer);
 
 #ifndef TORRENT_DISABLE_LOGGING
-			peer_log(peer_log_alert::info, "ENCRYPTION", "crypto %s : [%s%s ]"
+			peer_log(peer_log_alert::info, "ENCRYPTION", "crypto %s : [%s%s%s ]"
 				, is_outgoing() ? "select" : "provide"
 				, (crypto_field & 1) ? " plaintext" : ""
-				, (crypto_field & 2) ? " rc4" : "");
+				, (crypto_field & 2) ? " rc4" : ""
+				, (crypto_field & 4) ? " aes-ctr" : "");
 #endif
 
 			if (!is_outgoing())
 			{
 				// select a crypto method
 				int allowed_encryption = m_settings.get_int(settings_pack::allowed_enc_level);
+#ifdef TORRENT_USE_LIBCRYPTO
+				// the AES-128-CTR upgrade is implied by allowing RC4
+				if (allowed_encryption & settings_pack::pe_rc4)
+					allowed_encryption |= int(pe_aes_ctr);
+#endif
 				std::uint32_t crypto_select = crypto_field & std::uint32_t(allowed_encryption);
 
 				// when prefer_rc4 is set, keep the most significant bit
@@ -3085,6 +3205,15 @@ namespace {
 					}
 				}
 
+#ifdef TORRENT_USE_LIBCRYPTO
+				// if RC4 won the selection but both ends also support the
+				// AES-128-CTR upgrade, take that instead. It's the same
+				// stream cipher framing at a fraction of the CPU cost
+				if (crypto_select == settings_pack::pe_rc4
+					&& (crypto_field & std::uint32_t(allowed_encryption) & pe_aes_ctr))
+					crypto_select = pe_aes_ctr;
+#endif
+
 				if (crypto_select == 0)
 				{
 					disconnect(errors::unsupported_encryption_mode, operation_t::encryption, failure);
@@ -3098,6 +3227,11 @@ namespace {
 			{
 				// check if crypto select is valid
 				int allowed_encryption = m_settings.get_int(settings_pack::allowed_enc_level);
+#ifdef TORRENT_USE_LIBCRYPTO
+				// the AES-128-CTR upgrade is implied by allowing RC4
+				if (allowed_encryption & settings_pack::pe_rc4)
+					allowed_encryption |= int(pe_aes_ctr);
+#endif
 
 				crypto_field &= std::uint32_t(allowed_encryption);
 				if (crypto_field == 0)
@@ -3111,6 +3245,13 @@ namespace {
 					m_rc4_encrypted = false;
 				else if (crypto_field == settings_pack::pe_rc4)
 					m_rc4_encrypted = true;
+#ifdef TORRENT_USE_LIBCRYPTO
+				else if (crypto_field == pe_aes_ctr)
+				{
+					m_rc4_encrypted = true;
+					m_aes_encrypted = true;
+				}
+#endif
 			}
 
 			int const len_pad = aux::read_int16(recv_buffer);
@@ -3130,8 +3271,9 @@ namespace {
 					m_encrypted = true;
 					if (m_rc4_encrypted)
 					{
-						switch_send_crypto(m_rc4);
-						switch_recv_crypto(m_rc4);
+						auto const crypto = payload_crypto_handler();
+						switch_send_crypto(crypto);
+						switch_recv_crypto(crypto);
 					}
 					m_state = state_t::init_bt_handshake;
 				}
@@ -3173,8 +3315,9 @@ namespace {
 					m_encrypted = true;
 					if (m_rc4_encrypted)
 					{
-						switch_send_crypto(m_rc4);
-						switch_recv_crypto(m_rc4);
+						auto const crypto = payload_crypto_handler();
+						switch_send_crypto(crypto);
+						switch_recv_crypto(crypto);
 					}
 					m_state = state_t::init_bt_handshake;
 				}
@@ -3190,8 +3333,9 @@ namespace {
 				m_encrypted = true;
 				if (m_rc4_encrypted)
 				{
-					switch_send_crypto(m_rc4);
-					switch_recv_crypto(m_rc4);
+					auto const crypto = payload_crypto_handler();
+					switch_send_crypto(crypto);
+					switch_recv_crypto(crypto);
 				}
 				m_state = state_t::init_bt_handshake;
 			}
@@ -3218,10 +3362,14 @@ namespace {
 			m_encrypted = true;
 			if (m_rc4_encrypted)
 			{
-				switch_send_crypto(m_rc4);
-				switch_recv_crypto(m_rc4);
+				auto const crypto = payload_crypto_handler();
+				switch_send_crypto(crypto);
+				switch_recv_crypto(crypto);
 			}
 			m_rc4.reset();
+#ifdef TORRENT_USE_LIBCRYPTO
+			m_aes.reset();
+#endif
 
 			m_state = state_t::read_protocol_identifier;
 			m_recv_buffer.cut(0, 20);
@@ -3233,12 +3381,13 @@ namespace {
 			bytes_transferred = 0;
 			TORRENT_ASSERT(m_encrypted);
 
-			// decrypt remaining received bytes
+			// decrypt remaining received bytes. These were sent after the
+			// peer switched to the negotiated payload cipher
 			if (m_rc4_encrypted)
 			{
 				span<char> const remaining = m_recv_buffer.mutable_buffer()
 					.subspan(m_recv_buffer.packet_size());
-				rc4_decrypt(remaining);
+				payload_decrypt(remaining);
 
 #ifndef TORRENT_DISABLE_LOGGING
 				peer_log(peer_log_alert::info, "ENCRYPTION"
@@ -3246,6 +3395,9 @@ namespace {
 #endif
 			}
 			m_rc4.reset();
+#ifdef TORRENT_USE_LIBCRYPTO
+			m_aes.reset();
+#endif
 
 			// payload stream, start with 20 handshake bytes
 			m_state = state_t::read_protocol_identifier;
@@ -238,12 +238,20 @@ namespace {
 
 			int rate_threshold = sett.get_int(settings_pack::rate_choker_initial_threshold);
 
-			std::sort(peers.begin(), peers.end()
-				, [](peer_connection const* lhs, peer_connection const* rhs)
-				{ return upload_rate_compare(lhs, rhs); });
+			// we only visit peers in decreasing upload-rate order until the
+			// growing threshold overtakes the rate, so extract them lazily
+			// from a heap rather than sorting all peers. This is
+			// O(n + k log n), where k is the number of slots we end up
+			// with, instead of O(n log n)
+			auto const faster = [](peer_connection const* lhs, peer_connection const* rhs)
+				{ return upload_rate_compare(rhs, lhs); };
+
+			std::make_heap(peers.begin(), peers.end(), faster);
 
-			for (auto const* p : peers)
+			for (auto end = peers.end(); end != peers.begin(); --end)
 			{
+				std::pop_heap(peers.begin(), end, faster);
+				peer_connection const* p = *(end - 1);
 				int const rate = int(p->uploaded_in_last_round()
 					* 1000 / total_milliseconds(unchoke_interval));
 
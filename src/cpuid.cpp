@@ -119,6 +119,77 @@ namespace {
 #endif
 	}
 
+	bool supports_sha_ni() noexcept
+	{
+#if TORRENT_HAS_SSE
+		std::uint32_t cpui[4] = {0};
+		cpuid(cpui, 0);
+		if (cpui[0] < 7) return false;
+#if defined _MSC_VER
+		int cpui7[4] = {0};
+		__cpuidex(cpui7, 7, 0);
+		return (cpui7[1] & (1 << 29)) != 0;
+#elif defined __GNUC__
+		std::uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		return (ebx & (1u << 29)) != 0;
+#else
+		return false;
+#endif
+#else
+		return false;
+#endif
+	}
+
+	bool supports_avx2() noexcept
+	{
+#if TORRENT_HAS_SSE
+		std::uint32_t cpui[4] = {0};
+		cpuid(cpui, 0);
+		if (cpui[0] < 7) return false;
+		cpuid(cpui, 1);
+		// using the YMM registers also requires the OS to save and restore
+		// them on context switches. Check OSXSAVE and AVX, then ask xgetbv
+		// whether the SSE and AVX states are enabled in XCR0
+		if ((cpui[2] & (1 << 27)) == 0) return false;
+		if ((cpui[2] & (1 << 28)) == 0) return false;
+#if defined _MSC_VER
+		if ((_xgetbv(0) & 0x6) != 0x6) return false;
+		int cpui7[4] = {0};
+		__cpuidex(cpui7, 7, 0);
+		return (cpui7[1] & (1 << 5)) != 0;
+#elif defined __GNUC__
+		std::uint32_t lo = 0, hi = 0;
+		__asm__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		if ((lo & 0x6) != 0x6) return false;
+		std::uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		return (ebx & (1u << 5)) != 0;
+#else
+		return false;
+#endif
+#else
+		return false;
+#endif
+	}
+
+	bool supports_arm_sha1() noexcept
+	{
+#if TORRENT_HAS_ARM && TORRENT_HAS_AUXV
+#if defined __arm__
+		//return (getauxval(AT_HWCAP2) & HWCAP2_SHA1);
+		return (helper_getauxval(26) & (1 << 2)) != 0;
+#elif defined __aarch64__
+		//return (getauxval(AT_HWCAP) & HWCAP_SHA1);
+		return (helper_getauxval(16) & (1 << 5)) != 0;
+#else
+		return false;
+#endif
+#else
+		return false;
+#endif
+	}
+
 	bool supports_arm_neon() noexcept
 	{
 #if TORRENT_HAS_ARM_NEON && TORRENT_HAS_AUXV
@@ -138,7 +209,11 @@ namespace {
 
 	bool supports_arm_crc32c() noexcept
 	{
-#if TORRENT_HAS_ARM_CRC32 && TORRENT_HAS_AUXV
+	// note: detection is not conditioned on TORRENT_HAS_ARM_CRC32. The
+	// hardware path in crc32c.cpp may be compiled via a function target
+	// attribute even when the CRC extension isn't enabled for the whole
+	// build, and it still needs this runtime check
+#if TORRENT_HAS_ARM && TORRENT_HAS_AUXV
 #if defined TORRENT_FORCE_ARM_CRC32
 		return true;
 #elif defined __arm__
@@ -156,6 +231,9 @@ namespace {
 } // anonymous namespace
 
 	bool const sse42_support = supports_sse42();
+	bool const sha_ni_support = supports_sha_ni();
+	bool const avx2_support = supports_avx2();
+	bool const arm_sha1_support = supports_arm_sha1();
 	bool const mmx_support = supports_mmx();
 	bool const arm_neon_support = supports_arm_neon();
 	bool const arm_crc32c_support = supports_arm_crc32c();
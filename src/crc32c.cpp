@@ -47,10 +47,52 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #if TORRENT_HAS_ARM_CRC32
 #include <arm_acle.h>
+#define TORRENT_ARM_CRC32_FUN
+#define TORRENT_HAS_ARM_CRC32_DISPATCH 1
+#elif defined __aarch64__ && defined __GNUC__ && !defined __clang__
+// the CRC32 extension isn't enabled for the whole translation unit, but
+// the functions can still be compiled for it and called behind the
+// runtime check. The pragma makes arm_acle.h define the CRC intrinsics
+#pragma GCC push_options
+#pragma GCC target ("arch=armv8-a+crc")
+#include <arm_acle.h>
+#pragma GCC pop_options
+#define TORRENT_ARM_CRC32_FUN __attribute__((target("arch=armv8-a+crc")))
+#define TORRENT_HAS_ARM_CRC32_DISPATCH 1
+#elif defined __aarch64__ && defined __clang__
+#define __crc32cw __builtin_arm_crc32cw
+#define __crc32cd __builtin_arm_crc32cd
+#define TORRENT_ARM_CRC32_FUN __attribute__((target("crc")))
+#define TORRENT_HAS_ARM_CRC32_DISPATCH 1
+#else
+#define TORRENT_HAS_ARM_CRC32_DISPATCH 0
 #endif
 
 namespace libtorrent {
 
+#if TORRENT_HAS_ARM_CRC32_DISPATCH
+namespace {
+
+	TORRENT_ARM_CRC32_FUN
+	std::uint32_t crc32c_arm_32(std::uint32_t const v)
+	{
+		return __crc32cw(0xffffffff, v) ^ 0xffffffff;
+	}
+
+	TORRENT_ARM_CRC32_FUN
+	std::uint32_t crc32c_arm(std::uint64_t const* const buf, int const num_words)
+	{
+		std::uint32_t ret = 0xffffffff;
+		for (int i = 0; i < num_words; ++i)
+		{
+			ret = __crc32cd(ret, buf[i]);
+		}
+		return ret ^ 0xffffffff;
+	}
+
+} // anonymous namespace
+#endif // TORRENT_HAS_ARM_CRC32_DISPATCH
+
 	std::uint32_t crc32c_32(std::uint32_t v)
 	{
 #if TORRENT_HAS_SSE
@@ -71,12 +113,9 @@ namespace libtorrent {
 		}
 #endif
 
-#if TORRENT_HAS_ARM_CRC32
+#if TORRENT_HAS_ARM_CRC32_DISPATCH
 		if (aux::arm_crc32c_support)
-		{
-			std::uint32_t ret = 0xffffffff;
-			return __crc32cw(ret, v) ^ 0xffffffff;
-		}
+			return crc32c_arm_32(v);
 #endif
 
 		boost::crc_optimal<32, 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF, true, true> crc;
@@ -132,16 +171,9 @@ namespace libtorrent {
 		}
 #endif // x86 or amd64 and gcc or msvc
 
-#if TORRENT_HAS_ARM_CRC32
+#if TORRENT_HAS_ARM_CRC32_DISPATCH
 		if (aux::arm_crc32c_support)
-		{
-			std::uint32_t ret = 0xffffffff;
-			for (int i = 0; i < num_words; ++i)
-			{
-				ret = __crc32cd(ret, buf[i]);
-			}
-			return ret ^ 0xffffffff;
-		}
+			return crc32c_arm(buf, num_words);
 #endif
 
 		boost::crc_optimal<32, 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF, true, true> crc;
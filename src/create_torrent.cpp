@@ -51,8 +51,12 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 using namespace std::placeholders;
 
@@ -97,26 +101,43 @@ namespace {
 	}
 #endif
 
-	void add_files_impl(file_storage& fs, std::string const& p
-		, std::string const& l, std::function<bool(std::string)> const& pred
+	// one entry in the directory tree being scanned. The stat() result and
+	// the children (in the order the directory listed them) are filled in by
+	// the traversal, and the tree is then flattened into the file_storage in
+	// a second, serial pass
+	struct file_tree_node
+	{
+		explicit file_tree_node(std::string p) : path(std::move(p)) {}
+
+		// path relative to the directory the traversal was rooted in
+		std::string path;
+		file_status st;
+		file_flags_t file_flags{};
+		std::string symlink_path;
+		bool valid = false;
+		bool recurse = false;
+		std::vector<std::unique_ptr<file_tree_node>> children;
+	};
+
+	void stat_node(file_tree_node& n, std::string const& p
 		, create_flags_t const flags)
 	{
-		std::string const f = combine_path(p, l);
-		if (!pred(f)) return;
+		std::string const f = combine_path(p, n.path);
 		error_code ec;
-		file_status s;
-		stat_file(f, &s, ec, (flags & create_torrent::symlinks) ? dont_follow_links : 0);
+		stat_file(f, &n.st, ec, (flags & create_torrent::symlinks) ? dont_follow_links : 0);
 		if (ec) return;
+		n.valid = true;
 
 		// recurse into directories
-		bool recurse = (s.mode & file_status::directory) != 0;
+		bool recurse = (n.st.mode & file_status::directory) != 0;
 
 		// if the file is not a link or we're following links, and it's a directory
 		// only then should we recurse
 #ifndef TORRENT_WINDOWS
-		if ((s.mode & file_status::link) && (flags & create_torrent::symlinks))
+		if ((n.st.mode & file_status::link) && (flags & create_torrent::symlinks))
 			recurse = false;
 #endif
+		n.recurse = recurse;
 
 		if (recurse)
 		{
@@ -124,28 +145,122 @@ namespace {
 			{
 				std::string const leaf = i.file();
 				if (ignore_subdir(leaf)) continue;
-				add_files_impl(fs, p, combine_path(l, leaf), pred, flags);
+				n.children.emplace_back(new file_tree_node(
+					combine_path(n.path, leaf)));
 			}
 		}
 		else
 		{
-			// #error use the fields from s
-			file_flags_t const file_flags = aux::get_file_attributes(f);
+			n.file_flags = aux::get_file_attributes(f);
 
 			// mask all bits to check if the file is a symlink
-			if ((file_flags & file_storage::flag_symlink)
+			if ((n.file_flags & file_storage::flag_symlink)
 				&& (flags & create_torrent::symlinks))
 			{
-				std::string const sym_path = aux::get_symlink_path(f);
-				fs.add_file(l, 0, file_flags, std::time_t(s.mtime), sym_path);
+				n.symlink_path = aux::get_symlink_path(f);
 			}
-			else
+		}
+	}
+
+	// shared between the traversal worker threads. ``outstanding`` counts
+	// nodes that are queued or currently being processed; once it hits zero
+	// no more work can appear and the workers exit
+	struct traversal_state
+	{
+		std::string const& parent;
+		create_flags_t flags;
+		std::mutex mutex;
+		std::condition_variable cond;
+		std::vector<file_tree_node*> pending;
+		int outstanding = 0;
+	};
+
+	void traversal_worker(traversal_state* st)
+	{
+		std::unique_lock<std::mutex> l(st->mutex);
+		for (;;)
+		{
+			while (st->pending.empty())
+			{
+				if (st->outstanding == 0) return;
+				st->cond.wait(l);
+			}
+			file_tree_node* n = st->pending.back();
+			st->pending.pop_back();
+			l.unlock();
+			stat_node(*n, st->parent, st->flags);
+			l.lock();
+			if (!n->children.empty())
 			{
-				fs.add_file(l, s.file_size, file_flags, std::time_t(s.mtime));
+				for (auto& c : n->children)
+					st->pending.push_back(c.get());
+				st->outstanding += int(n->children.size());
+				st->cond.notify_all();
+			}
+			--st->outstanding;
+			if (st->outstanding == 0)
+			{
+				st->cond.notify_all();
+				return;
 			}
 		}
 	}
 
+	void merge_tree(file_storage& fs, file_tree_node const& n
+		, std::string const& p, std::function<bool(std::string)> const& pred
+		, create_flags_t const flags)
+	{
+		if (!pred(combine_path(p, n.path))) return;
+		if (!n.valid) return;
+
+		if (n.recurse)
+		{
+			for (auto const& c : n.children)
+				merge_tree(fs, *c, p, pred, flags);
+		}
+		else if ((n.file_flags & file_storage::flag_symlink)
+			&& (flags & create_torrent::symlinks))
+		{
+			fs.add_file(n.path, 0, n.file_flags, std::time_t(n.st.mtime), n.symlink_path);
+		}
+		else
+		{
+			fs.add_file(n.path, n.st.file_size, n.file_flags, std::time_t(n.st.mtime));
+		}
+	}
+
+	void add_files_impl(file_storage& fs, std::string const& p
+		, std::string const& l, std::function<bool(std::string)> const& pred
+		, create_flags_t const flags)
+	{
+		file_tree_node root(l);
+		stat_node(root, p, flags);
+
+		if (!root.children.empty())
+		{
+			// the stat() round-trips dominate the traversal on network
+			// filesystems. Fan the tree walk out over a thread pool and
+			// flatten the result in directory order afterwards, producing
+			// the same file order as a serial walk. The predicate is only
+			// called from this thread, in the flattening pass, since we
+			// don't know whether it's safe to call concurrently
+			traversal_state st{p, flags, {}, {}, {}, 0};
+			for (auto& c : root.children)
+				st.pending.push_back(c.get());
+			st.outstanding = int(st.pending.size());
+
+			int const num_threads = std::max(2
+				, static_cast<int>(std::thread::hardware_concurrency()));
+			std::vector<std::thread> pool;
+			pool.reserve(std::size_t(num_threads));
+			for (int i = 0; i < num_threads; ++i)
+				pool.emplace_back(&traversal_worker, &st);
+			for (auto& t : pool) t.join();
+		}
+
+		merge_tree(fs, root, p, pred, flags);
+	}
+
 	struct hash_state
 	{
 		create_torrent& ct;
@@ -340,10 +455,13 @@ namespace {
 		storage_holder storage = disk_thread->new_torrent(params
 			, std::shared_ptr<void>());
 
-		// have 4 outstanding hash requests per thread, and no less than 1 MiB
+		// have 4 outstanding hash requests per thread, and no less than 8 MiB
+		// worth of pieces. With small pieces the per-job overhead dominates,
+		// and a deeper pipeline is needed to keep the device reading at full
+		// sequential bandwidth
 		int const jobs_per_thread = 4;
 		int const piece_read_ahead = std::max(num_threads * jobs_per_thread
-			, 1 * 1024 * 1024 / t.piece_length());
+			, 8 * 1024 * 1024 / t.piece_length());
 
 		hash_state st = { t, std::move(storage), *disk_thread.get(), piece_index_t(0), piece_index_t(0), f, ec };
 		for (piece_index_t i(0); i < piece_index_t(piece_read_ahead); ++i)
@@ -683,6 +801,13 @@ namespace {
 			TORRENT_ASSERT(!m_file_piece_hash.empty());
 			m_fileroots.resize(m_files.num_files());
 
+			// note that this loop is not worth parallelizing. The expensive
+			// part of v2 torrent creation, hashing the 16 kiB blocks, is
+			// already spread across the disk I/O hash threads (see
+			// settings_pack::hashing_threads and set_piece_hashes()). What's
+			// left here is reducing 32-byte piece roots to one root per file,
+			// a fraction of a percent of the total hash work
+
 			sha256_hash const pad_hash = merkle_pad(m_files.piece_length() / default_block_size, 1);
 			auto& file_pieces = dict["piece layers"].dict();
 
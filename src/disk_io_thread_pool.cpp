@@ -49,6 +49,7 @@ namespace aux {
 		, io_context& ios)
 		: m_thread_iface(thread_iface)
 		, m_max_threads(0)
+		, m_min_threads(0)
 		, m_threads_to_exit(0)
 		, m_abort(false)
 		, m_num_idle_threads(0)
@@ -71,6 +72,12 @@ namespace aux {
 		stop_threads(int(m_threads.size()) - i);
 	}
 
+	void disk_io_thread_pool::set_min_threads(int const i)
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		m_min_threads = i;
+	}
+
 	void disk_io_thread_pool::abort(bool wait)
 	{
 		std::unique_lock<std::mutex> l(m_mutex);
@@ -194,8 +201,13 @@ namespace aux {
 		int const min_idle = m_min_idle_threads.exchange(m_num_idle_threads);
 		if (min_idle <= 0) return;
 		// stop either the minimum number of idle threads or the number of threads
-		// which must be stopped to get below the max, whichever is larger
-		int const to_stop = std::max(min_idle, int(m_threads.size()) - m_max_threads);
+		// which must be stopped to get below the max, whichever is larger.
+		// never shrink the pool below the configured minimum though, those
+		// threads are kept warm even when idle
+		int const to_stop = std::max(
+			std::min(min_idle, int(m_threads.size()) - m_min_threads)
+			, int(m_threads.size()) - m_max_threads);
+		if (to_stop <= 0) return;
 		stop_threads(to_stop);
 	}
 
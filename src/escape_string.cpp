@@ -35,6 +35,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "libtorrent/config.hpp"
 
+#include <array>
 #include <string>
 #include <cctype>
 #include <algorithm>
@@ -135,18 +136,39 @@ namespace libtorrent {
 
 	namespace {
 
+	// a table with an entry for every possible byte value, true for the
+	// characters that appear in unreserved_chars at or past the given
+	// offset. Indexing this is a lot cheaper than scanning the string with
+	// strchr() for every input byte, and keeps the escape loop free of
+	// data-dependent branches
+	std::array<bool, 256> make_unreserved_table(int const offset)
+	{
+		std::array<bool, 256> ret{};
+		for (char const* c = unreserved_chars + offset; *c != 0; ++c)
+			ret[std::uint8_t(*c)] = true;
+		return ret;
+	}
+
 	// the offset is used to ignore the first characters in the unreserved_chars table.
 	std::string escape_string_impl(const char* str, int const len, int const offset)
 	{
 		TORRENT_ASSERT(str != nullptr);
 		TORRENT_ASSERT(len >= 0);
-		TORRENT_ASSERT(offset >= 0);
-		TORRENT_ASSERT(offset < int(sizeof(unreserved_chars)) - 1);
+
+		// the two offsets used by escape_path() and escape_string()
+		TORRENT_ASSERT(offset == 10 || offset == 11);
+		static std::array<bool, 256> const tables[] = {
+			make_unreserved_table(10)
+			, make_unreserved_table(11)
+		};
+		std::array<bool, 256> const& unreserved = tables[offset - 10];
 
 		std::string ret;
+		// worst case, every byte expands to three characters
+		ret.reserve(std::size_t(len) * 3);
 		for (int i = 0; i < len; ++i)
 		{
-			if (std::strchr(unreserved_chars + offset, *str) && *str != 0)
+			if (unreserved[std::uint8_t(*str)])
 			{
 				ret += *str;
 			}
@@ -175,9 +197,10 @@ namespace libtorrent {
 
 	bool need_encoding(char const* str, int const len)
 	{
+		static std::array<bool, 256> const unreserved = make_unreserved_table(0);
 		for (int i = 0; i < len; ++i)
 		{
-			if (std::strchr(unreserved_chars, *str) == nullptr || *str == 0)
+			if (!unreserved[std::uint8_t(*str)])
 				return true;
 			++str;
 		}
@@ -0,0 +1,134 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "libtorrent/aux_/event_trace.hpp"
+
+#if TORRENT_USE_EVENT_TRACE
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional> // for std::hash
+#include <thread>
+#include <vector>
+#endif
+
+namespace libtorrent {
+namespace aux {
+
+#if TORRENT_USE_EVENT_TRACE
+
+namespace {
+
+	struct trace_slot
+	{
+		std::int64_t timestamp_us;
+		std::int64_t id;
+		char const* name;
+		std::uint32_t tid;
+		char phase;
+	};
+
+	// must be a power of two, so the sequence number can be mapped to a
+	// slot with a mask. 64k events cover a few seconds of heavy disk and
+	// peer traffic
+	constexpr std::uint32_t num_slots = 0x10000;
+
+	std::array<trace_slot, num_slots> slots;
+	std::atomic<std::uint32_t> next_seq{0};
+
+	std::chrono::steady_clock::time_point const trace_epoch
+		= std::chrono::steady_clock::now();
+}
+
+	void trace_event(char const phase, char const* name, std::int64_t const id)
+	{
+		std::uint32_t const seq = next_seq.fetch_add(1, std::memory_order_relaxed);
+		trace_slot& s = slots[seq & (num_slots - 1)];
+		s.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - trace_epoch).count();
+		s.id = id;
+		s.name = name;
+		s.tid = std::uint32_t(std::hash<std::thread::id>{}(
+			std::this_thread::get_id()));
+		s.phase = phase;
+	}
+
+	std::string render_chrome_trace()
+	{
+		// snapshot the buffer. Writers keep going while we copy; a slot
+		// being overwritten mid-copy yields one garbled event at worst,
+		// which the sort below just places somewhere harmless
+		std::vector<trace_slot> events;
+		events.reserve(num_slots);
+		for (trace_slot const& s : slots)
+		{
+			if (s.name == nullptr) continue;
+			events.push_back(s);
+		}
+		std::sort(events.begin(), events.end()
+			, [](trace_slot const& lhs, trace_slot const& rhs)
+			{ return lhs.timestamp_us < rhs.timestamp_us; });
+
+		std::string ret = "{\"traceEvents\":[";
+		bool first = true;
+		for (trace_slot const& s : events)
+		{
+			if (!first) ret += ',';
+			first = false;
+			ret += "{\"name\":\"";
+			ret += s.name;
+			ret += "\",\"cat\":\"libtorrent\",\"ph\":\"";
+			ret += s.phase;
+			ret += "\",\"ts\":";
+			ret += std::to_string(s.timestamp_us);
+			ret += ",\"pid\":1,\"tid\":";
+			ret += std::to_string(s.tid);
+			ret += ",\"id\":";
+			ret += std::to_string(s.id);
+			ret += '}';
+		}
+		ret += "]}";
+		return ret;
+	}
+
+#else
+
+	void trace_event(char, char const*, std::int64_t) {}
+
+	std::string render_chrome_trace()
+	{ return "{\"traceEvents\":[]}"; }
+
+#endif // TORRENT_USE_EVENT_TRACE
+
+}
+}
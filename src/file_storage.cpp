@@ -458,6 +458,26 @@ namespace aux {
 		return piece_index_t{aux::numeric_cast<int>(file_offset(f) / piece_length())};
 	}
 
+	std::int64_t file_storage::memory_usage() const
+	{
+		std::int64_t ret = std::int64_t(m_files.capacity()) * std::int64_t(sizeof(aux::file_entry));
+		for (auto const& fe : m_files)
+		{
+			// filenames that aren't owned point into the info section
+			// buffer, which is accounted separately
+			if (fe.name_len == aux::file_entry::name_is_owned)
+				ret += std::int64_t(fe.filename().size()) + 1;
+		}
+		ret += std::int64_t(m_file_hashes.capacity()) * std::int64_t(sizeof(char const*));
+		ret += std::int64_t(m_symlinks.capacity()) * std::int64_t(sizeof(std::string));
+		for (auto const& s : m_symlinks) ret += std::int64_t(s.capacity());
+		ret += std::int64_t(m_mtime.capacity()) * std::int64_t(sizeof(std::time_t));
+		ret += std::int64_t(m_paths.capacity()) * std::int64_t(sizeof(std::string));
+		for (auto const& p : m_paths) ret += std::int64_t(p.capacity());
+		ret += std::int64_t(m_name.capacity());
+		return ret;
+	}
+
 #if TORRENT_ABI_VERSION <= 2
 	char const* file_storage::file_name_ptr(file_index_t const index) const
 	{
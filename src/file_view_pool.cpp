@@ -71,10 +71,11 @@ namespace libtorrent { namespace aux {
 		std::shared_ptr<file_mapping> defer_destruction1;
 		std::shared_ptr<file_mapping> defer_destruction2;
 
-		std::unique_lock<std::mutex> l(m_mutex);
+		shard& s = shard_for(st);
+		std::unique_lock<std::mutex> l(s.mutex);
 
 		TORRENT_ASSERT(is_complete(p));
-		auto& key_view = m_files.get<0>();
+		auto& key_view = s.files.get<0>();
 		auto i = key_view.find(file_id{st, file_index});
 
 		// make sure the write bit is set if we asked for it
@@ -89,21 +90,22 @@ namespace libtorrent { namespace aux {
 				e.last_use = aux::time_now();
 			});
 
-			auto& lru_view = m_files.get<1>();
-			lru_view.relocate(m_files.project<1>(i), lru_view.begin());
+			auto& lru_view = s.files.get<1>();
+			lru_view.relocate(s.files.project<1>(i), lru_view.begin());
 
 			return i->mapping->view();
 		}
 
-		if (int(m_files.size()) >= m_size - 1)
+		l.unlock();
+
+		if (m_num_files >= m_size - 1)
 		{
 			// the file cache is at its maximum size, close
-			// the least recently used file
-			defer_destruction1 = remove_oldest(l);
+			// the least recently used file. This locks other shards, which is
+			// why our own shard is unlocked first
+			defer_destruction1 = remove_oldest();
 		}
 
-		l.unlock();
-
 #if TORRENT_HAVE_MAP_VIEW_OF_FILE
 		std::unique_lock<std::mutex> lou(*open_unmap_lock);
 #endif
@@ -129,7 +131,11 @@ namespace libtorrent { namespace aux {
 		// entry. If not, overwrite it with the newly opened file ``e``.
 		bool added;
 		std::tie(i, added) = key_view.insert(e);
-		if (added == false)
+		if (added)
+		{
+			++m_num_files;
+		}
+		else
 		{
 			// this is the case where this file was already in the pool. Make
 			// sure we can use it. If we asked for write mode, it must have been
@@ -145,13 +151,34 @@ namespace libtorrent { namespace aux {
 				});
 			}
 
-			auto& lru_view = m_files.get<1>();
-			lru_view.relocate(m_files.project<1>(i), lru_view.begin());
+			auto& lru_view = s.files.get<1>();
+			lru_view.relocate(s.files.project<1>(i), lru_view.begin());
 		}
 
 		return i->mapping->view();
 	}
 
+	boost::optional<file_view> file_view_pool::lookup(storage_index_t const st
+		, file_index_t const file_index)
+	{
+		shard& s = shard_for(st);
+		std::unique_lock<std::mutex> l(s.mutex);
+
+		auto& key_view = s.files.get<0>();
+		auto const i = key_view.find(file_id{st, file_index});
+		if (i == key_view.end()) return boost::none;
+
+		key_view.modify(i, [&](file_entry& e)
+		{
+			e.last_use = aux::time_now();
+		});
+
+		auto& lru_view = s.files.get<1>();
+		lru_view.relocate(s.files.project<1>(i), lru_view.begin());
+
+		return i->mapping->view();
+	}
+
 	file_open_mode_t to_file_open_mode(open_mode_t const mode)
 	{
 		return ((mode & open_mode::write)
@@ -165,9 +192,10 @@ namespace libtorrent { namespace aux {
 	{
 		std::vector<open_file_state> ret;
 		{
-			std::unique_lock<std::mutex> l(m_mutex);
+			shard const& s = shard_for(st);
+			std::unique_lock<std::mutex> l(s.mutex);
 
-			auto& key_view = m_files.get<0>();
+			auto& key_view = s.files.get<0>();
 			auto const start = key_view.lower_bound(file_id{st, file_index_t(0)});
 			auto const end = key_view.upper_bound(file_id{st, std::numeric_limits<file_index_t>::max()});
 
@@ -181,13 +209,36 @@ namespace libtorrent { namespace aux {
 		return ret;
 	}
 
-	std::shared_ptr<file_mapping> file_view_pool::remove_oldest(std::unique_lock<std::mutex>&)
+	std::shared_ptr<file_mapping> file_view_pool::remove_oldest()
 	{
-		auto& lru_view = m_files.get<1>();
-		if (lru_view.size() == 0) return {};
+		// find the shard whose least recently used file is the oldest
+		// overall. Shards are only locked one at a time, so the answer is
+		// approximate: a concurrent open may touch the candidate before we
+		// get back to it. That just means a slightly younger file gets
+		// closed, which is fine
+		int best = -1;
+		time_point oldest = (time_point::max)();
+		for (int i = 0; i < num_shards; ++i)
+		{
+			std::unique_lock<std::mutex> l(m_shards[std::size_t(i)].mutex);
+			auto& lru_view = m_shards[std::size_t(i)].files.get<1>();
+			if (lru_view.empty()) continue;
+			if (lru_view.back().last_use < oldest)
+			{
+				oldest = lru_view.back().last_use;
+				best = i;
+			}
+		}
+		if (best == -1) return {};
+
+		shard& s = m_shards[std::size_t(best)];
+		std::unique_lock<std::mutex> l(s.mutex);
+		auto& lru_view = s.files.get<1>();
+		if (lru_view.empty()) return {};
 
 		auto mapping = std::move(lru_view.back().mapping);
 		lru_view.pop_back();
+		--m_num_files;
 
 		// closing a file may be long running operation (mac os x)
 		// let the caller destruct it once it has released the mutex
@@ -196,14 +247,16 @@ namespace libtorrent { namespace aux {
 
 	void file_view_pool::release(storage_index_t const st, file_index_t file_index)
 	{
-		std::unique_lock<std::mutex> l(m_mutex);
+		shard& s = shard_for(st);
+		std::unique_lock<std::mutex> l(s.mutex);
 
-		auto& key_view = m_files.get<0>();
+		auto& key_view = s.files.get<0>();
 		auto const i = key_view.find(file_id{st, file_index});
 		if (i == key_view.end()) return;
 
 		auto mapping = std::move(i->mapping);
 		key_view.erase(i);
+		--m_num_files;
 
 		// closing a file may take a long time (mac os x), so make sure
 		// we're not holding the mutex
@@ -214,60 +267,67 @@ namespace libtorrent { namespace aux {
 	// storage, or all if none is specified.
 	void file_view_pool::release()
 	{
-		std::unique_lock<std::mutex> l(m_mutex);
-		std::unique_lock<std::mutex> l2(m_destruction_mutex);
-		m_deferred_destruction = std::move(m_files);
-		l.unlock();
-
-		// the files and mappings will be destructed here, not holding the main
-		// mutex
-		m_deferred_destruction.clear();
+		for (shard& s : m_shards)
+		{
+			std::unique_lock<std::mutex> l(s.mutex);
+			std::unique_lock<std::mutex> l2(s.destruction_mutex);
+			m_num_files -= int(s.files.size());
+			s.deferred_destruction = std::move(s.files);
+			l.unlock();
+
+			// the files and mappings will be destructed here, not holding the
+			// shard mutex
+			s.deferred_destruction.clear();
+		}
 	}
 
 	void file_view_pool::release(storage_index_t const st)
 	{
 		std::vector<std::shared_ptr<file_mapping>> defer_destruction;
 
-		std::unique_lock<std::mutex> l(m_mutex);
+		shard& s = shard_for(st);
+		std::unique_lock<std::mutex> l(s.mutex);
 
-		auto& key_view = m_files.get<0>();
+		auto& key_view = s.files.get<0>();
 		auto const begin = key_view.lower_bound(file_id{st, file_index_t(0)});
 		auto const end = key_view.upper_bound(file_id{st, std::numeric_limits<file_index_t>::max()});
 
 		for (auto it = begin; it != end; ++it)
 			defer_destruction.emplace_back(std::move(it->mapping));
 
-		if (begin != end) key_view.erase(begin, end);
+		if (begin != end)
+		{
+			m_num_files -= int(defer_destruction.size());
+			key_view.erase(begin, end);
+		}
 		l.unlock();
 		// the files are closed here while the lock is not held
 	}
 
 	void file_view_pool::resize(int const size)
 	{
-		// these are destructed _after_ the mutex is released
+		// these are destructed _after_ all shard mutexes are released
 		std::vector<std::shared_ptr<file_mapping>> defer_destruction;
 
-		std::unique_lock<std::mutex> l(m_mutex);
-
 		TORRENT_ASSERT(size > 0);
 
 		if (size == m_size) return;
 		m_size = size;
-		if (int(m_files.size()) <= m_size) return;
 
 		// close the least recently used files
-		while (int(m_files.size()) > m_size)
-			defer_destruction.emplace_back(remove_oldest(l));
+		while (m_num_files > m_size)
+		{
+			auto mapping = remove_oldest();
+			if (!mapping) break;
+			defer_destruction.emplace_back(std::move(mapping));
+		}
 	}
 
 	void file_view_pool::close_oldest()
 	{
 		// closing a file may be long running operation (mac os x)
-		// destruct it after the mutex is released
-		std::shared_ptr<file_mapping> deferred_destruction;
-
-		std::unique_lock<std::mutex> l(m_mutex);
-		deferred_destruction = remove_oldest(l);
+		// destruct it after the shard mutex is released
+		std::shared_ptr<file_mapping> deferred_destruction = remove_oldest();
 	}
 }
 }
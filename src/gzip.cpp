@@ -195,14 +195,27 @@ namespace {
 			return;
 		}
 
-		// start off with 4 kilobytes and grow
-		// if needed
-		unsigned long destlen = 4096;
-		int ret = 0;
 		in = in.subspan(header_len);
+
+		// first run through the compressed data just counting the inflated
+		// size, without producing any output (puff supports a null
+		// destination for this). It lets us reject oversized responses
+		// before allocating anything, and then allocate the output buffer
+		// exactly once, instead of repeatedly growing it and re-inflating
+		// from scratch
+		unsigned long destlen = 0;
 		unsigned long srclen = std::uint32_t(in.size());
+		int ret = puff(nullptr, &destlen
+			, reinterpret_cast<const unsigned char*>(in.data())
+			, &srclen);
+
+		if (ret == 0 && destlen > std::uint32_t(maximum_size))
+		{
+			ec = gzip_errors::inflated_data_too_large;
+			return;
+		}
 
-		do
+		if (ret == 0 && destlen > 0)
 		{
 			TORRENT_TRY {
 				buffer.resize(destlen);
@@ -211,27 +224,12 @@ namespace {
 				return;
 			}
 
+			srclen = std::uint32_t(in.size());
 			ret = puff(reinterpret_cast<unsigned char*>(buffer.data())
 				, &destlen
 				, reinterpret_cast<const unsigned char*>(in.data())
 				, &srclen);
-
-			// if the destination buffer wasn't large enough, double its
-			// size and try again. Unless it's already at its max, in which
-			// case we fail
-			if (ret == 1) // 1:  output space exhausted before completing inflate
-			{
-				if (destlen == std::uint32_t(maximum_size))
-				{
-					ec = gzip_errors::inflated_data_too_large;
-					return;
-				}
-
-				destlen *= 2;
-				if (destlen > std::uint32_t(maximum_size))
-					destlen = std::uint32_t(maximum_size);
-			}
-		} while (ret == 1);
+		}
 
 		if (ret != 0)
 		{
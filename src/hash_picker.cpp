@@ -276,19 +276,20 @@ bool validate_hash_request(hash_request const& hr, file_storage const& fs)
 
 		TORRENT_ASSERT(uncle_hashes.size() == num_uncle_hashes);
 
-		aux::vector<sha256_hash> tree(merkle_num_nodes(leaf_count));
-		std::copy(hashes.begin(), hashes.end(), tree.end() - leaf_count);
-
-		// the end of a file is a special case, we may need to pad the leaf layer
-		if (req.base == m_piece_layer && leaf_count != req.count)
-		{
-			sha256_hash const pad_hash = merkle_pad(
-				m_files.piece_length() / default_block_size, 1);
-			for (int i = req.count; i < leaf_count; ++i)
-				tree[tree.end_index() - leaf_count + i] = pad_hash;
-		}
-
-		merkle_fill_tree(tree, leaf_count);
+		auto& tree = m_tree_scratch;
+		tree.assign(merkle_num_nodes(leaf_count), sha256_hash{});
+		int const first_leaf = merkle_first_leaf(leaf_count);
+		std::copy(hashes.begin(), hashes.end(), tree.begin() + first_leaf);
+
+		// the end of a file is a special case, we may need to pad the leaf
+		// layer. All-pad sub-trees hash to the same value within a level, so
+		// fill them with one hash per level and only compute the ancestors
+		// of the hashes we received
+		sha256_hash const pad_hash = (req.base == m_piece_layer)
+			? merkle_pad(m_files.piece_length() / default_block_size, 1)
+			: sha256_hash{};
+		merkle_fill_pad(tree, leaf_count, first_leaf, req.count, pad_hash);
+		merkle_update_tree(tree, leaf_count, first_leaf, 0, req.count);
 
 		int const base_layer_idx = file_num_layers(req.file) - req.base;
 
@@ -326,6 +327,16 @@ bool validate_hash_request(hash_request const& hr, file_storage const& fs)
 			TORRENT_ASSERT(req.base == m_piece_layer);
 			int const file_piece_offset = int(m_files.file_offset(req.file) / m_files.piece_length());
 
+			// the hashes validated against the root, record that we have
+			// this span so pick_hashes() doesn't keep requesting it from
+			// other peers
+			auto& requested = m_piece_hash_requested[req.file];
+			for (int i = req.index; i < req.index + req.count
+				&& i / 512 < requested.end_index(); i += 512)
+			{
+				requested[i / 512].have = true;
+			}
+
 			ret.hash_passed = dst_tree.check_pieces(req.base, req.index
 				, file_piece_offset, hashes);
 		}
@@ -38,8 +38,276 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/error_code.hpp"
 #include "libtorrent/assert.hpp"
 
+#include <algorithm> // for min
+#include <array>
+#include <map>
+#include <mutex>
+
+#if TORRENT_HAS_SSE && (defined __GNUC__ || defined _MSC_VER)
+#define TORRENT_HAS_SHA256_MB_AVX2 1
+#include <immintrin.h>
+#include <cstring>
+#include "libtorrent/aux_/cpuid.hpp"
+#if defined __GNUC__
+#define TORRENT_SHA256_MB_FUN __attribute__((target("avx2")))
+#else
+#define TORRENT_SHA256_MB_FUN
+#endif
+#else
+#define TORRENT_HAS_SHA256_MB_AVX2 0
+#endif
+
+#include "libtorrent/aux_/cpuid.hpp"
+
 namespace libtorrent {
 
+namespace aux {
+
+	int sha1_backend()
+	{
+#if defined TORRENT_USE_LIBGCRYPT
+		return sha1_backend_gcrypt;
+#elif TORRENT_USE_COMMONCRYPTO
+		return sha1_backend_commoncrypto;
+#elif TORRENT_USE_CNG
+		return sha1_backend_cng;
+#elif TORRENT_USE_CRYPTOAPI
+		return sha1_backend_cryptoapi;
+#elif defined TORRENT_USE_LIBCRYPTO
+		return sha1_backend_libcrypto;
+#else
+		// mirror the dispatch conditions in sha1.cpp
+#if TORRENT_HAS_SSE && (defined __GNUC__ || defined _MSC_VER)
+		if (sha_ni_support) return sha1_backend_sha_ni;
+#endif
+#if defined __aarch64__ && defined __ARM_NEON \
+	&& (defined __ARM_FEATURE_CRYPTO || defined __ARM_FEATURE_SHA2 \
+		|| defined __clang__ || (defined __GNUC__ && __GNUC__ >= 9))
+		if (arm_sha1_support) return sha1_backend_arm;
+#endif
+		return sha1_backend_builtin;
+#endif
+	}
+
+	namespace {
+
+		template <typename Hasher, typename Digest>
+		Digest zeroes_digest(int const size, std::map<int, Digest>& cache
+			, std::mutex& mut)
+		{
+			TORRENT_ASSERT(size >= 0);
+			{
+				std::lock_guard<std::mutex> l(mut);
+				auto const it = cache.find(size);
+				if (it != cache.end()) return it->second;
+			}
+
+			// feed the hasher a modest zero buffer repeatedly rather than
+			// allocating one of the full size
+			std::array<char, 4096> const zeroes{};
+			Hasher h;
+			for (int left = size; left > 0;)
+			{
+				int const n = std::min(left, int(zeroes.size()));
+				h.update({zeroes.data(), n});
+				left -= n;
+			}
+			Digest const ret = h.final();
+
+			std::lock_guard<std::mutex> l(mut);
+			cache[size] = ret;
+			return ret;
+		}
+	}
+
+	sha1_hash hash_of_zeroes(int const size)
+	{
+		static std::mutex mut;
+		static std::map<int, sha1_hash> cache;
+		return zeroes_digest<hasher>(size, cache, mut);
+	}
+
+	sha256_hash hash2_of_zeroes(int const size)
+	{
+		static std::mutex mut;
+		static std::map<int, sha256_hash> cache;
+		return zeroes_digest<hasher256>(size, cache, mut);
+	}
+}
+
+#if TORRENT_HAS_SHA256_MB_AVX2
+namespace {
+
+	std::uint32_t read_be32(unsigned char const* const p)
+	{
+		return (std::uint32_t(p[0]) << 24)
+			| (std::uint32_t(p[1]) << 16)
+			| (std::uint32_t(p[2]) << 8)
+			| std::uint32_t(p[3]);
+	}
+
+	void write_be32(unsigned char* const p, std::uint32_t const v)
+	{
+		p[0] = (v >> 24) & 0xff;
+		p[1] = (v >> 16) & 0xff;
+		p[2] = (v >> 8) & 0xff;
+		p[3] = v & 0xff;
+	}
+
+	std::uint32_t const sha256_k[64] = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+		0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+		0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+		0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+		0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+		0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+		0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+		0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+		0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+	};
+
+	// hashes 8 equal-length buffers in lockstep, one per 32-bit lane of the
+	// YMM registers. This is a straight SHA-256 with every scalar operation
+	// replaced by its 8-wide counterpart; there are no data dependencies
+	// between the buffers so all lanes stay busy for the full message
+	TORRENT_SHA256_MB_FUN
+	void sha256_x8_avx2(unsigned char const* const* bufs
+		, std::ptrdiff_t const len, sha256_hash* const digests)
+	{
+
+#define TORRENT_ROR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define TORRENT_XOR3(a, b, c) _mm256_xor_si256(_mm256_xor_si256(a, b), c)
+
+		static std::uint32_t const init[8] = {
+			0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+			0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+		};
+
+		__m256i st[8];
+		for (int i = 0; i < 8; ++i)
+			st[i] = _mm256_set1_epi32(int(init[i]));
+
+		// build the tail of each message up front: the remaining bytes, the
+		// 0x80 terminator, zero padding and the 64-bit big-endian bit count
+		std::ptrdiff_t const tail = len % 64;
+		int const pad_blocks = (tail >= 56) ? 2 : 1;
+		unsigned char pad[8][128];
+		for (int l = 0; l < 8; ++l)
+		{
+			std::memcpy(pad[l], bufs[l] + (len - tail), std::size_t(tail));
+			std::memset(pad[l] + tail, 0, std::size_t(pad_blocks * 64 - tail));
+			pad[l][tail] = 0x80;
+			std::uint64_t const bits = std::uint64_t(len) * 8;
+			for (int b = 0; b < 8; ++b)
+				pad[l][pad_blocks * 64 - 1 - b] = (bits >> (b * 8)) & 0xff;
+		}
+
+		std::ptrdiff_t const full_blocks = len / 64;
+		for (std::ptrdiff_t blk = 0; blk < full_blocks + pad_blocks; ++blk)
+		{
+			unsigned char const* p[8];
+			for (int l = 0; l < 8; ++l)
+			{
+				p[l] = (blk < full_blocks)
+					? bufs[l] + blk * 64
+					: pad[l] + (blk - full_blocks) * 64;
+			}
+
+			// w[t] holds word t of the message schedule, lane l taken from
+			// buffer l
+			__m256i w[16];
+			for (int t = 0; t < 16; ++t)
+			{
+				w[t] = _mm256_set_epi32(
+					int(read_be32(p[7] + t * 4)), int(read_be32(p[6] + t * 4))
+					, int(read_be32(p[5] + t * 4)), int(read_be32(p[4] + t * 4))
+					, int(read_be32(p[3] + t * 4)), int(read_be32(p[2] + t * 4))
+					, int(read_be32(p[1] + t * 4)), int(read_be32(p[0] + t * 4)));
+			}
+
+			__m256i a = st[0];
+			__m256i b = st[1];
+			__m256i c = st[2];
+			__m256i d = st[3];
+			__m256i e = st[4];
+			__m256i f = st[5];
+			__m256i g = st[6];
+			__m256i h = st[7];
+
+			for (int t = 0; t < 64; ++t)
+			{
+				if (t >= 16)
+				{
+					__m256i const w15 = w[(t + 1) & 15];
+					__m256i const w2 = w[(t + 14) & 15];
+					__m256i const s0 = TORRENT_XOR3(TORRENT_ROR(w15, 7)
+						, TORRENT_ROR(w15, 18), _mm256_srli_epi32(w15, 3));
+					__m256i const s1 = TORRENT_XOR3(TORRENT_ROR(w2, 17)
+						, TORRENT_ROR(w2, 19), _mm256_srli_epi32(w2, 10));
+					w[t & 15] = _mm256_add_epi32(
+						_mm256_add_epi32(w[t & 15], w[(t + 9) & 15])
+						, _mm256_add_epi32(s0, s1));
+				}
+
+				__m256i const big_s1 = TORRENT_XOR3(TORRENT_ROR(e, 6)
+					, TORRENT_ROR(e, 11), TORRENT_ROR(e, 25));
+				__m256i const ch = _mm256_xor_si256(
+					_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+				__m256i const t1 = _mm256_add_epi32(
+					_mm256_add_epi32(_mm256_add_epi32(h, big_s1)
+						, _mm256_add_epi32(ch, w[t & 15]))
+					, _mm256_set1_epi32(int(sha256_k[t])));
+				__m256i const big_s0 = TORRENT_XOR3(TORRENT_ROR(a, 2)
+					, TORRENT_ROR(a, 13), TORRENT_ROR(a, 22));
+				__m256i const maj = TORRENT_XOR3(_mm256_and_si256(a, b)
+					, _mm256_and_si256(a, c), _mm256_and_si256(b, c));
+				__m256i const t2 = _mm256_add_epi32(big_s0, maj);
+
+				h = g;
+				g = f;
+				f = e;
+				e = _mm256_add_epi32(d, t1);
+				d = c;
+				c = b;
+				b = a;
+				a = _mm256_add_epi32(t1, t2);
+			}
+
+			st[0] = _mm256_add_epi32(st[0], a);
+			st[1] = _mm256_add_epi32(st[1], b);
+			st[2] = _mm256_add_epi32(st[2], c);
+			st[3] = _mm256_add_epi32(st[3], d);
+			st[4] = _mm256_add_epi32(st[4], e);
+			st[5] = _mm256_add_epi32(st[5], f);
+			st[6] = _mm256_add_epi32(st[6], g);
+			st[7] = _mm256_add_epi32(st[7], h);
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			alignas(32) std::uint32_t out[8];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(out), st[i]);
+			for (int l = 0; l < 8; ++l)
+			{
+				write_be32(reinterpret_cast<unsigned char*>(
+					digests[l].data()) + i * 4, out[l]);
+			}
+		}
+
+#undef TORRENT_ROR
+#undef TORRENT_XOR3
+	}
+
+} // anonymous namespace
+#endif // TORRENT_HAS_SHA256_MB_AVX2
+
 TORRENT_CRYPTO_NAMESPACE
 
 	hasher::hasher()
@@ -267,6 +535,38 @@ TORRENT_CRYPTO_NAMESPACE
 #endif
 	}
 
+	void hasher256::hash_blocks(span<span<char const> const> bufs
+		, span<sha256_hash> digests)
+	{
+		TORRENT_ASSERT(digests.size() >= bufs.size());
+		int i = 0;
+		int const n = int(bufs.size());
+#if TORRENT_HAS_SHA256_MB_AVX2
+		if (aux::avx2_support)
+		{
+			while (n - i >= 8)
+			{
+				// the lanes run in lockstep, so all 8 buffers must be the
+				// same length. In practice only the last buffer of a batch
+				// ever differs, it falls through to the loop below
+				std::ptrdiff_t const len = bufs[i].size();
+				bool uniform = len > 0;
+				for (int k = 1; k < 8; ++k)
+					uniform &= bufs[i + k].size() == len;
+				if (!uniform) break;
+
+				unsigned char const* ptrs[8];
+				for (int k = 0; k < 8; ++k)
+					ptrs[k] = reinterpret_cast<unsigned char const*>(bufs[i + k].data());
+				sha256_x8_avx2(ptrs, len, &digests[i]);
+				i += 8;
+			}
+		}
+#endif
+		for (; i < n; ++i)
+			digests[i] = hasher256(bufs[i]).final();
+	}
+
 	hasher256::~hasher256()
 	{
 #if defined TORRENT_USE_LIBGCRYPT
@@ -247,22 +247,26 @@ restart_response:
 		{
 			TORRENT_ASSERT(!m_finished);
 			TORRENT_ASSERT(pos <= recv_buffer.end());
+			// note that std::find() of a char lowers to memchr(), which is
+			// vectorized by the C library. Don't replace these scans with
+			// manual loops
 			char const* newline = std::find(pos, recv_buffer.end(), '\n');
-			std::string line;
 
 			while (newline != recv_buffer.end() && m_state == read_header)
 			{
 				// if the LF character is preceded by a CR
-				// character, don't copy it into the line string.
+				// character, don't include it in the line
 				char const* line_end = newline;
 				if (pos != line_end && *(line_end - 1) == '\r') --line_end;
-				line.assign(pos, line_end);
+				char const* const line = pos;
 				++newline;
 				m_recv_pos += newline - pos;
 				pos = newline;
 
-				std::string::size_type separator = line.find(':');
-				if (separator == std::string::npos)
+				// the header line is parsed in place, straight out of the
+				// receive buffer. Only the name and value are copied out
+				char const* const separator = std::find(line, line_end, ':');
+				if (separator == line_end)
 				{
 					if (m_status_code == 100)
 					{
@@ -284,14 +288,14 @@ restart_response:
 					break;
 				}
 
-				std::string name = line.substr(0, separator);
+				std::string name(line, separator);
 				std::transform(name.begin(), name.end(), name.begin(), &to_lower);
-				++separator;
+				char const* value_start = separator + 1;
 				// skip whitespace
-				while (separator < line.size()
-					&& (line[separator] == ' ' || line[separator] == '\t'))
-					++separator;
-				std::string value = line.substr(separator, std::string::npos);
+				while (value_start != line_end
+					&& (*value_start == ' ' || *value_start == '\t'))
+					++value_start;
+				std::string value(value_start, line_end);
 				m_header.insert(std::make_pair(name, value));
 
 				if (name == "content-length")
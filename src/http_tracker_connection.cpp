@@ -98,6 +98,10 @@ namespace libtorrent {
 
 		aux::session_settings const& settings = m_man.settings();
 
+		// the query string is appended piecewise below; reserve room for it
+		// up front rather than growing the string repeatedly
+		url.reserve(url.size() + 512);
+
 		// if request-string already contains
 		// some parameters, append an ampersand instead
 		// of a question mark
@@ -209,6 +213,16 @@ namespace libtorrent {
 		}
 
 		using namespace std::placeholders;
+		// each announce deliberately uses a fresh, single-shot connection
+		// (http_connection requests "Connection: close"). Pooling idle
+		// connections per tracker host was considered, but http_connection
+		// binds its completion handlers at construction and only reuses its
+		// socket for redirects within one request, so a keep-alive pool
+		// would mean re-architecting it and handling stale-connection races
+		// (a server may close an idle connection just as we reuse it). With
+		// the default announce interval, the handshake amortizes over
+		// 30 minutes per torrent; trackers that care deploy anyway behind
+		// TLS terminators where handshakes are cheap
 		m_tracker_connection = std::make_shared<http_connection>(m_ioc, m_man.host_resolver()
 			, std::bind(&http_tracker_connection::on_response, shared_from_this(), _1, _2, _3)
 			, true, settings.get_int(settings_pack::max_http_recv_buffer_size)
@@ -47,6 +47,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/hex.hpp" // for to_hex
 #include "libtorrent/debug.hpp"
 
+#include <algorithm>
 #include <cstring>
 
 namespace libtorrent {
@@ -101,9 +102,72 @@ namespace libtorrent {
 
 	i2p_connection::~i2p_connection() = default;
 
+	namespace {
+		// the number of standby SAM bridge sockets to keep warm. Enough to
+		// absorb a burst of peer connection attempts while replacements are
+		// brought up
+		constexpr int max_warm_sockets = 4;
+	}
+
 	void i2p_connection::close(error_code& e)
 	{
 		if (m_sam_socket) m_sam_socket->close(e);
+		for (auto const& s : m_warm_connecting)
+		{
+			error_code ec;
+			s->close(ec);
+		}
+		for (auto const& s : m_warm_sockets)
+		{
+			error_code ec;
+			s->close(ec);
+		}
+		m_warm_sockets.clear();
+	}
+
+	bool i2p_connection::take_warm_socket(i2p_stream& s)
+	{
+		bool primed = false;
+		while (!primed && !m_warm_sockets.empty())
+		{
+			std::shared_ptr<i2p_stream> warm = std::move(m_warm_sockets.back());
+			m_warm_sockets.pop_back();
+			// the bridge may have torn the connection down while the socket
+			// sat idle
+			if (!warm->is_open()) continue;
+			s.set_sam_socket(std::move(warm->next_layer()));
+			primed = true;
+		}
+		// start replacing whatever was handed out (or found dead)
+		refresh_warm_sockets();
+		return primed;
+	}
+
+	void i2p_connection::refresh_warm_sockets()
+	{
+		if (!is_open()) return;
+		while (int(m_warm_sockets.size() + m_warm_connecting.size())
+			< max_warm_sockets)
+		{
+			auto s = std::make_shared<i2p_stream>(m_io_service);
+			s->set_proxy(m_hostname, m_port);
+			s->set_command(i2p_stream::cmd_none);
+			m_warm_connecting.push_back(s);
+			ADD_OUTSTANDING_ASYNC("i2p_connection::on_warm_connect");
+			s->async_connect(tcp::endpoint()
+				, [this, s](error_code const& ec) { on_warm_connect(ec, s); });
+		}
+	}
+
+	void i2p_connection::on_warm_connect(error_code const& ec
+		, std::shared_ptr<i2p_stream> s)
+	{
+		COMPLETE_ASYNC("i2p_connection::on_warm_connect");
+		auto const i = std::find(m_warm_connecting.begin()
+			, m_warm_connecting.end(), s);
+		if (i != m_warm_connecting.end()) m_warm_connecting.erase(i);
+		if (ec || !s->is_open()) return;
+		m_warm_sockets.push_back(std::move(s));
 	}
 
 	aux::proxy_settings i2p_connection::proxy() const
@@ -0,0 +1,1045 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "libtorrent/config.hpp"
+#include "libtorrent/io_uring_disk_io.hpp"
+
+#if TORRENT_USE_IOURING
+
+#include "libtorrent/disk_interface.hpp"
+#include "libtorrent/aux_/disk_buffer_pool.hpp"
+#include "libtorrent/io_context.hpp"
+#include "libtorrent/performance_counters.hpp"
+#include "libtorrent/aux_/session_settings.hpp"
+#include "libtorrent/aux_/path.hpp"
+#include "libtorrent/aux_/numeric_cast.hpp"
+#include "libtorrent/aux_/posix_storage.hpp"
+#include "libtorrent/stat_cache.hpp"
+#include "libtorrent/file_storage.hpp"
+#include "libtorrent/hasher.hpp"
+#include "libtorrent/add_torrent_params.hpp"
+#include "libtorrent/aux_/merkle.hpp"
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#include "libtorrent/download_priority.hpp"
+
+namespace libtorrent {
+
+namespace {
+
+	storage_index_t pop(std::vector<storage_index_t>& q)
+	{
+		TORRENT_ASSERT(!q.empty());
+		storage_index_t const ret = q.back();
+		q.pop_back();
+		return ret;
+	}
+
+	using aux::posix_storage;
+
+	int sys_io_uring_setup(unsigned const entries, ::io_uring_params* p)
+	{ return int(::syscall(__NR_io_uring_setup, entries, p)); }
+
+	int sys_io_uring_enter(int const fd, unsigned const to_submit
+		, unsigned const min_complete, unsigned const flags)
+	{
+		return int(::syscall(__NR_io_uring_enter, fd, to_submit
+			, min_complete, flags, nullptr, 0));
+	}
+
+	// a minimal wrapper around the raw io_uring system call interface. We
+	// don't depend on liburing, the setup and ring accounting is simple
+	// enough to do in-line. Only the submission thread touches the ring, so
+	// the only synchronization needed is with the kernel (acquire/release on
+	// the shared head/tail indices)
+	struct uring
+	{
+		bool init(unsigned const entries)
+		{
+			::io_uring_params p;
+			std::memset(&p, 0, sizeof(p));
+			m_fd = sys_io_uring_setup(entries, &p);
+			if (m_fd < 0) return false;
+
+			std::size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+			std::size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(::io_uring_cqe);
+			bool const single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (single_mmap)
+			{
+				if (cq_size > sq_size) sq_size = cq_size;
+				cq_size = sq_size;
+			}
+
+			m_sq_ptr = ::mmap(nullptr, sq_size, PROT_READ | PROT_WRITE
+				, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+			if (m_sq_ptr == MAP_FAILED) { close_ring(); return false; }
+			m_sq_map_size = sq_size;
+
+			if (single_mmap)
+			{
+				m_cq_ptr = m_sq_ptr;
+			}
+			else
+			{
+				m_cq_ptr = ::mmap(nullptr, cq_size, PROT_READ | PROT_WRITE
+					, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+				if (m_cq_ptr == MAP_FAILED) { close_ring(); return false; }
+				m_cq_map_size = cq_size;
+			}
+
+			m_sqes_map_size = p.sq_entries * sizeof(::io_uring_sqe);
+			void* sqes = ::mmap(nullptr, m_sqes_map_size, PROT_READ | PROT_WRITE
+				, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+			if (sqes == MAP_FAILED) { close_ring(); return false; }
+			m_sqes = static_cast<::io_uring_sqe*>(sqes);
+
+			auto sq = static_cast<char*>(m_sq_ptr);
+			m_sq_head = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+			m_sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+			m_sq_mask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+			m_sq_entries = p.sq_entries;
+			auto sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+			// identity-map the submission array once. SQE index i always goes
+			// in array slot i, so submission just has to bump the tail
+			for (unsigned i = 0; i < p.sq_entries; ++i) sq_array[i] = i;
+
+			auto cq = static_cast<char*>(m_cq_ptr);
+			m_cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+			m_cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+			m_cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+			m_cqes = reinterpret_cast<::io_uring_cqe*>(cq + p.cq_off.cqes);
+
+			m_tail = *m_sq_tail;
+			return true;
+		}
+
+		~uring() { close_ring(); }
+
+		::io_uring_sqe* get_sqe()
+		{
+			unsigned const head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+			if (m_tail - head >= m_sq_entries) return nullptr;
+			::io_uring_sqe* s = &m_sqes[m_tail & m_sq_mask];
+			std::memset(s, 0, sizeof(*s));
+			++m_tail;
+			++m_pending;
+			return s;
+		}
+
+		// submit any SQEs handed out by get_sqe(). If wait is true, also block
+		// until at least one completion is available
+		int submit(bool const wait)
+		{
+			__atomic_store_n(m_sq_tail, m_tail, __ATOMIC_RELEASE);
+			unsigned const to_submit = m_pending;
+			m_pending = 0;
+			return sys_io_uring_enter(m_fd, to_submit, wait ? 1 : 0
+				, wait ? IORING_ENTER_GETEVENTS : 0);
+		}
+
+		::io_uring_cqe* peek_cqe()
+		{
+			unsigned const tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+			if (*m_cq_head == tail) return nullptr;
+			return &m_cqes[*m_cq_head & m_cq_mask];
+		}
+
+		void pop_cqe()
+		{ __atomic_store_n(m_cq_head, *m_cq_head + 1, __ATOMIC_RELEASE); }
+
+		bool valid() const { return m_fd >= 0; }
+
+	private:
+
+		void close_ring()
+		{
+			if (m_sqes != nullptr) ::munmap(m_sqes, m_sqes_map_size);
+			if (m_cq_ptr != nullptr && m_cq_ptr != m_sq_ptr) ::munmap(m_cq_ptr, m_cq_map_size);
+			if (m_sq_ptr != nullptr) ::munmap(m_sq_ptr, m_sq_map_size);
+			if (m_fd >= 0) ::close(m_fd);
+			m_sqes = nullptr;
+			m_cq_ptr = nullptr;
+			m_sq_ptr = nullptr;
+			m_fd = -1;
+		}
+
+		int m_fd = -1;
+		void* m_sq_ptr = nullptr;
+		void* m_cq_ptr = nullptr;
+		::io_uring_sqe* m_sqes = nullptr;
+		std::size_t m_sq_map_size = 0;
+		std::size_t m_cq_map_size = 0;
+		std::size_t m_sqes_map_size = 0;
+
+		unsigned* m_sq_head = nullptr;
+		unsigned* m_sq_tail = nullptr;
+		unsigned m_sq_mask = 0;
+		unsigned m_sq_entries = 0;
+
+		unsigned* m_cq_head = nullptr;
+		unsigned* m_cq_tail = nullptr;
+		unsigned m_cq_mask = 0;
+		::io_uring_cqe* m_cqes = nullptr;
+
+		// local copy of the SQ tail, only published to the kernel in submit()
+		unsigned m_tail = 0;
+
+		// number of SQEs handed out but not yet submitted
+		unsigned m_pending = 0;
+	};
+
+	// the number of in-flight operations the ring is sized for
+	constexpr unsigned ring_entries = 128;
+
+	// user_data value reserved for the eventfd wake-up poll
+	constexpr std::uint64_t wakeup_user_data = 0;
+
+} // anonymous namespace
+
+	struct TORRENT_EXTRA_EXPORT io_uring_disk_io final
+		: disk_interface
+		, buffer_allocator_interface
+	{
+		io_uring_disk_io(io_context& ios, settings_interface const& sett, counters& cnt)
+			: m_settings(sett)
+			, m_buffer_pool(ios)
+			, m_stats_counters(cnt)
+			, m_ios(ios)
+		{
+			settings_updated();
+			m_ring_ok = m_ring.init(ring_entries);
+			if (m_ring_ok)
+			{
+				m_event_fd = ::eventfd(0, EFD_NONBLOCK);
+				if (m_event_fd < 0) m_ring_ok = false;
+			}
+			m_thread = std::thread([this] { this->thread_fun(); });
+		}
+
+		~io_uring_disk_io() override
+		{
+			abort(true);
+			if (m_thread.joinable()) m_thread.join();
+			for (auto const& e : m_fd_cache) ::close(e.second.fd);
+			for (int const fd : m_deferred_close) ::close(fd);
+			if (m_event_fd >= 0) ::close(m_event_fd);
+		}
+
+		void settings_updated() override
+		{
+			m_buffer_pool.set_settings(m_settings);
+		}
+
+		storage_holder new_torrent(storage_params const& params
+			, std::shared_ptr<void> const&) override
+		{
+			// make sure we can remove this torrent without causing a memory
+			// allocation, by causing the allocation now instead
+			m_free_slots.reserve(m_torrents.size() + 1);
+			storage_index_t const idx = m_free_slots.empty()
+				? m_torrents.end_index()
+				: pop(m_free_slots);
+			auto storage = std::make_unique<posix_storage>(params);
+			if (idx == m_torrents.end_index())
+			{
+				m_torrents.emplace_back(std::move(storage));
+				m_save_paths.emplace_back(params.path);
+				m_need_fallback.push_back(false);
+			}
+			else
+			{
+				m_torrents[idx] = std::move(storage);
+				m_save_paths[idx] = params.path;
+				m_need_fallback[idx] = false;
+			}
+			// a part file may be in use for this torrent. Routing any of its
+			// I/O through raw file descriptors would bypass it, so pin such
+			// torrents to the synchronous fall-back path
+			for (download_priority_t const p : params.priorities)
+				if (p == dont_download) m_need_fallback[idx] = true;
+			return storage_holder(idx, *this);
+		}
+
+		void remove_torrent(storage_index_t const idx) override
+		{
+			// the fd cache is owned by the submission thread, so the
+			// descriptors have to be closed over there. The storage itself
+			// is torn down synchronously, before the slot is made reusable.
+			// Otherwise a new_torrent() picking up this slot before the
+			// queued job runs would have its storage destroyed by it. A
+			// torrent reusing the slot can only open descriptors through
+			// jobs queued after this one, so the deferred drop_fds() cannot
+			// close them
+			queue_job([this, idx] { drop_fds(idx); });
+			m_torrents[idx].reset();
+			m_free_slots.push_back(idx);
+		}
+
+		void abort(bool const wait) override
+		{
+			{
+				std::unique_lock<std::mutex> l(m_mutex);
+				if (m_abort) return;
+				m_abort = true;
+				m_cond.notify_all();
+			}
+			wake_ring();
+			if (wait && m_thread.joinable()) m_thread.join();
+		}
+
+		void async_read(storage_index_t storage, peer_request const& r
+			, std::function<void(disk_buffer_holder block, storage_error const& se)> handler
+			, disk_job_flags_t) override
+		{
+			auto j = std::make_shared<uring_job>();
+			j->buffer = disk_buffer_holder(*this, m_buffer_pool.allocate_buffer("send buffer"), default_block_size);
+			if (!j->buffer)
+			{
+				storage_error error;
+				error.ec = errors::no_memory;
+				error.operation = operation_t::alloc_cache_piece;
+				post(m_ios, [error, h = std::move(handler)]{ h(disk_buffer_holder{}, error); });
+				return;
+			}
+			j->storage = storage;
+			j->req = r;
+			j->read_handler = std::move(handler);
+			queue_job([this, j] { submit_read(j); });
+		}
+
+		bool async_write(storage_index_t storage, peer_request const& r
+			, char const* buf, std::shared_ptr<disk_observer>
+			, std::function<void(storage_error const&)> handler
+			, disk_job_flags_t) override
+		{
+			auto j = std::make_shared<uring_job>();
+			j->buffer = disk_buffer_holder(*this, m_buffer_pool.allocate_buffer("receive buffer"), default_block_size);
+			if (!j->buffer)
+			{
+				// we can't take a copy of the block. The caller's buffer is only
+				// guaranteed to stay alive for the duration of this call, so
+				// perform the write synchronously, the way the posix back-end
+				// does
+				iovec_t const b = { const_cast<char*>(buf), r.length };
+				time_point const start_time = clock_type::now();
+				storage_error error;
+				m_torrents[storage]->writev(m_settings, b, r.piece, r.start, error);
+				if (!error.ec)
+				{
+					std::int64_t const write_time = total_microseconds(clock_type::now() - start_time);
+					m_stats_counters.inc_stats_counter(counters::num_blocks_written);
+					m_stats_counters.inc_stats_counter(counters::num_write_ops);
+					m_stats_counters.inc_stats_counter(counters::disk_write_time, write_time);
+					m_stats_counters.inc_stats_counter(counters::disk_job_time, write_time);
+				}
+				post(m_ios, [error, h = std::move(handler)]{ h(error); });
+				return false;
+			}
+			std::memcpy(j->buffer.data(), buf, aux::numeric_cast<std::size_t>(r.length));
+			j->storage = storage;
+			j->req = r;
+			j->write_handler = std::move(handler);
+			queue_job([this, j] { submit_write(j); });
+			return false;
+		}
+
+		void async_hash(storage_index_t storage, piece_index_t const piece
+			, span<sha256_hash> block_hashes, disk_job_flags_t flags
+			, std::function<void(piece_index_t, sha1_hash const&, storage_error const&)> handler) override
+		{
+			bool const v1 = bool(flags & disk_interface::v1_hash);
+			queue_job([this, storage, piece, block_hashes, v1, h = std::move(handler)]
+			{
+				time_point const start_time = clock_type::now();
+
+				bool const v2 = !block_hashes.empty();
+
+				disk_buffer_holder buffer = disk_buffer_holder(*this, m_buffer_pool.allocate_buffer("hash buffer"), default_block_size);
+				storage_error error;
+				if (!buffer)
+				{
+					error.ec = errors::no_memory;
+					error.operation = operation_t::alloc_cache_piece;
+					post(m_ios, [=]{ h(piece, sha1_hash{}, error); });
+					return;
+				}
+				hasher ph;
+
+				posix_storage* st = m_torrents[storage].get();
+
+				int const piece_size = v1 ? st->files().piece_size(piece) : 0;
+				int const piece_size2 = v2 ? st->orig_files().piece_size2(piece) : 0;
+				int const blocks_in_piece = v1 ? (piece_size + default_block_size - 1) / default_block_size : 0;
+				int const blocks_in_piece2 = v2 ? st->orig_files().blocks_in_piece2(piece) : 0;
+
+				TORRENT_ASSERT(!v2 || int(block_hashes.size()) >= blocks_in_piece2);
+
+				int offset = 0;
+				int const blocks_to_read = std::max(blocks_in_piece, blocks_in_piece2);
+				for (int i = 0; i < blocks_to_read; ++i)
+				{
+					bool const v2_block = i < blocks_in_piece2;
+
+					auto const len = v1 ? std::min(default_block_size, piece_size - offset) : 0;
+					auto const len2 = v2_block ? std::min(default_block_size, piece_size2 - offset) : 0;
+
+					iovec_t b = {buffer.data(), std::max(len, len2)};
+					int const ret = st->readv(m_settings, b, piece, offset, error);
+					offset += default_block_size;
+					if (ret <= 0) break;
+					if (v1)
+						ph.update(b.first(std::min(ret, len)));
+					if (v2_block)
+						block_hashes[i] = hasher256(b.first(std::min(ret, len2))).final();
+				}
+
+				sha1_hash const hash = v1 ? ph.final() : sha1_hash();
+
+				if (!error.ec)
+				{
+					std::int64_t const read_time = total_microseconds(clock_type::now() - start_time);
+
+					m_stats_counters.inc_stats_counter(counters::num_read_back);
+					m_stats_counters.inc_stats_counter(counters::num_blocks_read, blocks_to_read);
+					m_stats_counters.inc_stats_counter(counters::num_read_ops);
+					m_stats_counters.inc_stats_counter(counters::disk_hash_time, read_time);
+					m_stats_counters.inc_stats_counter(counters::disk_job_time, read_time);
+				}
+
+				post(m_ios, [=]{ h(piece, hash, error); });
+			});
+		}
+
+		void async_hash2(storage_index_t storage, piece_index_t const piece, int const offset, disk_job_flags_t
+			, std::function<void(piece_index_t, sha256_hash const&, storage_error const&)> handler) override
+		{
+			queue_job([this, storage, piece, offset, h = std::move(handler)]
+			{
+				time_point const start_time = clock_type::now();
+
+				disk_buffer_holder buffer = disk_buffer_holder(*this, m_buffer_pool.allocate_buffer("hash buffer"), 0x4000);
+				storage_error error;
+				if (!buffer)
+				{
+					error.ec = errors::no_memory;
+					error.operation = operation_t::alloc_cache_piece;
+					post(m_ios, [=]{ h(piece, sha256_hash{}, error); });
+					return;
+				}
+
+				posix_storage* st = m_torrents[storage].get();
+
+				int const piece_size = st->files().piece_size2(piece);
+
+				std::ptrdiff_t const len = std::min(default_block_size, piece_size - offset);
+
+				hasher256 ph;
+				iovec_t b = {buffer.data(), len};
+				int const ret = st->readv(m_settings, b, piece, offset, error);
+				if (ret > 0)
+					ph.update(b.first(ret));
+
+				sha256_hash const hash = ph.final();
+
+				if (!error.ec)
+				{
+					std::int64_t const read_time = total_microseconds(clock_type::now() - start_time);
+
+					m_stats_counters.inc_stats_counter(counters::num_read_back);
+					m_stats_counters.inc_stats_counter(counters::num_blocks_read);
+					m_stats_counters.inc_stats_counter(counters::num_read_ops);
+					m_stats_counters.inc_stats_counter(counters::disk_hash_time, read_time);
+					m_stats_counters.inc_stats_counter(counters::disk_job_time, read_time);
+				}
+
+				post(m_ios, [=]{ h(piece, hash, error); });
+			});
+		}
+
+		void async_move_storage(storage_index_t const storage, std::string p
+			, move_flags_t const flags
+			, std::function<void(status_t, std::string const&, storage_error const&)> handler) override
+		{
+			queue_job([this, storage, p, flags, h = std::move(handler)]
+			{
+				drop_fds(storage);
+				posix_storage* st = m_torrents[storage].get();
+				storage_error ec;
+				status_t ret;
+				std::string path;
+				std::tie(ret, path) = st->move_storage(p, flags, ec);
+				if (!ec) m_save_paths[storage] = path;
+				post(m_ios, [=]{ h(ret, path, ec); });
+			});
+		}
+
+		void async_release_files(storage_index_t storage, std::function<void()> handler) override
+		{
+			queue_job([this, storage, h = std::move(handler)]
+			{
+				drop_fds(storage);
+				posix_storage* st = m_torrents[storage].get();
+				st->release_files();
+				if (!h) return;
+				post(m_ios, [=]{ h(); });
+			});
+		}
+
+		void async_delete_files(storage_index_t storage, remove_flags_t const options
+			, std::function<void(storage_error const&)> handler) override
+		{
+			queue_job([this, storage, options, h = std::move(handler)]
+			{
+				drop_fds(storage);
+				storage_error error;
+				posix_storage* st = m_torrents[storage].get();
+				st->delete_files(options, error);
+				post(m_ios, [=]{ h(error); });
+			});
+		}
+
+		void async_check_files(storage_index_t storage
+			, add_torrent_params const* resume_data
+			, aux::vector<std::string, file_index_t> links
+			, std::function<void(status_t, storage_error const&)> handler) override
+		{
+			// the resume data pointer is only guaranteed to be valid for the
+			// duration of this call, take a copy to bring to the disk thread
+			auto rd = std::make_shared<add_torrent_params>(
+				resume_data ? *resume_data : add_torrent_params{});
+			queue_job([this, storage, rd, l = std::move(links), h = std::move(handler)]
+			{
+				posix_storage* st = m_torrents[storage].get();
+
+				storage_error error;
+				status_t const ret = [&]
+				{
+					st->initialize(m_settings, error);
+					if (error) return status_t::fatal_disk_error;
+
+					bool const verify_success = st->verify_resume_data(*rd, l, error);
+
+					if (m_settings.get_bool(settings_pack::no_recheck_incomplete_resume))
+						return status_t::no_error;
+
+					if (!aux::contains_resume_data(*rd))
+					{
+						// if we don't have any resume data, we still may need to trigger a
+						// full re-check, if there are *any* files.
+						storage_error ignore;
+						return (st->has_any_file(ignore))
+							? status_t::need_full_check
+							: status_t::no_error;
+					}
+
+					return verify_success
+						? status_t::no_error
+						: status_t::need_full_check;
+				}();
+
+				post(m_ios, [error, ret, h]{ h(ret, error); });
+			});
+		}
+
+		void async_rename_file(storage_index_t const storage
+			, file_index_t const idx
+			, std::string name
+			, std::function<void(std::string const&, file_index_t, storage_error const&)> handler) override
+		{
+			queue_job([this, storage, idx, n = std::move(name), h = std::move(handler)]
+			{
+				drop_fds(storage);
+				posix_storage* st = m_torrents[storage].get();
+				storage_error error;
+				st->rename_file(idx, n, error);
+				post(m_ios, [=]{ h(n, idx, error); });
+			});
+		}
+
+		void async_stop_torrent(storage_index_t, std::function<void()> handler) override
+		{
+			if (!handler) return;
+			queue_job([this, h = std::move(handler)]
+			{
+				post(m_ios, [=]{ h(); });
+			});
+		}
+
+		void async_set_file_priority(storage_index_t const storage
+			, aux::vector<download_priority_t, file_index_t> prio
+			, std::function<void(storage_error const&
+				, aux::vector<download_priority_t, file_index_t>)> handler) override
+		{
+			queue_job([this, storage, p = std::move(prio), h = std::move(handler)]() mutable
+			{
+				posix_storage* st = m_torrents[storage].get();
+				storage_error error;
+				st->set_file_priority(p, error);
+				for (download_priority_t const e : p)
+					if (e == dont_download) m_need_fallback[storage] = true;
+				post(m_ios, [p, h, error]() mutable { h(error, std::move(p)); });
+			});
+		}
+
+		void async_clear_piece(storage_index_t, piece_index_t index
+			, std::function<void(piece_index_t)> handler) override
+		{
+			queue_job([this, index, h = std::move(handler)]
+			{
+				post(m_ios, [=]{ h(index); });
+			});
+		}
+
+		// implements buffer_allocator_interface
+		void free_disk_buffer(char* b) override
+		{ m_buffer_pool.free_buffer(b); }
+
+		void update_stats_counters(counters&) const override {}
+
+		std::vector<open_file_state> get_status(storage_index_t) const override
+		{ return {}; }
+
+		void submit_jobs() override
+		{
+			std::unique_lock<std::mutex> l(m_mutex);
+			if (m_queue.empty()) return;
+			m_cond.notify_all();
+			l.unlock();
+			wake_ring();
+		}
+
+	private:
+
+		struct uring_job
+		{
+			storage_index_t storage{0};
+			peer_request req;
+			disk_buffer_holder buffer;
+			std::function<void(disk_buffer_holder, storage_error const&)> read_handler;
+			std::function<void(storage_error const&)> write_handler;
+			time_point start_time = clock_type::now();
+			::iovec iov{};
+		};
+
+		struct cached_fd
+		{
+			int fd = -1;
+			bool writable = false;
+		};
+
+		void queue_job(std::function<void()> f)
+		{
+			{
+				std::unique_lock<std::mutex> l(m_mutex);
+				m_queue.emplace_back(std::move(f));
+				m_cond.notify_all();
+			}
+			wake_ring();
+		}
+
+		// wake the submission thread if it's blocked in io_uring_enter()
+		void wake_ring()
+		{
+			if (m_event_fd < 0) return;
+			std::uint64_t const one = 1;
+			// any failure here (e.g. EAGAIN from a saturated counter) still
+			// leaves the eventfd readable, which is all we need
+			auto const ignore = ::write(m_event_fd, &one, sizeof(one));
+			TORRENT_UNUSED(ignore);
+		}
+
+		void thread_fun()
+		{
+			if (m_ring_ok) arm_wakeup();
+			for (;;)
+			{
+				std::deque<std::function<void()>> jobs;
+				{
+					std::unique_lock<std::mutex> l(m_mutex);
+					while (m_queue.empty() && m_in_flight.empty() && !m_abort)
+						m_cond.wait(l);
+					if (m_abort && m_queue.empty() && m_in_flight.empty()) return;
+					jobs.swap(m_queue);
+				}
+
+				for (auto& j : jobs) j();
+
+				if (!m_ring_ok)
+				{
+					close_deferred_fds();
+					continue;
+				}
+
+				// submit whatever the jobs above queued up. Only block waiting
+				// for completions when there's nothing else to do
+				bool wait;
+				{
+					std::unique_lock<std::mutex> l(m_mutex);
+					wait = m_queue.empty() && !m_in_flight.empty() && !m_abort;
+				}
+				m_ring.submit(wait);
+				close_deferred_fds();
+				process_completions();
+				if (!m_wakeup_armed) arm_wakeup();
+			}
+		}
+
+		void arm_wakeup()
+		{
+			::io_uring_sqe* s = m_ring.get_sqe();
+			if (s == nullptr)
+			{
+				// the ring is full, try again once some completions have been
+				// reaped
+				m_wakeup_armed = false;
+				return;
+			}
+			s->opcode = IORING_OP_POLL_ADD;
+			s->fd = m_event_fd;
+			s->poll_events = POLLIN;
+			s->user_data = wakeup_user_data;
+			m_wakeup_armed = true;
+		}
+
+		void process_completions()
+		{
+			for (;;)
+			{
+				::io_uring_cqe* cqe = m_ring.peek_cqe();
+				if (cqe == nullptr) break;
+				std::uint64_t const key = cqe->user_data;
+				int const res = cqe->res;
+				m_ring.pop_cqe();
+
+				if (key == wakeup_user_data)
+				{
+					std::uint64_t buf;
+					while (::read(m_event_fd, &buf, sizeof(buf)) > 0);
+					arm_wakeup();
+					continue;
+				}
+
+				std::shared_ptr<uring_job> j;
+				{
+					auto const it = m_in_flight.find(key);
+					TORRENT_ASSERT(it != m_in_flight.end());
+					if (it == m_in_flight.end()) continue;
+					j = std::move(it->second);
+					m_in_flight.erase(it);
+				}
+
+				if (j->read_handler) complete_read(j, res);
+				else complete_write(j, res);
+			}
+		}
+
+		// returns false if the job could not be submitted to the ring and the
+		// caller should fall back to the synchronous path
+		bool submit_to_ring(std::shared_ptr<uring_job> const& j, bool const write)
+		{
+			if (!m_ring_ok) return false;
+			if (m_need_fallback[j->storage]) return false;
+
+			posix_storage* st = m_torrents[j->storage].get();
+			file_storage const& fs = st->files();
+			std::vector<file_slice> const slices = fs.map_block(
+				j->req.piece, j->req.start, j->req.length);
+			// blocks that straddle a file boundary, or touch a pad file, go
+			// through posix_storage, which knows how to deal with them
+			if (slices.size() != 1) return false;
+			file_index_t const file = slices.front().file_index;
+			if (fs.pad_file_at(file)) return false;
+
+			int const fd = get_fd(j->storage, file, write);
+			if (fd < 0) return false;
+
+			::io_uring_sqe* s = m_ring.get_sqe();
+			if (s == nullptr)
+			{
+				// the ring is full. Push out what we have to make room, then
+				// try once more
+				m_ring.submit(false);
+				close_deferred_fds();
+				process_completions();
+				s = m_ring.get_sqe();
+				if (s == nullptr) return false;
+			}
+
+			j->iov.iov_base = j->buffer.data();
+			j->iov.iov_len = aux::numeric_cast<std::size_t>(j->req.length);
+			s->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+			s->fd = fd;
+			s->off = aux::numeric_cast<std::uint64_t>(slices.front().offset);
+			s->addr = reinterpret_cast<std::uint64_t>(&j->iov);
+			s->len = 1;
+			std::uint64_t const key = m_next_job_id++;
+			s->user_data = key;
+			m_in_flight.emplace(key, j);
+			return true;
+		}
+
+		void submit_read(std::shared_ptr<uring_job> const& j)
+		{
+			if (submit_to_ring(j, false)) return;
+
+			// synchronous fall-back, the same path the posix back-end takes
+			storage_error error;
+			iovec_t b = {j->buffer.data(), j->req.length};
+			m_torrents[j->storage]->readv(m_settings, b, j->req.piece, j->req.start, error);
+			if (!error.ec) count_read(j->start_time);
+			post(m_ios, [j, error]{ j->read_handler(std::move(j->buffer), error); });
+		}
+
+		void submit_write(std::shared_ptr<uring_job> const& j)
+		{
+			if (submit_to_ring(j, true)) return;
+
+			storage_error error;
+			iovec_t const b = {j->buffer.data(), j->req.length};
+			m_torrents[j->storage]->writev(m_settings, b, j->req.piece, j->req.start, error);
+			if (!error.ec) count_write(j->start_time);
+			post(m_ios, [j, error]{ j->write_handler(error); });
+		}
+
+		void complete_read(std::shared_ptr<uring_job> const& j, int const res)
+		{
+			storage_error error;
+			if (res < 0)
+			{
+				error.ec = error_code(-res, generic_category());
+				error.operation = operation_t::file_read;
+			}
+			else if (res < j->req.length)
+			{
+				// a short read. The tail of the file may be sparse or not yet
+				// written, behave like a read of a zeroed region
+				std::memset(j->buffer.data() + res, 0
+					, aux::numeric_cast<std::size_t>(j->req.length - res));
+			}
+			if (!error.ec) count_read(j->start_time);
+			post(m_ios, [j, error]{ j->read_handler(std::move(j->buffer), error); });
+		}
+
+		void complete_write(std::shared_ptr<uring_job> const& j, int const res)
+		{
+			storage_error error;
+			if (res < 0)
+			{
+				error.ec = error_code(-res, generic_category());
+				error.operation = operation_t::file_write;
+			}
+			else if (res < j->req.length)
+			{
+				// a short write. Complete the remainder through the synchronous
+				// path rather than reporting a spurious failure
+				posix_storage* st = m_torrents[j->storage].get();
+				if (st == nullptr)
+				{
+					// the torrent was removed while this operation was in
+					// flight, there is nothing to write the tail against
+					error.ec = errors::torrent_removed;
+					error.operation = operation_t::file_write;
+				}
+				else
+				{
+					iovec_t const b = {j->buffer.data() + res, j->req.length - res};
+					st->writev(m_settings, b
+						, j->req.piece, j->req.start + res, error);
+				}
+			}
+			if (!error.ec) count_write(j->start_time);
+			post(m_ios, [j, error]{ j->write_handler(error); });
+		}
+
+		void count_read(time_point const start_time)
+		{
+			std::int64_t const read_time = total_microseconds(clock_type::now() - start_time);
+			m_stats_counters.inc_stats_counter(counters::num_read_back);
+			m_stats_counters.inc_stats_counter(counters::num_blocks_read);
+			m_stats_counters.inc_stats_counter(counters::num_read_ops);
+			m_stats_counters.inc_stats_counter(counters::disk_read_time, read_time);
+			m_stats_counters.inc_stats_counter(counters::disk_job_time, read_time);
+		}
+
+		void count_write(time_point const start_time)
+		{
+			std::int64_t const write_time = total_microseconds(clock_type::now() - start_time);
+			m_stats_counters.inc_stats_counter(counters::num_blocks_written);
+			m_stats_counters.inc_stats_counter(counters::num_write_ops);
+			m_stats_counters.inc_stats_counter(counters::disk_write_time, write_time);
+			m_stats_counters.inc_stats_counter(counters::disk_job_time, write_time);
+		}
+
+		int get_fd(storage_index_t const storage, file_index_t const file, bool const write)
+		{
+			auto const key = std::make_pair(storage, file);
+			auto it = m_fd_cache.find(key);
+			if (it != m_fd_cache.end())
+			{
+				if (!write || it->second.writable) return it->second.fd;
+				// SQEs prepared earlier in this batch may still refer to this
+				// descriptor, and io_uring resolves fd numbers at submit time.
+				// Closing it here would fail those operations with EBADF (or
+				// worse, redirect them if the number is reused), so the close
+				// is deferred until the batch has been handed to the kernel
+				m_deferred_close.push_back(it->second.fd);
+				m_fd_cache.erase(it);
+			}
+			file_storage const& fs = m_torrents[storage]->files();
+			std::string const path = fs.file_path(file, m_save_paths[storage]);
+			int const fd = write
+				? ::open(path.c_str(), O_RDWR | O_CREAT, 0666)
+				: ::open(path.c_str(), O_RDONLY);
+			// if this fails (e.g. the directory hasn't been created yet), the
+			// caller falls back to posix_storage, which will create it
+			if (fd < 0) return -1;
+			cached_fd entry;
+			entry.fd = fd;
+			entry.writable = write;
+			m_fd_cache[key] = entry;
+			return fd;
+		}
+
+		void drop_fds(storage_index_t const storage)
+		{
+			for (auto it = m_fd_cache.begin(); it != m_fd_cache.end();)
+			{
+				if (it->first.first == storage)
+				{
+					m_deferred_close.push_back(it->second.fd);
+					it = m_fd_cache.erase(it);
+				}
+				else ++it;
+			}
+		}
+
+		// close descriptors evicted from the cache. Only safe once every SQE
+		// prepared against them has been submitted to the kernel
+		void close_deferred_fds()
+		{
+			for (int const fd : m_deferred_close) ::close(fd);
+			m_deferred_close.clear();
+		}
+
+		aux::vector<std::unique_ptr<posix_storage>, storage_index_t> m_torrents;
+
+		// slots that are unused in the m_torrents vector
+		std::vector<storage_index_t> m_free_slots;
+
+		// the save path of each torrent, used to resolve file paths when
+		// opening raw file descriptors
+		aux::vector<std::string, storage_index_t> m_save_paths;
+
+		// torrents that may be using a part file. All their I/O is routed
+		// through posix_storage
+		aux::vector<bool, storage_index_t> m_need_fallback;
+
+		settings_interface const& m_settings;
+
+		// disk cache
+		aux::disk_buffer_pool m_buffer_pool;
+
+		counters& m_stats_counters;
+
+		// callbacks are posted on this
+		io_context& m_ios;
+
+		// the io_uring, only valid if m_ring_ok is true. Only the submission
+		// thread touches it after construction
+		uring m_ring;
+		bool m_ring_ok = false;
+
+		// used to wake the submission thread out of io_uring_enter() when new
+		// jobs arrive
+		int m_event_fd = -1;
+		bool m_wakeup_armed = false;
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		std::deque<std::function<void()>> m_queue;
+		bool m_abort = false;
+
+		// submission-thread state: operations handed to the kernel but not
+		// yet completed, keyed by the SQE user_data
+		std::map<std::uint64_t, std::shared_ptr<uring_job>> m_in_flight;
+		std::uint64_t m_next_job_id = 1;
+
+		// file descriptors kept open across jobs, keyed by torrent and file
+		std::map<std::pair<storage_index_t, file_index_t>, cached_fd> m_fd_cache;
+
+		// descriptors evicted from the cache while SQEs in the current batch
+		// may still refer to them, closed after the next ring submit
+		std::vector<int> m_deferred_close;
+	};
+
+	TORRENT_EXPORT std::unique_ptr<disk_interface> io_uring_disk_io_constructor(
+		io_context& ios, settings_interface const& sett, counters& cnt)
+	{
+		return std::make_unique<io_uring_disk_io>(ios, sett, cnt);
+	}
+}
+
+#else // TORRENT_USE_IOURING
+
+#include "libtorrent/session.hpp" // for default_disk_io_constructor
+#include "libtorrent/disk_interface.hpp"
+
+namespace libtorrent {
+
+	TORRENT_EXPORT std::unique_ptr<disk_interface> io_uring_disk_io_constructor(
+		io_context& ios, settings_interface const& sett, counters& cnt)
+	{
+		return default_disk_io_constructor(ios, sett, cnt);
+	}
+}
+
+#endif // TORRENT_USE_IOURING
+
@@ -31,6 +31,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 */
 
+#include <algorithm> // for upper_bound
 #include <iterator> // for next
 
 #include "libtorrent/ip_filter.hpp"
@@ -232,16 +233,23 @@ namespace aux {
 
 		if (j != m_access_list.end() && j->access == flags) m_access_list.erase(j);
 		TORRENT_ASSERT(!m_access_list.empty());
+
+		m_dirty = true;
 	}
 
 	template <typename Addr>
 	std::uint32_t filter_impl<Addr>::access(Addr const& addr) const
 	{
 		TORRENT_ASSERT(!m_access_list.empty());
-		auto i = m_access_list.upper_bound(addr);
-		if (i != m_access_list.begin()) --i;
-		TORRENT_ASSERT(i != m_access_list.end());
-		TORRENT_ASSERT(i->start <= addr && (std::next(i) == m_access_list.end()
+		if (m_dirty)
+		{
+			m_flattened.assign(m_access_list.begin(), m_access_list.end());
+			m_dirty = false;
+		}
+		auto i = std::upper_bound(m_flattened.begin(), m_flattened.end(), range(addr));
+		if (i != m_flattened.begin()) --i;
+		TORRENT_ASSERT(i != m_flattened.end());
+		TORRENT_ASSERT(i->start <= addr && (std::next(i) == m_flattened.end()
 			|| addr < std::next(i)->start));
 		return i->access;
 	}
@@ -87,6 +87,45 @@ namespace {
 		}
 		return ret;
 	}
+
+	entry save_table_nodes(std::vector<std::pair<node_id, udp::endpoint>> const& nodes)
+	{
+		entry ret(entry::list_t);
+		entry::list_type& list = ret.list();
+		for (auto const& n : nodes)
+		{
+			std::string node;
+			std::back_insert_iterator<std::string> out(node);
+			std::copy(n.first.begin(), n.first.end(), out);
+			aux::write_endpoint(n.second, out);
+			list.emplace_back(node);
+		}
+		return ret;
+	}
+
+	std::vector<std::pair<node_id, udp::endpoint>> extract_table_nodes(
+		bdecode_node const& nodes)
+	{
+		std::vector<std::pair<node_id, udp::endpoint>> ret;
+		for (int i = 0; i < nodes.list_size(); i++)
+		{
+			bdecode_node n = nodes.list_at(i);
+			if (n.type() != bdecode_node::string_t) continue;
+			// a node is a 20 byte node ID followed by a 6 byte IPv4 or an
+			// 18 byte IPv6 endpoint
+			if (n.string_length() != 26 && n.string_length() != 38) continue;
+			char const* in = n.string_ptr();
+			node_id const id(in);
+			in += id.size();
+			udp::endpoint ep;
+			if (n.string_length() == 26)
+				ep = aux::read_v4_endpoint<udp::endpoint>(in);
+			else
+				ep = aux::read_v6_endpoint<udp::endpoint>(in);
+			ret.emplace_back(id, ep);
+		}
+		return ret;
+	}
 } // anonymous namespace
 
 	void dht_state::clear()
@@ -98,6 +137,11 @@ namespace {
 		nodes.shrink_to_fit();
 		nodes6.clear();
 		nodes6.shrink_to_fit();
+
+		table_nodes.clear();
+		table_nodes.shrink_to_fit();
+		table_nodes6.clear();
+		table_nodes6.shrink_to_fit();
 	}
 
 	dht_state read_dht_state(bdecode_node const& e)
@@ -112,6 +156,10 @@ namespace {
 			ret.nodes = aux::read_endpoint_list<udp::endpoint>(nodes);
 		if (bdecode_node const nodes = e.dict_find_list("nodes6"))
 			ret.nodes6 = aux::read_endpoint_list<udp::endpoint>(nodes);
+		if (bdecode_node const nodes = e.dict_find_list("table-nodes"))
+			ret.table_nodes = extract_table_nodes(nodes);
+		if (bdecode_node const nodes = e.dict_find_list("table-nodes6"))
+			ret.table_nodes6 = extract_table_nodes(nodes);
 		return ret;
 	}
 
@@ -130,6 +178,10 @@ namespace {
 		if (!nodes.list().empty()) ret["nodes"] = nodes;
 		entry const nodes6 = save_nodes(state.nodes6);
 		if (!nodes6.list().empty()) ret["nodes6"] = nodes6;
+		entry const table_nodes = save_table_nodes(state.table_nodes);
+		if (!table_nodes.list().empty()) ret["table-nodes"] = table_nodes;
+		entry const table_nodes6 = save_table_nodes(state.table_nodes6);
+		if (!table_nodes6.list().empty()) ret["table-nodes6"] = table_nodes6;
 		return ret;
 	}
 }}
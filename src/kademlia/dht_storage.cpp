@@ -493,12 +493,27 @@ namespace {
 
 		void tick() override
 		{
-			// look through all peers and see if any have timed out
-			for (auto i = m_map.begin(), end(m_map.end()); i != end;)
+			// the peer map can grow very large on a well-connected node, so
+			// it's purged incrementally: each tick only sweeps a slice of
+			// the torrents, resuming where the previous tick left off. A
+			// fifth of the table per tick bounds the stall while still
+			// visiting every entry well within the expiry slack. Note that
+			// peer lifetimes are all the same, so entries expire in
+			// announce order and there is nothing for a timing wheel or
+			// priority queue to short-circuit; the cost is the sweep itself
+			int quota = std::max(64, int(m_map.size()) / 5);
+			auto i = m_map.lower_bound(m_next_purge_torrent);
+			while (quota > 0)
 			{
+				if (i == m_map.end())
+				{
+					i = m_map.begin();
+					if (i == m_map.end()) break;
+				}
 				torrent_entry& t = i->second;
 				purge_peers(t.peers4);
 				purge_peers(t.peers6);
+				--quota;
 
 				if (!t.peers4.empty() || !t.peers6.empty())
 				{
@@ -510,6 +525,7 @@ namespace {
 				i = m_map.erase(i);
 				m_counters.torrents -= 1;// peers is decreased by purge_peers
 			}
+			m_next_purge_torrent = (i == m_map.end()) ? node_id() : i->first;
 
 			if (0 == m_settings.get_int(settings_pack::dht_item_lifetime)) return;
 
@@ -552,6 +568,9 @@ namespace {
 
 		std::vector<node_id> m_node_ids;
 		std::map<node_id, torrent_entry> m_map;
+
+		// where the incremental purge in tick() resumes on the next call
+		node_id m_next_purge_torrent{};
 		std::map<node_id, dht_immutable_item> m_immutable_table;
 		std::map<node_id, dht_mutable_item> m_mutable_table;
 
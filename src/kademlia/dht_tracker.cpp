@@ -176,7 +176,16 @@ namespace libtorrent { namespace dht {
 			n.second.connection_timer.expires_after(seconds(1));
 			n.second.connection_timer.async_wait(
 				std::bind(&dht_tracker::connection_timeout, self(), n.first, _1));
-			if (aux::is_v6(n.first.get_local_endpoint()))
+			bool const v6 = aux::is_v6(n.first.get_local_endpoint());
+
+			// nodes saved with their node IDs can go straight back into the
+			// routing table, making the table warm right away. They enter
+			// unconfirmed and are validated lazily, by the table's regular
+			// ping and refresh maintenance, rather than up-front
+			for (auto const& tn : v6 ? m_state.table_nodes6 : m_state.table_nodes)
+				n.second.dht.m_table.heard_about(tn.first, tn.second);
+
+			if (v6)
 				n.second.dht.bootstrap(concat(m_state.nodes6, m_state.nodes), f);
 			else
 				n.second.dht.bootstrap(concat(m_state.nodes, m_state.nodes6), f);
@@ -329,6 +338,14 @@ namespace libtorrent { namespace dht {
 			n.second.dht.announce(ih, listen_port, flags, f);
 	}
 
+	int dht_tracker::num_active_lookups() const
+	{
+		int ret = 0;
+		for (auto const& n : m_nodes)
+			ret += n.second.dht.num_traversal_algorithms();
+		return ret;
+	}
+
 	void dht_tracker::sample_infohashes(udp::endpoint const& ep, sha1_hash const& target
 		, std::function<void(node_id
 			, time_duration
@@ -606,6 +623,16 @@ namespace {
 		return ret;
 	}
 
+	std::vector<std::pair<node_id, udp::endpoint>> save_table_nodes(node const& dht)
+	{
+		std::vector<std::pair<node_id, udp::endpoint>> ret;
+
+		dht.m_table.for_each_node([&ret](node_entry const& e)
+		{ ret.emplace_back(e.id, e.ep()); });
+
+		return ret;
+	}
+
 } // anonymous namespace
 
 	dht_state dht_tracker::state() const
@@ -618,6 +645,12 @@ namespace {
 			ret.nids.emplace_back(n.first.get_local_endpoint().address(), n.second.dht.nid());
 			auto nodes = save_nodes(n.second.dht);
 			ret.nodes.insert(ret.nodes.end(), nodes.begin(), nodes.end());
+			for (auto& tn : save_table_nodes(n.second.dht))
+			{
+				auto& table_nodes = aux::is_v6(tn.second)
+					? ret.table_nodes6 : ret.table_nodes;
+				table_nodes.emplace_back(std::move(tn));
+			}
 		}
 		return ret;
 	}
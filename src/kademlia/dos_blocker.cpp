@@ -32,6 +32,9 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "libtorrent/kademlia/dos_blocker.hpp"
+#include "libtorrent/crc32c.hpp"
+
+#include <cstring> // for std::memset, std::memcpy
 
 #ifndef TORRENT_DISABLE_LOGGING
 #include "libtorrent/socket_io.hpp" // for print_address
@@ -40,74 +43,115 @@ POSSIBILITY OF SUCH DAMAGE.
 
 namespace libtorrent { namespace dht {
 
+namespace {
+
+	std::uint32_t address_hash(address const& addr)
+	{
+		if (addr.is_v4())
+		{
+			address_v4::bytes_type const b = addr.to_v4().to_bytes();
+			std::uint32_t k;
+			std::memcpy(&k, b.data(), 4);
+			return crc32c_32(k);
+		}
+		else
+		{
+			address_v6::bytes_type const b = addr.to_v6().to_bytes();
+			std::uint64_t k[2];
+			std::memcpy(k, b.data(), 16);
+			return crc32c(k, 2);
+		}
+	}
+}
+
 	dos_blocker::dos_blocker()
 		: m_message_rate_limit(5)
 		, m_block_timeout(5 * 60)
+		, m_window_end(min_time())
 	{
 		for (auto& e : m_ban_nodes)
 		{
 			e.count = 0;
 			e.limit = min_time();
 		}
+		std::memset(m_sketch, 0, sizeof(m_sketch));
 	}
 
 	bool dos_blocker::incoming(address const& addr, time_point const now, dht_logger* logger)
 	{
 		TORRENT_UNUSED(logger);
+
+		// are we currently ignoring this source? Empty entries have their
+		// limit set to min_time(), so ``min`` doubles as the slot to evict
+		// if we need to ban someone new
 		node_ban_entry* match = nullptr;
 		node_ban_entry* min = m_ban_nodes;
 		for (node_ban_entry* i = m_ban_nodes; i < m_ban_nodes + num_ban_nodes; ++i)
 		{
-			if (i->src == addr)
+			if (i->count > 0 && i->src == addr)
 			{
 				match = i;
 				break;
 			}
-			if (i->count < min->count) min = i;
-			else if (i->count == min->count
-				&& i->limit < min->limit) min = i;
+			if (i->limit < min->limit) min = i;
 		}
 
 		if (match)
 		{
-			++match->count;
+			if (now < match->limit) return false;
 
-			if (match->count >= m_message_rate_limit * 10)
-			{
-				if (now < match->limit)
-				{
-					if (match->count == m_message_rate_limit * 10)
-					{
-#ifndef TORRENT_DISABLE_LOGGING
-						if (logger != nullptr && logger->should_log(dht_logger::tracker))
-						{
-							logger->log(dht_logger::tracker, "BANNING PEER [ ip: %s time: %d ms count: %d ]"
-								, print_address(addr).c_str()
-								, int(total_milliseconds((now - match->limit) + seconds(10)))
-								, match->count);
-						}
-#else
-						TORRENT_UNUSED(logger);
-#endif // TORRENT_DISABLE_LOGGING
-						// we've received too many messages in less than 10 seconds
-						// from this node. Ignore it until it's silent for 5 minutes
-						match->limit = now + seconds(m_block_timeout);
-					}
-
-					return false;
-				}
-
-				// the messages we received from this peer took more than 10
-				// seconds. Reset the counter and the timer
-				match->count = 0;
-				match->limit = now + seconds(10);
-			}
+			// the ban has expired
+			match->count = 0;
+			match->limit = min_time();
 		}
-		else
+
+		if (now >= m_window_end)
+		{
+			// start a new sampling window, discarding all counts
+			std::memset(m_sketch, 0, sizeof(m_sketch));
+			m_window_end = now + seconds(10);
+		}
+
+		std::uint32_t const h = address_hash(addr);
+		std::uint32_t const h1 = h >> 16;
+		std::uint32_t const h2 = (h & 0xffff) | 1;
+
+		// the estimated number of packets received from this source in
+		// this window is the minimum of its counters. Only raise counters
+		// up to that estimate ("conservative update"). It keeps a source
+		// sharing a counter with a heavy hitter from inheriting its count,
+		// as long as they differ in at least one row
+		int est = 0xffff;
+		std::uint16_t* slot[sketch_rows];
+		for (int i = 0; i < sketch_rows; ++i)
+		{
+			slot[i] = &m_sketch[i][(h1 + std::uint32_t(i) * h2) & (sketch_width - 1)];
+			est = std::min(est, int(*slot[i]));
+		}
+		if (est < 0xffff)
 		{
-			min->count = 1;
-			min->limit = now + seconds(10);
+			++est;
+			for (int i = 0; i < sketch_rows; ++i)
+				if (int(*slot[i]) < est) *slot[i] = std::uint16_t(est);
+		}
+
+		if (est >= m_message_rate_limit * 10)
+		{
+#ifndef TORRENT_DISABLE_LOGGING
+			if (logger != nullptr && logger->should_log(dht_logger::tracker))
+			{
+				logger->log(dht_logger::tracker, "BANNING PEER [ ip: %s time: %d ms count: %d ]"
+					, print_address(addr).c_str()
+					, int(total_milliseconds(seconds(10) - (m_window_end - now)))
+					, est);
+			}
+#endif // TORRENT_DISABLE_LOGGING
+			// we've received too many messages in less than 10 seconds
+			// from this node. Ignore it until it's silent for 5 minutes
 			min->src = addr;
+			min->count = est;
+			min->limit = now + seconds(m_block_timeout);
+			return false;
 		}
 		return true;
 	}
@@ -51,12 +51,53 @@ node_id distance(node_id const& n1, node_id const& n2)
 	return n1 ^ n2;
 }
 
+namespace {
+
+	// load 8 (or 4) bytes in big-endian (network) byte order. The
+	// byte-assembly form is endian-agnostic and compiles down to a plain
+	// (byte-swapping) load on the common compilers
+	std::uint64_t load_be64(char const* b)
+	{
+		auto const* p = reinterpret_cast<std::uint8_t const*>(b);
+		std::uint64_t ret = 0;
+		for (int i = 0; i < 8; ++i) ret = (ret << 8) | p[i];
+		return ret;
+	}
+
+	std::uint32_t load_be32(char const* b)
+	{
+		auto const* p = reinterpret_cast<std::uint8_t const*>(b);
+		std::uint32_t ret = 0;
+		for (int i = 0; i < 4; ++i) ret = (ret << 8) | p[i];
+		return ret;
+	}
+}
+
 // returns true if: distance(n1, ref) < distance(n2, ref)
 bool compare_ref(node_id const& n1, node_id const& n2, node_id const& ref)
 {
-	node_id const lhs = n1 ^ ref;
-	node_id const rhs = n2 ^ ref;
-	return lhs < rhs;
+	// compare the two XOR distances 64 bits at a time (two 64-bit words
+	// and one 32-bit word covers 160 bits), rather than materializing
+	// them as node_id temporaries and comparing those. This runs in the
+	// comparison of every sort and ordered insert along a traversal
+	for (int i = 0; i < 16; i += 8)
+	{
+		std::uint64_t const r = load_be64(ref.data() + i);
+		std::uint64_t const lhs = load_be64(n1.data() + i) ^ r;
+		std::uint64_t const rhs = load_be64(n2.data() + i) ^ r;
+		if (lhs != rhs) return lhs < rhs;
+	}
+	std::uint32_t const r = load_be32(ref.data() + 16);
+	return (load_be32(n1.data() + 16) ^ r) < (load_be32(n2.data() + 16) ^ r);
+}
+
+// sorts the node entries by how close their ids are to ref, closest
+// first, using the kademlia XOR-metric
+void sort_by_distance(span<node_entry> l, node_id const& ref)
+{
+	std::sort(l.begin(), l.end()
+		, [&ref](node_entry const& lhs, node_entry const& rhs)
+		{ return compare_ref(lhs.id, rhs.id, ref); });
 }
 
 // returns n in: 2^n <= distance(n1, n2) < 2^(n+1)
@@ -1133,9 +1133,7 @@ std::vector<node_entry> routing_table::find_node(node_id const& target
 		if (int(l.size()) > count)
 		{
 			// sort the nodes by how close they are to the target
-			std::sort(l.begin() + unsorted_start_idx, l.end()
-				, [&target](node_entry const& lhs, node_entry const& rhs)
-				{ return compare_ref(lhs.id, rhs.id, target); });
+			sort_by_distance(span<node_entry>(l).subspan(unsorted_start_idx), target);
 
 			l.resize(aux::numeric_cast<std::size_t>(count));
 			return l;
@@ -1172,9 +1170,7 @@ std::vector<node_entry> routing_table::find_node(node_id const& target
 		if (int(l.size()) > count)
 		{
 			// sort the nodes by how close they are to the target
-			std::sort(l.begin() + unsorted_start_idx, l.end()
-				, [&target](node_entry const& lhs, node_entry const& rhs)
-				{ return compare_ref(lhs.id, rhs.id, target); });
+			sort_by_distance(span<node_entry>(l).subspan(unsorted_start_idx), target);
 
 			l.resize(aux::numeric_cast<std::size_t>(count));
 			return l;
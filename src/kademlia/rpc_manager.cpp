@@ -392,56 +392,103 @@ time_duration rpc_manager::tick()
 	constexpr auto short_timeout = seconds(1);
 	constexpr auto timeout = seconds(15);
 
-	// look for observers that have timed out
+	// look for observers that have timed out. The two queues are in send
+	// order, which is also expiry order since all transactions share the
+	// same timeout constants, so only the entries at the front can have
+	// expired; everything behind them expires later
 
-	if (m_transactions.empty()) return short_timeout;
+	if (m_transactions.empty())
+	{
+		m_short_timeout_queue.clear();
+		m_timeout_queue.clear();
+		return short_timeout;
+	}
 
 	std::vector<observer_ptr> timeouts;
 	std::vector<observer_ptr> short_timeouts;
 
 	time_duration ret = short_timeout;
-	time_point now = aux::time_now();
+	time_point const now = aux::time_now();
 
-	for (auto i = m_transactions.begin(); i != m_transactions.end();)
+	// finds the transaction entry for this exact observer, or
+	// m_transactions.end() if it has already completed
+	auto const find_transaction = [this](int const tid, observer_ptr const& o)
 	{
-		observer_ptr o = i->second;
+		auto const range = m_transactions.equal_range(tid);
+		for (auto i = range.first; i != range.second; ++i)
+			if (i->second == o) return i;
+		return m_transactions.end();
+	};
 
-		time_duration diff = now - o->sent();
-		if (diff >= timeout)
+	while (!m_short_timeout_queue.empty())
+	{
+		int const tid = m_short_timeout_queue.front().first;
+		observer_ptr o = m_short_timeout_queue.front().second;
+
+		if (find_transaction(tid, o) == m_transactions.end())
 		{
-#ifndef TORRENT_DISABLE_LOGGING
-			if (m_log->should_log(dht_logger::rpc_manager))
-			{
-				m_log->log(dht_logger::rpc_manager, "[%u] timing out transaction id: %d from: %s"
-					, o->algorithm()->id(), i->first
-					, print_endpoint(o->target_ep()).c_str());
-			}
-#endif
-			i = m_transactions.erase(i);
-			timeouts.push_back(o);
+			// this transaction already completed
+			m_short_timeout_queue.pop_front();
 			continue;
 		}
 
+		time_duration const diff = now - o->sent();
+		if (diff < short_timeout)
+		{
+			ret = std::min(duration_cast<time_duration>(short_timeout - diff), ret);
+			break;
+		}
+
+		m_short_timeout_queue.pop_front();
+		m_timeout_queue.emplace_back(tid, o);
+
 		// don't call short_timeout() again if we've
 		// already called it once
-		if (diff >= short_timeout && !o->has_short_timeout())
+		if (!o->has_short_timeout())
 		{
 #ifndef TORRENT_DISABLE_LOGGING
 			if (m_log->should_log(dht_logger::rpc_manager))
 			{
 				m_log->log(dht_logger::rpc_manager, "[%u] short-timing out transaction id: %d from: %s"
-					, o->algorithm()->id(), i->first
+					, o->algorithm()->id(), tid
 					, print_endpoint(o->target_ep()).c_str());
 			}
 #endif
-			++i;
+			short_timeouts.push_back(std::move(o));
+		}
+	}
 
-			short_timeouts.push_back(o);
+	while (!m_timeout_queue.empty())
+	{
+		int const tid = m_timeout_queue.front().first;
+		observer_ptr o = m_timeout_queue.front().second;
+
+		auto const it = find_transaction(tid, o);
+		if (it == m_transactions.end())
+		{
+			// this transaction already completed
+			m_timeout_queue.pop_front();
 			continue;
 		}
 
-		ret = std::min(duration_cast<time_duration>(timeout - diff), ret);
-		++i;
+		time_duration const diff = now - o->sent();
+		if (diff < timeout)
+		{
+			ret = std::min(duration_cast<time_duration>(timeout - diff), ret);
+			break;
+		}
+
+#ifndef TORRENT_DISABLE_LOGGING
+		if (m_log->should_log(dht_logger::rpc_manager))
+		{
+			m_log->log(dht_logger::rpc_manager, "[%u] timing out transaction id: %d from: %s"
+				, o->algorithm()->id(), tid
+				, print_endpoint(o->target_ep()).c_str());
+		}
+#endif
+		m_transactions.erase(it);
+		m_timeout_queue.pop_front();
+		timeouts.push_back(std::move(o));
 	}
 
 	std::for_each(timeouts.begin(), timeouts.end(), std::bind(&observer::timeout, _1));
@@ -497,6 +544,7 @@ bool rpc_manager::invoke(entry& e, udp::endpoint const& target_addr
 	if (m_sock_man->send_packet(m_sock, e, target_addr))
 	{
 		m_transactions.insert(std::make_pair(tid, o));
+		m_short_timeout_queue.emplace_back(tid, o);
 #if TORRENT_USE_ASSERTS
 		o->m_was_sent = true;
 #endif
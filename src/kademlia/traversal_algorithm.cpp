@@ -327,6 +327,14 @@ void traversal_algorithm::finished(observer_ptr o)
 	o->flags |= observer::flag_alive;
 
 	++m_responses;
+
+	// this lookup is making progress. As long as timeouts stay rare,
+	// allow more queries in flight, up to double the configured branch
+	// factor
+	if (m_timeouts * 4 <= m_responses
+		&& m_adaptive_branch < m_branch_factor)
+		++m_adaptive_branch;
+
 	TORRENT_ASSERT(m_invoke_count > 0);
 	--m_invoke_count;
 	bool const is_done = add_requests();
@@ -378,6 +386,13 @@ void traversal_algorithm::failed(observer_ptr o, traversal_flags_t const flags)
 #endif
 
 		++m_timeouts;
+
+		// back off the concurrency when queries keep timing out; there's
+		// no point keeping many parallel queries in flight towards dead
+		// address space
+		if (m_adaptive_branch > -(m_branch_factor / 2))
+			--m_adaptive_branch;
+
 		TORRENT_ASSERT(m_invoke_count > 0);
 		--m_invoke_count;
 	}
@@ -493,11 +508,16 @@ bool traversal_algorithm::add_requests()
 	// limits the number of outstanding requests, this limits the
 	// number of good outstanding requests. It will use more traffic,
 	// but is intended to speed up lookups
+	// the effective concurrency limit is the configured branch factor
+	// plus the adaptive adjustment learned over the course of this lookup
+	int const branch_limit = std::max(1
+		, int(m_branch_factor) + int(m_adaptive_branch));
+
 	for (auto i = m_results.begin()
 		, end(m_results.end()); i != end
 		&& results_target > 0
-		&& (agg ? outstanding < m_branch_factor
-			: m_invoke_count < m_branch_factor);
+		&& (agg ? outstanding < branch_limit
+			: m_invoke_count < branch_limit);
 		++i)
 	{
 		observer* o = i->get();
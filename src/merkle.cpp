@@ -35,6 +35,9 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/aux_/merkle.hpp"
 #include "libtorrent/aux_/vector.hpp"
 
+#include <algorithm> // for std::min
+#include <array>
+
 namespace libtorrent {
 
 	int merkle_layer_start(int const layer)
@@ -142,6 +145,63 @@ namespace libtorrent {
 		TORRENT_ASSERT(level_size == 1);
 	}
 
+	void merkle_update_tree(span<sha256_hash> tree, int const num_leafs
+		, int level_start, int first_dirty, int end_dirty)
+	{
+		TORRENT_ASSERT(level_start >= 0);
+		TORRENT_ASSERT(num_leafs >= 1);
+		TORRENT_ASSERT(first_dirty >= 0);
+		TORRENT_ASSERT(first_dirty < end_dirty);
+		TORRENT_ASSERT(end_dirty <= num_leafs);
+
+		int level_size = num_leafs;
+		while (level_size > 1)
+		{
+			// widen the range to whole sibling pairs, the siblings are
+			// expected to be valid
+			first_dirty &= ~1;
+			end_dirty = std::min(level_size, (end_dirty + 1) & ~1);
+			for (int i = first_dirty; i < end_dirty; i += 2)
+			{
+				hasher256 h;
+				h.update(tree[level_start + i]);
+				h.update(tree[level_start + i + 1]);
+				tree[merkle_get_parent(level_start + i)] = h.final();
+			}
+			level_start = merkle_get_parent(level_start);
+			level_size /= 2;
+			first_dirty /= 2;
+			end_dirty /= 2;
+		}
+		TORRENT_ASSERT(level_size == 1);
+	}
+
+	void merkle_fill_pad(span<sha256_hash> tree, int const num_leafs
+		, int level_start, int const end_payload, sha256_hash pad)
+	{
+		TORRENT_ASSERT(level_start >= 0);
+		TORRENT_ASSERT(num_leafs >= 1);
+		TORRENT_ASSERT(end_payload >= 0);
+		TORRENT_ASSERT(end_payload <= num_leafs);
+
+		int level_size = num_leafs;
+		int level_end = end_payload;
+		for (;;)
+		{
+			for (int i = level_end; i < level_size; ++i)
+				tree[level_start + i] = pad;
+			if (level_size == 1) break;
+			hasher256 h;
+			h.update(pad);
+			h.update(pad);
+			pad = h.final();
+			level_start = merkle_get_parent(level_start);
+			level_size /= 2;
+			level_end = std::min(level_size, (level_end + 1) / 2);
+		}
+		TORRENT_ASSERT(level_size == 1);
+	}
+
 	void merkle_fill_partial_tree(span<sha256_hash> tree)
 	{
 		int const num_nodes = aux::numeric_cast<int>(tree.size());
@@ -243,7 +303,21 @@ namespace libtorrent {
 		while (num_leafs > 1)
 		{
 			int i = 0;
-			for (; i < int(leaves.size()) / 2; ++i)
+			int const pairs = int(leaves.size()) / 2;
+			// each sibling pair is 64 contiguous bytes in the layer below.
+			// hash them in batches of 8, which lets hash_blocks() run the
+			// pairs in lockstep with SIMD where the CPU supports it. This is
+			// safe even though the output aliases the input on the upper
+			// layers: output slot i is only written once input slots 2*i and
+			// 2*i + 1 have been read
+			for (; i + 8 <= pairs; i += 8)
+			{
+				std::array<span<char const>, 8> bufs;
+				for (int k = 0; k < 8; ++k)
+					bufs[k] = { leaves[(i + k) * 2].data(), 64 };
+				hasher256::hash_blocks(bufs, { scratch_space.data() + i, 8 });
+			}
+			for (; i < pairs; ++i)
 			{
 				scratch_space[std::size_t(i)] = hasher256()
 					.update(leaves[i * 2])
@@ -548,19 +548,21 @@ namespace {
 				int const start = merkle_first_leaf(piece_layer_size);
 				TORRENT_ASSERT(m_tree.end_index() <= piece_layer_size);
 				std::copy(m_tree.begin(), m_tree.end(), ret.begin() + start);
-				std::fill(ret.begin() + start + m_tree.end_index(), ret.begin() + start + piece_layer_size, pad_hash);
-				merkle_fill_tree(span<sha256_hash>(ret).subspan(0, merkle_num_nodes(piece_layer_size))
-					, piece_layer_size);
+				// the all-pad sub-trees to the right of the payload are
+				// identical within each level, fill them with one hash per
+				// level and only compute the ancestors of the payload
+				auto const interior = span<sha256_hash>(ret).subspan(0, merkle_num_nodes(piece_layer_size));
+				merkle_fill_pad(interior, piece_layer_size, start, m_tree.end_index(), pad_hash);
+				merkle_update_tree(interior, piece_layer_size, start, 0, m_tree.end_index());
 				break;
 			}
 			case mode_t::block_layer:
 			{
 				int const num_leafs = merkle_num_leafs(m_num_blocks);
-				sha256_hash const pad_hash{};
 				int const start = merkle_first_leaf(num_leafs);
 				std::copy(m_tree.begin(), m_tree.end(), ret.begin() + start);
-				std::fill(ret.begin() + start + m_tree.end_index(), ret.begin() + start + num_leafs, sha256_hash{});
-				merkle_fill_tree(ret, num_leafs);
+				merkle_fill_pad(ret, num_leafs, start, m_tree.end_index(), sha256_hash{});
+				merkle_update_tree(ret, num_leafs, start, 0, m_tree.end_index());
 				break;
 			}
 		}
@@ -54,6 +54,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <sys/mman.h> // for mmap
 #include <sys/stat.h>
 #include <fcntl.h> // for open
+#include <unistd.h> // for sysconf
+#include <cerrno> // for errno
 
 #include "libtorrent/aux_/disable_warnings_push.hpp"
 auto const map_failed = MAP_FAILED;
@@ -308,6 +310,11 @@ namespace {
 #ifdef MAP_NOCACHE
 			| ((m & open_mode::no_cache) ? MAP_NOCACHE : 0)
 #endif
+#ifdef MAP_POPULATE
+			// pre-fault the whole mapping up-front, instead of taking a
+			// page-fault storm on first access
+			| ((m & open_mode::populate) ? MAP_POPULATE : 0)
+#endif
 #ifdef MAP_NOCORE
 			// BSD has a flag to exclude this region from core files
 			| MAP_NOCORE
@@ -348,7 +355,21 @@ file_handle::file_handle(string_view name, std::int64_t const size
 
 		if (!(mode & open_mode::sparse))
 		{
-#if TORRENT_HAS_FALLOCATE
+#ifdef TORRENT_LINUX
+			// prefer the native fallocate() over posix_fallocate(). When the
+			// filesystem doesn't support pre-allocation it fails right away,
+			// instead of falling back to writing a zero to every block of
+			// the file, which can take minutes for large files. The file
+			// size is already set by the ftruncate() above, so an
+			// unsupported filesystem is fine to ignore
+			if (::fallocate(m_fd, 0, 0, size) != 0
+				&& errno != EOPNOTSUPP && errno != ENOSYS && errno != EINVAL)
+			{
+				int const err = errno;
+				::close(m_fd);
+				throw_ex<system_error>(error_code(err, system_category()));
+			}
+#elif TORRENT_HAS_FALLOCATE
 			// if fallocate failed, we have to use posix_fallocate
 			// which can be painfully slow
 			// if you get a compile error here, you might want to
@@ -575,6 +596,12 @@ file_mapping::file_mapping(file_handle file, open_mode_t const mode, std::int64_
 		// with large disk caches)
 		// ignore errors here, since this is best-effort
 			| MADV_DONTDUMP
+#endif
+#ifdef MADV_HUGEPAGE
+		// ask the kernel to back this mapping with transparent huge pages,
+		// so large hot files occupy fewer TLB entries. Only supported for
+		// file-backed mappings on recent kernels; best-effort like the rest
+			| ((mode & open_mode::hugepage) ? MADV_HUGEPAGE : 0)
 #endif
 		;
 		if (advise != 0)
@@ -650,6 +677,121 @@ file_mapping::file_mapping(file_mapping&& rhs)
 		return file_view(shared_from_this());
 	}
 
+	void file_view::hint_read_ahead(std::int64_t const offset
+		, std::int64_t const length) const
+	{
+#if TORRENT_USE_MADVISE && defined MADV_WILLNEED
+		span<byte const> const mem = m_mapping->memory();
+		if (offset < 0 || offset >= mem.size()) return;
+		std::int64_t const len = std::min(length
+			, std::int64_t(mem.size()) - offset);
+		if (len <= 0) return;
+		// the address passed to madvise() must be page aligned
+		static std::uintptr_t const page_mask
+			= std::uintptr_t(sysconf(_SC_PAGESIZE)) - 1;
+		auto const addr = reinterpret_cast<std::uintptr_t>(mem.data())
+			+ static_cast<std::uintptr_t>(offset);
+		auto const aligned = addr & ~page_mask;
+		// this is a best-effort hint, ignore failures
+		madvise(reinterpret_cast<void*>(aligned)
+			, static_cast<std::size_t>(len + std::int64_t(addr - aligned))
+			, MADV_WILLNEED);
+#else
+		TORRENT_UNUSED(offset);
+		TORRENT_UNUSED(length);
+#endif
+	}
+
+	void file_view::flush_async(std::int64_t const offset
+		, std::int64_t const length) const
+	{
+#if TORRENT_HAVE_MMAP
+		span<byte const> const mem = m_mapping->memory();
+		if (offset < 0 || offset >= mem.size()) return;
+		std::int64_t const len = std::min(length
+			, std::int64_t(mem.size()) - offset);
+		if (len <= 0) return;
+		// the address passed to msync() must be page aligned
+		static std::uintptr_t const page_mask
+			= std::uintptr_t(sysconf(_SC_PAGESIZE)) - 1;
+		auto const addr = reinterpret_cast<std::uintptr_t>(mem.data())
+			+ static_cast<std::uintptr_t>(offset);
+		auto const aligned = addr & ~page_mask;
+		// this is a best-effort hint, ignore failures
+		::msync(reinterpret_cast<void*>(aligned)
+			, static_cast<std::size_t>(len + std::int64_t(addr - aligned))
+			, MS_ASYNC);
+#else
+		TORRENT_UNUSED(offset);
+		TORRENT_UNUSED(length);
+#endif
+	}
+
+	bool file_view::has_data(std::int64_t const offset
+		, std::int64_t const length) const
+	{
+#if TORRENT_HAVE_MMAP && defined SEEK_DATA
+		// lseek() with SEEK_DATA finds the first byte at or after the given
+		// offset that isn't part of a hole in a sparse file. The file
+		// position of this descriptor isn't used for I/O (all access goes
+		// through the mapping), so moving it is harmless
+		std::int64_t const data = ::lseek(m_mapping->m_file.fd(), offset, SEEK_DATA);
+		if (data < 0)
+		{
+			// ENXIO means there's no data at or beyond this offset. Any
+			// other error means the filesystem can't probe for holes, in
+			// which case we have to assume the range holds data
+			return errno != ENXIO;
+		}
+		return data < offset + length;
+#else
+		TORRENT_UNUSED(offset);
+		TORRENT_UNUSED(length);
+		return true;
+#endif
+	}
+
+	bool file_view::is_resident(std::int64_t const offset
+		, std::int64_t const length) const
+	{
+#if TORRENT_HAVE_MMAP
+		span<byte const> const mem = m_mapping->memory();
+		if (offset < 0 || length <= 0 || offset + length > mem.size())
+			return false;
+		// the address passed to mincore() must be page aligned
+		static std::uintptr_t const page_mask
+			= std::uintptr_t(sysconf(_SC_PAGESIZE)) - 1;
+		auto const addr = reinterpret_cast<std::uintptr_t>(mem.data())
+			+ static_cast<std::uintptr_t>(offset);
+		auto const aligned = addr & ~page_mask;
+		auto const len = static_cast<std::size_t>(length
+			+ std::int64_t(addr - aligned));
+		std::size_t const num_pages = (len + page_mask) / (page_mask + 1);
+
+		// this is only meant for block-sized ranges, i.e. a handful of
+		// pages. If the range is larger than this, report not-resident and
+		// let the caller take the regular read path
+		constexpr std::size_t max_pages = 64;
+		if (num_pages > max_pages) return false;
+
+		// the vector element type differs between platforms
+#ifdef TORRENT_LINUX
+		unsigned char vec[max_pages];
+#else
+		char vec[max_pages];
+#endif
+		if (::mincore(reinterpret_cast<void*>(aligned), len, vec) != 0)
+			return false;
+		for (std::size_t i = 0; i < num_pages; ++i)
+			if (!(vec[i] & 1)) return false;
+		return true;
+#else
+		TORRENT_UNUSED(offset);
+		TORRENT_UNUSED(length);
+		return false;
+#endif
+	}
+
 } // aux
 } // libtorrent
 
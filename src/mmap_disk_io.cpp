@@ -47,6 +47,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/torrent_info.hpp"
 #include "libtorrent/aux_/disk_buffer_pool.hpp"
 #include "libtorrent/aux_/disk_io_job.hpp"
+#include "libtorrent/aux_/tracepoint.hpp"
+#include "libtorrent/aux_/event_trace.hpp"
 #include "libtorrent/performance_counters.hpp"
 #include "libtorrent/debug.hpp"
 #include "libtorrent/units.hpp"
@@ -71,6 +73,11 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include <functional>
 #include <condition_variable>
+#include <array>
+#include <deque>
+#include <vector>
+#include <limits>
+#include <unordered_map>
 
 #include "libtorrent/aux_/disable_warnings_push.hpp"
 #include <boost/variant/get.hpp>
@@ -151,6 +158,211 @@ namespace {
 
 using jobqueue_t = tailqueue<aux::disk_io_job>;
 
+// the maximum number of adjacent blocks flushed in a single write
+// operation (see take_adjacent_writes())
+constexpr int max_coalesce_blocks = 32;
+
+// a job queue that deals out jobs fairly across storages, instead of
+// strictly FIFO. Each storage has its own lane and lanes are drained
+// deficit-round-robin, so a single torrent with a deep queue (e.g. a
+// force-recheck) can't starve the jobs of every other torrent
+struct fair_jobqueue
+{
+	bool empty() const { return m_size == 0; }
+	int size() const { return m_size; }
+
+	void push_back(aux::disk_io_job* j)
+	{
+		lane& ln = m_lanes[key_for(j)];
+		if (!ln.active)
+		{
+			ln.active = true;
+			ln.deficit = quantum;
+			m_rr.push_back(key_for(j));
+		}
+		ln.q.push_back(j);
+		++m_size;
+	}
+
+	aux::disk_io_job* pop_front()
+	{
+		TORRENT_ASSERT(m_size > 0);
+		for (;;)
+		{
+			TORRENT_ASSERT(!m_rr.empty());
+			std::uint32_t const key = m_rr.front();
+			auto const it = m_lanes.find(key);
+			if (it == m_lanes.end() || it->second.q.empty())
+			{
+				if (it != m_lanes.end()) m_lanes.erase(it);
+				m_rr.pop_front();
+				continue;
+			}
+			lane& ln = it->second;
+			if (ln.deficit == 0)
+			{
+				// this lane used up its quantum, move it to the back of the
+				// round-robin order
+				ln.deficit = quantum;
+				m_rr.pop_front();
+				m_rr.push_back(key);
+				continue;
+			}
+			--ln.deficit;
+			--m_size;
+			aux::disk_io_job* j = ln.q.pop_front();
+			if (ln.q.empty())
+			{
+				m_lanes.erase(it);
+				m_rr.pop_front();
+			}
+			return j;
+		}
+	}
+
+	void append(jobqueue_t& jobs)
+	{
+		while (!jobs.empty()) push_back(jobs.pop_front());
+	}
+
+	// puts jobs back at the front of their respective lanes, in order
+	void prepend(jobqueue_t& jobs)
+	{
+		std::vector<aux::disk_io_job*> tmp;
+		while (!jobs.empty()) tmp.push_back(jobs.pop_front());
+		for (auto i = tmp.rbegin(); i != tmp.rend(); ++i)
+		{
+			aux::disk_io_job* j = *i;
+			lane& ln = m_lanes[key_for(j)];
+			if (!ln.active)
+			{
+				ln.active = true;
+				ln.deficit = quantum;
+				m_rr.push_back(key_for(j));
+			}
+			ln.q.push_front(j);
+			++m_size;
+		}
+	}
+
+	// visit every queued job. The jobs must not be removed or re-linked by f
+	template <typename Fun>
+	void visit(Fun f)
+	{
+		for (auto& e : m_lanes)
+			for (auto i = e.second.q.iterate(); i.get(); i.next())
+				f(i.get());
+	}
+
+	// remove and return the queued write jobs forming a contiguous run of
+	// blocks right after j in the same piece, in ascending offset order.
+	// Only j's own lane needs to be scanned
+	jobqueue_t extract_adjacent_writes(aux::disk_io_job* j, int const max_blocks)
+	{
+		jobqueue_t ret;
+		auto const it = m_lanes.find(key_for(j));
+		if (it == m_lanes.end()) return ret;
+		lane& ln = it->second;
+
+		// candidate jobs, indexed by block distance from j (minus one)
+		std::vector<aux::disk_io_job*> adjacent(std::size_t(max_blocks - 1), nullptr);
+		jobqueue_t keep;
+		int found = 0;
+		while (!ln.q.empty())
+		{
+			aux::disk_io_job* k = ln.q.pop_front();
+			int slot = -1;
+			if (k->action == aux::job_action_t::write
+				&& k->storage == j->storage
+				&& k->piece == j->piece
+				&& !(k->flags & aux::disk_io_job::fence))
+			{
+				int const dist = k->d.io.offset - j->d.io.offset;
+				if (dist > 0
+					&& (dist % default_block_size) == 0
+					&& dist / default_block_size < max_blocks
+					&& adjacent[std::size_t(dist / default_block_size - 1)] == nullptr)
+				{
+					slot = dist / default_block_size - 1;
+				}
+			}
+			if (slot >= 0)
+			{
+				adjacent[std::size_t(slot)] = k;
+				++found;
+			}
+			else
+			{
+				keep.push_back(k);
+			}
+		}
+		ln.q.swap(keep);
+		m_size -= found;
+
+		// take the contiguous run, and put any jobs beyond the first hole
+		// back in the lane
+		std::vector<aux::disk_io_job*> requeue;
+		bool contiguous = true;
+		for (aux::disk_io_job* k : adjacent)
+		{
+			if (k == nullptr)
+			{
+				contiguous = false;
+				continue;
+			}
+			if (contiguous)
+			{
+				ret.push_back(k);
+				// a block shorter than default_block_size is the last block
+				// of the piece, nothing can follow it
+				if (k->d.io.buffer_size != default_block_size) contiguous = false;
+			}
+			else
+			{
+				requeue.push_back(k);
+			}
+		}
+		for (auto i = requeue.rbegin(); i != requeue.rend(); ++i)
+		{
+			ln.q.push_front(*i);
+			++m_size;
+		}
+		if (ln.q.empty())
+		{
+			// the stale round-robin entry is left behind, pop_front() cleans
+			// it up
+			m_lanes.erase(it);
+		}
+		return ret;
+	}
+
+private:
+
+	// the number of jobs a lane may run before yielding to the next one
+	static constexpr int quantum = 4;
+
+	static std::uint32_t key_for(aux::disk_io_job const* j)
+	{
+		// jobs without a storage all share one lane
+		return j->storage ? static_cast<std::uint32_t>(j->storage->storage_index())
+			: std::numeric_limits<std::uint32_t>::max();
+	}
+
+	struct lane
+	{
+		jobqueue_t q;
+		int deficit = 0;
+		bool active = false;
+	};
+
+	std::unordered_map<std::uint32_t, lane> m_lanes;
+
+	// the round-robin order of active lanes. May contain stale keys, they
+	// are skipped (and removed) by pop_front()
+	std::deque<std::uint32_t> m_rr;
+	int m_size = 0;
+};
+
 // this is a singleton consisting of the thread and a queue
 // of disk io jobs
 struct TORRENT_EXTRA_EXPORT mmap_disk_io final
@@ -205,7 +417,23 @@ struct TORRENT_EXTRA_EXPORT mmap_disk_io final
 
 	// implements buffer_allocator_interface
 	void free_disk_buffer(char* b) override
-	{ m_buffer_pool.free_buffer(b); }
+	{
+		// buffers handed out by the zero-copy read path point into file
+		// mappings rather than the buffer pool. The atomic check keeps the
+		// common case free of the extra lock
+		if (m_mapped_bufs_in_flight.load(std::memory_order_acquire) > 0)
+		{
+			std::unique_lock<std::mutex> l(m_mapped_bufs_mutex);
+			auto const it = m_mapped_bufs.find(b);
+			if (it != m_mapped_bufs.end())
+			{
+				m_mapped_bufs.erase(it);
+				m_mapped_bufs_in_flight.fetch_sub(1, std::memory_order_release);
+				return;
+			}
+		}
+		m_buffer_pool.free_buffer(b);
+	}
 
 	void update_stats_counters(counters& c) const override;
 
@@ -216,6 +444,7 @@ struct TORRENT_EXTRA_EXPORT mmap_disk_io final
 
 	status_t do_read(aux::disk_io_job* j);
 	status_t do_write(aux::disk_io_job* j);
+	jobqueue_t take_adjacent_writes(aux::disk_io_job* j);
 	status_t do_hash(aux::disk_io_job* j);
 	status_t do_hash2(aux::disk_io_job* j);
 
@@ -259,8 +488,8 @@ private:
 		// jobs on the job queue (m_queued_jobs)
 		std::condition_variable m_job_cond;
 
-		// jobs queued for servicing
-		jobqueue_t m_queued_jobs;
+		// jobs queued for servicing, dealt out fairly across storages
+		fair_jobqueue m_queued_jobs;
 	};
 
 	void thread_fun(job_queue& queue, aux::disk_io_thread_pool& pool);
@@ -331,6 +560,21 @@ private:
 	// disk cache
 	aux::disk_buffer_pool m_buffer_pool;
 
+	// blocks served straight out of a file mapping (zero-copy reads) are
+	// tracked here, keyed on the pointer handed out. The file_view keeps
+	// the mapping alive until the buffer is freed. A multimap, since the
+	// same block may be in flight to more than one peer
+	std::mutex m_mapped_bufs_mutex;
+	std::unordered_multimap<char*, aux::file_view> m_mapped_bufs;
+	std::atomic<int> m_mapped_bufs_in_flight{0};
+
+	// the token bucket pacing asynchronous write-back of dirty pages, in
+	// bytes. Refilled at settings_pack::disk_write_back_rate bytes per
+	// second
+	std::mutex m_write_back_mutex;
+	std::int64_t m_write_back_tokens = 0;
+	time_point m_write_back_last_refill = clock_type::now();
+
 	// total number of blocks in use by both the read
 	// and the write cache. This is not supposed to
 	// exceed m_cache_size
@@ -424,6 +668,7 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 
 	void mmap_disk_io::remove_torrent(storage_index_t const idx)
 	{
+		m_store_buffer.clear_cache(idx);
 		m_torrents[idx].reset();
 		m_free_slots.push_back(idx);
 	}
@@ -456,8 +701,8 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 		// abort outstanding jobs belonging to this torrent
 
 		DLOG("aborting hash jobs\n");
-		for (auto i = m_hash_io_jobs.m_queued_jobs.iterate(); i.get(); i.next())
-			i.get()->flags |= aux::disk_io_job::aborted;
+		m_hash_io_jobs.m_queued_jobs.visit([](aux::disk_io_job* j)
+			{ j->flags |= aux::disk_io_job::aborted; });
 		l.unlock();
 
 		// if there are no disk threads, we can't wait for the jobs here, because
@@ -480,12 +725,15 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 		TORRENT_ASSERT(m_magic == 0x1337);
 		m_buffer_pool.set_settings(m_settings);
 		m_file_pool.resize(m_settings.get_int(settings_pack::file_pool_size));
+		m_store_buffer.set_cache_size(m_settings.get_int(settings_pack::disk_read_cache_size));
 
 		int const num_threads = m_settings.get_int(settings_pack::aio_threads);
 		int const num_hash_threads = m_settings.get_int(settings_pack::hashing_threads);
 		DLOG("set max threads(%d, %d)\n", num_threads, num_hash_threads);
 
 		m_generic_threads.set_max_threads(num_threads);
+		m_generic_threads.set_min_threads(std::min(
+			m_settings.get_int(settings_pack::aio_threads_min), num_threads));
 		m_hash_threads.set_max_threads(num_hash_threads);
 	}
 
@@ -508,6 +756,35 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 
 	namespace {
 
+	// maps a job duration to one of the log-scale latency histogram
+	// buckets. Bucket N covers durations below 4^N milliseconds, the last
+	// one everything else
+	int latency_bucket(std::int64_t const us)
+	{
+		int bucket = 0;
+		std::int64_t threshold = 1000;
+		while (bucket < 6 && us >= threshold)
+		{
+			threshold *= 4;
+			++bucket;
+		}
+		return bucket;
+	}
+
+	// the first histogram bucket for the given job type, or -1 for job
+	// types whose latency isn't tracked
+	int latency_base_counter(aux::job_action_t const action)
+	{
+		switch (action)
+		{
+			case aux::job_action_t::read: return counters::disk_read_lat_1ms;
+			case aux::job_action_t::write: return counters::disk_write_lat_1ms;
+			case aux::job_action_t::hash:
+			case aux::job_action_t::hash2: return counters::disk_hash_lat_1ms;
+			default: return -1;
+		}
+	}
+
 	typedef status_t (mmap_disk_io::*disk_io_fun_t)(aux::disk_io_job* j);
 
 	// this is a jump-table for disk I/O jobs
@@ -553,6 +830,11 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 
 		m_stats_counters.inc_stats_counter(counters::num_running_disk_jobs, 1);
 
+		time_point const start_time = clock_type::now();
+		TORRENT_PROBE2(disk_job_start, static_cast<int>(j->action)
+			, static_cast<int>(j->piece));
+		TORRENT_TRACE_BEGIN(job_name(j->action), static_cast<int>(j->piece));
+
 		// call disk function
 		// TODO: in the future, propagate exceptions back to the handlers
 		status_t ret = status_t::no_error;
@@ -584,8 +866,19 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 		TORRENT_ASSERT(ret != status_t::fatal_disk_error
 			|| (j->error.ec && j->error.operation != operation_t::unknown));
 
+		int const lat_base = latency_base_counter(j->action);
+		if (lat_base >= 0)
+		{
+			std::int64_t const job_time = total_microseconds(clock_type::now() - start_time);
+			m_stats_counters.inc_stats_counter(lat_base + latency_bucket(job_time));
+		}
+
 		m_stats_counters.inc_stats_counter(counters::num_running_disk_jobs, -1);
 
+		TORRENT_PROBE3(disk_job_complete, static_cast<int>(j->action)
+			, static_cast<int>(j->piece), static_cast<int>(ret));
+		TORRENT_TRACE_END(job_name(j->action), static_cast<int>(j->piece));
+
 		j->ret = ret;
 
 		completed_jobs.push_back(j);
@@ -593,6 +886,37 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 
 	status_t mmap_disk_io::do_read(aux::disk_io_job* j)
 	{
+		// when the caller has promised not to modify the buffer, serve the
+		// read straight out of the file mapping instead of copying the block
+		// into a send buffer. The network layer then transmits directly from
+		// the page cache, cutting the per-byte copy out of the upload path
+		if ((j->flags & disk_interface::zero_copy)
+			&& !(j->flags & disk_interface::force_copy))
+		{
+			time_point const start_time = clock_type::now();
+			boost::optional<aux::file_view> view;
+			char* const buf = j->storage->map_read(m_settings, j->piece
+				, j->d.io.offset, j->d.io.buffer_size
+				, file_flags_for_job(j), view);
+			if (buf != nullptr)
+			{
+				{
+					std::lock_guard<std::mutex> l(m_mapped_bufs_mutex);
+					m_mapped_bufs.emplace(buf, std::move(*view));
+					m_mapped_bufs_in_flight.fetch_add(1, std::memory_order_release);
+				}
+				j->argument = disk_buffer_holder(*this, buf, j->d.io.buffer_size);
+
+				std::int64_t const read_time = total_microseconds(clock_type::now() - start_time);
+				m_stats_counters.inc_stats_counter(counters::num_read_back);
+				m_stats_counters.inc_stats_counter(counters::num_blocks_read);
+				m_stats_counters.inc_stats_counter(counters::num_read_ops);
+				m_stats_counters.inc_stats_counter(counters::disk_read_time, read_time);
+				m_stats_counters.inc_stats_counter(counters::disk_job_time, read_time);
+				return status_t::no_error;
+			}
+		}
+
 		j->argument = disk_buffer_holder(*this, m_buffer_pool.allocate_buffer("send buffer"), default_block_size);
 		auto& buffer = boost::get<disk_buffer_holder>(j->argument);
 		if (!buffer)
@@ -605,11 +929,56 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 		time_point const start_time = clock_type::now();
 
 		aux::open_mode_t const file_flags = file_flags_for_job(j);
-		iovec_t b = {buffer.data(), j->d.io.buffer_size};
 
-		int const ret = j->storage->readv(m_settings, b
+		// how many blocks past the requested one to read in the same
+		// operation. The wire protocol and the piece picker stay at 16 kiB
+		// granularity, but reading several blocks per disk job and handing
+		// the extra ones to the read cache quarters the per-block job
+		// bookkeeping for sequential reads (at the default of 4 blocks)
+		int read_ahead = 0;
+		if (!(j->flags & disk_interface::volatile_read)
+			&& j->d.io.buffer_size == default_block_size
+			&& (j->d.io.offset % default_block_size) == 0)
+		{
+			int const limit = std::min(std::max(
+				m_settings.get_int(settings_pack::disk_read_coalesce_blocks), 1)
+				, max_coalesce_blocks);
+			int const piece_size = j->storage->files().piece_size(j->piece);
+			read_ahead = std::min(limit - 1
+				, (piece_size - j->d.io.offset - default_block_size) / default_block_size);
+			if (read_ahead < 0) read_ahead = 0;
+		}
+
+		TORRENT_ALLOCA(bufs, iovec_t, read_ahead + 1);
+		TORRENT_ALLOCA(extra_buffers, disk_buffer_holder, read_ahead);
+		bufs[0] = {buffer.data(), j->d.io.buffer_size};
+		for (int i = 0; i < read_ahead; ++i)
+		{
+			extra_buffers[i] = disk_buffer_holder(*this
+				, m_buffer_pool.allocate_buffer("read cache"), default_block_size);
+			if (!extra_buffers[i])
+			{
+				// out of buffers; just shrink the read
+				read_ahead = i;
+				break;
+			}
+			bufs[i + 1] = {extra_buffers[i].data(), default_block_size};
+		}
+
+		int ret = j->storage->readv(m_settings
+			, bufs.first(read_ahead + 1)
 			, j->piece, j->d.io.offset, file_flags, j->error);
 
+		if (j->error.ec && read_ahead > 0)
+		{
+			// a failure in one of the read-ahead blocks must not fail the
+			// block the job actually asked for. Retry just that block
+			j->error = storage_error();
+			read_ahead = 0;
+			ret = j->storage->readv(m_settings, bufs.first(1)
+				, j->piece, j->d.io.offset, file_flags, j->error);
+		}
+
 		TORRENT_ASSERT(ret >= 0 || j->error.ec);
 		TORRENT_UNUSED(ret);
 
@@ -622,6 +991,34 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 			m_stats_counters.inc_stats_counter(counters::num_read_ops);
 			m_stats_counters.inc_stats_counter(counters::disk_read_time, read_time);
 			m_stats_counters.inc_stats_counter(counters::disk_job_time, read_time);
+
+			// hand a copy of the block over to the read cache, so subsequent
+			// requests for it don't have to touch the file again
+			if (!(j->flags & disk_interface::volatile_read)
+				&& (j->d.io.offset % default_block_size) == 0)
+			{
+				disk_buffer_holder cached(*this
+					, m_buffer_pool.allocate_buffer("read cache"), default_block_size);
+				if (cached)
+				{
+					std::memcpy(cached.data(), buffer.data(), std::size_t(j->d.io.buffer_size));
+					m_store_buffer.cache({j->storage->storage_index(), j->piece, j->d.io.offset}
+						, std::move(cached));
+				}
+			}
+
+			// hand the read-ahead blocks to the read cache as well, but only
+			// the ones the read actually covered in full
+			for (int i = 0; i < read_ahead; ++i)
+			{
+				int const block_offset = j->d.io.offset
+					+ j->d.io.buffer_size + i * default_block_size;
+				if (ret < block_offset - j->d.io.offset + default_block_size)
+					break;
+				m_stats_counters.inc_stats_counter(counters::num_blocks_read);
+				m_store_buffer.cache({j->storage->storage_index(), j->piece, block_offset}
+					, std::move(extra_buffers[i]));
+			}
 		}
 		return status_t::no_error;
 	}
@@ -631,13 +1028,34 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 		time_point const start_time = clock_type::now();
 		auto buffer = std::move(boost::get<disk_buffer_holder>(j->argument));
 
-		iovec_t const b = { buffer.data(), j->d.io.buffer_size};
+		// pull writes of physically adjacent blocks of the same piece out of
+		// the job queue, and flush them together with this one, in a single
+		// writev(). Under heavy ingest this saves one storage round-trip (and
+		// one job dispatch) per block
+		jobqueue_t coalesced = take_adjacent_writes(j);
+		int const num_bufs = coalesced.size() + 1;
+
+		TORRENT_ALLOCA(bufs, iovec_t, num_bufs);
+		TORRENT_ALLOCA(extra_buffers, disk_buffer_holder, coalesced.size());
+		bufs[0] = { buffer.data(), j->d.io.buffer_size };
+		int total_len = j->d.io.buffer_size;
+		{
+			int idx = 1;
+			for (auto i = coalesced.iterate(); i.get(); i.next(), ++idx)
+			{
+				aux::disk_io_job* k = i.get();
+				extra_buffers[idx - 1] = std::move(boost::get<disk_buffer_holder>(k->argument));
+				bufs[idx] = { extra_buffers[idx - 1].data(), k->d.io.buffer_size };
+				total_len += k->d.io.buffer_size;
+			}
+		}
+
 		aux::open_mode_t const file_flags = file_flags_for_job(j);
 
 		m_stats_counters.inc_stats_counter(counters::num_writing_threads, 1);
 
 		// the actual write operation
-		int const ret = j->storage->writev(m_settings, b
+		int const ret = j->storage->writev(m_settings, bufs
 			, j->piece, j->d.io.offset, file_flags, j->error);
 
 		m_stats_counters.inc_stats_counter(counters::num_writing_threads, -1);
@@ -646,7 +1064,7 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 		{
 			std::int64_t const write_time = total_microseconds(clock_type::now() - start_time);
 
-			m_stats_counters.inc_stats_counter(counters::num_blocks_written);
+			m_stats_counters.inc_stats_counter(counters::num_blocks_written, num_bufs);
 			m_stats_counters.inc_stats_counter(counters::num_write_ops);
 			m_stats_counters.inc_stats_counter(counters::disk_write_time, write_time);
 			m_stats_counters.inc_stats_counter(counters::disk_job_time, write_time);
@@ -660,10 +1078,79 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 
 		m_store_buffer.erase({j->storage->storage_index(), j->piece, j->d.io.offset});
 
-		return ret != j->d.io.buffer_size
+		// the write-back governor: hand recently written extents over to the
+		// OS for asynchronous flushing, paced by a token bucket, so dirty
+		// pages trickle out at the configured rate instead of accumulating
+		// until the kernel flushes them in one large burst
+		int const write_back_rate = m_settings.get_int(settings_pack::disk_write_back_rate);
+		if (write_back_rate > 0 && !j->error.ec)
+		{
+			std::int64_t budget = 0;
+			time_point const now = clock_type::now();
+			{
+				std::lock_guard<std::mutex> l(m_write_back_mutex);
+				// refill the bucket, capped at one second's worth of burst
+				m_write_back_tokens = std::min(std::int64_t(write_back_rate)
+					, m_write_back_tokens
+						+ total_microseconds(now - m_write_back_last_refill)
+						* write_back_rate / 1000000);
+				m_write_back_last_refill = now;
+				budget = m_write_back_tokens;
+			}
+			if (budget >= default_block_size)
+			{
+				std::int64_t const flushed = j->storage->write_back_dirty(m_settings, budget);
+				if (flushed > 0)
+				{
+					std::lock_guard<std::mutex> l(m_write_back_mutex);
+					m_write_back_tokens -= flushed;
+				}
+			}
+		}
+
+		// complete the coalesced jobs. A short write fails every job whose
+		// bytes were not fully written
+		if (!coalesced.empty())
+		{
+			int bytes_flushed = ret < 0 ? 0 : ret;
+			bytes_flushed -= j->d.io.buffer_size;
+			jobqueue_t completed;
+			while (!coalesced.empty())
+			{
+				aux::disk_io_job* k = coalesced.pop_front();
+				m_store_buffer.erase({k->storage->storage_index(), k->piece, k->d.io.offset});
+				if (bytes_flushed >= k->d.io.buffer_size)
+				{
+					k->ret = status_t::no_error;
+				}
+				else
+				{
+					k->ret = status_t::fatal_disk_error;
+					k->error = j->error;
+				}
+				bytes_flushed -= k->d.io.buffer_size;
+				completed.push_back(k);
+			}
+			add_completed_jobs(completed);
+		}
+
+		return ret != total_len
 			? status_t::fatal_disk_error : status_t::no_error;
 	}
 
+	// collect queued write jobs forming a contiguous run of blocks right
+	// after j in the same piece. The returned jobs are in ascending offset
+	// order. Jobs that are adjacent but leave a hole are left in the queue
+	jobqueue_t mmap_disk_io::take_adjacent_writes(aux::disk_io_job* j)
+	{
+		if ((j->d.io.offset % default_block_size) != 0) return {};
+		if (j->d.io.buffer_size != default_block_size) return {};
+
+		std::lock_guard<std::mutex> l(m_job_mutex);
+		return m_generic_io_jobs.m_queued_jobs.extract_adjacent_writes(j
+			, max_coalesce_blocks);
+	}
+
 	void mmap_disk_io::async_read(storage_index_t storage, peer_request const& r
 		, std::function<void(disk_buffer_holder, storage_error const&)> handler
 		, disk_job_flags_t const flags)
@@ -709,6 +1196,68 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 			return;
 		}
 
+		if (m_store_buffer.get_cached({ storage, r.piece, block_offset }, [&](char* buf)
+		{
+			buffer = disk_buffer_holder(*this, m_buffer_pool.allocate_buffer("send buffer"), r.length);
+			if (!buffer)
+			{
+				ec.ec = error::no_memory;
+				ec.operation = operation_t::alloc_cache_piece;
+				return;
+			}
+
+			std::memcpy(buffer.data(), buf + read_offset, std::size_t(r.length));
+			m_stats_counters.inc_stats_counter(counters::num_read_cache_hits);
+		}))
+		{
+			handler(std::move(buffer), ec);
+			return;
+		}
+
+		// opportunistic fast path: if the requested range is backed by an
+		// already-mapped file whose pages are resident in the page cache,
+		// the read cannot block, so serve it inline instead of taking the
+		// round-trip through the disk threads. The residency probe is racy
+		// (pages may be evicted right after it), but a false positive just
+		// means a page fault on a thread that normally takes a ~100x longer
+		// detour for the same block anyway
+		{
+			boost::optional<aux::file_view> view;
+			char* const buf = m_torrents[storage]->resident_read(
+				r.piece, r.start, r.length, view);
+			if (buf != nullptr)
+			{
+				if ((flags & disk_interface::zero_copy)
+					&& !(flags & disk_interface::force_copy))
+				{
+					// hand out a pointer straight into the mapping, keeping
+					// the mapping alive until the buffer is freed
+					{
+						std::lock_guard<std::mutex> l(m_mapped_bufs_mutex);
+						m_mapped_bufs.emplace(buf, std::move(*view));
+						m_mapped_bufs_in_flight.fetch_add(1, std::memory_order_release);
+					}
+					m_stats_counters.inc_stats_counter(counters::num_blocks_read);
+					m_stats_counters.inc_stats_counter(counters::num_read_ops);
+					handler(disk_buffer_holder(*this, buf, r.length), ec);
+					return;
+				}
+
+				buffer = disk_buffer_holder(*this
+					, m_buffer_pool.allocate_buffer("send buffer"), r.length);
+				if (buffer)
+				{
+					std::memcpy(buffer.data(), buf, std::size_t(r.length));
+					m_stats_counters.inc_stats_counter(counters::num_blocks_read);
+					m_stats_counters.inc_stats_counter(counters::num_read_ops);
+					handler(std::move(buffer), ec);
+					return;
+				}
+				// failing to allocate a buffer isn't fatal here; fall
+				// through and let the regular read path report it
+			}
+		}
+
 		aux::disk_io_job* j = m_job_pool.allocate_job(aux::job_action_t::read);
 		j->storage = m_torrents[storage]->shared_from_this();
 		j->piece = r.piece;
@@ -740,6 +1289,11 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 		disk_buffer_holder buffer(*this, m_buffer_pool.allocate_buffer(
 			exceeded, o, "receive buffer"), default_block_size);
 		if (!buffer) aux::throw_ex<std::bad_alloc>();
+		// this copy is deliberate. It detaches the block from the caller's
+		// receive buffer (which is reused as soon as we return), defers the
+		// page faults of writing through the file mapping to a disk thread,
+		// and gives the store buffer a stable copy to serve reads from until
+		// the block hits disk
 		std::memcpy(buffer.data(), buf, aux::numeric_cast<std::size_t>(r.length));
 
 		aux::disk_io_job* j = m_job_pool.allocate_job(aux::job_action_t::write);
@@ -826,17 +1380,16 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 
 		auto st = m_torrents[storage]->shared_from_this();
 		// hash jobs
-		for (auto i = m_hash_io_jobs.m_queued_jobs.iterate(); i.get(); i.next())
+		m_hash_io_jobs.m_queued_jobs.visit([&st](aux::disk_io_job* j)
 		{
-			aux::disk_io_job* j = i.get();
-			if (j->storage != st) continue;
+			if (j->storage != st) return;
 			// only cancel volatile-read jobs. This means only full checking
 			// jobs. These jobs are likely to have a pretty deep queue and
 			// really gain from being cancelled. They can also be restarted
 			// easily.
-			if (!(j->flags & disk_interface::volatile_read)) continue;
+			if (!(j->flags & disk_interface::volatile_read)) return;
 			j->flags |= aux::disk_io_job::aborted;
-		}
+		});
 	}
 
 	void mmap_disk_io::async_delete_files(storage_index_t const storage
@@ -941,14 +1494,133 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 
 		TORRENT_ASSERT(!v2 || int(j->d.h.block_hashes.size()) >= blocks_in_piece2);
 
+		// when checking a torrent (volatile_read), probe the filesystem for
+		// holes first. A piece lying entirely in holes reads back as all
+		// zeroes, so its hashes can be produced from a (cached) table
+		// instead of reading and hashing every block. This makes rechecking
+		// a partially downloaded torrent proportional to the data actually
+		// on disk. Note that these must be the digests of all-zero buffers,
+		// not zeroed-out digests: a piece whose content is legitimately all
+		// zeroes may be stored as holes by hole-punching filesystems, and
+		// must still pass verification
+		if ((j->flags & disk_interface::volatile_read)
+			&& !j->storage->piece_has_data(m_settings, j->piece
+				, std::max(piece_size, piece_size2), file_flags))
+		{
+			if (v1) j->d.h.piece_hash = aux::hash_of_zeroes(piece_size);
+			for (int i = 0; i < blocks_in_piece2; ++i)
+			{
+				int const len2 = std::min(default_block_size
+					, piece_size2 - i * default_block_size);
+				j->d.h.block_hashes[i] = aux::hash2_of_zeroes(len2);
+			}
+			return status_t::no_error;
+		}
+
+		// v2-only jobs hash every block independently, they don't have to
+		// feed a single hasher in block order the way v1 does. If all blocks
+		// can be served straight out of file mappings, hand them to
+		// hasher256 as one batch, which lets it interleave several blocks
+		// with SIMD
+		if (v2 && !v1 && blocks_in_piece2 > 1)
+		{
+			std::vector<boost::optional<aux::file_view>> views;
+			std::vector<span<char const>> blocks;
+			views.reserve(std::size_t(blocks_in_piece2));
+			blocks.reserve(std::size_t(blocks_in_piece2));
+			bool batch = true;
+			for (int i = 0; i < blocks_in_piece2; ++i)
+			{
+				int const block_offset = i * default_block_size;
+				int const len2 = std::min(default_block_size, piece_size2 - block_offset);
+				// dirty blocks haven't been written to the file yet, fall
+				// back to the one-block-at-a-time loop below
+				if (m_store_buffer.contains({ j->storage->storage_index(), j->piece, block_offset }))
+				{
+					batch = false;
+					break;
+				}
+				boost::optional<aux::file_view> view;
+				char const* const buf = j->storage->map_read(m_settings, j->piece
+					, block_offset, len2, file_flags, view);
+				if (buf == nullptr)
+				{
+					batch = false;
+					break;
+				}
+				views.emplace_back(std::move(view));
+				blocks.push_back({ buf, len2 });
+			}
+			if (batch)
+			{
+				time_point const start_time = clock_type::now();
+
+				// start the reads for the whole piece before hashing the
+				// first block, so the kernel pages in the later blocks while
+				// we chew on the earlier ones
+				for (int i = 0; i < blocks_in_piece2; ++i)
+					j->storage->prefetch(m_settings, j->piece, i * default_block_size
+						, int(blocks[std::size_t(i)].size()), file_flags);
+
+				hasher256::hash_blocks(blocks, j->d.h.block_hashes);
+
+				std::int64_t const read_time = total_microseconds(clock_type::now() - start_time);
+				m_stats_counters.inc_stats_counter(counters::num_blocks_read, blocks_in_piece2);
+				m_stats_counters.inc_stats_counter(counters::num_read_ops);
+				m_stats_counters.inc_stats_counter(counters::disk_hash_time, read_time);
+				m_stats_counters.inc_stats_counter(counters::disk_job_time, read_time);
+				return status_t::no_error;
+			}
+		}
+
 		hasher h;
 		int ret = 0;
 		int offset = 0;
 		int const blocks_to_read = std::max(blocks_in_piece, blocks_in_piece2);
+
+		// when rechecking a torrent, pieces are hashed strictly in order. Use
+		// a deep read-ahead window in that case so the kernel streams the file
+		// at full sequential bandwidth while the hash threads chew on earlier
+		// blocks. checking_mem_usage bounds how much data is in flight. For
+		// regular (random-access) hash jobs just stay one block ahead
+		int const read_ahead = (j->flags & disk_interface::sequential_access)
+			? std::max(1, m_settings.get_int(settings_pack::checking_mem_usage))
+			: 1;
+		int hinted = 1;
+
+		// also hint the head of the next piece, so the pipeline stays full
+		// across job boundaries while this job's result is posted back and
+		// the next hash job is dispatched
+		if ((j->flags & disk_interface::sequential_access)
+			&& next(j->piece) < j->storage->files().end_piece())
+		{
+			piece_index_t const np = next(j->piece);
+			int const np_size = j->storage->files().piece_size(np);
+			int const np_hint = std::min(np_size, read_ahead * default_block_size);
+			for (int o = 0; o < np_hint; o += default_block_size)
+				j->storage->prefetch(m_settings, np, o
+					, std::min(default_block_size, np_size - o), file_flags);
+		}
+
 		for (int i = 0; i < blocks_to_read; ++i)
 		{
 			bool const v2_block = i < blocks_in_piece2;
 
+			// hint upcoming blocks before hashing, so the kernel pages them
+			// in from disk while the hasher chews on this block. This
+			// pipelines the reads with the hash computation instead of
+			// alternating between them
+			while (hinted < blocks_to_read && hinted - i <= read_ahead)
+			{
+				int const next_offset = hinted * default_block_size;
+				int const next_len = std::min(default_block_size
+					, std::max(piece_size, piece_size2) - next_offset);
+				if (next_len > 0)
+					j->storage->prefetch(m_settings, j->piece, next_offset
+						, next_len, file_flags);
+				++hinted;
+			}
+
 			DLOG("do_hash: reading (piece: %d block: %d)\n", int(j->piece), i);
 
 			time_point const start_time = clock_type::now();
@@ -1172,6 +1844,7 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 
 		// gauges
 		c.set_value(counters::disk_blocks_in_use, m_buffer_pool.in_use());
+		c.set_value(counters::disk_read_cache_blocks, m_store_buffer.cache_blocks());
 	}
 
 	status_t mmap_disk_io::do_file_priority(aux::disk_io_job* j)
@@ -1185,10 +1858,12 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 	// this job won't return until all outstanding jobs on this
 	// piece are completed or cancelled and the buffers for it
 	// have been evicted
-	status_t mmap_disk_io::do_clear_piece(aux::disk_io_job*)
+	status_t mmap_disk_io::do_clear_piece(aux::disk_io_job* j)
 	{
-		// there's nothing to do here, by the time this is called the jobs for
-		// this storage has been completed since this is a fence job
+		// by the time this is called the jobs for this storage have been
+		// completed, since this is a fence job. Any blocks of this piece left
+		// in the read cache are stale now
+		m_store_buffer.clear_cache(j->storage->storage_index(), j->piece);
 		return status_t::no_error;
 	}
 
@@ -1259,6 +1934,11 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 			, job_name(j->action)
 			, j->storage ? j->storage->num_outstanding_jobs() : 0);
 
+		// the span from here to the completion handler running covers the
+		// time the job spent waiting in queues, as well as executing
+		TORRENT_TRACE_ASYNC_BEGIN(job_name(j->action)
+			, std::int64_t(reinterpret_cast<std::uintptr_t>(j)));
+
 		// is the fence up for this storage?
 		// jobs that are instantaneous are not affected by the fence, is_blocked()
 		// will take ownership of the job and queue it up, in case the fence is up
@@ -1406,6 +2086,29 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 			bool const should_exit = wait_for_job(queue, pool, l);
 			if (should_exit) break;
 			j = queue.m_queued_jobs.pop_front();
+
+			// checking jobs (hash jobs posted with volatile_read, i.e. a
+			// full recheck rather than verifying a just-downloaded piece)
+			// are background work. While the interactive queue has more
+			// jobs backed up than there are threads to serve them, hold the
+			// checking job back so reads and writes on behalf of peers get
+			// the disk first. When the interactive queue drains, checking
+			// resumes at full speed. The job goes back at the front of its
+			// lane to keep its sequential read order
+			if (&queue == &m_hash_io_jobs
+				&& (j->flags & disk_interface::volatile_read)
+				&& !(j->flags & aux::disk_io_job::aborted)
+				&& !m_abort
+				&& !pool.should_exit()
+				&& m_generic_io_jobs.m_queued_jobs.size()
+					> m_generic_threads.num_threads())
+			{
+				jobqueue_t deferred;
+				deferred.push_back(j);
+				queue.m_queued_jobs.prepend(deferred);
+				queue.m_job_cond.wait_for(l, milliseconds(100));
+				continue;
+			}
 			l.unlock();
 
 			TORRENT_ASSERT((j->flags & aux::disk_io_job::in_progress) || !j->storage);
@@ -1648,6 +2351,8 @@ TORRENT_EXPORT std::unique_ptr<disk_interface> mmap_disk_io_constructor(
 #if TORRENT_USE_ASSERTS
 			j->callback_called = true;
 #endif
+			TORRENT_TRACE_ASYNC_END(job_name(j->action)
+				, std::int64_t(reinterpret_cast<std::uintptr_t>(j)));
 			j->call_callback();
 			to_delete[cnt++] = j;
 			j = next;
@@ -232,6 +232,11 @@ namespace libtorrent {
 	{
 		m_stat_cache.reserve(files().num_files());
 
+		// stat all files in one pass up front. The loops below, and any
+		// resume data validation that follows, are then served out of the
+		// cache
+		m_stat_cache.bulk_stat(files(), m_save_path);
+
 #ifdef TORRENT_WINDOWS
 		// don't do full file allocations on network drives
 		auto const file_name = convert_to_native_path_string(m_save_path);
@@ -371,6 +376,7 @@ namespace libtorrent {
 	bool mmap_storage::has_any_file(storage_error& ec)
 	{
 		m_stat_cache.reserve(files().num_files());
+		m_stat_cache.bulk_stat(files(), m_save_path);
 
 		if (aux::has_any_file(files(), m_save_path, m_stat_cache, ec))
 			return true;
@@ -517,6 +523,172 @@ namespace libtorrent {
 		return { ret, m_save_path };
 	}
 
+namespace {
+
+	// the number of consecutive contiguous block reads before the access
+	// pattern is considered sequential and read-ahead hints are issued
+	constexpr int seq_read_threshold = 4;
+
+	// how far ahead of the read cursor to fault in pages
+	constexpr std::int64_t read_ahead_window = 4 * 1024 * 1024;
+}
+
+	void mmap_storage::maybe_read_ahead(settings_interface const& sett
+		, piece_index_t const piece, int const offset, int const len
+		, aux::open_mode_t const flags)
+	{
+		std::int64_t const start = std::int64_t(files().piece_length())
+			* static_cast<int>(piece) + offset;
+
+		if (start == m_seq_read_cursor.load(std::memory_order_relaxed))
+		{
+			m_seq_read_run.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			m_seq_read_run.store(0, std::memory_order_relaxed);
+			m_read_ahead_pos.store(0, std::memory_order_relaxed);
+		}
+		m_seq_read_cursor.store(start + len, std::memory_order_relaxed);
+
+		if (m_seq_read_run.load(std::memory_order_relaxed) < seq_read_threshold)
+			return;
+
+		std::int64_t const window_end = std::min(start + len + read_ahead_window
+			, files().total_size());
+		std::int64_t const from = std::max(
+			m_read_ahead_pos.load(std::memory_order_relaxed), start + len);
+		if (window_end <= from) return;
+		m_read_ahead_pos.store(window_end, std::memory_order_relaxed);
+
+		piece_index_t const p(int(from / files().piece_length()));
+		std::int64_t const p_offset = from % files().piece_length();
+		for (file_slice const& slice : files().map_block(p, p_offset
+			, int(window_end - from)))
+		{
+			if (files().pad_file_at(slice.file_index)) continue;
+			if (slice.file_index < m_file_priority.end_index()
+				&& m_file_priority[slice.file_index] == dont_download
+				&& use_partfile(slice.file_index))
+				continue;
+
+			storage_error ec;
+			auto handle = open_file(sett, slice.file_index, flags, ec);
+			if (ec) return;
+			handle->hint_read_ahead(slice.offset, slice.size);
+		}
+	}
+
+	void mmap_storage::prefetch(settings_interface const& sett
+		, piece_index_t const piece, int const offset, int const len
+		, aux::open_mode_t const flags)
+	{
+		for (file_slice const& slice : files().map_block(piece, offset, len))
+		{
+			if (files().pad_file_at(slice.file_index)) continue;
+			if (slice.file_index < m_file_priority.end_index()
+				&& m_file_priority[slice.file_index] == dont_download
+				&& use_partfile(slice.file_index))
+				continue;
+
+			storage_error ec;
+			auto handle = open_file(sett, slice.file_index, flags, ec);
+			if (ec) return;
+			handle->hint_read_ahead(slice.offset, slice.size);
+		}
+	}
+
+	bool mmap_storage::piece_has_data(settings_interface const& sett
+		, piece_index_t const piece, int const len, aux::open_mode_t const flags)
+	{
+		for (file_slice const& slice : files().map_block(piece, 0, len))
+		{
+			file_index_t const file_index = slice.file_index;
+			if (files().pad_file_at(file_index)) continue;
+			if (file_index < m_file_priority.end_index()
+				&& m_file_priority[file_index] == dont_download
+				&& use_partfile(file_index))
+			{
+				// this part of the piece may live in the part file, assume
+				// it's there
+				return true;
+			}
+
+			error_code err;
+			std::int64_t const size = m_stat_cache.get_filesize(file_index
+				, files(), m_save_path, err);
+			if (err == boost::system::errc::no_such_file_or_directory) continue;
+			// any other stat error will surface when the piece is hashed
+			if (err) return true;
+			// the range past the end of the file is all hole
+			if (size <= slice.offset) continue;
+
+			storage_error ec;
+			auto handle = open_file(sett, file_index, flags, ec);
+			if (ec) return true;
+			if (handle->has_data(slice.offset, slice.size)) return true;
+		}
+		return false;
+	}
+
+	char* mmap_storage::map_read(settings_interface const& sett
+		, piece_index_t const piece, int const offset, int const len
+		, aux::open_mode_t const flags, boost::optional<aux::file_view>& view)
+	{
+		auto const slices = files().map_block(piece, offset, len);
+		if (slices.size() != 1) return nullptr;
+		file_slice const& slice = slices.front();
+		file_index_t const file_index = slice.file_index;
+		if (files().pad_file_at(file_index)) return nullptr;
+		if (file_index < m_file_priority.end_index()
+			&& m_file_priority[file_index] == dont_download
+			&& use_partfile(file_index))
+			return nullptr;
+
+		storage_error ec;
+		auto handle = open_file(sett, file_index, flags, ec);
+		if (ec) return nullptr;
+
+		span<byte> const file_range = handle->range();
+		if (slice.offset + slice.size > file_range.size()) return nullptr;
+
+		char* const buf = file_range.data()
+			+ static_cast<std::ptrdiff_t>(slice.offset);
+		view = std::move(handle);
+		return buf;
+	}
+
+	char* mmap_storage::resident_read(piece_index_t const piece
+		, int const offset, int const len
+		, boost::optional<aux::file_view>& view)
+	{
+		auto const slices = files().map_block(piece, offset, len);
+		if (slices.size() != 1) return nullptr;
+		file_slice const& slice = slices.front();
+		file_index_t const file_index = slice.file_index;
+		if (files().pad_file_at(file_index)) return nullptr;
+		if (file_index < m_file_priority.end_index()
+			&& m_file_priority[file_index] == dont_download
+			&& use_partfile(file_index))
+			return nullptr;
+
+		// only serve the read if the file is already held open by the pool.
+		// opening (and mapping) a file can block on disk I/O, which defeats
+		// the purpose of this path
+		auto handle = m_pool.lookup(storage_index(), file_index);
+		if (!handle) return nullptr;
+
+		span<byte> const file_range = handle->range();
+		if (slice.offset + slice.size > file_range.size()) return nullptr;
+
+		if (!handle->is_resident(slice.offset, slice.size)) return nullptr;
+
+		char* const buf = file_range.data()
+			+ static_cast<std::ptrdiff_t>(slice.offset);
+		view = std::move(handle);
+		return buf;
+	}
+
 	int mmap_storage::readv(settings_interface const& sett
 		, span<iovec_t const> bufs
 		, piece_index_t const piece, int const offset
@@ -525,6 +697,8 @@ namespace libtorrent {
 #ifdef TORRENT_SIMULATE_SLOW_READ
 		std::this_thread::sleep_for(seconds(1));
 #endif
+		maybe_read_ahead(sett, piece, offset, int(bufs_size(bufs)), flags);
+
 		return readwritev(files(), bufs, piece, offset, error
 			, [this, flags, &sett](file_index_t const file_index
 				, std::int64_t const file_offset
@@ -667,10 +841,55 @@ namespace libtorrent {
 				return -1;
 			}
 
+			if (ret > 0 && sett.get_int(settings_pack::disk_write_back_rate) > 0)
+				record_dirty_extent(file_index, file_offset, ret);
+
 			return ret;
 		});
 	}
 
+	void mmap_storage::record_dirty_extent(file_index_t const file
+		, std::int64_t const offset, std::int64_t const len)
+	{
+		std::lock_guard<std::mutex> l(m_dirty_extents_mutex);
+		if (!m_dirty_extents.empty())
+		{
+			dirty_extent& last = m_dirty_extents.back();
+			if (last.file == file && last.offset + last.length == offset)
+			{
+				last.length += len;
+				return;
+			}
+		}
+		// if the governor can't keep up, drop the oldest extents. The kernel
+		// flushes those pages on its own schedule, like it did before
+		if (int(m_dirty_extents.size()) >= 512)
+			m_dirty_extents.pop_front();
+		m_dirty_extents.push_back({file, offset, len});
+	}
+
+	std::int64_t mmap_storage::write_back_dirty(settings_interface const& sett
+		, std::int64_t const budget)
+	{
+		std::int64_t flushed = 0;
+		while (flushed < budget)
+		{
+			dirty_extent e{file_index_t(0), 0, 0};
+			{
+				std::lock_guard<std::mutex> l(m_dirty_extents_mutex);
+				if (m_dirty_extents.empty()) break;
+				e = m_dirty_extents.front();
+				m_dirty_extents.pop_front();
+			}
+			storage_error ec;
+			auto handle = open_file(sett, e.file, aux::open_mode::write, ec);
+			if (ec) continue;
+			handle->flush_async(e.offset, e.length);
+			flushed += e.length;
+		}
+		return flushed;
+	}
+
 	int mmap_storage::hashv(settings_interface const& sett
 		, hasher& ph, std::ptrdiff_t const len
 		, piece_index_t const piece, int const offset
@@ -875,6 +1094,22 @@ namespace libtorrent {
 			mode |= aux::open_mode::no_cache;
 		}
 
+		{
+			std::int64_t const file_size = files().file_size(file);
+			int const hugepage_cutoff = sett.get_int(settings_pack::mmap_hugepage_cutoff);
+			if (hugepage_cutoff > 0
+				&& file_size >= std::int64_t(hugepage_cutoff) * 1024 * 1024)
+			{
+				mode |= aux::open_mode::hugepage;
+			}
+			int const populate_limit = sett.get_int(settings_pack::mmap_populate_limit);
+			if (populate_limit > 0
+				&& file_size <= std::int64_t(populate_limit) * 1024 * 1024)
+			{
+				mode |= aux::open_mode::populate;
+			}
+		}
+
 		try {
 			return m_pool.open_file(storage_index(), m_save_path, file
 				, files(), mode
@@ -41,6 +41,8 @@ namespace aux {
 	bool compare_less_wrap(std::uint32_t lhs, std::uint32_t rhs
 		, std::uint32_t mask);
 
+	constexpr std::uint32_t packet_buffer::default_capacity;
+
 #if TORRENT_USE_INVARIANT_CHECKS
 	void packet_buffer::check_invariant() const
 	{
@@ -106,7 +108,7 @@ namespace aux {
 			m_last = (idx + 1) & 0xffff;
 		}
 
-		if (m_capacity == 0) reserve(16);
+		if (m_capacity == 0) reserve(default_capacity);
 
 		packet_ptr old_value = std::move(m_storage[idx & (m_capacity - 1)]);
 		m_storage[idx & (m_capacity - 1)] = std::move(value);
@@ -137,15 +139,37 @@ namespace aux {
 	{
 		INVARIANT_CHECK;
 		TORRENT_ASSERT_VAL(size <= 0xffff, size);
-		std::uint32_t new_size = m_capacity == 0 ? 16 : m_capacity;
+		std::uint32_t new_size = m_capacity == 0 ? default_capacity : m_capacity;
 
 		while (new_size < size)
 			new_size <<= 1;
 
+		m_shrink_timer = 0;
+
+		aux::unique_ptr<packet_ptr[], index_type> new_storage(new packet_ptr[new_size]);
+
+		for (index_type i = m_first; i < (m_first + m_capacity); ++i)
+			new_storage[i & (new_size - 1)] = std::move(m_storage[i & (m_capacity - 1)]);
+
+		m_storage = std::move(new_storage);
+		m_capacity = new_size;
+	}
+
+	void packet_buffer::shrink()
+	{
+		TORRENT_ASSERT(m_capacity > default_capacity);
+		std::uint32_t const new_size = m_capacity / 2;
+		TORRENT_ASSERT(span() <= new_size);
+
 		aux::unique_ptr<packet_ptr[], index_type> new_storage(new packet_ptr[new_size]);
 
+		// with the smaller mask, two old slots map to each new slot, so only
+		// move the occupied ones. The whole window fits in the new capacity
 		for (index_type i = m_first; i < (m_first + m_capacity); ++i)
+		{
+			if (!m_storage[i & (m_capacity - 1)]) continue;
 			new_storage[i & (new_size - 1)] = std::move(m_storage[i & (m_capacity - 1)]);
+		}
 
 		m_storage = std::move(new_storage);
 		m_capacity = new_size;
@@ -188,6 +212,26 @@ namespace aux {
 			m_last &= 0xffff;
 		}
 
+		if (old_value && m_capacity > default_capacity)
+		{
+			// if the window keeps using no more than a quarter of the
+			// capacity for as many removals as there are slots, halve the
+			// allocation. A single deep-window burst shouldn't pin a large
+			// slot array for the remaining life of the socket
+			if (span() <= m_capacity / 4)
+			{
+				if (++m_shrink_timer >= m_capacity)
+				{
+					shrink();
+					m_shrink_timer = 0;
+				}
+			}
+			else
+			{
+				m_shrink_timer = 0;
+			}
+		}
+
 		TORRENT_ASSERT_VAL(m_first <= 0xffff, m_first);
 		return old_value;
 	}
@@ -71,6 +71,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/aux_/path.hpp"
 #include "libtorrent/aux_/storage_utils.hpp" // for iovec_t
 
+#include <algorithm> // for sort and unique
 #include <functional> // for std::function
 #include <cstdint>
 
@@ -101,7 +102,7 @@ namespace libtorrent {
 		// parse header
 		std::vector<char> header(static_cast<std::size_t>(m_header_size));
 		iovec_t b = header;
-		int const n = int(f.readv(0, b, ec));
+		int const n = int(f->readv(0, b, ec));
 		if (ec) return;
 
 		// we don't have a full header. consider the file empty
@@ -143,6 +144,10 @@ namespace libtorrent {
 		{
 			if (free_slots[i]) m_free_slots.push_back(i);
 		}
+
+		// the file holds a complete, valid header. Metadata flushes can
+		// patch individual slot entries from here on
+		m_header_written = true;
 	}
 
 	part_file::~part_file()
@@ -170,6 +175,7 @@ namespace libtorrent {
 
 		m_piece_map[piece] = slot;
 		m_dirty_metadata = true;
+		m_dirty_slots.push_back(piece);
 		return slot;
 	}
 
@@ -189,7 +195,7 @@ namespace libtorrent {
 
 		l.unlock();
 
-		return int(f.writev(slot_offset(slot) + offset, bufs, ec));
+		return int(f->writev(slot_offset(slot) + offset, bufs, ec));
 	}
 
 	int part_file::readv(span<iovec_t const> bufs
@@ -208,12 +214,13 @@ namespace libtorrent {
 		}
 
 		slot_index_t const slot = i->second;
-		l.unlock();
 
 		auto f = open_file(aux::open_mode::read_only | aux::open_mode::hidden, ec);
 		if (ec) return -1;
 
-		return int(f.readv(slot_offset(slot) + offset, bufs, ec));
+		l.unlock();
+
+		return int(f->readv(slot_offset(slot) + offset, bufs, ec));
 	}
 
 	int part_file::hashv(hasher& ph
@@ -260,13 +267,21 @@ namespace libtorrent {
 		std::vector<char> buffer(static_cast<std::size_t>(len));
 		iovec_t v = buffer;
 		std::int64_t const slot_offset = std::int64_t(m_header_size) + std::int64_t(static_cast<int>(slot)) * m_piece_size;
-		int const ret = int(f.readv(slot_offset + offset, v, ec));
+		int const ret = int(f->readv(slot_offset + offset, v, ec));
 		ph.update(buffer);
 		return ret;
 	}
 
-	file part_file::open_file(aux::open_mode_t const mode, error_code& ec)
+	// the mutex is assumed to be held here. The returned handle stays valid
+	// after the mutex is released; I/O through it is positional
+	std::shared_ptr<file> part_file::open_file(aux::open_mode_t const mode, error_code& ec)
 	{
+		// the cached handle can be used as long as we don't need write
+		// access to a file opened read-only
+		if (m_file && (!(mode & aux::open_mode::write)
+			|| (m_file_mode & aux::open_mode::write)))
+			return m_file;
+
 		std::string const fn = combine_path(m_path, m_name);
 		file f(fn, mode, ec);
 		if ((mode & aux::open_mode::write)
@@ -281,7 +296,12 @@ namespace libtorrent {
 			f = file(fn, mode, ec);
 		}
 		if (ec) return {};
-		return f;
+
+		// a previous (read-only) handle, if any, is kept alive by any
+		// thread still performing I/O on it
+		m_file = std::make_shared<file>(std::move(f));
+		m_file_mode = mode;
+		return m_file;
 	}
 
 	void part_file::free_piece(piece_index_t const piece)
@@ -299,6 +319,7 @@ namespace libtorrent {
 		m_free_slots.push_back(i->second);
 		m_piece_map.erase(i);
 		m_dirty_metadata = true;
+		m_dirty_slots.push_back(piece);
 	}
 
 	void part_file::move_partfile(std::string const& path, error_code& ec)
@@ -308,6 +329,11 @@ namespace libtorrent {
 		flush_metadata_impl(ec);
 		if (ec) return;
 
+		// moving the storage is a fenced operation, no other threads are
+		// doing I/O on this part file right now. Close the handle so the
+		// file can be renamed on all platforms
+		m_file.reset();
+
 		if (!m_piece_map.empty())
 		{
 			std::string old_path = combine_path(m_path, m_name);
@@ -360,7 +386,7 @@ namespace libtorrent {
 				l.unlock();
 
 				iovec_t v = {buf.get(), block_to_copy};
-				auto bytes_read = file.readv(slot_offset(slot) + piece_offset, v, ec);
+				auto bytes_read = file->readv(slot_offset(slot) + piece_offset, v, ec);
 				v = v.first(static_cast<std::ptrdiff_t>(bytes_read));
 				TORRENT_ASSERT(!ec);
 				if (ec || v.empty()) return;
@@ -385,6 +411,7 @@ namespace libtorrent {
 						m_free_slots.push_back(j->second);
 						m_piece_map.erase(j);
 						m_dirty_metadata = true;
+						m_dirty_slots.push_back(piece);
 					}
 				}
 			}
@@ -401,8 +428,6 @@ namespace libtorrent {
 		flush_metadata_impl(ec);
 	}
 
-	// TODO: instead of rebuilding the whole file header
-	// and flushing it, update the slot entries as we go
 	void part_file::flush_metadata_impl(error_code& ec)
 	{
 		// do we need to flush the metadata?
@@ -412,6 +437,10 @@ namespace libtorrent {
 		{
 			// if we don't have any pieces left in the
 			// part file, remove it
+			m_file.reset();
+			m_header_written = false;
+			m_dirty_slots.clear();
+
 			std::string const p = combine_path(m_path, m_name);
 			remove(p, ec);
 
@@ -423,25 +452,63 @@ namespace libtorrent {
 		auto f = open_file(aux::open_mode::write | aux::open_mode::hidden, ec);
 		if (ec) return;
 
-		std::vector<char> header(static_cast<std::size_t>(m_header_size));
-
 		using namespace libtorrent::aux;
 
-		char* ptr = header.data();
-		write_uint32(m_max_pieces, ptr);
-		write_uint32(m_piece_size, ptr);
+		if (!m_header_written)
+		{
+			// no full header on disk yet, write the whole thing
+			std::vector<char> header(static_cast<std::size_t>(m_header_size));
+
+			char* ptr = header.data();
+			write_uint32(m_max_pieces, ptr);
+			write_uint32(m_piece_size, ptr);
 
-		for (piece_index_t piece(0); piece < piece_index_t(m_max_pieces); ++piece)
+			for (piece_index_t piece(0); piece < piece_index_t(m_max_pieces); ++piece)
+			{
+				auto const i = m_piece_map.find(piece);
+				slot_index_t const slot(i == m_piece_map.end()
+					? slot_index_t(-1) : i->second);
+				write_int32(static_cast<int>(slot), ptr);
+			}
+			std::memset(ptr, 0, std::size_t(m_header_size - (ptr - header.data())));
+			iovec_t b = header;
+			f->writev(0, b, ec);
+			if (ec) return;
+			m_header_written = true;
+		}
+		else
 		{
-			auto const i = m_piece_map.find(piece);
-			slot_index_t const slot(i == m_piece_map.end()
-				? slot_index_t(-1) : i->second);
-			write_int32(static_cast<int>(slot), ptr);
+			// the header on disk is complete, just patch the slot entries
+			// that changed since the last flush. Contiguous entries are
+			// written in a single operation
+			std::sort(m_dirty_slots.begin(), m_dirty_slots.end());
+			m_dirty_slots.erase(std::unique(m_dirty_slots.begin()
+				, m_dirty_slots.end()), m_dirty_slots.end());
+
+			auto it = m_dirty_slots.begin();
+			while (it != m_dirty_slots.end())
+			{
+				auto run_end = it + 1;
+				while (run_end != m_dirty_slots.end()
+					&& *run_end == next(*(run_end - 1)))
+					++run_end;
+
+				std::vector<char> entries(std::size_t(run_end - it) * 4);
+				char* ptr = entries.data();
+				for (auto p = it; p != run_end; ++p)
+				{
+					auto const i = m_piece_map.find(*p);
+					slot_index_t const slot(i == m_piece_map.end()
+						? slot_index_t(-1) : i->second);
+					write_int32(static_cast<int>(slot), ptr);
+				}
+				iovec_t b = entries;
+				f->writev(8 + std::int64_t(static_cast<int>(*it)) * 4, b, ec);
+				if (ec) return;
+				it = run_end;
+			}
 		}
-		std::memset(ptr, 0, std::size_t(m_header_size - (ptr - header.data())));
-		iovec_t b = header;
-		f.writev(0, b, ec);
-		if (ec) return;
+		m_dirty_slots.clear();
 		m_dirty_metadata = false;
 	}
 }
@@ -52,6 +52,12 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/pe_crypto.hpp"
 #include "libtorrent/hasher.hpp"
 
+#ifdef TORRENT_USE_LIBCRYPTO
+#include "libtorrent/aux_/disable_warnings_push.hpp"
+#include <openssl/evp.h>
+#include "libtorrent/aux_/disable_warnings_pop.hpp"
+#endif
+
 namespace libtorrent {
 
 	namespace mp = boost::multiprecision;
@@ -343,6 +349,95 @@ namespace libtorrent {
 		return std::make_tuple(0, bytes_processed, 0);
 	}
 
+#ifdef TORRENT_USE_LIBCRYPTO
+
+	namespace {
+
+	// initialize an AES-128-CTR stream from a 20 byte session key. The
+	// first 16 bytes are the AES key and the initial counter block is
+	// derived by hashing the full key, so both ends of the connection
+	// compute the same stream
+	EVP_CIPHER_CTX* aes_ctr_init(span<char const> key)
+	{
+		TORRENT_ASSERT(key.size() >= 20);
+		sha1_hash const iv = hasher(key).final();
+		EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+		if (ctx == nullptr) return nullptr;
+		if (EVP_EncryptInit_ex(ctx, EVP_aes_128_ctr(), nullptr
+			, reinterpret_cast<unsigned char const*>(key.data())
+			, reinterpret_cast<unsigned char const*>(iv.data())) != 1)
+		{
+			EVP_CIPHER_CTX_free(ctx);
+			return nullptr;
+		}
+		return ctx;
+	}
+
+	// advance the key stream over the buffer, in-place. CTR mode uses the
+	// same operation for encryption and decryption
+	int aes_ctr_process(EVP_CIPHER_CTX* ctx, span<span<char>> bufs)
+	{
+		int bytes_processed = 0;
+		for (auto& buf : bufs)
+		{
+			auto* const pos = reinterpret_cast<unsigned char*>(buf.data());
+			int const len = int(buf.size());
+
+			TORRENT_ASSERT(len >= 0);
+			TORRENT_ASSERT(pos);
+
+			int out_len = 0;
+			EVP_EncryptUpdate(ctx, pos, &out_len, pos, len);
+			TORRENT_ASSERT(out_len == len);
+			bytes_processed += len;
+		}
+		return bytes_processed;
+	}
+
+	} // anonymous namespace
+
+	aes_ctr_handler::aes_ctr_handler()
+		: m_enc_ctx(nullptr)
+		, m_dec_ctx(nullptr)
+	{}
+
+	aes_ctr_handler::~aes_ctr_handler()
+	{
+		if (m_enc_ctx) EVP_CIPHER_CTX_free(m_enc_ctx);
+		if (m_dec_ctx) EVP_CIPHER_CTX_free(m_dec_ctx);
+	}
+
+	void aes_ctr_handler::set_incoming_key(span<char const> key)
+	{
+		if (m_dec_ctx) EVP_CIPHER_CTX_free(m_dec_ctx);
+		m_dec_ctx = aes_ctr_init(key);
+	}
+
+	void aes_ctr_handler::set_outgoing_key(span<char const> key)
+	{
+		if (m_enc_ctx) EVP_CIPHER_CTX_free(m_enc_ctx);
+		m_enc_ctx = aes_ctr_init(key);
+	}
+
+	std::tuple<int, span<span<char const>>>
+	aes_ctr_handler::encrypt(span<span<char>> bufs)
+	{
+		span<span<char const>> empty;
+		if (!m_enc_ctx) return std::make_tuple(0, empty);
+		if (bufs.empty()) return std::make_tuple(0, empty);
+
+		return std::make_tuple(aes_ctr_process(m_enc_ctx, bufs), empty);
+	}
+
+	std::tuple<int, int, int> aes_ctr_handler::decrypt(span<span<char>> bufs)
+	{
+		if (!m_dec_ctx) return std::make_tuple(0, 0, 0);
+
+		return std::make_tuple(0, aes_ctr_process(m_dec_ctx, bufs), 0);
+	}
+
+#endif // TORRENT_USE_LIBCRYPTO
+
 // All this code is based on libTomCrypt (http://www.libtomcrypt.com/)
 // this library is public domain and has been specially
 // tailored for libtorrent by Arvid Norberg
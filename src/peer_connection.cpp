@@ -77,6 +77,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/aux_/buffer.hpp"
 #include "libtorrent/aux_/array.hpp"
 #include "libtorrent/aux_/set_socket_buffer.hpp"
+#include "libtorrent/aux_/tracepoint.hpp"
+#include "libtorrent/aux_/event_trace.hpp"
 
 #if TORRENT_USE_ASSERTS
 #include <set>
@@ -455,6 +457,17 @@ namespace libtorrent {
 				, print_endpoint(m_remote).c_str());
 		}
 #endif
+#ifdef TCP_FASTOPEN_CONNECT
+		{
+			// if the kernel has a fast open cookie cached for this peer
+			// from an earlier connection, this lets the handshake ride in
+			// the SYN. for other socket types (uTP, proxies) the option
+			// just fails. this is best-effort. ignore errors
+			error_code err;
+			m_socket.set_option(tcp_fastopen_connect(true), err);
+		}
+#endif
+
 		ADD_OUTSTANDING_ASYNC("peer_connection::on_connection_complete");
 
 		auto conn = self();
@@ -527,19 +540,40 @@ namespace libtorrent {
 		{
 			t->need_picker();
 			piece_picker const& p = t->picker();
-			piece_index_t const end_piece(p.num_pieces());
-			for (piece_index_t j(0); j != end_piece; ++j)
+			// the two common cases can be answered with word-wise scans of
+			// the peer's bitfield alone, without consulting the picker for
+			// every piece. A peer with no pieces is never interesting, and a
+			// seed is interesting exactly when we still want a piece we
+			// haven't passed the hash check for, which is what is_finished()
+			// computes from the picker's counters. The general case still
+			// needs the per-piece loop, since priorities and passed-state
+			// live in the picker's piece map, not in a bitfield we could
+			// AND against
+			if (m_have_piece.none_set())
+			{
+				interested = false;
+			}
+			else if (m_have_piece.all_set()
+				&& m_have_piece.size() == p.num_pieces())
+			{
+				interested = !p.is_finished();
+			}
+			else
 			{
-				if (m_have_piece[j]
-					&& t->piece_priority(j) > dont_download
-					&& !p.has_piece_passed(j))
+				piece_index_t const end_piece(p.num_pieces());
+				for (piece_index_t j(0); j != end_piece; ++j)
 				{
-					interested = true;
+					if (m_have_piece[j]
+						&& t->piece_priority(j) > dont_download
+						&& !p.has_piece_passed(j))
+					{
+						interested = true;
 #ifndef TORRENT_DISABLE_LOGGING
-					peer_log(peer_log_alert::info, "UPDATE_INTEREST", "interesting, piece: %d"
-						, static_cast<int>(j));
+						peer_log(peer_log_alert::info, "UPDATE_INTEREST", "interesting, piece: %d"
+							, static_cast<int>(j));
 #endif
-					break;
+						break;
+					}
 				}
 			}
 		}
@@ -597,6 +631,7 @@ namespace libtorrent {
 	void peer_connection::add_extension(std::shared_ptr<peer_plugin> ext)
 	{
 		TORRENT_ASSERT(is_single_thread());
+		m_extension_features |= ext->implemented_features();
 		m_extensions.push_back(ext);
 	}
 
@@ -676,6 +711,12 @@ namespace libtorrent {
 			return;
 		}
 
+		// the BEP 6 generation below typically costs one or two SHA-1
+		// rounds over 24-36 bytes per connection. Caching generated sets
+		// per (info-hash, address) across reconnects was considered and
+		// rejected: the hashing is cheaper than the lookup would be, and
+		// the resulting sets are at most allowed_fast_set_size entries, so
+		// the linear membership scans on them beat any indexed structure
 		std::string x;
 		address const& addr = m_remote.address();
 		if (addr.is_v4())
@@ -867,6 +908,14 @@ namespace libtorrent {
 		if (!m_download_queue.empty())
 			m_counters.inc_stats_counter(counters::num_peers_down_requests, -1);
 
+		// return this connection's share of the socket buffer budget
+		if (m_socket_send_buf > 0)
+			m_counters.inc_stats_counter(counters::socket_send_buffer_bytes
+				, -m_socket_send_buf);
+		if (m_socket_recv_buf > 0)
+			m_counters.inc_stats_counter(counters::socket_recv_buffer_bytes
+				, -m_socket_recv_buf);
+
 		// defensive
 		std::shared_ptr<torrent> t = m_torrent.lock();
 		// if t is nullptr, we better not be connecting, since
@@ -1060,7 +1109,7 @@ namespace libtorrent {
 		return m_download_queue;
 	}
 
-	std::vector<peer_request> const& peer_connection::upload_queue() const
+	aux::small_vector<peer_request, 4> const& peer_connection::upload_queue() const
 	{
 		TORRENT_ASSERT(is_single_thread());
 		return m_requests;
@@ -1143,7 +1192,7 @@ namespace libtorrent {
 		TORRENT_ASSERT(is_single_thread());
 		m_statistics.sent_bytes(bytes_payload, bytes_protocol);
 #ifndef TORRENT_DISABLE_EXTENSIONS
-		if (bytes_payload)
+		if (bytes_payload && (m_extension_features & peer_plugin::sent_payload_feature))
 		{
 			for (auto const& e : m_extensions)
 			{
@@ -1913,9 +1962,12 @@ namespace libtorrent {
 		TORRENT_ASSERT(t);
 
 #ifndef TORRENT_DISABLE_EXTENSIONS
-		for (auto const& e : m_extensions)
+		if (m_extension_features & peer_plugin::on_have_feature)
 		{
-			if (e->on_have(index)) return;
+			for (auto const& e : m_extensions)
+			{
+				if (e->on_have(index)) return;
+			}
 		}
 #endif
 
@@ -2014,13 +2066,22 @@ namespace libtorrent {
 		// we won't have a piece picker)
 		if (!t->valid_metadata()) return;
 
-		t->peer_has(index, this);
+		// defer the piece picker update. A burst of consecutive HAVE
+		// messages is applied as one bulk refcount update and a single
+		// interest check in flush_haves(), once a different message arrives
+		// or the receive quantum ends
+		m_pending_haves.push_back(index);
 
 		// it's important to not disconnect before we have
 		// updated the piece picker, otherwise we will incorrectly
 		// decrement the piece count without first incrementing it
 		if (is_seed())
 		{
+			// this HAVE message completed the peer's piece set. Apply the
+			// deferred updates now, the seed transition below relies on the
+			// picker being in sync with m_have_piece
+			flush_haves();
+			if (is_disconnecting()) return;
 #ifndef TORRENT_DISABLE_LOGGING
 			peer_log(peer_log_alert::info, "SEED", "this is a seed. p: %p"
 				, static_cast<void*>(m_peer_info));
@@ -2041,16 +2102,6 @@ namespace libtorrent {
 			if (disconnect_if_redundant()) return;
 		}
 
-		// it's important to update whether we're interested in this peer before
-		// calling disconnect_if_redundant, otherwise we may disconnect even if
-		// we are interested
-		if (!t->has_piece_passed(index)
-			&& !t->is_upload_only()
-			&& !is_interesting()
-			&& (!t->has_picker() || t->picker().piece_priority(index) != dont_download))
-			t->peer_is_interesting(*this);
-
-		disconnect_if_redundant();
 		if (is_disconnecting()) return;
 
 #ifndef TORRENT_DISABLE_SUPERSEEDING
@@ -2073,6 +2124,52 @@ namespace libtorrent {
 #endif // TORRENT_DISABLE_SUPERSEEDING
 	}
 
+	void peer_connection::flush_haves()
+	{
+		TORRENT_ASSERT(is_single_thread());
+		if (m_pending_haves.empty()) return;
+
+		std::shared_ptr<torrent> t = m_torrent.lock();
+		TORRENT_ASSERT(t);
+		TORRENT_ASSERT(t->valid_metadata());
+
+		// move the list out of the member, so that a disconnect triggered
+		// below cannot make us apply these pieces twice
+		std::vector<piece_index_t> const pending = std::move(m_pending_haves);
+		m_pending_haves.clear();
+
+		if (pending.size() == 1)
+		{
+			t->peer_has(pending[0], this);
+		}
+		else
+		{
+			typed_bitfield<piece_index_t> bits;
+			bits.resize(m_have_piece.size(), false);
+			for (piece_index_t const p : pending) bits.set_bit(p);
+			t->peer_has(bits, this);
+		}
+
+		if (is_disconnecting()) return;
+
+		// it's important to update whether we're interested in this peer before
+		// calling disconnect_if_redundant, otherwise we may disconnect even if
+		// we are interested
+		if (!t->is_upload_only() && !is_interesting())
+		{
+			for (piece_index_t const p : pending)
+			{
+				if (t->has_piece_passed(p)) continue;
+				if (t->has_picker() && t->picker().piece_priority(p) == dont_download)
+					continue;
+				t->peer_is_interesting(*this);
+				break;
+			}
+		}
+
+		disconnect_if_redundant();
+	}
+
 	// -----------------------------
 	// -------- DONT HAVE ----------
 	// -----------------------------
@@ -2147,7 +2244,7 @@ namespace libtorrent {
 	// --------- BITFIELD ----------
 	// -----------------------------
 
-	void peer_connection::incoming_bitfield(typed_bitfield<piece_index_t> const& bits)
+	void peer_connection::incoming_bitfield(typed_bitfield<piece_index_t> bits)
 	{
 		TORRENT_ASSERT(is_single_thread());
 		INVARIANT_CHECK;
@@ -2214,9 +2311,10 @@ namespace libtorrent {
 				peer_log(peer_log_alert::info, "SEED", "this is a seed. p: %p"
 					, static_cast<void*>(m_peer_info));
 #endif
-			m_have_piece = bits;
-			m_num_pieces = bits.count();
-			t->set_seed(m_peer_info, m_num_pieces == bits.size());
+			int const size = bits.size();
+			m_have_piece = std::move(bits);
+			m_num_pieces = m_have_piece.count();
+			t->set_seed(m_peer_info, m_num_pieces == size);
 
 #if TORRENT_USE_INVARIANT_CHECKS
 			if (t && t->has_picker())
@@ -2264,7 +2362,7 @@ namespace libtorrent {
 		// don't keep track of piece availability
 		t->peer_has(bits, this);
 
-		m_have_piece = bits;
+		m_have_piece = std::move(bits);
 		m_num_pieces = num_pieces;
 
 		update_interest();
@@ -2401,11 +2499,14 @@ namespace libtorrent {
 		if (is_disconnecting()) return;
 
 #ifndef TORRENT_DISABLE_EXTENSIONS
-		for (auto const& e : m_extensions)
+		if (m_extension_features & peer_plugin::on_request_feature)
 		{
-			if (e->on_request(r)) return;
+			for (auto const& e : m_extensions)
+			{
+				if (e->on_request(r)) return;
+			}
+			if (is_disconnecting()) return;
 		}
-		if (is_disconnecting()) return;
 #endif
 
 		if (!t->valid_metadata())
@@ -2605,10 +2706,14 @@ namespace libtorrent {
 	void peer_connection::reject_piece(piece_index_t const index)
 	{
 		TORRENT_ASSERT(is_single_thread());
-		for (auto i = m_requests.begin(), end(m_requests.end()); i != end; ++i)
+		for (auto i = m_requests.begin(); i != m_requests.end();)
 		{
 			peer_request const& r = *i;
-			if (r.piece != index) continue;
+			if (r.piece != index)
+			{
+				++i;
+				continue;
+			}
 			write_reject_request(r);
 			i = m_requests.erase(i);
 
@@ -2758,6 +2863,8 @@ namespace libtorrent {
 		// we're not receiving any block right now
 		m_receiving_block = piece_block::invalid;
 
+		TORRENT_TRACE_INSTANT("block_received", static_cast<int>(p.piece));
+
 #ifdef TORRENT_CORRUPT_DATA
 		// corrupt all pieces from certain peers
 		if (aux::is_v4(m_remote)
@@ -2779,15 +2886,18 @@ namespace libtorrent {
 		update_desired_queue_size();
 
 #ifndef TORRENT_DISABLE_EXTENSIONS
-		for (auto const& e : m_extensions)
+		if (m_extension_features & peer_plugin::on_piece_feature)
 		{
-			if (e->on_piece(p, {data, p.length}))
+			for (auto const& e : m_extensions)
 			{
+				if (e->on_piece(p, {data, p.length}))
+				{
 #if TORRENT_USE_ASSERTS
-				TORRENT_ASSERT(m_received_in_piece == p.length);
-				m_received_in_piece = 0;
+					TORRENT_ASSERT(m_received_in_piece == p.length);
+					m_received_in_piece = 0;
 #endif
-				return;
+					return;
+				}
 			}
 		}
 #endif
@@ -2901,7 +3011,10 @@ namespace libtorrent {
 
 			if (m_disconnecting) return;
 
-			m_request_time.add_sample(int(total_milliseconds(now - m_requested.get(m_connect))));
+			int const request_time = int(total_milliseconds(now - m_requested.get(m_connect)));
+			m_request_time.add_sample(request_time);
+			if (m_request_time_min == 0 || request_time < m_request_time_min)
+				m_request_time_min = request_time;
 #ifndef TORRENT_DISABLE_LOGGING
 			if (should_log(peer_log_alert::info))
 			{
@@ -2980,7 +3093,10 @@ namespace libtorrent {
 				, performance_alert::too_high_disk_queue_limit);
 		}
 
-		m_request_time.add_sample(int(total_milliseconds(now - m_requested.get(m_connect))));
+		int const request_time = int(total_milliseconds(now - m_requested.get(m_connect)));
+		m_request_time.add_sample(request_time);
+		if (m_request_time_min == 0 || request_time < m_request_time_min)
+			m_request_time_min = request_time;
 #ifndef TORRENT_DISABLE_LOGGING
 		if (should_log(peer_log_alert::info))
 		{
@@ -3254,6 +3370,12 @@ namespace libtorrent {
 			, "piece: %d s: %x l: %x", static_cast<int>(r.piece), r.start, r.length);
 #endif
 
+		// the linear scan is fine here. m_requests is bounded by
+		// max_allowed_in_request_queue and holds small flat entries, so
+		// even a full scan is a few cache lines per kilobyte of queue. A
+		// per-piece bitmap for O(1) membership would have to be kept
+		// consistent with every insert, erase, reject and choke path for a
+		// structure this small
 		auto const i = std::find(m_requests.begin(), m_requests.end(), r);
 
 		if (i != m_requests.end())
@@ -3793,6 +3915,11 @@ namespace libtorrent {
 		m_suggest_pieces.clear();
 		m_suggest_pieces.shrink_to_fit();
 
+		// the choke message and the reject messages for the queued requests
+		// below should go out in the same send operation. The choker calls
+		// this outside of any receive handler, where nothing else corks us
+		cork _c(*this);
+
 #ifndef TORRENT_DISABLE_LOGGING
 		peer_log(peer_log_alert::outgoing_message, "CHOKE");
 #endif
@@ -3999,6 +4126,12 @@ namespace libtorrent {
 
 		bool const empty_download_queue = m_download_queue.empty();
 
+		// batch all request messages generated by the loop below into a
+		// single send operation, instead of flushing each 17 byte message
+		// on its own. When called from the receive path we're already
+		// corked, in which case this is a no-op
+		cork _c(*this);
+
 		while (!m_request_queue.empty()
 			&& (int(m_download_queue.size()) < m_desired_queue_size
 				|| m_queued_time_critical > 0))
@@ -4105,6 +4238,7 @@ namespace libtorrent {
 			{
 				write_request(r);
 				m_last_request.set(m_connect, aux::time_now());
+				TORRENT_TRACE_INSTANT("block_request", static_cast<int>(r.piece));
 			}
 
 #ifndef TORRENT_DISABLE_LOGGING
@@ -4410,6 +4544,10 @@ namespace libtorrent {
 
 		m_disconnecting = true;
 
+		// apply buffered HAVE messages to the picker before remove_peer()
+		// reconciles the refcounts against our bitfield
+		flush_haves();
+
 		if (t)
 		{
 			if (ec)
@@ -4761,7 +4899,21 @@ namespace libtorrent {
 
 			TORRENT_ASSERT(bs > 0);
 
-			m_desired_queue_size = std::uint16_t(queue_time * download_rate / bs);
+			// the queue only needs to cover the bandwidth-delay product of
+			// the link, plus some headroom. queue_time (in seconds) is the
+			// upper bound on that window. If we have measured the
+			// round-trip delay to this peer, use three times that instead,
+			// so that fast low-latency peers aren't asked to queue several
+			// seconds worth of blocks
+			int queue_time_ms = queue_time * 1000;
+			if (m_request_time_min > 0)
+				queue_time_ms = std::min(queue_time_ms
+					, std::max(m_request_time_min * 3, 1000));
+
+			std::int64_t const desired = std::int64_t(queue_time_ms)
+				* download_rate / 1000 / bs;
+			m_desired_queue_size = std::uint16_t(std::min(desired
+				, std::int64_t(m_max_out_request_queue)));
 		}
 
 		if (m_desired_queue_size > m_max_out_request_queue)
@@ -4780,6 +4932,74 @@ namespace libtorrent {
 #endif
 	}
 
+	void peer_connection::tune_socket_buffers()
+	{
+		// explicitly configured buffer sizes take precedence. Autotuning
+		// only kicks in for settings left at 0 (OS default)
+		bool const tune_snd = m_settings.get_int(settings_pack::send_socket_buffer_size) == 0;
+		bool const tune_rcv = m_settings.get_int(settings_pack::recv_socket_buffer_size) == 0;
+		if (!tune_snd && !tune_rcv) return;
+
+		// the best estimate of the round-trip delay to this peer is the
+		// fastest request-to-piece time we've observed. Without one we
+		// don't know the bandwidth-delay product, and leave the buffers
+		// alone
+		if (m_request_time_min <= 0) return;
+
+		// one size can't fit every connection: a buffer sized for a 300 ms
+		// satellite link wastes memory across thousands of LAN peers, and a
+		// LAN-sized buffer caps throughput on the long link. Size each
+		// socket to twice its measured bandwidth-delay product, leaving
+		// room for the rate to keep growing, and only ever grow. The OS
+		// default is a fine floor, and shrinking a buffer with data in
+		// flight tends to stall the connection. The total memory handed out
+		// this way is bounded by a budget proportional to the connection
+		// limit
+		std::int64_t const budget = std::int64_t(
+			m_settings.get_int(settings_pack::connections_limit)) * 128 * 1024;
+		int const max_buf = 2 * 1024 * 1024;
+
+		if (tune_snd)
+		{
+			std::int64_t target = std::int64_t(m_statistics.upload_rate())
+				* m_request_time_min / 1000 * 2;
+			if (target > max_buf) target = max_buf;
+			if (target > m_socket_send_buf
+				&& m_counters[counters::socket_send_buffer_bytes]
+					+ target - m_socket_send_buf <= budget)
+			{
+				error_code ec;
+				m_socket.set_option(aux::socket_type::send_buffer_size(int(target)), ec);
+				if (!ec)
+				{
+					m_counters.inc_stats_counter(counters::socket_send_buffer_bytes
+						, target - m_socket_send_buf);
+					m_socket_send_buf = int(target);
+				}
+			}
+		}
+
+		if (tune_rcv)
+		{
+			std::int64_t target = std::int64_t(m_statistics.download_rate())
+				* m_request_time_min / 1000 * 2;
+			if (target > max_buf) target = max_buf;
+			if (target > m_socket_recv_buf
+				&& m_counters[counters::socket_recv_buffer_bytes]
+					+ target - m_socket_recv_buf <= budget)
+			{
+				error_code ec;
+				m_socket.set_option(aux::socket_type::receive_buffer_size(int(target)), ec);
+				if (!ec)
+				{
+					m_counters.inc_stats_counter(counters::socket_recv_buffer_bytes
+						, target - m_socket_recv_buf);
+					m_socket_recv_buf = int(target);
+				}
+			}
+		}
+	}
+
 	void peer_connection::second_tick(int const tick_interval_ms)
 	{
 		TORRENT_ASSERT(is_single_thread());
@@ -5033,6 +5253,8 @@ namespace libtorrent {
 
 		m_statistics.second_tick(tick_interval_ms);
 
+		tune_socket_buffers();
+
 		if (m_statistics.upload_payload_rate() > m_upload_rate_peak)
 		{
 			m_upload_rate_peak = m_statistics.upload_payload_rate();
@@ -5045,36 +5267,47 @@ namespace libtorrent {
 
 		if (!t->ready_for_connections()) return;
 
-		update_desired_queue_size();
-
-		if (m_desired_queue_size == m_max_out_request_queue
-			&& t->alerts().should_post<performance_alert>())
+		// when the torrent is upload-only we never issue any requests, so
+		// the download-side bookkeeping (request queue sizing and piece
+		// timeouts) is dead weight, and seeding sessions run a lot of
+		// connections. Note that a separate, slimmed-down connection type
+		// for seeds wouldn't buy much beyond this: the idle download state
+		// is a few empty vectors, and a torrent can leave upload-only mode
+		// at any time (file priorities, force-recheck), which would mean
+		// migrating live connections between types
+		if (!t->is_upload_only())
 		{
-			t->alerts().emplace_alert<performance_alert>(t->get_handle()
-				, performance_alert::outstanding_request_limit_reached);
-		}
-
-		int const piece_timeout = m_settings.get_int(settings_pack::piece_timeout);
+			update_desired_queue_size();
 
-		if (!m_download_queue.empty()
-			&& m_quota[download_channel] > 0
-			&& now - m_last_piece.get(m_connect) > seconds(piece_timeout))
-		{
-			// this peer isn't sending the pieces we've
-			// requested (this has been observed by BitComet)
-			// in this case we'll clear our download queue and
-			// re-request the blocks.
-#ifndef TORRENT_DISABLE_LOGGING
-			if (should_log(peer_log_alert::info))
+			if (m_desired_queue_size == m_max_out_request_queue
+				&& t->alerts().should_post<performance_alert>())
 			{
-				peer_log(peer_log_alert::info, "PIECE_REQUEST_TIMED_OUT"
-					, "%d time: %d to: %d"
-					, int(m_download_queue.size()), int(total_seconds(now - m_last_piece.get(m_connect)))
-					, piece_timeout);
+				t->alerts().emplace_alert<performance_alert>(t->get_handle()
+					, performance_alert::outstanding_request_limit_reached);
 			}
+
+			int const piece_timeout = m_settings.get_int(settings_pack::piece_timeout);
+
+			if (!m_download_queue.empty()
+				&& m_quota[download_channel] > 0
+				&& now - m_last_piece.get(m_connect) > seconds(piece_timeout))
+			{
+				// this peer isn't sending the pieces we've
+				// requested (this has been observed by BitComet)
+				// in this case we'll clear our download queue and
+				// re-request the blocks.
+#ifndef TORRENT_DISABLE_LOGGING
+				if (should_log(peer_log_alert::info))
+				{
+					peer_log(peer_log_alert::info, "PIECE_REQUEST_TIMED_OUT"
+						, "%d time: %d to: %d"
+						, int(m_download_queue.size()), int(total_seconds(now - m_last_piece.get(m_connect)))
+						, piece_timeout);
+				}
 #endif
 
-			snub_peer();
+				snub_peer();
+			}
 		}
 
 		fill_send_buffer();
@@ -5317,7 +5550,9 @@ namespace libtorrent {
 
 				m_disk_thread.async_read(t->storage(), r
 					, [conn = self(), r](disk_buffer_holder buf, storage_error const& ec)
-					{ conn->wrap(&peer_connection::on_disk_read_complete, std::move(buf), ec, r, clock_type::now()); });
+					{ conn->wrap(&peer_connection::on_disk_read_complete, std::move(buf), ec, r, clock_type::now()); }
+					, is_send_plaintext()
+						? disk_interface::zero_copy : disk_job_flags_t{});
 			}
 			m_last_sent_payload.set(m_connect, clock_type::now());
 			m_requests.erase(m_requests.begin() + i);
@@ -5358,84 +5593,16 @@ namespace libtorrent {
 			return;
 		}
 
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wmissing-braces"
-#endif
-		aux::array<boost::tribool, num_protocols, protocol_version>
-			hash_failed{ { boost::indeterminate, boost::indeterminate } };
-#ifdef __clang__
-#pragma clang diagnostic pop
-#endif
-
-		// we're using the piece hashes here, we need the torrent to be loaded
-		if (!m_settings.get_bool(settings_pack::disable_hash_checks)
-			&& t->info_hash().has_v1())
-		{
-			hash_failed[protocol_version::V1] = piece_hash != t->torrent_file().hash_for_piece(piece);
-		}
-
-		if (!m_settings.get_bool(settings_pack::disable_hash_checks)
-			&& t->info_hash().has_v2())
-		{
-			hash_failed[protocol_version::V2] = false;
-
-			int const blocks_in_piece = t->torrent_file().files().blocks_in_piece2(piece);
-
-			TORRENT_ASSERT(blocks_in_piece == int(block_hashes.size()));
-
-			t->need_hash_picker();
-			auto picker = t->get_hash_picker();
-			set_block_hash_result result = set_block_hash_result::unknown();
-			for (int i = 0; i < blocks_in_piece; ++i)
-			{
-				result = picker.set_block_hash(piece, i * default_block_size, block_hashes[i]);
-				if (result.status == set_block_hash_result::result::block_hash_failed
-					|| result.status == set_block_hash_result::result::piece_hash_failed)
-				{
-					hash_failed[protocol_version::V2] = true;
-				}
-			}
-
-			// if the last block still couldn't be verified
-			// it means we don't know the piece's root hash
-			// we must leave seed mode
-			if (result.status == set_block_hash_result::result::unknown)
-				hash_failed[protocol_version::V1] = hash_failed[protocol_version::V2] = true;
-		}
-
-		if ((hash_failed[protocol_version::V1] && !hash_failed[protocol_version::V2])
-			|| (!hash_failed[protocol_version::V1] && hash_failed[protocol_version::V2]))
-		{
-			t->set_error(errors::torrent_inconsistent_hashes, torrent_status::error_file_none);
-			t->pause();
-			return;
-		}
-
-		if (hash_failed[protocol_version::V1] || hash_failed[protocol_version::V2])
-		{
-#ifndef TORRENT_DISABLE_LOGGING
-			peer_log(peer_log_alert::info, "SEED_MODE_FILE_HASH"
-				, "piece: %d failed", static_cast<int>(piece));
-#endif
-
-			t->leave_seed_mode(torrent::seed_mode_t::check_files);
-		}
-		else
-		{
-			if (t->seed_mode())
-			{
-				TORRENT_ASSERT(t->verifying_piece(piece));
-				t->verified(piece);
-			}
+		// the verified-state bookkeeping is shared with the background
+		// verifier, and lives in the torrent
+		bool const passed = t->seed_mode_piece_hashed(piece, piece_hash, block_hashes);
 
 #ifndef TORRENT_DISABLE_LOGGING
-			peer_log(peer_log_alert::info, "SEED_MODE_FILE_HASH"
-				, "piece: %d passed", static_cast<int>(piece));
+		peer_log(peer_log_alert::info, "SEED_MODE_FILE_HASH"
+			, "piece: %d %s", static_cast<int>(piece)
+			, passed ? "passed" : "failed");
 #endif
-			if (t->seed_mode() && t->all_verified())
-				t->leave_seed_mode(torrent::seed_mode_t::skip_checking);
-		}
+		if (!passed) return;
 
 		// try to service the requests again, now that the piece
 		// has been verified
@@ -5768,6 +5935,8 @@ namespace libtorrent {
 				&& !m_requests.empty()
 				&& m_reading_bytes > m_settings.get_int(settings_pack::send_buffer_watermark) - 0x4000)
 			{
+				m_counters.inc_stats_counter(counters::num_send_buffer_stalls);
+
 				std::shared_ptr<torrent> t = m_torrent.lock();
 
 				// we're stalled on the disk. We want to write and we can write
@@ -6015,6 +6184,11 @@ namespace libtorrent {
 	{
 		TORRENT_ASSERT(is_single_thread());
 		COMPLETE_ASYNC("peer_connection::on_receive_data");
+		TORRENT_PROBE2(peer_receive_data, int(bytes_transferred), error.value());
+
+		// refresh the cached coarse clock once per receive event, instead
+		// of every piece of bookkeeping below reading the clock itself
+		aux::update_time_now();
 
 #ifndef TORRENT_DISABLE_LOGGING
 		if (should_log(peer_log_alert::incoming))
@@ -6149,6 +6323,10 @@ namespace libtorrent {
 			if (m_disconnecting) return;
 		} while (bytes > 0 && sub_transferred > 0);
 
+		// apply any HAVE messages from the tail end of this receive quantum
+		flush_haves();
+		if (m_disconnecting) return;
+
 		// if the peer went from unchoked to choked, suggest to the receive
 		// buffer that it shrinks to 100 bytes
 		int const force_shrink = (m_peer_choked && !prev_choked)
@@ -6361,6 +6539,7 @@ namespace libtorrent {
 		, std::size_t const bytes_transferred)
 	{
 		TORRENT_ASSERT(is_single_thread());
+		aux::update_time_now();
 		m_counters.inc_stats_counter(counters::on_write_counter);
 		m_ses.sent_buffer(int(bytes_transferred));
 
@@ -6496,7 +6675,7 @@ namespace libtorrent {
 
 #if TORRENT_USE_INVARIANT_CHECKS \
 	&& !defined TORRENT_NO_EXPENSIVE_INVARIANT_CHECK
-		if (t && t->has_picker() && !m_disconnecting)
+		if (t && t->has_picker() && !m_disconnecting && m_pending_haves.empty())
 			t->picker().check_peer_invariant(m_have_piece, peer_info_struct());
 #endif
 
@@ -100,16 +100,27 @@ namespace libtorrent {
 
 	void peer_list::clear()
 	{
-		for (auto const p : m_peers)
-			m_peer_allocator.free_peer_entry(p);
+		free_all_peers();
 		m_peers.clear();
 		m_num_connect_candidates = 0;
 	}
 
 	peer_list::~peer_list()
 	{
+		free_all_peers();
+	}
+
+	// the allocator is per-torrent, so when dropping every peer at once we
+	// can release its slabs wholesale rather than walking 100k entries and
+	// freeing them one by one. Only i2p peers own heap allocations and need
+	// their destructors run
+	void peer_list::free_all_peers()
+	{
+#if TORRENT_USE_I2P
 		for (auto const p : m_peers)
-			m_peer_allocator.free_peer_entry(p);
+			if (p->is_i2p_addr) m_peer_allocator.free_peer_entry(p);
+#endif
+		m_peer_allocator.free_all_peer_entries();
 	}
 
 	void peer_list::set_max_failcount(torrent_state* state)
@@ -451,6 +462,15 @@ namespace libtorrent {
 		return true;
 	}
 
+	// this deliberately does not maintain a sorted index of connect
+	// candidates. The scan below is bounded to 300 peers per call,
+	// continuing round-robin where the previous call left off, and
+	// produces a batch of 10 candidates that connect_one_peer() consumes
+	// before scanning again. A persistent heap or bucket index would have
+	// to be updated from every place that changes anything
+	// is_connect_candidate() or compare_peer() read (failcount, port
+	// filter, connection state, pad-seed state, external IP, ...), which
+	// in practice costs more than the bounded amortized scan
 	void peer_list::find_connect_candidates(std::vector<torrent_peer*>& peers
 		, int session_time, torrent_state* state)
 	{
@@ -828,6 +848,30 @@ namespace libtorrent {
 		return std::find(m_peers.begin(), m_peers.end(), p) != m_peers.end();
 	}
 
+	std::int64_t peer_list::memory_usage() const
+	{
+		TORRENT_ASSERT(is_single_thread());
+		std::int64_t ret = std::int64_t(sizeof(*this));
+		ret += std::int64_t(m_peers.size()) * std::int64_t(sizeof(torrent_peer*));
+		ret += std::int64_t(m_candidate_cache.capacity()) * std::int64_t(sizeof(torrent_peer*));
+		// the entries themselves live in the torrent_peer_allocator pools.
+		// attribute each entry's size to this torrent
+		for (auto const* p : m_peers)
+		{
+#if TORRENT_USE_I2P
+			if (p->is_i2p_addr)
+			{
+				ret += std::int64_t(sizeof(i2p_peer));
+				continue;
+			}
+#endif
+			ret += p->is_v6_addr
+				? std::int64_t(sizeof(ipv6_peer))
+				: std::int64_t(sizeof(ipv4_peer));
+		}
+		return ret;
+	}
+
 	void peer_list::set_seed(torrent_peer* p, bool s)
 	{
 		TORRENT_ASSERT(is_single_thread());
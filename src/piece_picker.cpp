@@ -47,6 +47,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/bitfield.hpp"
 #include "libtorrent/random.hpp"
 #include "libtorrent/aux_/alloca.hpp"
+#include "libtorrent/aux_/tracepoint.hpp"
 #include "libtorrent/aux_/range.hpp"
 #include "libtorrent/performance_counters.hpp" // for counters
 #include "libtorrent/alert_types.hpp" // for picker_log_alert
@@ -171,6 +172,7 @@ namespace libtorrent {
 		m_cursor = piece_index_t(0);
 
 		for (auto& c : m_downloads) c.clear();
+		m_downloads_index.clear();
 		m_block_info.clear();
 		m_free_block_infos.clear();
 
@@ -306,6 +308,8 @@ namespace libtorrent {
 #endif
 		}
 		downloading_iter = m_downloads[download_state].insert(downloading_iter, ret);
+		update_download_index(download_state
+			, int(downloading_iter - m_downloads[download_state].begin()));
 
 		// in case every block was a pad block, we need to make sure the piece
 		// structure is correctly categorised
@@ -335,8 +339,11 @@ namespace libtorrent {
 		m_free_block_infos.push_back(i->info_idx);
 
 		TORRENT_ASSERT(find_dl_piece(download_state, i->index) == i);
+		int const pos = int(i - m_downloads[download_state].begin());
+		m_downloads_index.erase(i->index);
 		m_piece_map[i->index].state(piece_pos::piece_open);
 		m_downloads[download_state].erase(i);
+		update_download_index(download_state, pos);
 
 		TORRENT_ASSERT(prev_size == int(m_downloads[download_state].size()) + 1);
 
@@ -410,6 +417,22 @@ namespace libtorrent {
 				}
 			}
 		}
+
+		// every downloading_piece must be recorded at its correct position
+		// in m_downloads_index, and the index must not have any stale
+		// entries left behind
+		std::size_t num_entries = 0;
+		for (auto const k : categories())
+		{
+			for (int i = 0; i < int(m_downloads[k].size()); ++i)
+			{
+				auto const j = m_downloads_index.find(m_downloads[k][i].index);
+				TORRENT_ASSERT(j != m_downloads_index.end());
+				TORRENT_ASSERT(j->second == i);
+				++num_entries;
+			}
+		}
+		TORRENT_ASSERT(m_downloads_index.size() == num_entries);
 	}
 
 	void piece_picker::verify_pick(span<piece_block const> const picked
@@ -773,6 +796,25 @@ namespace libtorrent {
 		return std::make_pair(min_availability + m_seeds, fraction_part * 1000 / npieces);
 	}
 
+	std::int64_t piece_picker::memory_usage() const
+	{
+		std::int64_t ret = std::int64_t(sizeof(*this));
+		ret += std::int64_t(m_piece_map.capacity()) * std::int64_t(sizeof(piece_pos));
+		ret += std::int64_t(m_pad_blocks.size() + 7) / 8;
+		// approximate the unordered_map node overhead with two pointers
+		// per entry
+		ret += std::int64_t(m_pads_in_piece.size())
+			* std::int64_t(sizeof(std::pair<piece_index_t, int>) + 2 * sizeof(void*));
+		ret += std::int64_t(m_recent_extents.capacity()) * std::int64_t(sizeof(piece_extent_t));
+		ret += std::int64_t(m_pieces.capacity()) * std::int64_t(sizeof(piece_index_t));
+		ret += std::int64_t(m_priority_boundaries.capacity()) * std::int64_t(sizeof(prio_index_t));
+		for (auto const& dq : m_downloads)
+			ret += std::int64_t(dq.capacity()) * std::int64_t(sizeof(downloading_piece));
+		ret += std::int64_t(m_block_info.capacity()) * std::int64_t(sizeof(block_info));
+		ret += std::int64_t(m_free_block_infos.capacity()) * std::int64_t(sizeof(std::uint16_t));
+		return ret;
+	}
+
 	prio_index_t piece_picker::priority_begin(int const prio) const
 	{
 		TORRENT_ASSERT(prio >= 0);
@@ -1318,12 +1360,11 @@ namespace libtorrent {
 			// and mark the picker as dirty, so we'll rebuild it next time we need it.
 			// this only matters if we're not already dirty, in which case the fasted
 			// thing to do is to just update the counters and be done
-			piece_index_t index = piece_index_t(0);
 			int num_inc = 0;
-			for (auto i = bitmask.begin(), end(bitmask.end()); i != end; ++i, ++index)
+			for (int i = bitmask.find_first_set(0); i != -1;
+				i = bitmask.find_first_set(i + 1))
 			{
-				if (!*i) continue;
-				if (num_inc < size) incremented[num_inc] = index;
+				if (num_inc < size) incremented[num_inc] = piece_index_t(i);
 				++num_inc;
 				if (num_inc >= size) break;
 			}
@@ -1354,22 +1395,20 @@ namespace libtorrent {
 			}
 		}
 
-		piece_index_t index = piece_index_t(0);
 		bool updated = false;
-		for (auto i = bitmask.begin(), end(bitmask.end()); i != end; ++i, ++index)
+		for (int i = bitmask.find_first_set(0); i != -1;
+			i = bitmask.find_first_set(i + 1))
 		{
-			if (*i)
-			{
+			piece_index_t const index(i);
 #ifdef TORRENT_DEBUG_REFCOUNTS
-				TORRENT_ASSERT(m_piece_map[index].have_peers.count(peer) == 0);
-				m_piece_map[index].have_peers.insert(peer);
+			TORRENT_ASSERT(m_piece_map[index].have_peers.count(peer) == 0);
+			m_piece_map[index].have_peers.insert(peer);
 #else
-				TORRENT_UNUSED(peer);
+			TORRENT_UNUSED(peer);
 #endif
 
-				++m_piece_map[index].peer_count;
-				updated = true;
-			}
+			++m_piece_map[index].peer_count;
+			updated = true;
 		}
 
 		// if we're already dirty, no point in doing anything more
@@ -1414,12 +1453,11 @@ namespace libtorrent {
 			// and mark the picker as dirty, so we'll rebuild it next time we need it.
 			// this only matters if we're not already dirty, in which case the fasted
 			// thing to do is to just update the counters and be done
-			piece_index_t index = piece_index_t(0);
 			int num_dec = 0;
-			for (auto i = bitmask.begin(), end(bitmask.end()); i != end; ++i, ++index)
+			for (int i = bitmask.find_first_set(0); i != -1;
+				i = bitmask.find_first_set(i + 1))
 			{
-				if (!*i) continue;
-				if (num_dec < size) decremented[num_dec] = index;
+				if (num_dec < size) decremented[num_dec] = piece_index_t(i);
 				++num_dec;
 				if (num_dec >= size) break;
 			}
@@ -1459,34 +1497,31 @@ namespace libtorrent {
 			}
 		}
 
-		piece_index_t index = piece_index_t(0);
 		bool updated = false;
-		for (auto i = bitmask.begin(), end(bitmask.end()); i != end; ++i, ++index)
+		for (int i = bitmask.find_first_set(0); i != -1;
+			i = bitmask.find_first_set(i + 1))
 		{
-			if (*i)
+			piece_pos& p = m_piece_map[piece_index_t(i)];
+			if (p.peer_count == 0)
 			{
-				piece_pos& p = m_piece_map[index];
-				if (p.peer_count == 0)
-				{
-					TORRENT_ASSERT(m_seeds > 0);
-					// this is the case where we have one or more
-					// seeds, and one of them saying: I don't have this
-					// piece anymore. we need to break up one of the seed
-					// counters into actual peer counters on the pieces
-					break_one_seed();
-				}
+				TORRENT_ASSERT(m_seeds > 0);
+				// this is the case where we have one or more
+				// seeds, and one of them saying: I don't have this
+				// piece anymore. we need to break up one of the seed
+				// counters into actual peer counters on the pieces
+				break_one_seed();
+			}
 
 #ifdef TORRENT_DEBUG_REFCOUNTS
-				TORRENT_ASSERT(p.have_peers.count(peer) == 1);
-				p.have_peers.erase(peer);
+			TORRENT_ASSERT(p.have_peers.count(peer) == 1);
+			p.have_peers.erase(peer);
 #else
-				TORRENT_UNUSED(peer);
+			TORRENT_UNUSED(peer);
 #endif
 
-				TORRENT_ASSERT(p.peer_count > 0);
-				--p.peer_count;
-				updated = true;
-			}
+			TORRENT_ASSERT(p.peer_count > 0);
+			--p.peer_count;
+			updated = true;
 		}
 
 		// if we're already dirty, no point in doing anything more
@@ -1765,6 +1800,7 @@ namespace libtorrent {
 		m_num_have = num_pieces();
 
 		for (auto& queue : m_downloads) queue.clear();
+		m_downloads_index.clear();
 		for (auto& p : m_piece_map)
 		{
 			p.set_have();
@@ -1884,6 +1920,40 @@ namespace libtorrent {
 		return ret;
 	}
 
+	bool piece_picker::set_piece_priorities(
+		aux::vector<download_priority_t, piece_index_t> const& priorities)
+	{
+		TORRENT_ASSERT(int(priorities.size()) <= int(m_piece_map.size()));
+
+		// when many pieces are about to move between priority buckets,
+		// restructuring the ordered priority list for each of them is
+		// wasted work. Mark the list dirty up front, which makes
+		// set_piece_priority() skip the incremental updates, and let the
+		// next pick rebuild it in a single pass. For a few changes the
+		// incremental updates are cheaper than a rebuild, so count first
+		if (!m_dirty)
+		{
+			// the number of changed pieces where an incremental update is
+			// assumed to be cheaper than one rebuild of the priority list
+			int const rebuild_threshold = 32;
+			int changed = 0;
+			for (piece_index_t index(0); index != priorities.end_index(); ++index)
+			{
+				if (download_priority_t(m_piece_map[index].piece_priority)
+					== priorities[index]) continue;
+				++changed;
+				if (changed <= rebuild_threshold) continue;
+				m_dirty = true;
+				break;
+			}
+		}
+
+		bool ret = false;
+		for (piece_index_t index(0); index != priorities.end_index(); ++index)
+			ret |= set_piece_priority(index, priorities[index]);
+		return ret;
+	}
+
 	download_priority_t piece_picker::piece_priority(piece_index_t const index) const
 	{
 		return download_priority_t{static_cast<std::uint8_t>(m_piece_map[index].piece_priority)};
@@ -1972,6 +2042,7 @@ namespace {
 		, counters& pc
 		) const
 	{
+		TORRENT_PROBE2(pick_pieces, num_blocks, num_peers);
 		TORRENT_ASSERT(peer == nullptr || peer->in_use);
 		picker_flags_t ret;
 
@@ -2955,13 +3026,22 @@ get_out:
 			|| queue == piece_pos::piece_finished
 			|| queue == piece_pos::piece_zero_prio);
 
-		downloading_piece cmp;
-		cmp.index = index;
-		auto const i = std::lower_bound(
-			m_downloads[queue].begin(), m_downloads[queue].end(), cmp);
-		if (i == m_downloads[queue].end()) return i;
-		if (i->index == index) return i;
-		return m_downloads[queue].end();
+		auto const j = m_downloads_index.find(index);
+		if (j == m_downloads_index.end()) return m_downloads[queue].end();
+		// the entry lives in the queue its piece_pos says it does. If the
+		// caller asks for any other queue, it's a miss
+		int const pos = j->second;
+		if (pos >= int(m_downloads[queue].size())) return m_downloads[queue].end();
+		auto const i = m_downloads[queue].begin() + pos;
+		if (i->index != index) return m_downloads[queue].end();
+		return i;
+	}
+
+	void piece_picker::update_download_index(download_queue_t const queue, int const from)
+	{
+		auto const& q = m_downloads[queue];
+		for (int i = from; i < int(q.size()); ++i)
+			m_downloads_index[q[i].index] = i;
 	}
 
 	std::vector<piece_picker::downloading_piece>::const_iterator piece_picker::find_dl_piece(
@@ -3027,7 +3107,10 @@ get_out:
 		// remove the downloading_piece from the list corresponding
 		// to the old state
 		downloading_piece dp_info = *dp;
-		m_downloads[p.download_queue()].erase(dp);
+		auto const old_queue = p.download_queue();
+		int const erase_pos = int(dp - m_downloads[old_queue].begin());
+		m_downloads[old_queue].erase(dp);
+		update_download_index(old_queue, erase_pos);
 
 		int const prio = p.priority(this);
 		TORRENT_ASSERT(prio < int(m_priority_boundaries.size()) || m_dirty);
@@ -3045,6 +3128,8 @@ get_out:
 		TORRENT_ASSERT(i == m_downloads[p.download_queue()].end()
 			|| i->index != dp_info.index);
 		i = m_downloads[p.download_queue()].insert(i, dp_info);
+		update_download_index(p.download_queue()
+			, int(i - m_downloads[p.download_queue()].begin()));
 
 		if (!m_dirty)
 		{
@@ -3328,6 +3413,25 @@ get_out:
 		return m_piece_map[piece].peer_count + m_seeds;
 	}
 
+	void piece_picker::get_availability_histogram(aux::vector<int>& hist) const
+	{
+		TORRENT_ASSERT(m_seeds >= 0);
+		INVARIANT_CHECK;
+
+		// a single pass over the piece map. Since every seed has every
+		// piece, m_seeds just offsets the whole histogram. The result is
+		// small (bounded by the most well-seeded piece), which makes this a
+		// lot cheaper for clients polling the availability distribution
+		// than copying out the full per-piece vector
+		hist.clear();
+		for (auto const& p : m_piece_map)
+		{
+			int const a = p.peer_count + m_seeds;
+			if (a >= int(hist.size())) hist.resize(a + 1, 0);
+			++hist[a];
+		}
+	}
+
 	bool piece_picker::mark_as_writing(piece_block const block, torrent_peer* peer)
 	{
 #ifdef TORRENT_EXPENSIVE_INVARIANT_CHECKS
@@ -199,6 +199,27 @@ namespace {
 
 			TORRENT_ASSERT(!v2 || int(block_hashes.size()) >= blocks_in_piece2);
 
+			// when checking a torrent (volatile_read), probe the filesystem
+			// for holes first. A piece lying entirely in holes reads back
+			// as all zeroes, so its hashes can be produced from a (cached)
+			// table instead of reading and hashing every block. These must
+			// be the digests of all-zero buffers, not zeroed-out digests: a
+			// legitimately all-zero piece may be stored as holes by
+			// hole-punching filesystems, and must still pass verification
+			if ((flags & disk_interface::volatile_read)
+				&& !st->piece_has_data(piece, std::max(piece_size, piece_size2)))
+			{
+				for (int i = 0; i < blocks_in_piece2; ++i)
+				{
+					int const len2 = std::min(default_block_size
+						, piece_size2 - i * default_block_size);
+					block_hashes[i] = aux::hash2_of_zeroes(len2);
+				}
+				sha1_hash const ph = v1 ? aux::hash_of_zeroes(piece_size) : sha1_hash{};
+				post(m_ios, [=, h = std::move(handler)]{ h(piece, ph, error); });
+				return;
+			}
+
 			int offset = 0;
 			int const blocks_to_read = std::max(blocks_in_piece, blocks_in_piece2);
 			for (int i = 0; i < blocks_to_read; ++i)
@@ -46,8 +46,26 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <unistd.h> // for symlink()
 #endif
 
+#ifdef TORRENT_LINUX
+#include <fcntl.h> // for open() and O_DIRECT
+#include <sys/uio.h> // for pwritev()
+#include <unistd.h> // for close()
+#endif
+
 using namespace libtorrent::flags; // for flag operators
 
+#ifdef TORRENT_LINUX
+namespace {
+	// the alignment required of file offsets, buffer addresses and buffer
+	// lengths for O_DIRECT I/O. 4 kiB covers all common devices
+	constexpr int direct_io_alignment = 4096;
+
+	// sentinel returned by write_direct() when the request cannot be
+	// performed with O_DIRECT and should take the buffered path instead
+	constexpr int direct_io_unsupported = std::numeric_limits<int>::min();
+}
+#endif
+
 namespace libtorrent {
 namespace aux {
 
@@ -217,13 +235,13 @@ namespace aux {
 		});
 	}
 
-	int posix_storage::writev(settings_interface const&
+	int posix_storage::writev(settings_interface const& sett
 		, span<iovec_t const> bufs
 		, piece_index_t const piece, int const offset
 		, storage_error& error)
 	{
 		return readwritev(files(), bufs, piece, offset, error
-			, [this](file_index_t const file_index
+			, [this, &sett](file_index_t const file_index
 				, std::int64_t const file_offset
 				, span<iovec_t const> vec, storage_error& ec)
 		{
@@ -254,6 +272,17 @@ namespace aux {
 				return ret;
 			}
 
+#ifdef TORRENT_LINUX
+			if (sett.get_int(settings_pack::disk_io_write_mode)
+				== settings_pack::disable_os_cache)
+			{
+				int const r = write_direct(file_index, file_offset, vec, ec);
+				// if the file system (or this request's alignment) doesn't
+				// support O_DIRECT, fall through to the buffered path
+				if (r != direct_io_unsupported) return r;
+			}
+#endif
+
 			file_pointer const f = open_file(file_index, open_mode::write
 				, file_offset, ec);
 			if (ec.ec) return -1;
@@ -290,9 +319,60 @@ namespace aux {
 		});
 	}
 
+	bool posix_storage::piece_has_data(piece_index_t const piece, int const len)
+	{
+#ifdef TORRENT_LINUX
+		for (file_slice const& slice : files().map_block(piece, 0, len))
+		{
+			file_index_t const i = slice.file_index;
+			if (files().pad_file_at(i)) continue;
+			if (i < m_file_priority.end_index()
+				&& m_file_priority[i] == dont_download
+				&& use_partfile(i))
+			{
+				// this part of the piece may live in the part file, assume
+				// it's there
+				return true;
+			}
+
+			error_code err;
+			std::int64_t const size = m_stat_cache.get_filesize(i
+				, files(), m_save_path, err);
+			if (err == boost::system::errc::no_such_file_or_directory) continue;
+			// any other stat error will surface when the piece is hashed
+			if (err) return true;
+			// the range past the end of the file is all hole
+			if (size <= slice.offset) continue;
+
+			std::string const path = files().file_path(i, m_save_path);
+			int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0) return true;
+			// lseek() with SEEK_DATA finds the first byte at or after the
+			// given offset that isn't part of a hole in a sparse file.
+			// ENXIO means there's no data at or beyond the offset; any
+			// other error means the filesystem can't probe for holes
+			std::int64_t const data = ::lseek(fd, slice.offset, SEEK_DATA);
+			int const e = errno;
+			::close(fd);
+			if (data < 0)
+			{
+				if (e != ENXIO) return true;
+				continue;
+			}
+			if (data < slice.offset + slice.size) return true;
+		}
+		return false;
+#else
+		TORRENT_UNUSED(piece);
+		TORRENT_UNUSED(len);
+		return true;
+#endif
+	}
+
 	bool posix_storage::has_any_file(storage_error& error)
 	{
 		m_stat_cache.reserve(files().num_files());
+		m_stat_cache.bulk_stat(files(), m_save_path);
 		return aux::has_any_file(files(), m_save_path, m_stat_cache, error);
 	}
 
@@ -389,6 +469,11 @@ namespace aux {
 	{
 		m_stat_cache.reserve(files().num_files());
 
+		// stat all files in one pass up front. The loop below, and any
+		// resume data validation that follows, are then served out of the
+		// cache
+		m_stat_cache.bulk_stat(files(), m_save_path);
+
 		file_storage const& fs = files();
 		// if some files have priority 0, we need to check if they exist on the
 		// filesystem, in which case we won't use a partfile for them.
@@ -507,6 +592,110 @@ namespace aux {
 		}
 	}
 
+#ifdef TORRENT_LINUX
+	int posix_storage::write_direct(file_index_t const idx
+		, std::int64_t const file_offset
+		, span<iovec_t const> vec, storage_error& ec)
+	{
+		// O_DIRECT requires the file offset, the buffer addresses and the
+		// buffer lengths to all be sector aligned. The buffers from
+		// disk_buffer_pool are allocated aligned, but a block may land at an
+		// unaligned file offset in multi-file torrents, and the last block of
+		// a file may have an unaligned length. Anything that doesn't qualify
+		// is handed back to the buffered path
+		if (file_offset % direct_io_alignment != 0) return direct_io_unsupported;
+
+		// count how many buffers can be written directly. Only the last one
+		// is allowed an unaligned length, the remainder of it (the tail) is
+		// written buffered
+		int aligned_bufs = 0;
+		for (auto const& buf : vec)
+		{
+			if (reinterpret_cast<std::uintptr_t>(buf.data()) % direct_io_alignment != 0)
+				break;
+			if (buf.size() % direct_io_alignment != 0) break;
+			++aligned_bufs;
+		}
+		if (aligned_bufs == 0) return direct_io_unsupported;
+
+		std::string const fn = files().file_path(idx, m_save_path);
+		int const fd = ::open(fn.c_str(), O_WRONLY | O_CREAT | O_DIRECT, 0666);
+		// this fails with EINVAL on file systems without O_DIRECT support,
+		// and with ENOENT if the containing directory hasn't been created
+		// yet. The buffered path deals with both
+		if (fd < 0) return direct_io_unsupported;
+
+		::iovec iov[64];
+		int const num_iov = std::min(aligned_bufs
+			, int(sizeof(iov) / sizeof(iov[0])));
+		std::int64_t to_write = 0;
+		for (int i = 0; i < num_iov; ++i)
+		{
+			iov[i].iov_base = const_cast<char*>(vec[i].data());
+			iov[i].iov_len = static_cast<std::size_t>(vec[i].size());
+			to_write += vec[i].size();
+		}
+
+		ec.operation = operation_t::file_write;
+		auto const written = ::pwritev(fd, iov, num_iov, file_offset);
+		::close(fd);
+		if (written < 0)
+		{
+			if (errno == EINVAL) return direct_io_unsupported;
+			ec.ec.assign(errno, generic_category());
+			ec.file(idx);
+			return -1;
+		}
+
+		m_stat_cache.set_dirty(idx);
+
+		if (written < to_write)
+		{
+			// a short direct write. Let the caller retry the rest through
+			// the regular path by reporting how much was written
+			return static_cast<int>(written);
+		}
+
+		int ret = static_cast<int>(written);
+
+		// the unaligned tail, if any, goes through the buffered path
+		if (num_iov < int(vec.size()))
+		{
+			storage_error tail_ec;
+			int const r = [&]() -> int
+			{
+				file_pointer const f = open_file(idx, open_mode::write
+					, file_offset + written, tail_ec);
+				if (tail_ec.ec) return -1;
+				int n = 0;
+				for (auto buf : vec.subspan(num_iov))
+				{
+					auto const w = static_cast<int>(fwrite(buf.data(), 1
+						, static_cast<std::size_t>(buf.size()), f.file()));
+					n += w;
+					if (w != buf.size())
+					{
+						if (ferror(f.file())) tail_ec.ec.assign(errno, generic_category());
+						else tail_ec.ec.assign(errors::file_too_short, libtorrent_category());
+						break;
+					}
+				}
+				return n;
+			}();
+			if (tail_ec.ec)
+			{
+				ec = tail_ec;
+				ec.file(idx);
+				ec.operation = operation_t::file_write;
+				return -1;
+			}
+			ret += r;
+		}
+
+		return ret;
+	}
+#endif
+
 	file_pointer posix_storage::open_file(file_index_t idx, open_mode_t const mode
 		, std::int64_t const offset, storage_error& ec)
 	{
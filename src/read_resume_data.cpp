@@ -66,6 +66,12 @@ namespace {
 
 } // anonyous namespace
 
+	// note that add_torrent_params owns all its strings and bitfields, even
+	// though they are parsed out of a caller-provided buffer. It's tempting to
+	// let the fields borrow spans into the (possibly memory mapped) resume
+	// buffer instead, but the params object is moved into the session's
+	// message queue and consumed on the network thread, long after the
+	// caller's buffer may be gone. The copies are what make the handoff safe.
 	add_torrent_params read_resume_data(bdecode_node const& rd, error_code& ec
 		, int const piece_limit)
 	{
@@ -304,6 +310,7 @@ namespace {
 
 		if (url_list)
 		{
+			ret.url_seeds.reserve(std::size_t(url_list.list_size()));
 			for (int i = 0; i < url_list.list_size(); ++i)
 			{
 				auto url = url_list.list_string_value_at(i);
@@ -314,6 +321,7 @@ namespace {
 
 		if (httpseeds)
 		{
+			ret.http_seeds.reserve(std::size_t(httpseeds.list_size()));
 			for (int i = 0; i < httpseeds.list_size(); ++i)
 			{
 				auto url = httpseeds.list_string_value_at(i);
@@ -341,6 +349,19 @@ namespace {
 			}
 		}
 
+		if (bdecode_node const sizes = rd.dict_find_list("file sizes"))
+		{
+			ret.file_sizes.reserve(std::size_t(sizes.list_size()));
+			for (int i = 0; i < sizes.list_size(); ++i)
+			{
+				bdecode_node const fp = sizes.list_at(i);
+				if (fp.type() != bdecode_node::list_t || fp.list_size() < 2)
+					break;
+				ret.file_sizes.emplace_back(fp.list_int_value_at(0)
+					, fp.list_int_value_at(1));
+			}
+		}
+
 		if (bdecode_node const piece_priority = rd.dict_find_string("piece_priority"))
 		{
 			char const* prio_str = piece_priority.string_ptr();
@@ -360,6 +381,8 @@ namespace {
 		if (bdecode_node const peers_entry = rd.dict_find_string("peers"))
 		{
 			char const* ptr = peers_entry.string_ptr();
+			ret.peers.reserve(ret.peers.size()
+				+ std::size_t(peers_entry.string_length() / v4_size));
 			for (int i = v4_size - 1; i < peers_entry.string_length(); i += v4_size)
 				ret.peers.push_back(read_v4_endpoint<tcp::endpoint>(ptr));
 		}
@@ -367,6 +390,8 @@ namespace {
 		if (bdecode_node const peers_entry = rd.dict_find_string("peers6"))
 		{
 			char const* ptr = peers_entry.string_ptr();
+			ret.peers.reserve(ret.peers.size()
+				+ std::size_t(peers_entry.string_length() / v6_size));
 			for (int i = v6_size - 1; i < peers_entry.string_length(); i += v6_size)
 				ret.peers.push_back(read_v6_endpoint<tcp::endpoint>(ptr));
 		}
@@ -374,6 +399,8 @@ namespace {
 		if (bdecode_node const peers_entry = rd.dict_find_string("banned_peers"))
 		{
 			char const* ptr = peers_entry.string_ptr();
+			ret.banned_peers.reserve(ret.banned_peers.size()
+				+ std::size_t(peers_entry.string_length() / v4_size));
 			for (int i = v4_size; i < peers_entry.string_length(); i += v4_size)
 				ret.banned_peers.push_back(read_v4_endpoint<tcp::endpoint>(ptr));
 		}
@@ -381,6 +408,8 @@ namespace {
 		if (bdecode_node const peers_entry = rd.dict_find_string("banned_peers6"))
 		{
 			char const* ptr = peers_entry.string_ptr();
+			ret.banned_peers.reserve(ret.banned_peers.size()
+				+ std::size_t(peers_entry.string_length() / v6_size));
 			for (int i = v6_size - 1; i < peers_entry.string_length(); i += v6_size)
 				ret.banned_peers.push_back(read_v6_endpoint<tcp::endpoint>(ptr));
 		}
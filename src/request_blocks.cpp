@@ -121,6 +121,12 @@ namespace libtorrent {
 			// "whole_pieces_threshold" seconds, we prefer to pick an entire piece.
 			// If we can download multiple whole pieces, we prefer to download that
 			// many contiguous pieces.
+			// besides cutting per-request overhead, this is what gives the
+			// disk layer sequential write extents. Blocks a single fast peer
+			// downloads back-to-back complete in order, so the writes they
+			// produce sit adjacent in the piece and can be coalesced into
+			// large contiguous writes, instead of the scattered pattern that
+			// results when several peers interleave blocks of the same piece.
 
 			// download_rate times the whole piece threshold (seconds) gives the
 			// number of bytes downloaded in one window of that threshold, divided
@@ -214,6 +220,14 @@ namespace libtorrent {
 		// that some other peer is currently downloading
 		piece_block busy_block = piece_block::invalid;
 
+		// in v2 swarms, blocks belonging to pieces whose hashes we haven't
+		// downloaded yet can't be verified when they arrive; they sit
+		// unverified in RAM and on disk until the merkle proof shows up.
+		// Defer such blocks and prefer pieces we can verify immediately,
+		// falling back to the deferred ones only if we still have requests
+		// to spend, to keep the unverified backlog small
+		std::vector<piece_block> unhashed_blocks;
+
 		for (piece_block const& pb : interesting_pieces)
 		{
 			if (prefer_contiguous_blocks == 0 && num_requests <= 0) break;
@@ -243,6 +257,14 @@ namespace libtorrent {
 
 			TORRENT_ASSERT(p.num_peers(pb) == 0);
 
+			if (t.has_hash_picker()
+				&& !time_critical_mode
+				&& !t.get_hash_picker().have_hash(pb.piece_index))
+			{
+				unhashed_blocks.push_back(pb);
+				continue;
+			}
+
 			// don't request pieces we already have in our request queue
 			// This happens when pieces time out or the peer sends us
 			// pieces we didn't request. Those aren't marked in the
@@ -272,6 +294,18 @@ namespace libtorrent {
 			num_requests--;
 		}
 
+		// we couldn't fill the queue with verifiable pieces alone; spend
+		// the remaining requests on the blocks we deferred above
+		for (piece_block const& pb : unhashed_blocks)
+		{
+			if (num_requests <= 0) break;
+			if (std::find_if(dq.begin(), dq.end(), aux::has_block(pb)) != dq.end()
+				|| std::find_if(rq.begin(), rq.end(), aux::has_block(pb)) != rq.end())
+				continue;
+			if (!c.add_request(pb, {})) continue;
+			num_requests--;
+		}
+
 		// we have picked as many blocks as we should
 		// we're done!
 		if (num_requests <= 0)
@@ -312,6 +346,35 @@ namespace libtorrent {
 		TORRENT_ASSERT(!p.is_finished(busy_block));
 		TORRENT_ASSERT(p.num_peers(busy_block) > 0);
 
+		// before issuing a duplicate request for a block somebody else is
+		// already downloading, make sure we're actually likely to beat the
+		// current owner to it. The picker records who requested the block;
+		// estimate the owner's delivery time from how far down its request
+		// queue the block sits and its payload rate, and our own from our
+		// payload rate. If the owner is likely to win, completing second
+		// just wastes a block's worth of bandwidth (the loser is cancelled
+		// when the winner's copy arrives, in torrent::cancel_block()). An
+		// owner with no measurable rate is stalled, and fair game
+		torrent_peer const* owner = p.get_downloader(busy_block);
+		if (owner != nullptr && owner->connection != nullptr)
+		{
+			auto const* ow = static_cast<peer_connection const*>(owner->connection);
+			std::int64_t const owner_rate = ow->statistics().download_payload_rate();
+			std::int64_t const our_rate = c.statistics().download_payload_rate();
+			if (owner_rate > 0)
+			{
+				auto const& odq = ow->download_queue();
+				auto const i = std::find_if(odq.begin(), odq.end()
+					, aux::has_block(busy_block));
+				std::int64_t const bytes_ahead = std::int64_t(t.block_size())
+					* (i == odq.end() ? 1 : i - odq.begin() + 1);
+				// only duplicate if we can deliver the block in less than
+				// half the time it will take the owner to get to it
+				if (our_rate * bytes_ahead < owner_rate * t.block_size() * 2)
+					return true;
+			}
+		}
+
 		c.add_request(busy_block, peer_connection::busy);
 		return true;
 	}
@@ -66,16 +66,42 @@ namespace aux {
 		COMPLETE_ASYNC("resolver::on_lookup");
 		if (ec)
 		{
+			auto const it = m_cache.find(hostname);
+			if (it != m_cache.end() && !it->second.addresses.empty())
+			{
+				// the lookup failed, but we still have addresses from an
+				// earlier successful one. Serve those to the waiters, stale
+				// addresses beat failing an announce. Bumping last_seen also
+				// backs us off from re-resolving while DNS is unresponsive
+				it->second.last_seen = time_now();
+				auto const range = m_callbacks.equal_range(hostname);
+				for (auto c = range.first; c != range.second; ++c)
+					callback(std::move(c->second), error_code(), it->second.addresses);
+				m_callbacks.erase(range.first, range.second);
+				return;
+			}
+
+			// cache the failure (a negative entry), so that a burst of
+			// lookups of a hostname that doesn't resolve is answered from
+			// the cache instead of each waiting out a full lookup
+			dns_cache_entry& ce = m_cache[hostname];
+			ce.last_seen = time_now();
+			ce.addresses.clear();
+			ce.error = ec;
+
 			auto const range = m_callbacks.equal_range(hostname);
 			for (auto c = range.first; c != range.second; ++c)
 				callback(std::move(c->second), ec, {});
 			m_callbacks.erase(range.first, range.second);
+
+			prune_cache();
 			return;
 		}
 
 		dns_cache_entry& ce = m_cache[hostname];
 		ce.last_seen = time_now();
 		ce.addresses.clear();
+		ce.error.clear();
 		for (auto i : ips)
 			ce.addresses.push_back(i.endpoint().address());
 
@@ -84,6 +110,11 @@ namespace aux {
 			callback(std::move(c->second), ec, ce.addresses);
 		m_callbacks.erase(range.first, range.second);
 
+		prune_cache();
+	}
+
+	void resolver::prune_cache()
+	{
 		// if m_cache grows too big, weed out the
 		// oldest entries
 		if (int(m_cache.size()) > m_max_size)
@@ -117,12 +148,40 @@ namespace aux {
 		auto const i = m_cache.find(host);
 		if (i != m_cache.end())
 		{
-			// keep cache entries valid for m_timeout seconds
+			// keep cache entries valid for m_timeout seconds, except
+			// negative entries (failed lookups), which expire much sooner
+			time_duration const timeout = i->second.error
+				? std::min(m_timeout, time_duration(seconds(60)))
+				: m_timeout;
 			if ((flags & resolver_interface::cache_only)
-				|| i->second.last_seen + m_timeout >= time_now())
+				|| i->second.last_seen + timeout >= time_now())
 			{
+				error_code const cached_ec = i->second.error;
 				std::vector<address> ips = i->second.addresses;
-				post(m_ios, [=] { callback(h, ec, ips); });
+				post(m_ios, [=] { callback(h, cached_ec, ips); });
+
+				// if this entry is in its last quarter of validity, refresh
+				// it in the background. A hot name (a tracker every torrent
+				// announces to) then never falls out of the cache, and no
+				// announce has to wait for the lookup
+				if (!i->second.error
+					&& !(flags & resolver_interface::cache_only)
+					&& i->second.last_seen + (m_timeout * 3) / 4 < time_now()
+					&& m_callbacks.find(host) == m_callbacks.end())
+				{
+					// the no-op callback marks the lookup as in-flight, so
+					// concurrent resolves of the same name attach to it
+					// instead of issuing their own
+					m_callbacks.insert({host, [](error_code const&
+						, std::vector<address> const&) {}});
+
+					// a prefetch is opportunistic, it's always safe to abort
+					// on shutdown
+					using namespace std::placeholders;
+					ADD_OUTSTANDING_ASYNC("resolver::on_lookup");
+					m_resolver.async_resolve(host, "80"
+						, std::bind(&resolver::on_lookup, this, _1, _2, host));
+				}
 				return;
 			}
 		}
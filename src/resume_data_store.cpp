@@ -0,0 +1,480 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "libtorrent/resume_data_store.hpp"
+#include "libtorrent/aux_/path.hpp"
+#include "libtorrent/crc32c.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+#ifdef TORRENT_WINDOWS
+#include <io.h> // for _commit, _chsize_s
+#define fseeko _fseeki64
+#else
+#include <unistd.h> // for fsync, ftruncate
+#endif
+
+namespace libtorrent {
+
+namespace {
+
+	// the journal starts with this tag, followed by a sequence of records:
+	//
+	//   1 byte   record type (1 = put, 2 = remove)
+	//   4 bytes  payload length, little endian (0 for remove)
+	//   20 bytes v1 info-hash (zeros if absent)
+	//   32 bytes v2 info-hash (zeros if absent)
+	//   n bytes  payload
+	//   4 bytes  crc32c of everything above, little endian
+	//
+	// a record whose bytes run past the end of the file, or whose checksum
+	// doesn't match, marks the end of the journal; everything before it is
+	// intact by construction, since records are only ever appended
+	char const journal_tag[] = "LTRJRN01";
+	constexpr int tag_size = 8;
+	constexpr int record_header_size = 1 + 4 + 20 + 32;
+	constexpr int record_overhead = record_header_size + 4;
+
+	constexpr std::uint8_t record_put = 1;
+	constexpr std::uint8_t record_remove = 2;
+
+	// cap on a single resume blob. Anything larger than this in a length
+	// field means we're not looking at a record
+	constexpr std::int32_t max_payload = 256 * 1024 * 1024;
+
+	std::uint32_t read_uint32(char const* b)
+	{
+		return std::uint32_t(std::uint8_t(b[0]))
+			| (std::uint32_t(std::uint8_t(b[1])) << 8)
+			| (std::uint32_t(std::uint8_t(b[2])) << 16)
+			| (std::uint32_t(std::uint8_t(b[3])) << 24);
+	}
+
+	void write_uint32(std::uint32_t const v, char* b)
+	{
+		b[0] = char(v & 0xff);
+		b[1] = char((v >> 8) & 0xff);
+		b[2] = char((v >> 16) & 0xff);
+		b[3] = char((v >> 24) & 0xff);
+	}
+
+	// the crc32c in this tree operates on whole 64 bit words, so the record
+	// is checksummed with zero-padding up to the next word boundary
+	std::uint32_t record_crc(span<char const> const header, span<char const> payload)
+	{
+		std::vector<std::uint64_t> words(
+			std::size_t(header.size() + payload.size() + 7) / 8, 0);
+		char* dst = reinterpret_cast<char*>(words.data());
+		std::memcpy(dst, header.data(), std::size_t(header.size()));
+		std::memcpy(dst + header.size(), payload.data(), std::size_t(payload.size()));
+		return crc32c(words.data(), int(words.size()));
+	}
+
+	aux::file_pointer open_journal(std::string const& path, error_code& ec)
+	{
+#ifdef TORRENT_WINDOWS
+		FILE* f = ::_wfopen(convert_to_native_path_string(path).c_str(), L"rb+");
+#else
+		FILE* f = std::fopen(path.c_str(), "rb+");
+#endif
+		if (f == nullptr && errno == ENOENT)
+		{
+			// create the journal
+#ifdef TORRENT_WINDOWS
+			f = ::_wfopen(convert_to_native_path_string(path).c_str(), L"wb+");
+#else
+			f = std::fopen(path.c_str(), "wb+");
+#endif
+		}
+		if (f == nullptr) ec.assign(errno, generic_category());
+		return aux::file_pointer(f);
+	}
+} // anonymous namespace
+
+	resume_data_store::resume_data_store() = default;
+	resume_data_store::~resume_data_store() = default;
+
+	void resume_data_store::open(std::string const& path, error_code& ec)
+	{
+		close();
+		ec.clear();
+		aux::file_pointer f = open_journal(path, ec);
+		if (ec) return;
+		m_file = std::move(f);
+		m_path = path;
+		load(ec);
+		if (ec) close();
+	}
+
+	void resume_data_store::close()
+	{
+		if (m_file.file() != nullptr) std::fflush(m_file.file());
+		m_file = aux::file_pointer(nullptr);
+		m_path.clear();
+		m_index.clear();
+		m_file_size = 0;
+		m_dead_bytes = 0;
+	}
+
+	void resume_data_store::load(error_code& ec)
+	{
+		FILE* const f = m_file.file();
+
+		char tag[tag_size];
+		std::size_t const tag_read = std::fread(tag, 1, tag_size, f);
+		if (tag_read == 0)
+		{
+			// brand new journal, write the tag
+			if (std::fwrite(journal_tag, 1, tag_size, f) != tag_size)
+			{
+				ec.assign(errno, generic_category());
+				return;
+			}
+			std::fflush(f);
+			m_file_size = tag_size;
+			return;
+		}
+		if (tag_read != tag_size || std::memcmp(tag, journal_tag, tag_size) != 0)
+		{
+			ec = errors::invalid_file_tag;
+			return;
+		}
+
+		std::int64_t pos = tag_size;
+		std::vector<char> buf;
+		for (;;)
+		{
+			char header[record_header_size];
+			std::size_t const n = std::fread(header, 1, record_header_size, f);
+			if (n == 0) break;
+
+			std::uint8_t const type = std::uint8_t(header[0]);
+			std::int32_t const len = std::int32_t(read_uint32(header + 1));
+			if (n != record_header_size
+				|| (type != record_put && type != record_remove)
+				|| len < 0 || len > max_payload
+				|| (type == record_remove && len != 0))
+			{
+				// torn or corrupt tail record (e.g. from a crash
+				// mid-append). Drop it and everything after it
+				break;
+			}
+
+			buf.resize(std::size_t(len) + 4);
+			if (std::fread(buf.data(), 1, buf.size(), f) != buf.size())
+				break;
+
+			std::uint32_t const crc = read_uint32(buf.data() + len);
+			if (crc != record_crc({header, record_header_size}, {buf.data(), len}))
+				break;
+
+			info_hash_t ih;
+			std::memcpy(ih.v1.data(), header + 5, 20);
+			std::memcpy(ih.v2.data(), header + 25, 32);
+
+			auto const it = m_index.find(ih);
+			if (it != m_index.end())
+			{
+				m_dead_bytes += record_overhead + it->second.length;
+				m_index.erase(it);
+			}
+			if (type == record_put)
+			{
+				m_index.insert({ih, {pos, len}});
+			}
+			else
+			{
+				// the tombstone itself is dead weight until compaction
+				m_dead_bytes += record_overhead;
+			}
+			pos += record_overhead + len;
+		}
+
+		// everything from pos onwards is a torn record (or garbage). Truncate
+		// it away so the next append produces a well-formed journal
+		m_file_size = pos;
+#ifdef TORRENT_WINDOWS
+		::_chsize_s(::_fileno(f), pos);
+#else
+		if (::ftruncate(::fileno(f), pos) != 0)
+		{
+			ec.assign(errno, generic_category());
+			return;
+		}
+#endif
+	}
+
+	void resume_data_store::append_record(std::uint8_t const type
+		, info_hash_t const& ih, span<char const> const buf, error_code& ec)
+	{
+		FILE* const f = m_file.file();
+
+		char header[record_header_size];
+		header[0] = char(type);
+		write_uint32(std::uint32_t(buf.size()), header + 1);
+		std::memcpy(header + 5, ih.v1.data(), 20);
+		std::memcpy(header + 25, ih.v2.data(), 32);
+
+		char crc[4];
+		write_uint32(record_crc({header, record_header_size}, buf), crc);
+
+		if (std::fseek(f, 0, SEEK_END) != 0
+			|| std::fwrite(header, 1, record_header_size, f) != record_header_size
+			|| (!buf.empty()
+				&& std::fwrite(buf.data(), 1, std::size_t(buf.size()), f)
+					!= std::size_t(buf.size()))
+			|| std::fwrite(crc, 1, 4, f) != 4
+			|| std::fflush(f) != 0)
+		{
+			ec.assign(errno, generic_category());
+			return;
+		}
+	}
+
+	void resume_data_store::put(info_hash_t const& ih, span<char const> const buf
+		, error_code& ec)
+	{
+		ec.clear();
+		if (!is_open()) return;
+
+		std::int64_t const pos = m_file_size;
+		append_record(record_put, ih, buf, ec);
+		if (ec) return;
+		m_file_size += record_overhead + buf.size();
+
+		auto const it = m_index.find(ih);
+		if (it != m_index.end())
+		{
+			m_dead_bytes += record_overhead + it->second.length;
+			it->second = {pos, std::int32_t(buf.size())};
+		}
+		else
+		{
+			m_index.insert({ih, {pos, std::int32_t(buf.size())}});
+		}
+
+		// reclaim dead bytes once they dominate the journal, so the file
+		// size stays proportional to the live records. The absolute floor
+		// keeps small stores from compacting all the time. The append above
+		// already succeeded; a failed opportunistic compaction leaves the
+		// journal as it was and is not an error of this put
+		if (m_dead_bytes > 1024 * 1024 && m_dead_bytes * 2 > m_file_size)
+		{
+			error_code ignore;
+			compact(ignore);
+		}
+	}
+
+	void resume_data_store::remove(info_hash_t const& ih, error_code& ec)
+	{
+		ec.clear();
+		if (!is_open()) return;
+
+		auto const it = m_index.find(ih);
+		if (it == m_index.end()) return;
+
+		append_record(record_remove, ih, {}, ec);
+		if (ec) return;
+		m_file_size += record_overhead;
+		m_dead_bytes += 2 * record_overhead + it->second.length;
+		m_index.erase(it);
+	}
+
+	std::vector<char> resume_data_store::get(info_hash_t const& ih, error_code& ec)
+	{
+		ec.clear();
+		auto const it = m_index.find(ih);
+		if (it == m_index.end())
+		{
+			ec = make_error_code(boost::system::errc::no_such_file_or_directory);
+			return {};
+		}
+
+		FILE* const f = m_file.file();
+		int const len = it->second.length;
+		std::vector<char> rec(std::size_t(record_overhead + len));
+		if (fseeko(f, it->second.offset, SEEK_SET) != 0
+			|| std::fread(rec.data(), 1, rec.size(), f) != rec.size())
+		{
+			ec.assign(errno, generic_category());
+			return {};
+		}
+
+		// validate the record checksum before handing the blob out. If the
+		// file was damaged on disk (or the index is out of sync with it),
+		// returning the bytes would silently hand corruption to the caller.
+		// Treat it as a miss instead
+		std::uint32_t const crc = read_uint32(rec.data() + record_header_size + len);
+		if (crc != record_crc({rec.data(), record_header_size}
+			, {rec.data() + record_header_size, len}))
+		{
+			ec = make_error_code(boost::system::errc::no_such_file_or_directory);
+			return {};
+		}
+
+		rec.erase(rec.begin(), rec.begin() + record_header_size);
+		rec.resize(std::size_t(len));
+		return rec;
+	}
+
+	void resume_data_store::for_each(std::function<void(info_hash_t const&
+		, std::vector<char>)> const& f, error_code& ec)
+	{
+		ec.clear();
+
+		// visit the records in file order, so the load is one sequential
+		// sweep of the journal
+		std::vector<std::pair<std::int64_t, info_hash_t>> order;
+		order.reserve(m_index.size());
+		for (auto const& e : m_index)
+			order.emplace_back(e.second.offset, e.first);
+		std::sort(order.begin(), order.end()
+			, [](std::pair<std::int64_t, info_hash_t> const& lhs
+				, std::pair<std::int64_t, info_hash_t> const& rhs)
+			{ return lhs.first < rhs.first; });
+
+		for (auto const& e : order)
+		{
+			std::vector<char> blob = get(e.second, ec);
+			if (ec) return;
+			f(e.second, std::move(blob));
+		}
+	}
+
+	void resume_data_store::flush(error_code& ec)
+	{
+		ec.clear();
+		if (!is_open()) return;
+		if (std::fflush(m_file.file()) != 0)
+		{
+			ec.assign(errno, generic_category());
+			return;
+		}
+#ifdef TORRENT_WINDOWS
+		if (::_commit(::_fileno(m_file.file())) != 0)
+#else
+		if (::fsync(::fileno(m_file.file())) != 0)
+#endif
+		{
+			ec.assign(errno, generic_category());
+		}
+	}
+
+	void resume_data_store::compact(error_code& ec)
+	{
+		ec.clear();
+		if (!is_open()) return;
+
+		std::string const tmp_path = m_path + ".tmp";
+
+		// staging area for the new offsets. The live index must keep
+		// pointing into the old journal until the tmp file is complete and
+		// swapped in; if the copy fails part-way we return with the old
+		// journal still in place, and the index must still match it
+		std::map<info_hash_t, std::int64_t> new_offsets;
+		std::int64_t new_pos = tag_size;
+		{
+			aux::file_pointer tmp = open_journal(tmp_path, ec);
+			if (ec) return;
+
+			// records are self-contained, so compaction is a verbatim copy
+			// of the live ones, in file order, into a fresh journal
+			if (std::fseek(tmp.file(), 0, SEEK_SET) != 0
+				|| std::fwrite(journal_tag, 1, tag_size, tmp.file()) != tag_size)
+			{
+				ec.assign(errno, generic_category());
+				return;
+			}
+
+			std::vector<std::pair<std::int64_t, info_hash_t>> order;
+			order.reserve(m_index.size());
+			for (auto const& e : m_index)
+				order.emplace_back(e.second.offset, e.first);
+			std::sort(order.begin(), order.end()
+				, [](std::pair<std::int64_t, info_hash_t> const& lhs
+					, std::pair<std::int64_t, info_hash_t> const& rhs)
+				{ return lhs.first < rhs.first; });
+
+			std::vector<char> buf;
+			for (auto const& e : order)
+			{
+				auto const it = m_index.find(e.second);
+				buf.resize(std::size_t(record_overhead + it->second.length));
+				if (fseeko(m_file.file(), it->second.offset, SEEK_SET) != 0
+					|| std::fread(buf.data(), 1, buf.size(), m_file.file()) != buf.size()
+					|| std::fwrite(buf.data(), 1, buf.size(), tmp.file()) != buf.size())
+				{
+					ec.assign(errno, generic_category());
+					return;
+				}
+				new_offsets[e.second] = new_pos;
+				new_pos += std::int64_t(buf.size());
+			}
+
+			if (std::fflush(tmp.file()) != 0)
+			{
+				ec.assign(errno, generic_category());
+				return;
+			}
+#ifdef TORRENT_WINDOWS
+			::_commit(::_fileno(tmp.file()));
+#else
+			::fsync(::fileno(tmp.file()));
+#endif
+
+			// close both files before the rename; Windows can't replace an
+			// open file
+			m_file = aux::file_pointer(nullptr);
+		}
+
+		rename(tmp_path, m_path, ec);
+		if (ec)
+		{
+			// the old journal is still in place and the index still
+			// describes it; reopen it and carry on uncompacted
+			error_code ignore;
+			m_file = open_journal(m_path, ignore);
+			return;
+		}
+
+		// the compacted journal is in place, install the new layout
+		for (auto& e : m_index)
+			e.second.offset = new_offsets[e.first];
+		m_file_size = new_pos;
+		m_dead_bytes = 0;
+
+		m_file = open_journal(m_path, ec);
+	}
+}
@@ -234,6 +234,11 @@ namespace libtorrent {
 		async_call(&session_impl::post_dht_stats);
 	}
 
+	void session_handle::save_all_resume_data(resume_data_flags_t const flags)
+	{
+		async_call(&session_impl::save_all_resume_data, flags);
+	}
+
 	io_context& session_handle::get_context()
 	{
 		std::shared_ptr<session_impl> s = m_impl.lock();
@@ -483,6 +488,37 @@ namespace {
 		guard.disarm();
 	}
 
+	void session_handle::async_add_torrents(std::vector<add_torrent_params> params)
+	{
+		// do all the per-torrent preparation up front, in the calling
+		// thread, then hand the whole batch to the session thread in one
+		// post
+		for (auto& p : params)
+		{
+			TORRENT_ASSERT_PRECOND(!p.save_path.empty());
+
+#if TORRENT_ABI_VERSION < 3
+			p.info_hash = p.info_hashes.get_best();
+#endif
+
+			// the internal torrent object keeps and mutates state in the
+			// torrent_info object. We can't let that leak back to the client
+			if (p.ti)
+				p.ti = std::make_shared<torrent_info>(*p.ti);
+
+			p.save_path = complete(p.save_path);
+
+#if TORRENT_ABI_VERSION == 1
+			handle_backwards_compatible_resume_data(p);
+#endif
+		}
+
+		auto* v = new std::vector<add_torrent_params>(std::move(params));
+		auto guard = aux::scope_end([v]{ delete v; });
+		async_call(&session_impl::async_add_torrents, v);
+		guard.disarm();
+	}
+
 #ifndef BOOST_NO_EXCEPTIONS
 #if TORRENT_ABI_VERSION == 1
 	// if the torrent already exists, this will throw duplicate_torrent
@@ -58,6 +58,10 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <unordered_set>
 #endif
 
+#ifndef TORRENT_WINDOWS
+#include <sys/resource.h> // for getrusage()
+#endif
+
 #include "libtorrent/aux_/disable_warnings_push.hpp"
 #include <boost/asio/ts/internet.hpp>
 #include <boost/asio/ts/executor.hpp>
@@ -539,18 +543,20 @@ bool ssl_server_name_callback(ssl::stream_handle_type stream_handle, std::string
 			std::bind(&session_impl::send_udp_packet, this, _1, _2, _3, _4, _5)
 			, [this](socket_type s) { this->incoming_connection(std::move(s)); }
 			, m_io_context
-			, m_settings, m_stats_counters, nullptr)
+			, m_settings, m_stats_counters, m_utp_packet_pool, nullptr)
 #ifdef TORRENT_SSL_PEERS
 		, m_ssl_utp_socket_manager(
 			std::bind(&session_impl::send_udp_packet, this, _1, _2, _3, _4, _5)
 			, std::bind(&session_impl::on_incoming_utp_ssl, this, _1)
 			, m_io_context
 			, m_settings, m_stats_counters
+			, m_utp_packet_pool
 			, &m_peer_ssl_ctx)
 #endif
 		, m_timer(m_io_context)
 		, m_lsd_announce_timer(m_io_context)
 		, m_close_file_timer(m_io_context)
+		, m_ip_change_timer(m_io_context)
 		, m_paused(flags & session::paused)
 	{
 	}
@@ -589,10 +595,18 @@ bool ssl_server_name_callback(ssl::stream_handle_type stream_handle, std::string
 #if TORRENT_USE_SSL
 		error_code ec;
 		m_ssl_ctx.set_default_verify_paths(ec);
+		// resume earlier TLS sessions with HTTPS trackers and web seeds
+		// instead of paying a full handshake on every announce
+		ssl::enable_client_session_cache(m_ssl_ctx);
 #endif
 #ifdef TORRENT_SSL_PEERS
 		m_peer_ssl_ctx.set_verify_mode(ssl::context::verify_none, ec);
 		ssl::set_server_name_callback(ssl::get_handle(m_peer_ssl_ctx), ssl_server_name_callback, this, ec);
+#ifdef SSL_OP_ENABLE_KTLS
+		// offload bulk record encryption for incoming SSL peer connections
+		// to the kernel, where supported. See torrent::init_ssl()
+		m_peer_ssl_ctx.set_options(SSL_OP_ENABLE_KTLS, ec);
+#endif
 #endif // TORRENT_SSL_PEERS
 
 #ifndef TORRENT_DISABLE_DHT
@@ -600,6 +614,10 @@ bool ssl_server_name_callback(ssl::stream_handle_type stream_handle, std::string
 #endif
 		m_next_lsd_torrent = 0;
 
+		// report which SHA-1 implementation this host ended up with, so
+		// it can be monitored across a fleet
+		m_stats_counters.set_value(counters::sha1_backend, aux::sha1_backend());
+
 		m_global_class = m_classes.new_peer_class("global");
 		m_tcp_peer_class = m_classes.new_peer_class("tcp");
 		m_local_peer_class = m_classes.new_peer_class("local");
@@ -996,6 +1014,7 @@ bool ssl_server_name_callback(ssl::stream_handle_type stream_handle, std::string
 		m_host_resolver.abort();
 
 		m_close_file_timer.cancel();
+		m_ip_change_timer.cancel();
 
 		// abort the main thread
 		m_abort = true;
@@ -1708,6 +1727,41 @@ namespace {
 
 			if (bind_ep.port() == 0) bind_ep = ret->local_endpoint;
 
+#ifdef TCP_FASTOPEN
+			{
+				// enable TCP fast open, so reconnecting peers holding a
+				// valid cookie can carry the start of the bittorrent
+				// handshake in their SYN. this is best-effort. ignore errors
+				error_code err;
+				ret->sock->set_option(tcp_fastopen(
+					m_settings.get_int(settings_pack::listen_queue_size)), err);
+#ifndef TORRENT_DISABLE_LOGGING
+				if (err && should_log())
+				{
+					session_log("failed to enable TCP fast open on listen socket: %s"
+						, err.message().c_str());
+				}
+#endif // TORRENT_DISABLE_LOGGING
+			}
+#endif // TCP_FASTOPEN
+
+#ifdef TCP_DEFER_ACCEPT
+			{
+				// the connecting peer always talks first, so there's no
+				// point in waking up the accept loop until its initial
+				// bytes have arrived. this is best-effort. ignore errors
+				error_code err;
+				ret->sock->set_option(tcp_defer_accept(1), err);
+#ifndef TORRENT_DISABLE_LOGGING
+				if (err && should_log())
+				{
+					session_log("failed to enable deferred accept on listen socket: %s"
+						, err.message().c_str());
+				}
+#endif // TORRENT_DISABLE_LOGGING
+			}
+#endif // TCP_DEFER_ACCEPT
+
 			ret->sock->listen(m_settings.get_int(settings_pack::listen_queue_size), ec);
 			last_op = operation_t::sock_listen;
 
@@ -1890,9 +1944,79 @@ namespace {
 		if (ec || m_abort || !m_ip_notifier) return;
 		m_ip_notifier->async_wait([this] (error_code const& e)
 			{ wrap(&session_impl::on_ip_change, e); });
+
+		// the set of local IPs changed, the cached interface and route
+		// enumerations are stale
+		m_net_interfaces_cached = false;
+		m_net_routes_cached = false;
+
+		// a flapping interface (e.g. a VPN reconnecting) posts a burst of
+		// change events. Instead of tearing down and rebinding the listen
+		// sockets for each one, wait for the interface set to settle.
+		// scheduling the timer again postpones the deadline, collapsing the
+		// whole burst into one rebind
+		m_ip_change_timer.expires_after(milliseconds(500));
+		ADD_OUTSTANDING_ASYNC("session_impl::on_ip_change_settled");
+		m_ip_change_timer.async_wait([this] (error_code const& e)
+			{ wrap(&session_impl::on_ip_change_settled, e); });
+	}
+
+	void session_impl::on_ip_change_settled(error_code const& ec)
+	{
+		COMPLETE_ASYNC("session_impl::on_ip_change_settled");
+		// operation_aborted means the timer was rescheduled by a newer
+		// change event, or we're shutting down
+		if (ec || m_abort) return;
+
+		// if the interfaces we can listen on are the same as when we last
+		// (re)opened the listen sockets, the change was a no-op (or undone
+		// itself within the settle window) and the sockets can be left alone
+		error_code err;
+		std::vector<ip_interface> const& ifs = net_interfaces(err);
+		std::vector<std::pair<std::string, address>> if_state;
+		if (!err)
+		{
+			if_state.reserve(ifs.size());
+			for (auto const& ipf : ifs)
+				if_state.emplace_back(ipf.name, ipf.interface_address);
+			std::sort(if_state.begin(), if_state.end());
+			if (if_state == m_last_if_state)
+			{
+#ifndef TORRENT_DISABLE_LOGGING
+				session_log("ip change settled with no actual interface change, not rebinding");
+#endif
+				return;
+			}
+		}
+		m_last_if_state = std::move(if_state);
+
 		reopen_network_sockets({});
 	}
 
+	std::vector<ip_interface> const& session_impl::net_interfaces(error_code& ec)
+	{
+		ec.clear();
+		// without the ip_notifier running there's nothing to invalidate the
+		// cache, so don't trust it
+		if (!m_ip_notifier || !m_net_interfaces_cached)
+		{
+			m_net_interfaces_cache = enum_net_interfaces(m_io_context, ec);
+			m_net_interfaces_cached = bool(m_ip_notifier) && !ec;
+		}
+		return m_net_interfaces_cache;
+	}
+
+	std::vector<ip_route> const& session_impl::net_routes(error_code& ec)
+	{
+		ec.clear();
+		if (!m_ip_notifier || !m_net_routes_cached)
+		{
+			m_net_routes_cache = enum_routes(m_io_context, ec);
+			m_net_routes_cached = bool(m_ip_notifier) && !ec;
+		}
+		return m_net_routes_cache;
+	}
+
 	// TODO: could this function be merged with expand_unspecified_addresses?
 	// right now both listen_endpoint_t and listen_interface_t are almost
 	// identical, maybe the latter could be removed too
@@ -1971,13 +2095,13 @@ namespace {
 		}
 		else
 		{
-			std::vector<ip_interface> const ifs = enum_net_interfaces(m_io_context, ec);
+			std::vector<ip_interface> const& ifs = net_interfaces(ec);
 			if (ec && m_alerts.should_post<listen_failed_alert>())
 			{
 				m_alerts.emplace_alert<listen_failed_alert>(""
 					, operation_t::enum_if, ec, socket_type_t::tcp);
 			}
-			auto const routes = enum_routes(m_io_context, ec);
+			auto const& routes = net_routes(ec);
 			if (ec && m_alerts.should_post<listen_failed_alert>())
 			{
 				m_alerts.emplace_alert<listen_failed_alert>(""
@@ -2324,6 +2448,7 @@ namespace {
 		auto& s = boost::get<i2p_stream>(*m_i2p_listen_socket);
 		s.set_command(i2p_stream::cmd_accept);
 		s.set_session_id(m_i2p_conn.session_id());
+		m_i2p_conn.take_warm_socket(s);
 
 		s.async_connect(tcp::endpoint()
 			, std::bind(&session_impl::on_i2p_accept, this, _1));
@@ -2440,6 +2565,7 @@ namespace {
 		, std::weak_ptr<listen_socket_t> ls, transport const ssl, error_code const& ec)
 	{
 		COMPLETE_ASYNC("session_impl::on_udp_packet");
+		aux::update_time_now();
 		if (ec)
 		{
 			std::shared_ptr<session_udp_socket> s = socket.lock();
@@ -2482,7 +2608,7 @@ namespace {
 
 		for (;;)
 		{
-			aux::array<udp_socket::packet, 50> p;
+			aux::array<udp_socket::packet, udp_socket::max_packets_per_read> p;
 			error_code err;
 			int const num_packets = s->sock.read(p, err);
 
@@ -2621,6 +2747,7 @@ namespace {
 		, std::weak_ptr<tcp::acceptor> listen_socket, transport const ssl)
 	{
 		COMPLETE_ASYNC("session_impl::on_accept_connection");
+		aux::update_time_now();
 		m_stats_counters.inc_stats_counter(counters::on_accept_counter);
 		m_stats_counters.inc_stats_counter(counters::num_outstanding_accept, -1);
 
@@ -3258,7 +3385,7 @@ namespace {
 
 		TORRENT_ASSERT(is_single_thread());
 
-		time_point const now = aux::time_now();
+		time_point const now = aux::update_time_now();
 
 		// remove undead peers that only have this list as their reference keeping them alive
 		if (!m_undead_peers.empty())
@@ -3320,6 +3447,35 @@ namespace {
 			std::abort();
 		}
 
+		// how late the tick timer fired. A large lag means some event
+		// handler stalled the network thread, which degrades everything the
+		// session does. Record it in the log-scale histogram and, past the
+		// configured threshold, tell the client via a performance warning.
+		// The first tick is posted directly, before the timer is ever
+		// scheduled; its expiry is still at the epoch, so skip it
+		if (!e && m_timer.expiry() > time_point())
+		{
+			std::int64_t const lag_us = std::max<std::int64_t>(0
+				, total_microseconds(now - m_timer.expiry()));
+			int bucket = 0;
+			std::int64_t threshold = 1000;
+			while (bucket < 6 && lag_us >= threshold)
+			{
+				threshold *= 4;
+				++bucket;
+			}
+			m_stats_counters.inc_stats_counter(counters::tick_lag_1ms + bucket);
+
+			int const stall_threshold = m_settings.get_int(settings_pack::tick_lag_warning_threshold);
+			if (stall_threshold > 0
+				&& lag_us >= std::int64_t(stall_threshold) * 1000
+				&& m_alerts.should_post<performance_alert>())
+			{
+				m_alerts.emplace_alert<performance_alert>(torrent_handle()
+					, performance_alert::network_thread_stalled);
+			}
+		}
+
 		ADD_OUTSTANDING_ASYNC("session_impl::on_tick");
 		milliseconds const tick_interval(m_abort ? 100 : m_settings.get_int(settings_pack::tick_interval));
 		m_timer.expires_at(now + tick_interval);
@@ -3336,6 +3492,10 @@ namespace {
 		m_ssl_utp_socket_manager.tick(now);
 #endif
 
+		// deliver any user notification held back by the coalescing batch
+		// whose max-delay deadline has passed
+		m_alerts.flush_pending_notify();
+
 		// only tick the following once per second
 		if (now - m_last_second_tick < seconds(1)) return;
 
@@ -3346,10 +3506,7 @@ namespace {
 			update_dht_announce_interval();
 #endif
 
-		m_utp_socket_manager.decay();
-#ifdef TORRENT_SSL_PEERS
-		m_ssl_utp_socket_manager.decay();
-#endif
+		m_utp_packet_pool.decay();
 
 		int const tick_interval_ms = aux::numeric_cast<int>(total_milliseconds(now - m_last_second_tick));
 		m_last_second_tick = now;
@@ -3382,6 +3539,8 @@ namespace {
 		// don't do any of the following while we're shutting down
 		if (m_abort) return;
 
+		update_autotune(now);
+
 		switch (m_settings.get_int(settings_pack::mixed_mode_algorithm))
 		{
 			case settings_pack::prefer_tcp:
@@ -3719,6 +3878,19 @@ namespace {
 
 		TORRENT_ASSERT(m_dht);
 
+		// if the DHT is already running as many lookups as we allow, don't
+		// queue more announces up behind them. Check back shortly instead of
+		// advancing the rotation
+		int const max_lookups = m_settings.get_int(settings_pack::dht_max_concurrent_lookups);
+		if (max_lookups > 0 && m_dht->num_active_lookups() >= max_lookups)
+		{
+			ADD_OUTSTANDING_ASYNC("session_impl::on_dht_announce");
+			m_dht_announce_timer.expires_after(seconds(1));
+			m_dht_announce_timer.async_wait([this](error_code const& err)
+				{ wrap(&session_impl::on_dht_announce, err); });
+			return;
+		}
+
 		// announce to DHT every 15 minutes
 		int delay = std::max(m_settings.get_int(settings_pack::dht_announce_interval)
 			/ std::max(int(m_torrents.size()), 1), 1);
@@ -3873,6 +4045,17 @@ namespace {
 		return v;
 	}
 
+	// this recomputes the active/queued partition from scratch, but the
+	// cost is bounded in several ways: triggers are coalesced and debounced
+	// to at most one pass per second (trigger_auto_manage()), only the
+	// auto-managed torrents appear in the per-state lists copied below,
+	// and the sorts are partial_sort bounded by the respective active
+	// limits, so the pass is O(n log k) in pointer-sized elements rather
+	// than a full sort. Maintaining the partition incrementally would not
+	// work well for seeds in particular: seed_rank() is a function of
+	// elapsed time and transfer ratios, so the ordering decays on its own
+	// and has to be re-evaluated each pass no matter what structure holds
+	// it
 	void session_impl::recalculate_auto_managed_torrents()
 	{
 		INVARIANT_CHECK;
@@ -4159,9 +4342,40 @@ namespace {
 		if (num_connections() >= m_settings.get_int(settings_pack::connections_limit))
 			return;
 
+		int const base_speed = m_settings.get_int(settings_pack::connection_speed);
+
+		// adapt the attempt rate to how recent attempts have been faring.
+		// As long as connect timeouts stay rare, probe additively above
+		// connection_speed (a fast box re-establishing a large swarm after
+		// a restart can sustain far more than the configured rate). When
+		// timeouts spike (a consumer NAT running out of connection state,
+		// or an overloaded uplink dropping SYNs) back off multiplicatively,
+		// below the configured rate if need be
+		std::int64_t const attempts = m_stats_counters[counters::connection_attempts];
+		std::int64_t const timeouts = m_stats_counters[counters::connect_timeouts];
+		std::int64_t const attempt_delta = attempts - m_last_connect_attempts;
+		std::int64_t const timeout_delta = timeouts - m_last_connect_timeouts;
+		m_last_connect_attempts = attempts;
+		m_last_connect_timeouts = timeouts;
+
+		int const min_rate = std::max(1, base_speed / 4);
+		int const max_rate = std::max(base_speed, base_speed * 4);
+		if (m_connect_rate == 0) m_connect_rate = base_speed;
+		m_connect_rate = std::min(std::max(m_connect_rate, min_rate), max_rate);
+		if (timeout_delta > 0 && timeout_delta * 4 > attempt_delta)
+			m_connect_rate = std::max(min_rate, m_connect_rate / 2);
+		else if (attempt_delta > 0 && timeout_delta * 20 <= attempt_delta)
+			m_connect_rate = std::min(max_rate, m_connect_rate + std::max(1, base_speed / 4));
+
+		// the attempt quota is a token bucket refilled at m_connect_rate
+		// per second. Unspent attempts (e.g. from a tick where no torrent
+		// had connect candidates yet) carry over, capped at one extra
+		// second's worth
+		m_connect_quota = std::min(m_connect_quota + m_connect_rate, 2 * m_connect_rate);
+
 		// this is the maximum number of connections we will
 		// attempt this tick
-		int max_connections = m_settings.get_int(settings_pack::connection_speed);
+		int max_connections = m_connect_quota;
 
 		// this loop will "hand out" connection_speed to the torrents, in a round
 		// robin fashion, so that every torrent is equally likely to connect to a
@@ -4183,6 +4397,8 @@ namespace {
 				max_connections -= m_boost_connections;
 				m_boost_connections = 0;
 			}
+			// boost connections drain the token bucket too
+			m_connect_quota = max_connections;
 		}
 
 		// zero connections speeds are allowed, we just won't make any connections
@@ -4262,6 +4478,7 @@ namespace {
 			if (t->try_connect_peer())
 			{
 				--max_connections;
+				--m_connect_quota;
 				steps_since_last_connect = 0;
 				m_stats_counters.inc_stats_counter(counters::connection_attempts);
 			}
@@ -4473,6 +4690,16 @@ namespace {
 		m_torrents.insert(t->torrent_file().info_hashes(), t);
 	}
 
+	// queue positions are dense indexes into m_download_queue, cached on
+	// each torrent. A move only renumbers the torrents between the old and
+	// the new position, so a single move is O(distance). Backing this with
+	// an order-statistics tree would make moves O(log n), but every
+	// *read* of a position would become O(log n) too, and positions are
+	// read far more often than they change: the auto-manager sorts by
+	// them on every recalculation pass, and every status update reports
+	// them. Clients reordering a large queue wholesale should move
+	// torrents starting from the smallest target position, which keeps
+	// each shifted range short instead of O(queue length)
 	void session_impl::set_queue_position(torrent* me, queue_position_t p)
 	{
 		queue_position_t const current_pos = me->queue_position();
@@ -4705,6 +4932,41 @@ namespace {
 		m_stats_counters.set_value(counters::limiter_down_bytes
 			, m_download_rate.queued_bytes());
 
+		{
+			std::int64_t picker_mem = 0;
+			std::int64_t peer_list_mem = 0;
+			std::int64_t metadata_mem = 0;
+			for (auto const& t : m_torrents)
+			{
+				picker_mem += t->picker_memory_usage();
+				peer_list_mem += t->peer_list_memory_usage();
+				metadata_mem += t->metadata_memory_usage();
+			}
+			m_stats_counters.set_value(counters::picker_memory, picker_mem);
+			m_stats_counters.set_value(counters::peer_list_memory, peer_list_mem);
+			m_stats_counters.set_value(counters::metadata_memory, metadata_mem);
+		}
+
+#ifndef TORRENT_WINDOWS
+		{
+			struct ::rusage ru {};
+			if (::getrusage(RUSAGE_SELF, &ru) == 0)
+			{
+				m_stats_counters.set_value(counters::minor_page_faults, ru.ru_minflt);
+				m_stats_counters.set_value(counters::major_page_faults, ru.ru_majflt);
+			}
+		}
+#endif
+
+		// each snapshot carries the full counter array. A delta encoding
+		// (only counters changed since the last snapshot, with periodic
+		// keyframes) would shrink the payload considerably for frequent
+		// polling, but the flat array is a documented public format
+		// (clients index it via session_stats_metrics(), and
+		// tools/parse_session_stats.py parses it), the copy is a few kiB
+		// into the alert's stack allocator, and a stateful encoding breaks
+		// as soon as a snapshot is dropped by the alert queue limit. Any
+		// compaction belongs in the telemetry consumer
 		m_alerts.emplace_alert<session_stats_alert>(m_stats_counters);
 	}
 
@@ -4734,6 +4996,20 @@ namespace {
 #endif
 	}
 
+	void session_impl::save_all_resume_data(resume_data_flags_t const flags)
+	{
+		INVARIANT_CHECK;
+		TORRENT_ASSERT(is_single_thread());
+
+		// one pass over all torrents posts all the resume data alerts,
+		// instead of one cross-thread call per torrent_handle. The alerts
+		// stream out as they are generated, so the client can encode and
+		// write them from its own thread(s) while this loop (and whatever
+		// teardown follows it) is still running
+		for (auto const& te : m_torrents)
+			te->save_resume_data(flags);
+	}
+
 	std::vector<torrent_handle> session_impl::get_torrents() const
 	{
 		std::vector<torrent_handle> ret;
@@ -4758,6 +5034,16 @@ namespace {
 		add_torrent(std::move(*params), ec);
 	}
 
+	void session_impl::async_add_torrents(std::vector<add_torrent_params>* params)
+	{
+		std::unique_ptr<std::vector<add_torrent_params>> holder(params);
+		for (auto& p : *params)
+		{
+			error_code ec;
+			add_torrent(std::move(p), ec);
+		}
+	}
+
 #ifndef TORRENT_DISABLE_EXTENSIONS
 	void session_impl::add_extensions_to_torrent(
 		std::shared_ptr<torrent> const& torrent_ptr, client_data_t const userdata)
@@ -6583,12 +6869,133 @@ namespace {
 		}
 	}
 
+	void session_impl::update_autotune_state()
+	{
+		// toggling the tuner (re-)captures the baselines on the next round,
+		// so the currently configured values become the new bounds
+		m_next_autotune = min_time();
+	}
+
+	void session_impl::update_autotune(time_point const now)
+	{
+		if (!m_settings.get_bool(settings_pack::enable_autotune)) return;
+		if (m_next_autotune != min_time() && now < m_next_autotune) return;
+
+		bool const first_round = (m_next_autotune == min_time());
+		m_next_autotune = now + seconds(std::max(1
+			, m_settings.get_int(settings_pack::autotune_interval)));
+
+		std::int64_t ticks = 0;
+		for (int i = counters::tick_lag_1ms; i <= counters::tick_lag_inf; ++i)
+			ticks += m_stats_counters[i];
+		std::int64_t slow_ticks = 0;
+		for (int i = counters::tick_lag_64ms; i <= counters::tick_lag_inf; ++i)
+			slow_ticks += m_stats_counters[i];
+		std::int64_t const stalls = m_stats_counters[counters::num_send_buffer_stalls];
+
+		if (first_round)
+		{
+			// capture the operator-configured values. They act as the bounds
+			// the knobs may move within
+			m_autotune_aio_threads_base = std::max(1
+				, m_settings.get_int(settings_pack::aio_threads));
+			m_autotune_watermark_base = std::max(1
+				, m_settings.get_int(settings_pack::send_buffer_watermark));
+			m_autotune_connections_base = std::max(4
+				, m_settings.get_int(settings_pack::connections_limit));
+			m_autotune_ticks_snapshot = ticks;
+			m_autotune_slow_ticks_snapshot = slow_ticks;
+			m_autotune_stalls_snapshot = stalls;
+			return;
+		}
+
+		std::int64_t const d_ticks = ticks - m_autotune_ticks_snapshot;
+		std::int64_t const d_slow_ticks = slow_ticks - m_autotune_slow_ticks_snapshot;
+		std::int64_t const d_stalls = stalls - m_autotune_stalls_snapshot;
+		m_autotune_ticks_snapshot = ticks;
+		m_autotune_slow_ticks_snapshot = slow_ticks;
+		m_autotune_stalls_snapshot = stalls;
+
+		settings_pack pack;
+		bool changed = false;
+		auto adjust = [&](int const name, int const new_value)
+		{
+			int const prev = m_settings.get_int(name);
+			if (prev == new_value) return;
+			pack.set_int(name, new_value);
+			changed = true;
+			if (m_alerts.should_post<autotune_alert>())
+				m_alerts.emplace_alert<autotune_alert>(name, prev, new_value);
+		};
+
+		// disk thread pool: grow while jobs queue up faster than the threads
+		// drain them, shrink back toward the configured value when the queue
+		// stays empty
+		{
+			int const queued = int(m_stats_counters[counters::queued_disk_jobs]);
+			int const cur = m_settings.get_int(settings_pack::aio_threads);
+			if (queued > cur * 4 && cur < m_autotune_aio_threads_base * 3)
+				adjust(settings_pack::aio_threads, cur + 1);
+			else if (queued == 0 && cur > m_autotune_aio_threads_base)
+				adjust(settings_pack::aio_threads, cur - 1);
+		}
+
+		// send buffer watermark: raise while peers drain their send buffers
+		// before the disk refills them, fall back toward the configured
+		// value while they don't
+		{
+			int const cur = m_settings.get_int(settings_pack::send_buffer_watermark);
+			if (d_stalls > 0 && cur < m_autotune_watermark_base * 4)
+			{
+				adjust(settings_pack::send_buffer_watermark
+					, std::min(cur * 2, m_autotune_watermark_base * 4));
+			}
+			else if (d_stalls == 0 && cur > m_autotune_watermark_base)
+			{
+				adjust(settings_pack::send_buffer_watermark
+					, std::max(cur / 2, m_autotune_watermark_base));
+			}
+		}
+
+		// connection limit: back off while the network loop is chronically
+		// late (more than 10% of ticks lagging 64ms or more), recover toward
+		// the configured limit while it's healthy (less than 1%)
+		if (d_ticks > 0)
+		{
+			int const cur = m_settings.get_int(settings_pack::connections_limit);
+			int const step = std::max(1, m_autotune_connections_base / 8);
+			if (d_slow_ticks * 10 > d_ticks
+				&& cur > m_autotune_connections_base / 4)
+			{
+				adjust(settings_pack::connections_limit
+					, std::max(cur - step, m_autotune_connections_base / 4));
+			}
+			else if (d_slow_ticks * 100 < d_ticks
+				&& cur < m_autotune_connections_base)
+			{
+				adjust(settings_pack::connections_limit
+					, std::min(cur + step, m_autotune_connections_base));
+			}
+		}
+
+		if (changed) apply_settings_pack_impl(pack);
+	}
+
 	void session_impl::update_alert_mask()
 	{
 		m_alerts.set_alert_mask(alert_category_t(
 			static_cast<std::uint32_t>(m_settings.get_int(settings_pack::alert_mask))));
 	}
 
+	void session_impl::update_alert_notify_coalescing()
+	{
+		m_alerts.set_notify_coalescing(
+			m_settings.get_int(settings_pack::alert_notify_batch_size)
+			, milliseconds(m_settings.get_int(settings_pack::alert_notify_max_delay))
+			, alert_category_t(static_cast<std::uint32_t>(
+				m_settings.get_int(settings_pack::alert_notify_bypass_categories))));
+	}
+
 	void session_impl::update_validate_https()
 	{
 #if TORRENT_USE_SSL
@@ -6688,6 +7095,10 @@ namespace {
 		m_ip_notifier = create_ip_notifier(m_io_context);
 		m_ip_notifier->async_wait([this](error_code const& e)
 			{ wrap(&session_impl::on_ip_change, e); });
+
+		// anything cached while the notifier wasn't running may be stale
+		m_net_interfaces_cached = false;
+		m_net_routes_cached = false;
 	}
 
 	void session_impl::start_lsd()
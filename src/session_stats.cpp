@@ -163,6 +163,12 @@ namespace {
 		METRIC(peer, num_peers_up_disk)
 		METRIC(peer, num_peers_down_disk)
 
+		// the number of times a peer's send buffer ran dry while requests
+		// were pending and the disk hadn't refilled it yet, i.e. uploads
+		// were capped by send_buffer_watermark rather than by the link or
+		// the peer
+		METRIC(peer, num_send_buffer_stalls)
+
 		// These counters count the number of times the
 		// network thread wakes up for each respective
 		// reason. If these counters are very large, it
@@ -201,6 +207,11 @@ namespace {
 		METRIC(net, limiter_up_bytes)
 		METRIC(net, limiter_down_bytes)
 
+		// the total number of bytes of socket send and receive buffer space
+		// requested by the per-connection buffer autotuning
+		METRIC(net, socket_send_buffer_bytes)
+		METRIC(net, socket_recv_buffer_bytes)
+
 		// the number of bytes downloaded that had to be discarded because they
 		// failed the hash check
 		METRIC(net, recv_failed_bytes)
@@ -335,6 +346,10 @@ namespace {
 
 		METRIC(disk, disk_blocks_in_use)
 
+		// the number of blocks currently held by the in-process read cache,
+		// and the number of read requests served out of it
+		METRIC(disk, disk_read_cache_blocks)
+
 		// ``queued_disk_jobs`` is the number of disk jobs currently queued,
 		// waiting to be executed by a disk thread.
 		METRIC(disk, queued_disk_jobs)
@@ -372,6 +387,8 @@ namespace {
 		// hash a piece (when verifying against the piece hash)
 		METRIC(disk, num_read_back)
 
+		METRIC(disk, num_read_cache_hits)
+
 		// cumulative time spent in various disk jobs, as well
 		// as total for all disk jobs. Measured in microseconds
 		METRIC(disk, disk_read_time)
@@ -379,6 +396,43 @@ namespace {
 		METRIC(disk, disk_hash_time)
 		METRIC(disk, disk_job_time)
 
+		// log-scale latency histograms of completed disk jobs, one set of
+		// buckets per job class. Each bucket counts jobs that completed in
+		// less than the time in its name (the ``inf`` bucket counts the
+		// rest). Useful for graphing disk tail latency
+		METRIC(disk, disk_read_lat_1ms)
+		METRIC(disk, disk_read_lat_4ms)
+		METRIC(disk, disk_read_lat_16ms)
+		METRIC(disk, disk_read_lat_64ms)
+		METRIC(disk, disk_read_lat_256ms)
+		METRIC(disk, disk_read_lat_1s)
+		METRIC(disk, disk_read_lat_inf)
+		METRIC(disk, disk_write_lat_1ms)
+		METRIC(disk, disk_write_lat_4ms)
+		METRIC(disk, disk_write_lat_16ms)
+		METRIC(disk, disk_write_lat_64ms)
+		METRIC(disk, disk_write_lat_256ms)
+		METRIC(disk, disk_write_lat_1s)
+		METRIC(disk, disk_write_lat_inf)
+		METRIC(disk, disk_hash_lat_1ms)
+		METRIC(disk, disk_hash_lat_4ms)
+		METRIC(disk, disk_hash_lat_16ms)
+		METRIC(disk, disk_hash_lat_64ms)
+		METRIC(disk, disk_hash_lat_256ms)
+		METRIC(disk, disk_hash_lat_1s)
+		METRIC(disk, disk_hash_lat_inf)
+
+		// log-scale histogram of how late the network thread's tick timer
+		// fired. Lag in the higher buckets means some event handler stalled
+		// the event loop
+		METRIC(ses, tick_lag_1ms)
+		METRIC(ses, tick_lag_4ms)
+		METRIC(ses, tick_lag_16ms)
+		METRIC(ses, tick_lag_64ms)
+		METRIC(ses, tick_lag_256ms)
+		METRIC(ses, tick_lag_1s)
+		METRIC(ses, tick_lag_inf)
+
 		// for each kind of disk job, a counter of how many jobs of that kind
 		// are currently blocked by a disk fence
 		METRIC(disk, num_fenced_read)
@@ -541,6 +595,29 @@ namespace {
 		// this measure the number of tracker announces currently in the
 		// queue
 		METRIC(tracker, num_queued_tracker_announces)
+
+		// which SHA-1 implementation the hasher dispatches to on this
+		// machine. 0 = built-in portable, 1 = SHA-NI instructions, 2 = ARM
+		// crypto extension, and values 3 and up are the crypto libraries
+		// selected at build time (see aux::sha1_backend_t in hasher.hpp)
+		METRIC(ses, sha1_backend)
+
+		// the approximate number of bytes of heap allocated for piece
+		// picker state, peer list entries and torrent metadata
+		// (torrent_info), summed over all torrents. These are updated
+		// when the session stats are posted
+		METRIC(ses, picker_memory)
+		METRIC(ses, peer_list_memory)
+		METRIC(ses, metadata_memory)
+
+		// the cumulative number of page faults taken by this process, as
+		// reported by the operating system. Minor faults are served from
+		// memory (e.g. first touch of an already-cached mapped page), major
+		// faults had to read from disk. Mostly interesting for tuning the
+		// memory mapped disk I/O back-end. 0 on platforms where this can't
+		// be queried
+		METRIC(disk, minor_page_faults)
+		METRIC(disk, major_page_faults)
 		// ... more
 	}});
 #undef METRIC
@@ -569,4 +646,29 @@ namespace {
 		if (i == std::end(metrics)) return -1;
 		return i->value_index;
 	}
+
+	std::string prometheus_session_stats(span<std::int64_t const> const values)
+	{
+		std::string ret;
+		// two lines of roughly 60 characters per metric
+		ret.reserve(std::size_t(metrics.end_index()) * 120);
+		for (auto const& m : metrics)
+		{
+			if (m.value_index >= values.size()) continue;
+
+			std::string name = "libtorrent_";
+			name += m.name;
+			std::replace(name.begin(), name.end(), '.', '_');
+
+			ret += "# TYPE ";
+			ret += name;
+			ret += m.value_index >= counters::num_stats_counters
+				? " gauge\n" : " counter\n";
+			ret += name;
+			ret += ' ';
+			ret += std::to_string(values[m.value_index]);
+			ret += '\n';
+		}
+		return ret;
+	}
 }
@@ -218,6 +218,7 @@ namespace libtorrent {
 		SET(piece_extent_affinity, false, nullptr),
 		SET(validate_https_trackers, false, &session_impl::update_validate_https),
 		SET(enable_set_file_valid_data, false, nullptr),
+		SET(enable_autotune, false, &session_impl::update_autotune_state),
 	}});
 
 	CONSTEXPR_SETTINGS
@@ -374,6 +375,19 @@ namespace libtorrent {
 		SET(dht_sample_infohashes_interval, 21600, nullptr),
 		SET(dht_max_infohashes_sample_count, 20, nullptr),
 		SET(max_piece_count, 0x200000, nullptr),
+		SET(disk_read_cache_size, 1024, nullptr),
+		SET(aio_threads_min, 0, &session_impl::update_disk_threads),
+		SET(disk_write_back_rate, 0, nullptr),
+		SET(dht_max_concurrent_lookups, 16, nullptr),
+		SET(tick_lag_warning_threshold, 1000, nullptr),
+		SET(utp_congestion_control, settings_pack::utp_ledbat_pp, nullptr),
+		SET(mmap_hugepage_cutoff, 256, nullptr),
+		SET(mmap_populate_limit, 0, nullptr),
+		SET(disk_read_coalesce_blocks, 4, nullptr),
+		SET(autotune_interval, 30, nullptr),
+		SET(alert_notify_batch_size, 1, &session_impl::update_alert_notify_coalescing),
+		SET(alert_notify_max_delay, 500, &session_impl::update_alert_notify_coalescing),
+		SET(alert_notify_bypass_categories, int(static_cast<std::uint32_t>(alert_category::error)), &session_impl::update_alert_notify_coalescing),
 	}});
 
 #undef SET
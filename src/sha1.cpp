@@ -25,6 +25,34 @@ changelog at the end of the file.
 #include <boost/predef/other/endian.h>
 #include "libtorrent/aux_/disable_warnings_pop.hpp"
 
+// hardware accelerated block functions, dispatched at runtime based on
+// CPU support (see cpuid.cpp)
+#if TORRENT_HAS_SSE && (defined __GNUC__ || defined _MSC_VER)
+#define TORRENT_HAS_SHA1_NI 1
+#include <immintrin.h>
+#include "libtorrent/aux_/cpuid.hpp"
+#if defined _MSC_VER
+#define TORRENT_SHA1_NI_FUN
+#else
+#define TORRENT_SHA1_NI_FUN __attribute__((target("sha,sse4.1,ssse3")))
+#endif
+#endif
+
+#if defined __aarch64__ && defined __ARM_NEON \
+	&& (defined __ARM_FEATURE_CRYPTO || defined __ARM_FEATURE_SHA2 \
+		|| defined __clang__ || (defined __GNUC__ && __GNUC__ >= 9))
+#define TORRENT_HAS_SHA1_ARM 1
+#include <arm_neon.h>
+#include "libtorrent/aux_/cpuid.hpp"
+#if defined __ARM_FEATURE_CRYPTO || defined __ARM_FEATURE_SHA2
+#define TORRENT_SHA1_ARM_FUN
+#elif defined __clang__
+#define TORRENT_SHA1_ARM_FUN __attribute__((target("crypto")))
+#else
+#define TORRENT_SHA1_ARM_FUN __attribute__((target("+crypto")))
+#endif
+#endif
+
 namespace libtorrent {
 
 namespace {
@@ -124,6 +152,378 @@ using u8 = std::uint8_t;
 		state[4] += e;
 	}
 
+#if TORRENT_HAS_SHA1_NI
+	// hash a single 512-bit block with the x86 SHA instruction set
+	// extensions. The structure of this function is the standard SHA-NI
+	// round sequence, as published by Intel
+	TORRENT_SHA1_NI_FUN
+	void SHA1transform_ni(u32 state[5], u8 const buffer[64])
+	{
+		__m128i const MASK = _mm_set_epi64x(
+			0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+		__m128i ABCD = _mm_loadu_si128(reinterpret_cast<__m128i const*>(state));
+		ABCD = _mm_shuffle_epi32(ABCD, 0x1B);
+		__m128i E0 = _mm_set_epi32(int(state[4]), 0, 0, 0);
+
+		__m128i const ABCD_SAVE = ABCD;
+		__m128i const E0_SAVE = E0;
+		__m128i E1;
+
+		// rounds 0-3
+		__m128i MSG0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(buffer + 0));
+		MSG0 = _mm_shuffle_epi8(MSG0, MASK);
+		E0 = _mm_add_epi32(E0, MSG0);
+		E1 = ABCD;
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+
+		// rounds 4-7
+		__m128i MSG1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(buffer + 16));
+		MSG1 = _mm_shuffle_epi8(MSG1, MASK);
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 0);
+		MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+
+		// rounds 8-11
+		__m128i MSG2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(buffer + 32));
+		MSG2 = _mm_shuffle_epi8(MSG2, MASK);
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+		MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+		MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+		// rounds 12-15
+		__m128i MSG3 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(buffer + 48));
+		MSG3 = _mm_shuffle_epi8(MSG3, MASK);
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 0);
+		MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+		MSG1 = _mm_xor_si128(MSG1, MSG3);
+
+		// rounds 16-19
+		E0 = _mm_sha1nexte_epu32(E0, MSG0);
+		E1 = ABCD;
+		MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+		MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+		MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+		// rounds 20-23
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 1);
+		MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+		MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+		// rounds 24-27
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 1);
+		MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+		MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+		// rounds 28-31
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 1);
+		MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+		MSG1 = _mm_xor_si128(MSG1, MSG3);
+
+		// rounds 32-35
+		E0 = _mm_sha1nexte_epu32(E0, MSG0);
+		E1 = ABCD;
+		MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 1);
+		MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+		MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+		// rounds 36-39
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 1);
+		MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+		MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+		// rounds 40-43
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 2);
+		MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+		MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+		// rounds 44-47
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 2);
+		MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+		MSG1 = _mm_xor_si128(MSG1, MSG3);
+
+		// rounds 48-51
+		E0 = _mm_sha1nexte_epu32(E0, MSG0);
+		E1 = ABCD;
+		MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 2);
+		MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+		MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+		// rounds 52-55
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 2);
+		MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+		MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+		// rounds 56-59
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 2);
+		MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+		MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+		// rounds 60-63
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		MSG0 = _mm_sha1msg2_epu32(MSG0, MSG3);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+		MSG2 = _mm_sha1msg1_epu32(MSG2, MSG3);
+		MSG1 = _mm_xor_si128(MSG1, MSG3);
+
+		// rounds 64-67
+		E0 = _mm_sha1nexte_epu32(E0, MSG0);
+		E1 = ABCD;
+		MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+		MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+		MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+		// rounds 68-71
+		E1 = _mm_sha1nexte_epu32(E1, MSG1);
+		E0 = ABCD;
+		MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+		MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+		// rounds 72-75
+		E0 = _mm_sha1nexte_epu32(E0, MSG2);
+		E1 = ABCD;
+		MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+
+		// rounds 76-79
+		E1 = _mm_sha1nexte_epu32(E1, MSG3);
+		E0 = ABCD;
+		ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+
+		// combine with the previous state
+		E0 = _mm_sha1nexte_epu32(E0, E0_SAVE);
+		ABCD = _mm_add_epi32(ABCD, ABCD_SAVE);
+
+		ABCD = _mm_shuffle_epi32(ABCD, 0x1B);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(state), ABCD);
+		state[4] = u32(_mm_extract_epi32(E0, 3));
+	}
+#endif // TORRENT_HAS_SHA1_NI
+
+#if TORRENT_HAS_SHA1_ARM
+	// hash a single 512-bit block with the ARMv8 cryptography extensions
+	TORRENT_SHA1_ARM_FUN
+	void SHA1transform_arm(u32 state[5], u8 const buffer[64])
+	{
+		uint32x4_t ABCD = vld1q_u32(&state[0]);
+		std::uint32_t E0 = state[4];
+		std::uint32_t E1;
+
+		uint32x4_t const ABCD_SAVE = ABCD;
+		std::uint32_t const E0_SAVE = E0;
+
+		uint32x4_t MSG0 = vreinterpretq_u32_u8(vld1q_u8(buffer + 0));
+		uint32x4_t MSG1 = vreinterpretq_u32_u8(vld1q_u8(buffer + 16));
+		uint32x4_t MSG2 = vreinterpretq_u32_u8(vld1q_u8(buffer + 32));
+		uint32x4_t MSG3 = vreinterpretq_u32_u8(vld1q_u8(buffer + 48));
+
+		// the message is big-endian
+		MSG0 = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(MSG0)));
+		MSG1 = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(MSG1)));
+		MSG2 = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(MSG2)));
+		MSG3 = vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(MSG3)));
+
+		uint32x4_t TMP0 = vaddq_u32(MSG0, vdupq_n_u32(0x5A827999));
+		uint32x4_t TMP1 = vaddq_u32(MSG1, vdupq_n_u32(0x5A827999));
+
+		// rounds 0-3
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1cq_u32(ABCD, E0, TMP0);
+		TMP0 = vaddq_u32(MSG2, vdupq_n_u32(0x5A827999));
+		MSG0 = vsha1su0q_u32(MSG0, MSG1, MSG2);
+
+		// rounds 4-7
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1cq_u32(ABCD, E1, TMP1);
+		TMP1 = vaddq_u32(MSG3, vdupq_n_u32(0x5A827999));
+		MSG0 = vsha1su1q_u32(MSG0, MSG3);
+		MSG1 = vsha1su0q_u32(MSG1, MSG2, MSG3);
+
+		// rounds 8-11
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1cq_u32(ABCD, E0, TMP0);
+		TMP0 = vaddq_u32(MSG0, vdupq_n_u32(0x5A827999));
+		MSG1 = vsha1su1q_u32(MSG1, MSG0);
+		MSG2 = vsha1su0q_u32(MSG2, MSG3, MSG0);
+
+		// rounds 12-15
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1cq_u32(ABCD, E1, TMP1);
+		TMP1 = vaddq_u32(MSG1, vdupq_n_u32(0x6ED9EBA1));
+		MSG2 = vsha1su1q_u32(MSG2, MSG1);
+		MSG3 = vsha1su0q_u32(MSG3, MSG0, MSG1);
+
+		// rounds 16-19
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1cq_u32(ABCD, E0, TMP0);
+		TMP0 = vaddq_u32(MSG2, vdupq_n_u32(0x6ED9EBA1));
+		MSG3 = vsha1su1q_u32(MSG3, MSG2);
+		MSG0 = vsha1su0q_u32(MSG0, MSG1, MSG2);
+
+		// rounds 20-23
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E1, TMP1);
+		TMP1 = vaddq_u32(MSG3, vdupq_n_u32(0x6ED9EBA1));
+		MSG0 = vsha1su1q_u32(MSG0, MSG3);
+		MSG1 = vsha1su0q_u32(MSG1, MSG2, MSG3);
+
+		// rounds 24-27
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E0, TMP0);
+		TMP0 = vaddq_u32(MSG0, vdupq_n_u32(0x6ED9EBA1));
+		MSG1 = vsha1su1q_u32(MSG1, MSG0);
+		MSG2 = vsha1su0q_u32(MSG2, MSG3, MSG0);
+
+		// rounds 28-31
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E1, TMP1);
+		TMP1 = vaddq_u32(MSG1, vdupq_n_u32(0x6ED9EBA1));
+		MSG2 = vsha1su1q_u32(MSG2, MSG1);
+		MSG3 = vsha1su0q_u32(MSG3, MSG0, MSG1);
+
+		// rounds 32-35
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E0, TMP0);
+		TMP0 = vaddq_u32(MSG2, vdupq_n_u32(0x8F1BBCDC));
+		MSG3 = vsha1su1q_u32(MSG3, MSG2);
+		MSG0 = vsha1su0q_u32(MSG0, MSG1, MSG2);
+
+		// rounds 36-39
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E1, TMP1);
+		TMP1 = vaddq_u32(MSG3, vdupq_n_u32(0x8F1BBCDC));
+		MSG0 = vsha1su1q_u32(MSG0, MSG3);
+		MSG1 = vsha1su0q_u32(MSG1, MSG2, MSG3);
+
+		// rounds 40-43
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1mq_u32(ABCD, E0, TMP0);
+		TMP0 = vaddq_u32(MSG0, vdupq_n_u32(0x8F1BBCDC));
+		MSG1 = vsha1su1q_u32(MSG1, MSG0);
+		MSG2 = vsha1su0q_u32(MSG2, MSG3, MSG0);
+
+		// rounds 44-47
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1mq_u32(ABCD, E1, TMP1);
+		TMP1 = vaddq_u32(MSG1, vdupq_n_u32(0x8F1BBCDC));
+		MSG2 = vsha1su1q_u32(MSG2, MSG1);
+		MSG3 = vsha1su0q_u32(MSG3, MSG0, MSG1);
+
+		// rounds 48-51
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1mq_u32(ABCD, E0, TMP0);
+		TMP0 = vaddq_u32(MSG2, vdupq_n_u32(0x8F1BBCDC));
+		MSG3 = vsha1su1q_u32(MSG3, MSG2);
+		MSG0 = vsha1su0q_u32(MSG0, MSG1, MSG2);
+
+		// rounds 52-55
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1mq_u32(ABCD, E1, TMP1);
+		TMP1 = vaddq_u32(MSG3, vdupq_n_u32(0xCA62C1D6));
+		MSG0 = vsha1su1q_u32(MSG0, MSG3);
+		MSG1 = vsha1su0q_u32(MSG1, MSG2, MSG3);
+
+		// rounds 56-59
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1mq_u32(ABCD, E0, TMP0);
+		TMP0 = vaddq_u32(MSG0, vdupq_n_u32(0xCA62C1D6));
+		MSG1 = vsha1su1q_u32(MSG1, MSG0);
+		MSG2 = vsha1su0q_u32(MSG2, MSG3, MSG0);
+
+		// rounds 60-63
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E1, TMP1);
+		TMP1 = vaddq_u32(MSG1, vdupq_n_u32(0xCA62C1D6));
+		MSG2 = vsha1su1q_u32(MSG2, MSG1);
+		MSG3 = vsha1su0q_u32(MSG3, MSG0, MSG1);
+
+		// rounds 64-67
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E0, TMP0);
+		TMP0 = vaddq_u32(MSG2, vdupq_n_u32(0xCA62C1D6));
+		MSG3 = vsha1su1q_u32(MSG3, MSG2);
+		MSG0 = vsha1su0q_u32(MSG0, MSG1, MSG2);
+
+		// rounds 68-71
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E1, TMP1);
+		TMP1 = vaddq_u32(MSG3, vdupq_n_u32(0xCA62C1D6));
+		MSG0 = vsha1su1q_u32(MSG0, MSG3);
+
+		// rounds 72-75
+		E1 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E0, TMP0);
+
+		// rounds 76-79
+		E0 = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+		ABCD = vsha1pq_u32(ABCD, E1, TMP1);
+
+		// combine with the previous state
+		E0 += E0_SAVE;
+		ABCD = vaddq_u32(ABCD_SAVE, ABCD);
+
+		vst1q_u32(&state[0], ABCD);
+		state[4] = E0;
+	}
+#endif // TORRENT_HAS_SHA1_ARM
+
+	// dispatch to the fastest block function supported by this CPU
+	template <class BlkFun>
+	void transform(u32 state[5], u8 const buffer[64])
+	{
+#if TORRENT_HAS_SHA1_NI
+		if (aux::sha_ni_support)
+		{
+			SHA1transform_ni(state, buffer);
+			return;
+		}
+#endif
+#if TORRENT_HAS_SHA1_ARM
+		if (aux::arm_sha1_support)
+		{
+			SHA1transform_arm(state, buffer);
+			return;
+		}
+#endif
+		SHA1transform<BlkFun>(state, buffer);
+	}
+
 #ifdef VERBOSE
 	void SHAPrintContext(sha1_ctx *context, char *msg)
 	{
@@ -154,10 +554,10 @@ using u8 = std::uint8_t;
 		if ((j + len) > 63)
 		{
 			memcpy(&context->buffer[j], data, (i = 64-j));
-			SHA1transform<BlkFun>(context->state, context->buffer);
+			transform<BlkFun>(context->state, context->buffer);
 			for ( ; i + 63 < len; i += 64)
 			{
-				SHA1transform<BlkFun>(context->state, &data[i]);
+				transform<BlkFun>(context->state, &data[i]);
 			}
 			j = 0;
 		}
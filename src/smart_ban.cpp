@@ -141,6 +141,26 @@ namespace {
 			std::vector<torrent_peer*> const downloaders
 				= m_torrent.picker().get_downloaders(p);
 
+			// if at most one distinct peer sent this piece, there's nothing
+			// for this plugin to disambiguate. torrent::piece_failed() bans
+			// a single sender directly, without needing any block
+			// fingerprints. Don't spend disk reads and hashing on it
+			{
+				torrent_peer const* single = nullptr;
+				bool multiple = false;
+				for (auto const* tp : downloaders)
+				{
+					if (tp == nullptr) continue;
+					if (single != nullptr && tp != single)
+					{
+						multiple = true;
+						break;
+					}
+					single = tp;
+				}
+				if (!multiple) return;
+			}
+
 			int size = m_torrent.torrent_file().piece_size(p);
 			peer_request r = {p, 0, std::min(16*1024, size)};
 			piece_block pb(p, 0);
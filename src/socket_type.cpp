@@ -191,7 +191,13 @@ namespace aux {
 			ssl::set_server_name_callback(visitor.ctx_, nullptr, nullptr, ec);
 
 		if (visitor.ssl_)
+		{
 			ssl::set_host_name(visitor.ssl_, hostname, ec);
+
+			// offer a previously negotiated session with this host for
+			// resumption, if the context keeps a session cache
+			ssl::prime_client_session(visitor.ssl_, visitor.ctx_, hostname);
+		}
 #else
 		TORRENT_UNUSED(ec);
 		TORRENT_UNUSED(hostname);
@@ -43,6 +43,12 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <gnutls/x509.h>
 #endif
 
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
 namespace libtorrent {
 namespace ssl {
 
@@ -169,6 +175,159 @@ context_handle_type get_context(stream_handle_type s)
 #endif
 }
 
+#if defined TORRENT_USE_OPENSSL
+namespace {
+
+	// the sessions negotiated by streams of a context, for resumption.
+	// Owned by the SSL_CTX via ex_data, destroyed with it
+	struct client_session_cache
+	{
+		explicit client_session_cache(int const limit) : m_limit(limit) {}
+		~client_session_cache()
+		{
+			for (auto& e : m_sessions) SSL_SESSION_free(e.second);
+		}
+		client_session_cache(client_session_cache const&) = delete;
+		client_session_cache& operator=(client_session_cache const&) = delete;
+
+		// stores the session under the given key, taking over the caller's
+		// reference. An existing session under the same key is replaced;
+		// it's from an older handshake
+		void put(std::string const& key, SSL_SESSION* ses)
+		{
+			auto const it = m_index.find(key);
+			if (it != m_index.end())
+			{
+				SSL_SESSION_free(it->second->second);
+				it->second->second = ses;
+				m_sessions.splice(m_sessions.begin(), m_sessions, it->second);
+				return;
+			}
+			m_sessions.emplace_front(key, ses);
+			m_index[key] = m_sessions.begin();
+			if (int(m_sessions.size()) > m_limit)
+			{
+				SSL_SESSION_free(m_sessions.back().second);
+				m_index.erase(m_sessions.back().first);
+				m_sessions.pop_back();
+			}
+		}
+
+		// removes and returns the session for this key, passing its
+		// reference to the caller. Sessions are taken out of the cache when
+		// offered, since TLS 1.3 tickets are single-use; the handshake they
+		// resume delivers a fresh ticket via the new-session callback
+		SSL_SESSION* take(std::string const& key)
+		{
+			auto const it = m_index.find(key);
+			if (it == m_index.end()) return nullptr;
+			SSL_SESSION* const ses = it->second->second;
+			m_sessions.erase(it->second);
+			m_index.erase(it);
+			return ses;
+		}
+
+	private:
+		int m_limit;
+		// most recently used in front
+		std::list<std::pair<std::string, SSL_SESSION*>> m_sessions;
+		std::map<std::string
+			, std::list<std::pair<std::string, SSL_SESSION*>>::iterator> m_index;
+	};
+
+	extern "C" {
+	void cache_ex_free(void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*)
+	{
+		delete static_cast<client_session_cache*>(ptr);
+	}
+
+	void key_ex_free(void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*)
+	{
+		delete static_cast<std::string*>(ptr);
+	}
+	}
+
+	// the ex_data slot on the SSL_CTX holding the session cache
+	int cache_ex_index()
+	{
+		static int const idx = SSL_CTX_get_ex_new_index(0, nullptr, nullptr
+			, nullptr, &cache_ex_free);
+		return idx;
+	}
+
+	// the ex_data slot on the SSL holding the cache key its session should
+	// be stored under
+	int key_ex_index()
+	{
+		static int const idx = SSL_get_ex_new_index(0, nullptr, nullptr
+			, nullptr, &key_ex_free);
+		return idx;
+	}
+
+	extern "C" int new_session_cb(SSL* s, SSL_SESSION* ses)
+	{
+		auto* const cache = static_cast<client_session_cache*>(
+			SSL_CTX_get_ex_data(SSL_get_SSL_CTX(s), cache_ex_index()));
+		auto* const key = static_cast<std::string*>(
+			SSL_get_ex_data(s, key_ex_index()));
+
+		// streams that weren't primed don't participate in resumption
+		if (cache == nullptr || key == nullptr) return 0;
+		cache->put(*key, ses);
+		// we took over the reference to the session
+		return 1;
+	}
+}
+#endif
+
+void enable_client_session_cache(context& ctx, int const max_sessions)
+{
+#if defined TORRENT_USE_OPENSSL
+	SSL_CTX* const c = get_handle(ctx);
+
+	// let the new-session callback see sessions negotiated as a client,
+	// and keep OpenSSL's internal (server-side) store out of it
+	SSL_CTX_set_session_cache_mode(c
+		, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(c, &new_session_cb);
+
+	auto cache = std::unique_ptr<client_session_cache>(
+		new client_session_cache(max_sessions));
+	if (SSL_CTX_set_ex_data(c, cache_ex_index(), cache.get()) == 1)
+		cache.release();
+#else
+	// not implemented for GnuTLS; handshakes are full handshakes
+	TORRENT_UNUSED(ctx);
+	TORRENT_UNUSED(max_sessions);
+#endif
+}
+
+void prime_client_session(stream_handle_type s, context_handle_type c
+	, std::string const& key)
+{
+#if defined TORRENT_USE_OPENSSL
+	auto* const cache = static_cast<client_session_cache*>(
+		SSL_CTX_get_ex_data(c, cache_ex_index()));
+	if (cache == nullptr) return;
+
+	// tag the stream, so the session its handshake negotiates is cached
+	// under this key by the new-session callback
+	auto tag = std::unique_ptr<std::string>(new std::string(key));
+	if (SSL_set_ex_data(s, key_ex_index(), tag.get()) == 1)
+		tag.release();
+
+	SSL_SESSION* const ses = cache->take(key);
+	if (ses == nullptr) return;
+	// SSL_set_session() takes its own reference
+	SSL_set_session(s, ses);
+	SSL_SESSION_free(ses);
+#else
+	TORRENT_UNUSED(s);
+	TORRENT_UNUSED(c);
+	TORRENT_UNUSED(key);
+#endif
+}
+
 #if defined TORRENT_USE_OPENSSL
 namespace {
 	struct lifecycle
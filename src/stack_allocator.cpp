@@ -32,6 +32,7 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "libtorrent/stack_allocator.hpp"
 #include <cstdarg> // for va_list, va_copy, va_end
+#include <algorithm> // for std::max
 
 namespace libtorrent {
 namespace aux {
@@ -136,7 +137,22 @@ namespace aux {
 
 	void stack_allocator::reset()
 	{
+		// the capacity of m_storage is recycled from one generation of alerts
+		// to the next, so in steady state no allocation happens at all. The
+		// exception is a one-off burst (e.g. posting peer_log_alert for every
+		// connection during a hash failure), which would otherwise pin its
+		// peak allocation for the lifetime of the session. The watermark
+		// decays by half each generation, so capacity is only released once
+		// usage has stayed well below the peak for a few cycles
+		m_watermark = std::max(m_storage.end_index(), m_watermark / 2);
 		m_storage.clear();
+		if (m_storage.capacity() > std::size_t(m_watermark) * 2
+			&& m_storage.capacity() > 4096)
+		{
+			// clear() left the size at 0, so this releases the whole buffer
+			m_storage.shrink_to_fit();
+			m_storage.reserve(std::size_t(m_watermark));
+		}
 	}
 }
 }
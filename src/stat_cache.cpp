@@ -37,6 +37,12 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/error_code.hpp"
 #include "libtorrent/aux_/path.hpp"
 
+#ifndef TORRENT_WINDOWS
+#include <fcntl.h> // for open()
+#include <sys/stat.h> // for fstatat()
+#include <unistd.h> // for close()
+#endif
+
 namespace libtorrent {
 
 	stat_cache::stat_cache() = default;
@@ -120,6 +126,58 @@ namespace libtorrent {
 		return sz;
 	}
 
+	void stat_cache::bulk_stat(file_storage const& fs, std::string const& save_path)
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		if (m_stat_cache.end_index() < fs.end_file())
+			m_stat_cache.resize(fs.num_files(), stat_cache_t{not_in_cache});
+
+#ifndef TORRENT_WINDOWS
+		// keep the directory of the most recent file open. Files are laid
+		// out directory by directory, so consecutive stats normally only
+		// resolve the file name, not the whole path
+		std::string current_dir;
+		int dir_fd = -1;
+#endif
+		for (auto const i : fs.file_range())
+		{
+			if (m_stat_cache[i].file_size != not_in_cache) continue;
+			if (fs.pad_file_at(i)) continue;
+			// symlinks are deliberately never cached, see get_filesize()
+			if (fs.file_flags(i) & file_storage::flag_symlink) continue;
+
+			std::string const file_path = fs.file_path(i, save_path);
+#ifndef TORRENT_WINDOWS
+			std::string dir = parent_path(file_path);
+			if (dir != current_dir)
+			{
+				if (dir_fd >= 0) ::close(dir_fd);
+				dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				current_dir = std::move(dir);
+			}
+			if (dir_fd >= 0)
+			{
+				struct stat st;
+				if (::fstatat(dir_fd, filename(file_path).c_str(), &st, 0) != 0)
+					set_error_impl(i, error_code(errno, system_category()));
+				else
+					set_cache_impl(i, st.st_size);
+				continue;
+			}
+			// if the directory itself can't be opened, fall through to a
+			// full stat, which records the appropriate error
+#endif
+			file_status s;
+			error_code ec;
+			stat_file(file_path, &s, ec);
+			if (ec) set_error_impl(i, ec);
+			else set_cache_impl(i, s.file_size);
+		}
+#ifndef TORRENT_WINDOWS
+		if (dir_fd >= 0) ::close(dir_fd);
+#endif
+	}
+
 	void stat_cache::reserve(int num_files)
 	{
 		std::lock_guard<std::mutex> l(m_mutex);
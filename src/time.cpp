@@ -32,9 +32,38 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #include "libtorrent/aux_/time.hpp"
 
+#include <atomic>
+#include <cstdint>
+
 namespace libtorrent { namespace aux {
 
-	time_point time_now() { return clock_type::now(); }
-	time_point32 time_now32() { return time_point_cast<seconds32>(clock_type::now()); }
+namespace {
+
+	// the cached timestamp, stored as a raw tick count so it can be
+	// atomic. It's written by update_time_now() on the network thread and
+	// read from any thread. 0 means update_time_now() has never been
+	// called
+	std::atomic<std::int64_t> g_current_time{0};
+}
+
+	time_point time_now()
+	{
+		std::int64_t const t = g_current_time.load(std::memory_order_relaxed);
+		// if no one is refreshing the cache (there's no session main loop
+		// running, e.g. in unit tests or when using the parsing functions
+		// stand-alone), fall back to reading the clock
+		if (t == 0) return clock_type::now();
+		return time_point(clock_type::duration(t));
+	}
+
+	time_point32 time_now32() { return time_point_cast<seconds32>(time_now()); }
+
+	time_point update_time_now()
+	{
+		time_point const now = clock_type::now();
+		g_current_time.store(now.time_since_epoch().count()
+			, std::memory_order_relaxed);
+		return now;
+	}
 
 } }
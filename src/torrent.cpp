@@ -76,6 +76,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/http_seed_connection.hpp"
 #include "libtorrent/peer_connection_handle.hpp"
 #include "libtorrent/peer_id.hpp"
+#include "libtorrent/torrent_peer_allocator.hpp"
 #include "libtorrent/identify_client.hpp"
 #include "libtorrent/alert_types.hpp"
 #include "libtorrent/extensions.hpp"
@@ -103,6 +104,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/hex.hpp" // to_hex
 #include "libtorrent/aux_/range.hpp"
 #include "libtorrent/aux_/merkle.hpp"
+#include "libtorrent/aux_/event_trace.hpp"
 #include "libtorrent/mmap_disk_io.hpp" // for hasher_thread_divisor
 #include "libtorrent/aux_/numeric_cast.hpp"
 #include "libtorrent/aux_/path.hpp"
@@ -125,6 +127,15 @@ using namespace std::placeholders;
 namespace libtorrent {
 namespace {
 
+// all the conditions save_resume_data() can be asked to check for. Setting
+// all of them marks every part of the resume data as dirty
+constexpr resume_data_flags_t all_dirty_conditions
+	= torrent_handle::if_counters_changed
+	| torrent_handle::if_download_progress
+	| torrent_handle::if_config_changed
+	| torrent_handle::if_state_changed
+	| torrent_handle::if_metadata_changed;
+
 bool is_downloading_state(int const st)
 {
 	switch (st)
@@ -212,7 +223,8 @@ bool is_downloading_state(int const st)
 		, m_super_seeding(p.flags & torrent_flags::super_seeding)
 #endif
 		, m_stop_when_ready(p.flags & torrent_flags::stop_when_ready)
-		, m_need_save_resume_data(p.flags & torrent_flags::need_save_resume)
+		, m_need_save_resume_data((p.flags & torrent_flags::need_save_resume)
+			? all_dirty_conditions : resume_data_flags_t{})
 		, m_enable_dht(!bool(p.flags & torrent_flags::disable_dht))
 		, m_enable_lsd(!bool(p.flags & torrent_flags::disable_lsd))
 		, m_max_uploads((1 << 24) - 1)
@@ -504,7 +516,7 @@ bool is_downloading_state(int const st)
 		m_verified.clear();
 		m_verifying.clear();
 
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_state_changed);
 	}
 
 	void torrent::verified(piece_index_t const piece)
@@ -514,6 +526,150 @@ bool is_downloading_state(int const st)
 		m_verified.set_bit(piece);
 	}
 
+	bool torrent::seed_mode_piece_hashed(piece_index_t const piece
+		, sha1_hash const& piece_hash
+		, aux::vector<sha256_hash> const& block_hashes)
+	{
+		TORRENT_ASSERT(is_single_thread());
+
+		boost::tribool v1_failed = boost::indeterminate;
+		boost::tribool v2_failed = boost::indeterminate;
+
+		bool const disable_checks = settings().get_bool(settings_pack::disable_hash_checks);
+
+		if (!disable_checks && info_hash().has_v1())
+			v1_failed = piece_hash != m_torrent_file->hash_for_piece(piece);
+
+		if (!disable_checks && info_hash().has_v2())
+		{
+			v2_failed = false;
+
+			int const blocks_in_piece = m_torrent_file->files().blocks_in_piece2(piece);
+			TORRENT_ASSERT(blocks_in_piece == int(block_hashes.size()));
+
+			need_hash_picker();
+			auto& picker = get_hash_picker();
+			set_block_hash_result result = set_block_hash_result::unknown();
+			for (int i = 0; i < blocks_in_piece; ++i)
+			{
+				result = picker.set_block_hash(piece, i * default_block_size, block_hashes[i]);
+				if (result.status == set_block_hash_result::result::block_hash_failed
+					|| result.status == set_block_hash_result::result::piece_hash_failed)
+				{
+					v2_failed = true;
+				}
+			}
+
+			// if the last block still couldn't be verified
+			// it means we don't know the piece's root hash
+			// we must leave seed mode
+			if (result.status == set_block_hash_result::result::unknown)
+				v1_failed = v2_failed = true;
+		}
+
+		if ((v1_failed && !v2_failed) || (!v1_failed && v2_failed))
+		{
+			set_error(errors::torrent_inconsistent_hashes, torrent_status::error_file_none);
+			pause();
+			return false;
+		}
+
+		if (v1_failed || v2_failed)
+		{
+			leave_seed_mode(seed_mode_t::check_files);
+			return false;
+		}
+
+		if (m_seed_mode)
+		{
+			TORRENT_ASSERT(verifying_piece(piece));
+			verified(piece);
+		}
+
+		if (m_seed_mode && all_verified())
+			leave_seed_mode(seed_mode_t::skip_checking);
+
+		return true;
+	}
+
+	void torrent::kick_background_verification()
+	{
+		TORRENT_ASSERT(is_single_thread());
+
+		if (!m_seed_mode || m_background_verifying) return;
+		if (m_abort || m_deleted || !m_storage) return;
+		if (is_paused()) return;
+		if (settings().get_bool(settings_pack::disable_hash_checks)) return;
+
+		// find the next piece that hasn't been verified yet and isn't
+		// already being verified on behalf of a peer request. The cursor
+		// only moves forward; request-triggered checks behind it don't
+		// need to be revisited
+		piece_index_t const end = m_torrent_file->end_piece();
+		while (m_verify_cursor < end
+			&& (m_verified.get_bit(m_verify_cursor)
+				|| m_verifying.get_bit(m_verify_cursor)))
+			++m_verify_cursor;
+
+		if (m_verify_cursor == end) return;
+
+		piece_index_t const piece = m_verify_cursor;
+
+#ifndef TORRENT_DISABLE_LOGGING
+		debug_log("*** SEED_MODE BACKGROUND_HASH piece: %d"
+			, static_cast<int>(piece));
+#endif
+
+		disk_job_flags_t flags;
+		if (info_hash().has_v1())
+			flags |= disk_interface::v1_hash;
+		aux::vector<sha256_hash> hashes;
+		if (info_hash().has_v2())
+			hashes.resize(m_torrent_file->orig_files().blocks_in_piece2(piece));
+
+		m_background_verifying = true;
+		verifying(piece);
+
+		span<sha256_hash> v2_hashes(hashes);
+		m_ses.disk_thread().async_hash(m_storage, piece, v2_hashes, flags
+			, [self = shared_from_this(), h2 = std::move(hashes)]
+			(piece_index_t p, sha1_hash const& h, storage_error const& error) mutable
+			{ self->on_background_seed_hash(p, h, std::move(h2), error); });
+		m_ses.deferred_submit_jobs();
+	}
+
+	void torrent::on_background_seed_hash(piece_index_t const piece
+		, sha1_hash const& piece_hash
+		, aux::vector<sha256_hash> block_hashes
+		, storage_error const& error) try
+	{
+		TORRENT_ASSERT(is_single_thread());
+
+		m_background_verifying = false;
+
+		if (m_abort || m_deleted) return;
+		if (!m_seed_mode) return;
+
+		if (error)
+		{
+			handle_disk_error("hash", error);
+			leave_seed_mode(seed_mode_t::check_files);
+			return;
+		}
+
+		bool const passed = seed_mode_piece_hashed(piece, piece_hash, block_hashes);
+
+#ifndef TORRENT_DISABLE_LOGGING
+		debug_log("*** SEED_MODE BACKGROUND_HASH piece: %d %s"
+			, static_cast<int>(piece), passed ? "passed" : "failed");
+#endif
+
+		// keep walking the torrent, one piece at a time. If we just left
+		// seed mode (or got paused), the kick is a no-op
+		if (passed) kick_background_verification();
+	}
+	catch (...) { handle_exception(); }
+
 	void torrent::start()
 	{
 		TORRENT_ASSERT(is_single_thread());
@@ -768,6 +924,90 @@ bool is_downloading_state(int const st)
 		m_ses.deferred_submit_jobs();
 	}
 
+	void torrent::read_piece_blocks(piece_index_t const piece)
+	{
+		error_code ec;
+		if (m_abort || m_deleted)
+		{
+			ec.assign(boost::system::errc::operation_canceled, generic_category());
+		}
+		else if (!valid_metadata())
+		{
+			ec.assign(errors::no_metadata, libtorrent_category());
+		}
+		else if (piece < piece_index_t{0} || piece >= m_torrent_file->end_piece())
+		{
+			ec.assign(errors::invalid_piece_index, libtorrent_category());
+		}
+
+		if (ec)
+		{
+			m_ses.alerts().emplace_alert<read_piece_blocks_alert>(get_handle(), piece, ec);
+			return;
+		}
+
+		const int piece_size = m_torrent_file->piece_size(piece);
+		const int blocks_in_piece = (piece_size + block_size() - 1) / block_size();
+
+		TORRENT_ASSERT(blocks_in_piece > 0);
+		TORRENT_ASSERT(piece_size > 0);
+
+		std::shared_ptr<read_piece_blocks_struct> rp = std::make_shared<read_piece_blocks_struct>();
+		rp->blocks.resize(std::size_t(blocks_in_piece));
+		rp->blocks_left = blocks_in_piece;
+		rp->fail = false;
+
+		peer_request r;
+		r.piece = piece;
+		r.start = 0;
+		auto self = shared_from_this();
+		for (int i = 0; i < blocks_in_piece; ++i, r.start += block_size())
+		{
+			r.length = std::min(piece_size - r.start, block_size());
+			m_ses.disk_thread().async_read(m_storage, r
+				, [self, r, rp](disk_buffer_holder block, storage_error const& se) mutable
+				{ self->on_disk_read_blocks_complete(std::move(block), se, r, rp); });
+		}
+		m_ses.deferred_submit_jobs();
+	}
+
+	void torrent::on_disk_read_blocks_complete(disk_buffer_holder buffer
+		, storage_error const& se
+		, peer_request const& r, std::shared_ptr<read_piece_blocks_struct> rp) try
+	{
+		TORRENT_ASSERT(is_single_thread());
+
+		--rp->blocks_left;
+		if (se)
+		{
+			rp->fail = true;
+			rp->error = se.ec;
+			handle_disk_error("read", se);
+		}
+		else
+		{
+			// instead of copying the block out of the disk buffer, hang on
+			// to the buffer itself until all blocks of the piece are in
+			rp->blocks[std::size_t(r.start / block_size())] = std::move(buffer);
+		}
+
+		if (rp->blocks_left == 0)
+		{
+			if (rp->fail)
+			{
+				m_ses.alerts().emplace_alert<read_piece_blocks_alert>(
+					get_handle(), r.piece, rp->error);
+			}
+			else
+			{
+				int const size = m_torrent_file->piece_size(r.piece);
+				m_ses.alerts().emplace_alert<read_piece_blocks_alert>(
+					get_handle(), r.piece, std::move(rp->blocks), size);
+			}
+		}
+	}
+	catch (...) { handle_exception(); }
+
 #ifndef TORRENT_DISABLE_SHARE_MODE
 	void torrent::send_share_mode()
 	{
@@ -965,7 +1205,8 @@ bool is_downloading_state(int const st)
 	void torrent::need_peer_list()
 	{
 		if (m_peer_list) return;
-		m_peer_list = std::make_unique<peer_list>(m_ses.get_peer_allocator());
+		m_peer_allocator = std::make_unique<torrent_peer_allocator>();
+		m_peer_list = std::make_unique<peer_list>(*m_peer_allocator);
 	}
 
 	void torrent::handle_exception()
@@ -1581,6 +1822,15 @@ bool is_downloading_state(int const st)
 			| ssl::context::no_sslv3
 			| ssl::context::single_dh_use);
 
+#ifdef SSL_OP_ENABLE_KTLS
+		// OpenSSL 3.0+ can offload the bulk record encryption to the kernel
+		// (kTLS) once the handshake has completed, for cipher suites the
+		// kernel supports. That roughly halves the per-byte CPU cost of SSL
+		// torrents. If the kernel or cipher doesn't support it, OpenSSL
+		// silently falls back to encrypting in user space
+		ctx->set_options(SSL_OP_ENABLE_KTLS);
+#endif
+
 		error_code ec;
 		ctx->set_verify_mode(ssl::context::verify_peer
 			| ssl::context::verify_fail_if_no_peer_cert
@@ -1592,6 +1842,10 @@ bool is_downloading_state(int const st)
 			return;
 		}
 
+		// reconnecting to a peer resumes the earlier TLS session (keyed by
+		// endpoint, see connect_to_peer()) instead of doing a full handshake
+		ssl::enable_client_session_cache(*ctx);
+
 		// the verification function verifies the distinguished name
 		// of a peer certificate to make sure it matches the info-hash
 		// of the torrent, or that it's a "star-cert"
@@ -1982,7 +2236,7 @@ bool is_downloading_state(int const st)
 		// want anything in this function to affect the state of
 		// m_need_save_resume_data, so we save it in a local variable and reset
 		// it at the end of the function.
-		bool const need_save_resume_data = m_need_save_resume_data;
+		auto const need_save_resume_data = m_need_save_resume_data;
 
 		TORRENT_ASSERT(is_single_thread());
 
@@ -2184,6 +2438,62 @@ bool is_downloading_state(int const st)
 			update_state_list();
 		}
 
+		// if a full check is required, see whether the per-file fingerprints
+		// in the resume data let us trust some of the pieces without
+		// re-hashing them. A piece is trusted if the resume data says we
+		// have it and every non-pad file it overlaps still has the size and
+		// modification time recorded when the resume data was written
+		if (should_start_full_check
+			&& status != status_t::no_error
+			&& m_add_torrent_params
+			&& !m_add_torrent_params->file_sizes.empty()
+			&& !m_add_torrent_params->have_pieces.empty())
+		{
+			file_storage const& fs = m_torrent_file->files();
+			auto const& fingerprints = m_add_torrent_params->file_sizes;
+
+			int const num_pieces = std::min(m_add_torrent_params->have_pieces.size()
+				, m_torrent_file->num_pieces());
+			m_trusted_pieces.resize(m_torrent_file->num_pieces(), false);
+			for (piece_index_t i(0); i < piece_index_t(num_pieces); ++i)
+				if (m_add_torrent_params->have_pieces[i]) m_trusted_pieces.set_bit(i);
+
+			for (auto const f : fs.file_range())
+			{
+				if (fs.pad_file_at(f)) continue;
+				bool unchanged = false;
+				if (static_cast<int>(f) < int(fingerprints.size()))
+				{
+					auto const& fp = fingerprints[std::size_t(static_cast<int>(f))];
+					file_status s;
+					error_code err;
+					stat_file(fs.file_path(f, m_save_path), &s, err);
+					unchanged = !err
+						&& s.file_size == fp.first
+						&& std::int64_t(s.mtime) == fp.second;
+				}
+				if (unchanged) continue;
+
+				// this file changed, or we can't tell. Don't trust any piece
+				// overlapping it
+				piece_index_t const first = fs.map_file(f, 0, 0).piece;
+				piece_index_t const last = fs.map_file(f
+					, std::max<std::int64_t>(fs.file_size(f) - 1, 0), 0).piece;
+				for (piece_index_t p = first; p <= last
+					&& p < m_trusted_pieces.end_index(); ++p)
+					m_trusted_pieces.clear_bit(p);
+			}
+
+			if (m_trusted_pieces.none_set()) m_trusted_pieces.clear();
+#ifndef TORRENT_DISABLE_LOGGING
+			else if (should_log())
+			{
+				debug_log("resume file fingerprints match, trusting %d pieces"
+					, m_trusted_pieces.count());
+			}
+#endif
+		}
+
 		if (should_start_full_check)
 		{
 			set_state(torrent_status::checking_files);
@@ -2291,6 +2601,9 @@ bool is_downloading_state(int const st)
 			m_progress_ppm = 0;
 			m_checking_piece = piece_index_t(0);
 			m_num_checked_pieces = piece_index_t(0);
+			// the user asked for a recheck. Don't trust any pieces based on
+			// resume-data fingerprints
+			m_trusted_pieces.clear();
 
 			set_state(torrent_status::checking_files);
 			if (m_auto_managed) pause(torrent_handle::graceful_pause);
@@ -2318,6 +2631,27 @@ bool is_downloading_state(int const st)
 			- static_cast<int>(m_num_checked_pieces));
 		if (num_outstanding <= 0) return;
 
+		// pieces covered entirely by files whose resume-data fingerprints
+		// still match don't need to be re-hashed
+		while (m_checking_piece < m_trusted_pieces.end_index()
+			&& m_trusted_pieces.get_bit(m_checking_piece))
+			skip_trusted_piece();
+
+		if (m_checking_piece >= m_torrent_file->end_piece()
+			&& m_num_checked_pieces >= m_torrent_file->end_piece())
+		{
+			// the fingerprints let us trust every piece. There are no hash
+			// jobs to wait for
+#ifndef TORRENT_DISABLE_LOGGING
+			debug_log("start_checking, all pieces trusted via resume data");
+#endif
+			m_trusted_pieces.clear();
+			files_checked();
+			m_checking_piece = piece_index_t(0);
+			m_num_checked_pieces = piece_index_t(0);
+			return;
+		}
+
 		// we might already have some outstanding jobs, if we were paused and
 		// resumed quickly, before the outstanding jobs completed
 		if (m_checking_piece >= m_torrent_file->end_piece())
@@ -2331,6 +2665,11 @@ bool is_downloading_state(int const st)
 
 		for (int i = 0; i < num_outstanding; ++i)
 		{
+			while (m_checking_piece < m_trusted_pieces.end_index()
+				&& m_trusted_pieces.get_bit(m_checking_piece))
+				skip_trusted_piece();
+			if (m_checking_piece >= m_torrent_file->end_piece()) break;
+
 			auto flags = disk_interface::sequential_access | disk_interface::volatile_read;
 			if (torrent_file().info_hashes().has_v1())
 				flags |= disk_interface::v1_hash;
@@ -2397,6 +2736,7 @@ bool is_downloading_state(int const st)
 			{
 				m_checking_piece = piece_index_t{0};
 				m_num_checked_pieces = piece_index_t{0};
+				m_trusted_pieces.clear();
 				if (m_ses.alerts().should_post<file_error_alert>())
 					m_ses.alerts().emplace_alert<file_error_alert>(error.ec,
 						resolve_filename(error.file()), error.operation, get_handle());
@@ -2472,6 +2812,12 @@ bool is_downloading_state(int const st)
 				m_picker->mark_as_finished(piece_block(piece, i), nullptr);
 		}
 
+		// pieces covered entirely by files whose resume-data fingerprints
+		// still match don't need to be re-hashed
+		while (m_checking_piece < m_trusted_pieces.end_index()
+			&& m_trusted_pieces.get_bit(m_checking_piece))
+			skip_trusted_piece();
+
 		if (m_num_checked_pieces < m_torrent_file->end_piece())
 		{
 			// we're not done yet, issue another job
@@ -2532,6 +2878,8 @@ bool is_downloading_state(int const st)
 			set_paused(true, {});
 		}
 
+		m_trusted_pieces.clear();
+
 		// we're done checking! (this should cause a call to trigger_auto_manage)
 		files_checked();
 
@@ -2541,6 +2889,22 @@ bool is_downloading_state(int const st)
 	}
 	catch (...) { handle_exception(); }
 
+	void torrent::skip_trusted_piece()
+	{
+		TORRENT_ASSERT(is_single_thread());
+		TORRENT_ASSERT(m_checking_piece < m_trusted_pieces.end_index());
+		TORRENT_ASSERT(m_trusted_pieces.get_bit(m_checking_piece));
+		need_picker();
+		if (!m_picker->have_piece(m_checking_piece))
+		{
+			m_picker->we_have(m_checking_piece);
+			update_gauge();
+			we_have(m_checking_piece);
+		}
+		++m_num_checked_pieces;
+		++m_checking_piece;
+	}
+
 #if TORRENT_ABI_VERSION == 1
 	void torrent::use_interface(std::string net_interfaces)
 	{
@@ -2746,7 +3110,7 @@ bool is_downloading_state(int const st)
 namespace {
 	void refresh_endpoint_list(aux::session_interface& ses
 		, bool const is_ssl, bool const complete_sent
-		, std::vector<aux::announce_endpoint>& aeps)
+		, aux::small_vector<aux::announce_endpoint, 1>& aeps)
 	{
 		// update the endpoint list by adding entries for new listen sockets
 		// and removing entries for non-existent ones
@@ -3280,7 +3644,7 @@ namespace {
 			update_auto_sequential();
 
 			// these numbers are cached in the resume data
-			set_need_save_resume();
+			set_need_save_resume(torrent_handle::if_counters_changed);
 		}
 	}
 
@@ -3311,6 +3675,14 @@ namespace {
 		auto const interval = std::max(resp.interval, seconds32(
 			settings().get_int(settings_pack::min_announce_interval)));
 
+		// add a random jitter of up to 10% on top of the announce interval.
+		// after a session restart (or a tracker outage) a large number of
+		// torrents announce within the same few seconds. Without jitter they
+		// stay synchronized and hit the tracker in a thundering herd every
+		// interval. Announcing later than the tracker asked for is always
+		// safe
+		seconds32 const jitter(random(std::uint32_t(interval.count() / 10)));
+
 		aux::announce_entry* ae = find_tracker(r.url);
 		tcp::endpoint local_endpoint;
 		if (ae)
@@ -3335,7 +3707,7 @@ namespace {
 					m_complete_sent = true;
 				}
 				ae->verified = true;
-				a.next_announce = now + interval;
+				a.next_announce = now + interval + jitter;
 				a.min_announce = now + resp.min_interval;
 				a.updating = false;
 				a.fails = 0;
@@ -4020,7 +4392,7 @@ namespace {
 			p->update_interest();
 		}
 
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_download_progress);
 		state_updated();
 		update_want_tick();
 
@@ -4177,6 +4549,8 @@ namespace {
 		TORRENT_ASSERT(is_single_thread());
 		TORRENT_ASSERT(!m_picker->has_piece_passed(index));
 
+		TORRENT_TRACE_INSTANT("piece_passed", static_cast<int>(index));
+
 #ifndef TORRENT_DISABLE_LOGGING
 		if (should_log())
 			debug_log("PIECE_PASSED (%d)", num_passed());
@@ -4187,7 +4561,7 @@ namespace {
 		TORRENT_ASSERT(index >= piece_index_t(0));
 		TORRENT_ASSERT(index < m_torrent_file->end_piece());
 
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_download_progress);
 
 		inc_stats_counter(counters::num_piece_passed);
 
@@ -4289,6 +4663,8 @@ namespace {
 		TORRENT_ASSERT(index < m_torrent_file->end_piece());
 		TORRENT_ASSERT(std::is_sorted(blocks.begin(), blocks.end()));
 
+		TORRENT_TRACE_INSTANT("piece_failed", static_cast<int>(index));
+
 		inc_stats_counter(counters::num_piece_failed);
 
 #ifndef TORRENT_DISABLE_PREDICTIVE_PIECES
@@ -4732,7 +5108,7 @@ namespace {
 		if (on == m_super_seeding) return;
 
 		m_super_seeding = on;
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_config_changed);
 		state_updated();
 
 		if (m_super_seeding) return;
@@ -5080,6 +5456,81 @@ namespace {
 		}
 	}
 
+	void torrent::set_streaming_cursor(std::int64_t offset)
+	{
+		INVARIANT_CHECK;
+
+		if (m_abort || !valid_metadata()) return;
+
+		std::int64_t const total_size = m_torrent_file->total_size();
+		if (offset < 0) offset = 0;
+		if (offset >= total_size) offset = total_size - 1;
+
+		time_point const now = aux::time_now();
+
+		// estimate the consumption rate from how far the cursor moved
+		// since the last update. A single sample is noisy (players read
+		// in bursts), so smooth it with an exponential moving average
+		if (m_streaming_cursor >= 0 && offset > m_streaming_cursor)
+		{
+			std::int64_t const ms = total_milliseconds(now - m_streaming_cursor_time);
+			if (ms > 0)
+			{
+				std::int64_t const sample = (offset - m_streaming_cursor) * 1000 / ms;
+				m_streaming_rate = (m_streaming_rate == 0)
+					? sample : (m_streaming_rate * 3 + sample) / 4;
+			}
+		}
+		else if (offset < m_streaming_cursor)
+		{
+			// the consumer sought backwards. The rate estimate doesn't
+			// carry over across a seek
+			m_streaming_rate = 0;
+		}
+		m_streaming_cursor = offset;
+		m_streaming_cursor_time = now;
+
+		int const piece_len = m_torrent_file->piece_length();
+		piece_index_t const cursor_piece(static_cast<int>(offset / piece_len));
+
+		// everything behind the cursor has been consumed. Drop those
+		// deadlines so the picker stops favoring data nobody will read
+		std::vector<piece_index_t> stale;
+		for (auto const& p : m_time_critical_pieces)
+			if (p.piece < cursor_piece) stale.push_back(p.piece);
+		for (piece_index_t const p : stale)
+			remove_time_critical_piece(p);
+
+		// size the read-ahead window to roughly 10 seconds of playback,
+		// but never less than 4 pieces. Until we have a rate estimate,
+		// the minimum window applies
+		std::int64_t window = std::max(m_streaming_rate * 10
+			, std::int64_t(piece_len) * 4);
+
+		piece_index_t const end_piece = m_torrent_file->end_piece();
+		for (piece_index_t p = cursor_piece; p < end_piece; ++p)
+		{
+			std::int64_t const piece_start = std::int64_t(static_cast<int>(p)) * piece_len;
+			if (piece_start >= offset + window) break;
+
+			// deadline is the estimated time until the consumer reaches
+			// this piece. With no rate estimate yet, just space the
+			// deadlines out to preserve in-order picking
+			std::int64_t const distance = std::max(piece_start - offset, std::int64_t(0));
+			int const deadline = (m_streaming_rate > 0)
+				? int(distance * 1000 / m_streaming_rate)
+				: (static_cast<int>(p) - static_cast<int>(cursor_piece)) * 250;
+			set_piece_deadline(p, deadline, {});
+		}
+	}
+
+	void torrent::clear_streaming_cursor()
+	{
+		m_streaming_cursor = -1;
+		m_streaming_rate = 0;
+		clear_time_critical();
+	}
+
 	// remove time critical pieces where priority is 0
 	void torrent::remove_time_critical_pieces(aux::vector<download_priority_t, piece_index_t> const& priority)
 	{
@@ -5115,6 +5566,20 @@ namespace {
 		m_picker->get_availability(avail);
 	}
 
+	void torrent::piece_availability_histogram(aux::vector<int>& hist) const
+	{
+		INVARIANT_CHECK;
+
+		TORRENT_ASSERT(valid_metadata());
+		if (!has_picker())
+		{
+			hist.clear();
+			return;
+		}
+
+		m_picker->get_availability_histogram(hist);
+	}
+
 	void torrent::set_piece_priority(piece_index_t const index
 		, download_priority_t const priority)
 	{
@@ -5206,7 +5671,7 @@ namespace {
 		if (filter_updated)
 		{
 			// we need to save this new state
-			set_need_save_resume();
+			set_need_save_resume(torrent_handle::if_config_changed);
 
 			update_peer_interest(was_finished);
 		}
@@ -5232,24 +5697,23 @@ namespace {
 
 		need_picker();
 
-		piece_index_t index(0);
-		bool filter_updated = false;
-		bool const was_finished = is_finished();
-		for (auto prio : pieces)
-		{
-			static_assert(std::is_unsigned<decltype(prio)::underlying_type>::value
-				, "we need assert prio >= dont_download");
+		static_assert(std::is_unsigned<download_priority_t::underlying_type>::value
+			, "we need assert prio >= dont_download");
+#if TORRENT_USE_ASSERTS
+		for (auto const prio : pieces)
 			TORRENT_ASSERT(prio <= top_priority);
-			filter_updated |= m_picker->set_piece_priority(index, prio);
-			++index;
-		}
+#endif
+		bool const was_finished = is_finished();
+		// the bulk call restructures the picker's priority ordering once,
+		// rather than once per piece
+		bool const filter_updated = m_picker->set_piece_priorities(pieces);
 		update_gauge();
 		update_want_tick();
 
 		if (filter_updated)
 		{
 			// we need to save this new state
-			set_need_save_resume();
+			set_need_save_resume(torrent_handle::if_config_changed);
 
 			update_peer_interest(was_finished);
 #ifndef TORRENT_DISABLE_STREAMING
@@ -5644,7 +6108,7 @@ namespace {
 
 		if (!m_trackers.empty()) announce_with_tracker();
 
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_config_changed);
 	}
 
 	void torrent::prioritize_udp_trackers()
@@ -6012,6 +6476,17 @@ namespace {
 			set_paused(true);
 		}
 
+#ifndef TORRENT_DISABLE_DHT
+		if (m_connections.empty() && !m_abort && m_announcing
+			&& !is_finished() && m_ses.dht())
+		{
+			// we just lost our last peer and we're still downloading. Jump
+			// ahead of the regular DHT announce rotation to find new peers,
+			// rather than waiting for our turn among all torrents
+			m_ses.prioritize_dht(shared_from_this());
+		}
+#endif
+
 		update_want_peers();
 		update_want_tick();
 	}
@@ -6757,6 +7232,36 @@ namespace {
 				ret.verified_pieces = m_verified;
 		}
 
+		// record per-file fingerprints (size and mtime). They let us trust
+		// the have_pieces bitfield on the next start-up, even if a full
+		// recheck would otherwise be required, as long as the files haven't
+		// been touched since. stat() is metadata-only, it's cheap compared
+		// to serializing the resume data itself
+		if (valid_metadata() && !ret.have_pieces.empty())
+		{
+			file_storage const& fs = m_torrent_file->files();
+			ret.file_sizes.reserve(std::size_t(fs.num_files()));
+			for (auto const i : fs.file_range())
+			{
+				if (fs.pad_file_at(i))
+				{
+					ret.file_sizes.emplace_back(fs.file_size(i), 0);
+					continue;
+				}
+				file_status s;
+				error_code err;
+				stat_file(fs.file_path(i, m_save_path), &s, err);
+				if (err)
+				{
+					// a file we can't stat (e.g. it only exists in the
+					// part file) can never be trusted on the next load
+					ret.file_sizes.emplace_back(-1, 0);
+					continue;
+				}
+				ret.file_sizes.emplace_back(s.file_size, std::int64_t(s.mtime));
+			}
+		}
+
 		// write renamed files
 		if (valid_metadata()
 			&& &m_torrent_file->files() != &m_torrent_file->orig_files()
@@ -7147,6 +7652,10 @@ namespace {
 			boost::get<i2p_stream>(ret).set_destination(static_cast<i2p_peer*>(peerinfo)->dest());
 			boost::get<i2p_stream>(ret).set_command(i2p_stream::cmd_connect);
 			boost::get<i2p_stream>(ret).set_session_id(m_ses.i2p_session());
+			// if the SAM bridge has a standby socket with the handshake
+			// already out of the way, connecting to this peer only takes
+			// the STREAM CONNECT round-trip
+			m_ses.i2p_conn().take_warm_socket(boost::get<i2p_stream>(ret));
 			return ret;
 		}
 		else
@@ -7174,6 +7683,18 @@ namespace {
 					m_torrent_file->info_hashes().get(peerinfo->protocol()));
 
 				boost::apply_visitor(hostname_visitor{host_name}, ret);
+
+				// the SNI name is the info-hash, shared by every peer of
+				// this torrent, so sessions are keyed by the remote
+				// endpoint instead: resumption only makes sense when
+				// reconnecting to the same peer
+				auto stream_handle = boost::apply_visitor(ssl_handle_visitor{}, ret);
+				if (stream_handle)
+				{
+					ssl::prime_client_session(stream_handle
+						, ssl::get_handle(*m_ssl_ctx)
+						, print_endpoint(peerinfo->ip()));
+				}
 			}
 #endif
 			return ret;
@@ -7401,7 +7922,7 @@ namespace {
 		for (auto p : m_connections)
 			p->disconnect_if_redundant();
 
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_metadata_changed);
 
 		return true;
 	}
@@ -7683,6 +8204,14 @@ namespace {
 		return false;
 	}
 
+	// this predicate is what makes ticking event-driven rather than
+	// per-torrent. The session only iterates the torrent_want_tick list,
+	// and a torrent removes itself from it as soon as it has no peers, no
+	// rate history to decay and has been declared inactive (via the
+	// inactivity deadline timer, see on_inactivity_tick()). Tracker
+	// announces are driven by m_tracker_timer, not by ticks, so an idle
+	// seed costs nothing per second regardless of how many torrents the
+	// session has loaded
 	bool torrent::want_tick() const
 	{
 		if (m_abort) return false;
@@ -8131,7 +8660,7 @@ namespace {
 			if (m_super_seeding)
 			{
 				m_super_seeding = false;
-				set_need_save_resume();
+				set_need_save_resume(torrent_handle::if_download_progress);
 				state_updated();
 			}
 #endif
@@ -8219,6 +8748,10 @@ namespace {
 		start_announcing();
 
 		maybe_connect_web_seeds();
+
+		// start converging towards a fully verified seed in the
+		// background, instead of waiting for peers to request every piece
+		if (m_seed_mode) kick_background_verification();
 	}
 
 	aux::alert_manager& torrent::alerts() const
@@ -8330,7 +8863,7 @@ namespace {
 
 			m_save_path = save_path;
 #endif
-			set_need_save_resume();
+			set_need_save_resume(torrent_handle::if_config_changed);
 		}
 	}
 
@@ -8346,7 +8879,7 @@ namespace {
 			if (alerts().should_post<storage_moved_alert>())
 				alerts().emplace_alert<storage_moved_alert>(get_handle(), path, m_save_path);
 			m_save_path = path;
-			set_need_save_resume();
+			set_need_save_resume(torrent_handle::if_config_changed);
 			if (status == status_t::need_full_check)
 				force_recheck();
 		}
@@ -8628,7 +9161,7 @@ namespace {
 		debug_log("*** set-sequential-download: %d", sd);
 #endif
 
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_config_changed);
 
 		state_updated();
 	}
@@ -8682,7 +9215,7 @@ namespace {
 #endif
 
 		if (state_update)
-			set_need_save_resume();
+			set_need_save_resume(torrent_handle::if_config_changed);
 	}
 
 	void torrent::set_max_connections(int limit, bool const state_update)
@@ -8706,13 +9239,13 @@ namespace {
 		}
 
 		if (state_update)
-			set_need_save_resume();
+			set_need_save_resume(torrent_handle::if_config_changed);
 	}
 
 	void torrent::set_upload_limit(int const limit)
 	{
 		set_limit_impl(limit, peer_connection::upload_channel);
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_config_changed);
 #ifndef TORRENT_DISABLE_LOGGING
 		debug_log("*** set-upload-limit: %d", limit);
 #endif
@@ -8721,7 +9254,7 @@ namespace {
 	void torrent::set_download_limit(int const limit)
 	{
 		set_limit_impl(limit, peer_connection::download_channel);
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_config_changed);
 #ifndef TORRENT_DISABLE_LOGGING
 		debug_log("*** set-download-limit: %d", limit);
 #endif
@@ -8875,7 +9408,7 @@ namespace {
 		state_updated();
 
 		// we need to save this new state as well
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_state_changed);
 
 		// recalculate which torrents should be
 		// paused
@@ -8996,14 +9529,22 @@ namespace {
 			return;
 		}
 
-		if ((flags & torrent_handle::only_if_modified) && !m_need_save_resume_data)
+		// if any of the if_* flags are specified, only changes to those parts
+		// of the resume data count as a modification. only_if_modified alone
+		// means any change counts
+		resume_data_flags_t conditions = flags & all_dirty_conditions;
+		if ((flags & torrent_handle::only_if_modified) || conditions)
 		{
-			alerts().emplace_alert<save_resume_data_failed_alert>(get_handle()
-				, errors::resume_data_not_modified);
-			return;
+			if (!conditions) conditions = all_dirty_conditions;
+			if (!(m_need_save_resume_data & conditions))
+			{
+				alerts().emplace_alert<save_resume_data_failed_alert>(get_handle()
+					, errors::resume_data_not_modified);
+				return;
+			}
 		}
 
-		m_need_save_resume_data = false;
+		m_need_save_resume_data = {};
 		state_updated();
 
 		if ((flags & torrent_handle::flush_disk_cache) && m_storage)
@@ -9077,7 +9618,7 @@ namespace {
 		if (!m_paused)
 		{
 			// we need to save this new state
-			set_need_save_resume();
+			set_need_save_resume(torrent_handle::if_state_changed);
 		}
 
 		set_paused(true, flags | torrent_handle::clear_disk_cache);
@@ -9242,7 +9783,7 @@ namespace {
 		auto const it = std::find(m_web_seeds.begin(), m_web_seeds.end(), ent);
 		if (it != m_web_seeds.end()) return &*it;
 		m_web_seeds.push_back(ent);
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_config_changed);
 		update_want_tick();
 		return &m_web_seeds.back();
 	}
@@ -9320,7 +9861,7 @@ namespace {
 		update_gauge();
 
 		// we need to save this new state
-		set_need_save_resume();
+		set_need_save_resume(torrent_handle::if_state_changed);
 
 		do_resume();
 	}
@@ -9369,6 +9910,9 @@ namespace {
 		start_announcing();
 
 		do_connect_boost();
+
+		// resume background verification where we left off
+		if (m_seed_mode) kick_background_verification();
 	}
 
 	namespace
@@ -9762,11 +10306,13 @@ namespace {
 
 		m_total_uploaded += m_stat.last_payload_uploaded();
 		m_total_downloaded += m_stat.last_payload_downloaded();
-		m_stat.second_tick(tick_interval_ms);
 
-		// these counters are saved in the resume data, since they updated
+		// these counters are saved in the resume data, if they updated
 		// we need to save the resume data too
-		m_need_save_resume_data = true;
+		if (m_stat.last_payload_uploaded() > 0 || m_stat.last_payload_downloaded() > 0)
+			set_need_save_resume(torrent_handle::if_counters_changed);
+
+		m_stat.second_tick(tick_interval_ms);
 
 		// if the rate is 0, there's no update because of network transfers
 		if (m_stat.low_pass_upload_rate() > 0 || m_stat.low_pass_download_rate() > 0)
@@ -9863,6 +10409,15 @@ namespace {
 				continue;
 
 			--limit;
+			// each web seed entry supports a single connection. Opening
+			// multiple sockets to the same URL (e.g. one per resolved CDN
+			// endpoint) would require the web_seed_t state (peer_info, ban
+			// and retry bookkeeping, the have-pieces view handed to the
+			// picker) to be shared across connections, which the whole web
+			// seed subsystem assumes is 1:1. Depth on the one connection
+			// comes from pipelined range requests instead (the request
+			// queue is sized by request_queue_time x download rate, and
+			// adjacent blocks merge into urlseed_max_request_bytes ranges)
 			if (w->peer_info.connection || w->resolving)
 				continue;
 
@@ -10592,7 +11147,7 @@ namespace {
 		if (i != m_web_seeds.end())
 		{
 			remove_web_seed_iter(i);
-			set_need_save_resume();
+			set_need_save_resume(torrent_handle::if_config_changed);
 		}
 	}
 
@@ -11383,41 +11938,44 @@ namespace {
 #endif
 
 		st->current_tracker.clear();
-		if (m_last_working_tracker >= 0)
-		{
-			TORRENT_ASSERT(m_last_working_tracker < m_trackers.end_index());
-			const int i = m_last_working_tracker;
-			st->current_tracker = m_trackers[i].url;
-		}
-		else
+		if (flags & torrent_handle::query_current_tracker)
 		{
+			if (m_last_working_tracker >= 0)
+			{
+				TORRENT_ASSERT(m_last_working_tracker < m_trackers.end_index());
+				const int i = m_last_working_tracker;
+				st->current_tracker = m_trackers[i].url;
+			}
+			else
+			{
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wmissing-braces"
 #endif
-			aux::array<bool const, num_protocols, protocol_version> const supports_protocol{
-			{
-				m_info_hash.has_v1(),
-				m_info_hash.has_v2()
-			}};
+				aux::array<bool const, num_protocols, protocol_version> const supports_protocol{
+				{
+					m_info_hash.has_v1(),
+					m_info_hash.has_v2()
+				}};
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
 
-			for (auto const& t : m_trackers)
-			{
-				if (std::any_of(t.endpoints.begin(), t.endpoints.end()
-					, [supports_protocol](aux::announce_endpoint const& aep) {
-						for (protocol_version const ih : all_versions)
-						{
-							if (supports_protocol[ih] && aep.info_hashes[ih].updating)
-								return false;
-						}
-						return true;
-					})) continue;
-				if (!t.verified) continue;
-				st->current_tracker = t.url;
-				break;
+				for (auto const& t : m_trackers)
+				{
+					if (std::any_of(t.endpoints.begin(), t.endpoints.end()
+						, [supports_protocol](aux::announce_endpoint const& aep) {
+							for (protocol_version const ih : all_versions)
+							{
+								if (supports_protocol[ih] && aep.info_hashes[ih].updating)
+									return false;
+							}
+							return true;
+						})) continue;
+					if (!t.verified) continue;
+					st->current_tracker = t.url;
+					break;
+				}
 			}
 		}
 
@@ -11527,6 +12085,18 @@ namespace {
 		}
 
 		st->last_seen_complete = m_swarm_last_seen_complete;
+
+		if (flags & torrent_handle::query_memory_usage)
+		{
+			st->picker_memory_usage = picker_memory_usage();
+			st->peer_list_memory_usage = peer_list_memory_usage();
+			st->metadata_memory_usage = metadata_memory_usage();
+			for (auto const pc : m_connections)
+			{
+				TORRENT_INCREMENT(m_iterating_connections);
+				st->queued_write_bytes += pc->outstanding_writing_bytes();
+			}
+		}
 	}
 
 	int torrent::priority() const
@@ -482,6 +482,12 @@ namespace libtorrent {
 		sync_call(&torrent::piece_availability, availr);
 	}
 
+	void torrent_handle::piece_availability_histogram(std::vector<int>& hist) const
+	{
+		auto histr = std::ref(static_cast<aux::vector<int>&>(hist));
+		sync_call(&torrent::piece_availability_histogram, histr);
+	}
+
 	void torrent_handle::piece_priority(piece_index_t index, download_priority_t priority) const
 	{
 		async_call(&torrent::set_piece_priority, index, priority);
@@ -703,6 +709,11 @@ namespace libtorrent {
 		async_call(&torrent::read_piece, piece);
 	}
 
+	void torrent_handle::read_piece_blocks(piece_index_t piece) const
+	{
+		async_call(&torrent::read_piece_blocks, piece);
+	}
+
 	bool torrent_handle::have_piece(piece_index_t piece) const
 	{
 		return sync_call_ret<bool>(false, &torrent::user_have_piece, piece);
@@ -886,6 +897,22 @@ namespace libtorrent {
 #endif
 	}
 
+	void torrent_handle::set_streaming_cursor(std::int64_t const offset) const
+	{
+#ifndef TORRENT_DISABLE_STREAMING
+		async_call(&torrent::set_streaming_cursor, offset);
+#else
+		TORRENT_UNUSED(offset);
+#endif
+	}
+
+	void torrent_handle::clear_streaming_cursor() const
+	{
+#ifndef TORRENT_DISABLE_STREAMING
+		async_call(&torrent::clear_streaming_cursor);
+#endif
+	}
+
 	std::shared_ptr<torrent> torrent_handle::native_handle() const
 	{
 		return m_torrent.lock();
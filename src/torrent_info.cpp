@@ -574,7 +574,8 @@ namespace {
 	bool extract_files2(bdecode_node const& tree, file_storage& target
 		, std::string const& root_dir, ptrdiff_t const info_offset
 		, char const* info_buffer
-		, bool const has_files, int const depth, error_code& ec)
+		, bool const has_files, int const max_files
+		, int const depth, error_code& ec)
 	{
 		if (tree.type() != bdecode_node::dict_t)
 		{
@@ -626,11 +627,18 @@ namespace {
 				{
 					return false;
 				}
+				// bail out as soon as the limit is exceeded, rather than
+				// building the full (potentially enormous) file list first
+				if (target.num_files() > max_files)
+				{
+					ec = errors::too_many_files_in_torrent;
+					return false;
+				}
 				continue;
 			}
 
 			if (!extract_files2(e.second, target, path, info_offset, info_buffer
-				, true, depth + 1, ec))
+				, true, max_files, depth + 1, ec))
 			{
 				return false;
 			}
@@ -643,13 +651,18 @@ namespace {
 	// torrent, in which case it's empty.
 	bool extract_files(bdecode_node const& list, file_storage& target
 		, std::string const& root_dir, std::ptrdiff_t info_offset
-		, char const* info_buffer, error_code& ec)
+		, char const* info_buffer, int const max_files, error_code& ec)
 	{
 		if (list.type() != bdecode_node::list_t)
 		{
 			ec = errors::torrent_file_parse_failed;
 			return false;
 		}
+		if (list.list_size() > max_files)
+		{
+			ec = errors::too_many_files_in_torrent;
+			return false;
+		}
 		target.reserve(list.list_size());
 
 		for (int i = 0, end(list.list_size()); i < end; ++i)
@@ -907,10 +920,10 @@ namespace {
 #endif
 		}
 #ifndef BOOST_NO_EXCEPTIONS
-		if (!parse_torrent_file(e, ec, load_torrent_limits{}.max_pieces))
+		if (!parse_torrent_file(e, ec, load_torrent_limits{}))
 			aux::throw_ex<system_error>(ec);
 #else
-		parse_torrent_file(e, ec, load_torrent_limits{}.max_pieces);
+		parse_torrent_file(e, ec, load_torrent_limits{});
 #endif
 		INVARIANT_CHECK;
 	}
@@ -920,7 +933,7 @@ namespace {
 	torrent_info::torrent_info(bdecode_node const& torrent_file)
 	{
 		error_code ec;
-		if (!parse_torrent_file(torrent_file, ec, load_torrent_limits{}.max_pieces))
+		if (!parse_torrent_file(torrent_file, ec, load_torrent_limits{}))
 			aux::throw_ex<system_error>(ec);
 
 		INVARIANT_CHECK;
@@ -932,7 +945,7 @@ namespace {
 		bdecode_node e = bdecode(buffer, ec);
 		if (ec) aux::throw_ex<system_error>(ec);
 
-		if (!parse_torrent_file(e, ec, load_torrent_limits{}.max_pieces))
+		if (!parse_torrent_file(e, ec, load_torrent_limits{}))
 			aux::throw_ex<system_error>(ec);
 
 		INVARIANT_CHECK;
@@ -948,7 +961,7 @@ namespace {
 		bdecode_node e = bdecode(buf, ec);
 		if (ec) aux::throw_ex<system_error>(ec);
 
-		if (!parse_torrent_file(e, ec, load_torrent_limits{}.max_pieces))
+		if (!parse_torrent_file(e, ec, load_torrent_limits{}))
 			aux::throw_ex<system_error>(ec);
 
 		INVARIANT_CHECK;
@@ -958,7 +971,7 @@ namespace {
 		, load_torrent_limits const& cfg)
 	{
 		error_code ec;
-		if (!parse_torrent_file(torrent_file, ec, cfg.max_pieces))
+		if (!parse_torrent_file(torrent_file, ec, cfg))
 			aux::throw_ex<system_error>(ec);
 
 		INVARIANT_CHECK;
@@ -972,7 +985,7 @@ namespace {
 			, cfg.max_decode_depth, cfg.max_decode_tokens);
 		if (ec) aux::throw_ex<system_error>(ec);
 
-		if (!parse_torrent_file(e, ec, cfg.max_pieces))
+		if (!parse_torrent_file(e, ec, cfg))
 			aux::throw_ex<system_error>(ec);
 
 		INVARIANT_CHECK;
@@ -990,7 +1003,7 @@ namespace {
 			, cfg.max_decode_tokens);
 		if (ec) aux::throw_ex<system_error>(ec);
 
-		if (!parse_torrent_file(e, ec, cfg.max_pieces))
+		if (!parse_torrent_file(e, ec, cfg))
 			aux::throw_ex<system_error>(ec);
 
 		INVARIANT_CHECK;
@@ -1014,7 +1027,7 @@ namespace {
 	torrent_info::torrent_info(bdecode_node const& torrent_file
 		, error_code& ec)
 	{
-		parse_torrent_file(torrent_file, ec, load_torrent_limits{}.max_pieces);
+		parse_torrent_file(torrent_file, ec, load_torrent_limits{});
 		INVARIANT_CHECK;
 	}
 
@@ -1023,7 +1036,7 @@ namespace {
 	{
 		bdecode_node e = bdecode(buffer, ec);
 		if (ec) return;
-		parse_torrent_file(e, ec, load_torrent_limits{}.max_pieces);
+		parse_torrent_file(e, ec, load_torrent_limits{});
 
 		INVARIANT_CHECK;
 	}
@@ -1036,7 +1049,7 @@ namespace {
 
 		bdecode_node e = bdecode(buf, ec);
 		if (ec) return;
-		parse_torrent_file(e, ec, load_torrent_limits{}.max_pieces);
+		parse_torrent_file(e, ec, load_torrent_limits{});
 
 		INVARIANT_CHECK;
 	}
@@ -1075,9 +1088,9 @@ namespace {
 
 	boost::shared_array<char> torrent_info::metadata() const
 	{
-		boost::shared_array<char> ret(new char[std::size_t(m_info_section_size)]);
-		std::memcpy(ret.get(), m_info_section.get(), std::size_t(m_info_section_size));
-		return ret;
+		// the info section buffer is immutable once the torrent is loaded, so
+		// we can share it with the caller instead of copying it
+		return m_info_section;
 	}
 #endif
 
@@ -1108,6 +1121,13 @@ namespace {
 
 	bool torrent_info::parse_info_section(bdecode_node const& info
 		, error_code& ec, int const max_pieces)
+	{
+		return parse_info_section_impl(info, ec, max_pieces
+			, load_torrent_limits{}.max_file_count);
+	}
+
+	bool torrent_info::parse_info_section_impl(bdecode_node const& info
+		, error_code& ec, int const max_pieces, int const max_file_count)
 	{
 		if (info.type() != bdecode_node::dict_t)
 		{
@@ -1131,7 +1151,12 @@ namespace {
 			return false;
 		}
 
-		// copy the info section
+		// copy the info section. This is the only copy we make of the caller's
+		// buffer; the resulting shared_array is reference counted and shared
+		// by all copies of this torrent_info, and everything parsed out of the
+		// info dictionary (file names, piece hashes, the info dict itself)
+		// points into it. Borrowing the caller's buffer instead would make
+		// those internal pointers dangle as soon as the caller frees it
 		m_info_section_size = int(section.size());
 		m_info_section.reset(new char[aux::numeric_cast<std::size_t>(m_info_section_size)]);
 		std::memcpy(m_info_section.get(), section.data(), aux::numeric_cast<std::size_t>(m_info_section_size));
@@ -1226,7 +1251,7 @@ namespace {
 		if (version >= 2 && file_tree_node)
 		{
 			if (!extract_files2(file_tree_node, files, name, info_offset
-				, m_info_section.get(), bool(files_node), 0, ec))
+				, m_info_section.get(), bool(files_node), max_file_count, 0, ec))
 			{
 				// mark the torrent as invalid
 				m_files.set_piece_length(0);
@@ -1281,7 +1306,7 @@ namespace {
 		else
 		{
 			if (!extract_files(files_node, version == 2 ? v1_files : files, name
-				, info_offset, m_info_section.get(), ec))
+				, info_offset, m_info_section.get(), max_file_count, ec))
 			{
 				// mark the torrent as invalid
 				m_files.set_piece_length(0);
@@ -1484,6 +1509,29 @@ namespace {
 		return m_piece_layers[f];
 	}
 
+	std::int64_t torrent_info::memory_usage() const
+	{
+		std::int64_t ret = std::int64_t(sizeof(*this));
+		ret += m_info_section_size;
+		ret += m_files.memory_usage();
+		if (m_orig_files) ret += m_orig_files->memory_usage();
+		for (auto const& ae : m_urls)
+		{
+			ret += std::int64_t(sizeof(ae));
+			ret += std::int64_t(ae.url.capacity()) + std::int64_t(ae.trackerid.capacity());
+		}
+		for (auto const& ws : m_web_seeds)
+		{
+			ret += std::int64_t(sizeof(ws));
+			ret += std::int64_t(ws.url.capacity()) + std::int64_t(ws.auth.capacity());
+		}
+		ret += std::int64_t(m_merkle_tree.capacity()) * std::int64_t(sizeof(sha1_hash));
+		ret += std::int64_t(m_piece_layers.capacity()) * std::int64_t(sizeof(aux::vector<char>));
+		for (auto const& l : m_piece_layers) ret += std::int64_t(l.capacity());
+		ret += std::int64_t(m_comment.capacity()) + std::int64_t(m_created_by.capacity());
+		return ret;
+	}
+
 	void torrent_info::free_piece_layers()
 	{
 		m_piece_layers.clear();
@@ -1514,7 +1562,7 @@ namespace {
 	}
 
 	bool torrent_info::parse_torrent_file(bdecode_node const& torrent_file
-		, error_code& ec, int const piece_limit)
+		, error_code& ec, load_torrent_limits const& cfg)
 	{
 		if (torrent_file.type() != bdecode_node::dict_t)
 		{
@@ -1543,7 +1591,8 @@ namespace {
 			return false;
 		}
 
-		if (!parse_info_section(info, ec, piece_limit)) return false;
+		if (!parse_info_section_impl(info, ec, cfg.max_pieces, cfg.max_file_count))
+			return false;
 		resolve_duplicate_filenames();
 
 		if (m_info_hash.has_v2() && !parse_piece_layers(torrent_file.dict_find_dict("piece layers"), ec))
@@ -114,4 +114,21 @@ namespace libtorrent {
 		--m_live_allocations;
 	}
 
+	void torrent_peer_allocator::free_all_peer_entries()
+	{
+		TORRENT_ASSERT(m_in_use);
+		// this returns the pools' slabs to the heap without visiting the
+		// individual entries. ipv4_peer and ipv6_peer don't own any heap
+		// allocations, so skipping their destructors is fine. i2p_peer
+		// entries own their destination string and must have been freed
+		// through free_peer_entry() before calling this
+		m_ipv4_peer_pool.purge_memory();
+		m_ipv6_peer_pool.purge_memory();
+#if TORRENT_USE_I2P
+		m_i2p_peer_pool.purge_memory();
+#endif
+		m_live_bytes = 0;
+		m_live_allocations = 0;
+	}
+
 }
@@ -71,7 +71,12 @@ std::size_t const tmp_buffer_size = 270;
 std::size_t const max_header_size = 255;
 
 // this class hold the state of the SOCKS5 connection to maintain the UDP
-// ASSOCIATE tunnel. It's instantiated on the heap for two reasons:
+// ASSOCIATE tunnel. There is one tunnel per listen socket (i.e. per local
+// endpoint), not one per peer: every uTP connection and all DHT and UDP
+// tracker traffic on the listen socket is multiplexed over this single
+// association, and incoming datagrams are demultiplexed by the source
+// address in the SOCKS5 wrapper header. It's instantiated on the heap for
+// two reasons:
 //
 // 1. since its asynchronous functions may refer to it after the udp_socket has
 //    been destructed, it needs to be held by a shared_ptr
@@ -186,13 +191,16 @@ udp_socket::udp_socket(io_context& ios, aux::listen_socket_handle ls)
 
 int udp_socket::read(span<packet> pkts, error_code& ec)
 {
-	auto const num = int(pkts.size());
+	auto const num = std::min(int(pkts.size()), int(max_packets_per_read));
 	int ret = 0;
-	packet p;
 
 	while (ret < num)
 	{
-		int const len = int(m_socket.receive_from(boost::asio::buffer(*m_buf)
+		packet p;
+		// each packet is read into its own buffer. Skipped packets reuse
+		// their slot for the next read
+		auto& buf = (*m_buf)[std::size_t(ret)];
+		int const len = int(m_socket.receive_from(boost::asio::buffer(buf)
 			, p.from, 0, ec));
 
 		if (ec == error::would_block
@@ -220,7 +228,7 @@ int udp_socket::read(span<packet> pkts, error_code& ec)
 		}
 		else
 		{
-			p.data = {m_buf->data(), len};
+			p.data = {buf.data(), len};
 
 			// support packets coming from the SOCKS5 proxy
 			if (active_socks5())
@@ -247,11 +255,6 @@ int udp_socket::read(span<packet> pkts, error_code& ec)
 
 		pkts[ret] = p;
 		++ret;
-
-		// we only have a single buffer for now, so we can only return a
-		// single packet. In the future though, we could attempt to drain
-		// the socket here, or maybe even use recvmmsg()
-		break;
 	}
 
 	return ret;
@@ -336,6 +339,15 @@ void udp_socket::send(udp::endpoint const& ep, span<char const> p
 	set_dont_frag df(m_socket, (flags & dont_fragment)
 		&& aux::is_v4(ep));
 
+	// Linux segmentation offload (UDP_SEGMENT on the way out, UDP_GRO on the
+	// way in) could fold a whole train of MTU-sized uTP packets into one
+	// syscall. It deliberately isn't used here: the segment size has to be
+	// carried in cmsg ancillary data on each sendmsg()/recvmsg(), which
+	// boost.asio's datagram socket API doesn't expose, and without the cmsg
+	// on receive a GRO super-packet can't be split back up (uTP headers
+	// don't carry a length). A GSO train also requires uniformly sized
+	// packets to one destination, which nagle packets, MTU probes and
+	// SOCKS5-wrapped packets routinely violate
 	m_socket.send_to(boost::asio::buffer(p.data(), static_cast<std::size_t>(p.size())), ep, 0, ec);
 }
 
@@ -264,6 +264,17 @@ namespace libtorrent {
 		auto const cc = m_connection_cache.find(m_target.address());
 		if (cc != m_connection_cache.end())
 		{
+			// another announce to this endpoint recently timed out. Fail
+			// fast instead of spending a full timeout cycle of our own.
+			// Every torrent still records the failure and enters its
+			// regular tracker backoff
+			if (aux::time_now() < cc->second.unreachable_until)
+			{
+				l.unlock();
+				fail(error_code(errors::timed_out), operation_t::timer);
+				return;
+			}
+
 			// we found a cached entry! Now, we can only
 			// use if if it hasn't expired
 			if (aux::time_now() < cc->second.expires)
@@ -294,6 +305,17 @@ namespace libtorrent {
 		std::shared_ptr<request_callback> cb = requester();
 		if (cb) cb->debug_log("*** UDP_TRACKER [ timed out url: %s ]", tracker_req().url.c_str());
 #endif
+
+		// record the timeout in the shared cache, so other announces to the
+		// same endpoint can fail fast while it lasts. The window is short;
+		// the first announce after it has passed probes the tracker again
+		if (m_target != udp::endpoint())
+		{
+			std::lock_guard<std::mutex> l(m_cache_mutex);
+			m_connection_cache[m_target.address()].unreachable_until
+				= aux::time_now() + seconds(30);
+		}
+
 		fail(error_code(errors::timed_out), operation_t::timer);
 	}
 
@@ -450,6 +472,8 @@ namespace libtorrent {
 		connection_cache_entry& cce = m_connection_cache[m_target.address()];
 		cce.connection_id = connection_id;
 		cce.expires = aux::time_now() + seconds(m_man.settings().get_int(settings_pack::udp_tracker_token_expiry));
+		// the tracker is clearly reachable
+		cce.unreachable_until = min_time();
 
 		if (!(tracker_req().kind & tracker_request::scrape_request))
 			send_udp_announce();
@@ -526,6 +550,14 @@ namespace libtorrent {
 		sent_bytes(16 + 28); // assuming UDP/IP header
 	}
 
+	// the UDP tracker protocol allows scraping around 70 info-hashes in one
+	// packet, but we only ever pack a single one. Batching scrapes across
+	// torrents would need an aggregation window in tracker_manager plus
+	// fanning one response out to multiple request callbacks, while
+	// tracker_request and request_callback::tracker_scrape_response() carry
+	// exactly one info-hash end to end. Scrapes are rare (user-initiated),
+	// and the shared connection-id cache already removes the per-scrape
+	// connect round-trip, so the plumbing rewrite hasn't been worth it
 	void udp_tracker_connection::send_udp_scrape()
 	{
 		if (m_abort) return;
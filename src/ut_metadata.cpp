@@ -81,6 +81,15 @@ namespace {
 		// we may hit this case (and the client requesting
 		// doesn't throttle its requests)
 		max_incoming_requests = 1024,
+
+		// the maximum number of metadata pieces to serve per torrent and
+		// tick, across all connections (32 pieces = 512 kiB/s). The
+		// per-connection send buffer cap only bounds each peer; this
+		// bounds the whole torrent, so a leech swarm can't turn this
+		// client into a metadata CDN by spreading requests over many
+		// connections. Requests over budget are queued and served on
+		// later ticks
+		max_metadata_pieces_per_tick = 32,
 	};
 
 	enum class msg_t : std::uint8_t
@@ -150,6 +159,21 @@ namespace {
 			m_requested_metadata.resize(div_round_up(size, 16 * 1024));
 		}
 
+		// takes one piece out of this torrent's metadata serving budget.
+		// Returns false if the budget for this tick is used up, in which
+		// case the request should be queued and retried on a later tick
+		bool claim_metadata_piece()
+		{
+			if (m_send_quota <= 0) return false;
+			--m_send_quota;
+			return true;
+		}
+
+		void tick() override
+		{
+			m_send_quota = max_metadata_pieces_per_tick;
+		}
+
 		// explicitly disallow assignment, to silence msvc warning
 		ut_metadata_plugin& operator=(ut_metadata_plugin const&) = delete;
 
@@ -162,6 +186,10 @@ namespace {
 		// torrent_info of the underlying torrent
 		aux::vector<char> m_metadata;
 
+		// the number of metadata pieces this torrent may still serve this
+		// tick, across all connections
+		int m_send_quota = max_metadata_pieces_per_tick;
+
 		struct metadata_piece
 		{
 			metadata_piece() = default;
@@ -358,7 +386,8 @@ namespace {
 						write_metadata_packet(msg_t::dont_have, piece);
 						return true;
 					}
-					if (m_pc.send_buffer_size() < send_buffer_limit)
+					if (m_pc.send_buffer_size() < send_buffer_limit
+						&& m_tp.claim_metadata_piece())
 						write_metadata_packet(msg_t::piece, piece);
 					else if (m_incoming_requests.size() < max_incoming_requests)
 						m_incoming_requests.push_back(piece);
@@ -409,7 +438,8 @@ namespace {
 		{
 			maybe_send_request();
 			while (!m_incoming_requests.empty()
-				&& m_pc.send_buffer_size() < send_buffer_limit)
+				&& m_pc.send_buffer_size() < send_buffer_limit
+				&& m_tp.claim_metadata_piece())
 			{
 				int const piece = m_incoming_requests.front();
 				m_incoming_requests.erase(m_incoming_requests.begin());
@@ -45,6 +45,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/peer_info.hpp"
 #include "libtorrent/aux_/socket_type.hpp" // for is_utp
 #include "libtorrent/performance_counters.hpp" // for counters
+#include "libtorrent/bloom_filter.hpp"
 #include "libtorrent/extensions/ut_pex.hpp"
 #include "libtorrent/aux_/time.hpp"
 #include "libtorrent/aux_/ip_helpers.hpp" // for is_v4
@@ -58,9 +59,40 @@ namespace libtorrent { namespace {
 	enum
 	{
 		extension_index = 1,
-		max_peer_entries = 100
+		max_peer_entries = 100,
+
+		// the maximum number of new peers PEX may hand to the peer list
+		// per torrent and tick interval. In a storm of PEX messages, the
+		// overflow is dropped; peers worth knowing keep being exchanged
+		// and get through on a later tick
+		max_pex_adds_per_tick = 200
 	};
 
+	// maps an endpoint to a key for the PEX dedup bloom filter. The filter
+	// only looks at the first 4 bytes of the key (as two bit indices), so
+	// mix the whole endpoint into them. This is much cheaper than the
+	// SHA-1 the filter is normally keyed with, which matters at PEX
+	// message rates
+	sha1_hash pex_filter_key(tcp::endpoint const& ep)
+	{
+		std::uint32_t h = 0x811c9dc5;
+		auto const feed = [&h](std::uint8_t const b)
+		{ h = (h ^ b) * 0x01000193; };
+		if (aux::is_v4(ep))
+			for (auto const b : ep.address().to_v4().to_bytes()) feed(b);
+		else
+			for (auto const b : ep.address().to_v6().to_bytes()) feed(b);
+		feed(ep.port() & 0xff);
+		feed((ep.port() >> 8) & 0xff);
+
+		sha1_hash k;
+		k[0] = h & 0xff;
+		k[1] = (h >> 8) & 0xff;
+		k[2] = (h >> 16) & 0xff;
+		k[3] = (h >> 24) & 0xff;
+		return k;
+	}
+
 	bool send_peer(peer_connection const& p)
 	{
 		// don't send out those peers that we haven't connected to
@@ -103,11 +135,39 @@ namespace libtorrent { namespace {
 		// are calculated here and the pex message is created
 		// each peer connection will use this message
 		// max_peer_entries limits the packet size
+		// cross-connection dedup and rate budget for peers received via
+		// PEX. Big swarms deliver the same peers from dozens of
+		// connections; the bloom filter collapses those duplicates before
+		// they reach the peer list. Returns true if the endpoint should be
+		// handed to add_peer(). A false positive only delays learning about
+		// a peer until the filter is next cleared
+		bool register_pex_peer(tcp::endpoint const& ep)
+		{
+			if (m_pex_adds_left <= 0) return false;
+			sha1_hash const k = pex_filter_key(ep);
+			if (m_pex_filter.find(k)) return false;
+			m_pex_filter.set(k);
+			--m_pex_adds_left;
+			return true;
+		}
+
 		void tick() override
 		{
 			if (m_torrent.flags() & torrent_flags::disable_pex) return;
 
 			time_point const now = aux::time_now();
+
+			// replenish the PEX processing budget and periodically forget
+			// the dedup filter, so it doesn't saturate (and so peers that
+			// disappeared and came back, or collided with a false positive,
+			// get another chance)
+			m_pex_adds_left = max_pex_adds_per_tick;
+			if (now - minutes(5) >= m_last_filter_clear)
+			{
+				m_pex_filter.clear();
+				m_last_filter_clear = now;
+			}
+
 			if (now - seconds(60) < m_last_msg) return;
 			m_last_msg = now;
 
@@ -221,6 +281,14 @@ namespace libtorrent { namespace {
 		std::vector<char> m_ut_pex_msg;
 		int m_peers_in_message;
 
+		// endpoints already handed to the peer list by PEX, across all of
+		// this torrent's connections. Cleared every few minutes from tick()
+		bloom_filter<2048> m_pex_filter;
+		time_point m_last_filter_clear = min_time();
+
+		// how many more PEX peers may be added this tick interval
+		int m_pex_adds_left = max_pex_adds_per_tick;
+
 		// explicitly disallow assignment, to silence msvc warning
 		ut_pex_plugin& operator=(ut_pex_plugin const&) = delete;
 	};
@@ -353,6 +421,8 @@ namespace libtorrent { namespace {
 					// do we already know about this peer?
 					if (j != m_peers.end() && *j == v) continue;
 					m_peers.insert(j, v);
+					// did some other connection already deliver this peer?
+					if (!m_tp.register_pex_peer(adr)) continue;
 					m_torrent.add_peer(adr, peer_info::pex, flags);
 					peers_added = true;
 				}
@@ -405,6 +475,8 @@ namespace libtorrent { namespace {
 					// do we already know about this peer?
 					if (j != m_peers6.end() && *j == v) continue;
 					m_peers6.insert(j, v);
+					// did some other connection already deliver this peer?
+					if (!m_tp.register_pex_peer(adr)) continue;
 					m_torrent.add_peer(adr, peer_info::pex, flags);
 					peers_added = true;
 				}
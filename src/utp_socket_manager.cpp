@@ -56,6 +56,7 @@ namespace aux {
 		, io_context& ios
 		, aux::session_settings const& sett
 		, counters& cnt
+		, aux::packet_pool& pool
 		, void* ssl_context)
 		: m_send_fun(std::move(send_fun))
 		, m_cb(std::move(cb))
@@ -63,6 +64,7 @@ namespace aux {
 		, m_counters(cnt)
 		, m_ios(ios)
 		, m_ssl_context(ssl_context)
+		, m_packet_pool(pool)
 	{
 		m_restrict_mtu.fill(65536);
 	}
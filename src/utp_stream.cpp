@@ -41,6 +41,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "libtorrent/aux_/utp_stream.hpp"
 #include "libtorrent/aux_/utp_socket_manager.hpp"
 #include "libtorrent/aux_/alloca.hpp"
+#include "libtorrent/aux_/tracepoint.hpp"
 #include "libtorrent/error.hpp"
 #include "libtorrent/random.hpp"
 #include "libtorrent/aux_/invariant_check.hpp"
@@ -1043,6 +1044,12 @@ std::pair<std::uint32_t, int> utp_socket_impl::parse_sack(std::uint16_t const pa
 	int acked_bytes = 0;
 	std::uint32_t min_rtt = std::numeric_limits<std::uint32_t>::max();
 
+	// the most recent time we sent a packet that this SACK message acks.
+	// this is the basis for time based (RACK style) loss detection. Any
+	// packet sent sufficiently long before this one, that still hasn't been
+	// acked, is deemed lost
+	time_point rack_time = min_time();
+
 	// this was implicitly lost
 	if (!compare_less_wrap((packet_ack + 1) & ACK_MASK, m_fast_resend_seq_nr, ACK_MASK))
 	{
@@ -1066,6 +1073,7 @@ std::pair<std::uint32_t, int> utp_socket_impl::parse_sack(std::uint16_t const pa
 				if (p)
 				{
 					acked_bytes += p->size - p->header_size;
+					if (p->send_time > rack_time) rack_time = p->send_time;
 					// each ACKed packet counts as a duplicate ack
 					UTP_LOGV("%8p: duplicate_acks:%u fast_resend_seq_nr:%u\n"
 						, static_cast<void*>(this), m_duplicate_acks, m_fast_resend_seq_nr);
@@ -1122,14 +1130,27 @@ std::pair<std::uint32_t, int> utp_socket_impl::parse_sack(std::uint16_t const pa
 		if (dups > dup_ack_limit) break;
 	}
 
-	// we did not get enough packets acked in this message to warrant a resend
-	if (dups <= dup_ack_limit)
+	// the classic fast-retransmit trigger requires more than 'dup_ack_limit'
+	// packets past a hole to be acked in this message. With fewer ACKs than
+	// that, we fall back on time based loss detection (in the style of RACK)
+	// below, and only resend packets that were sent at least a reordering
+	// window before the most recently sent packet this message acks. On long
+	// RTT links, where a loss may be followed by just a few stretched ACKs,
+	// this recovers much sooner than waiting for the timeout
+	bool const dup_ack_trigger = dups > dup_ack_limit;
+
+	if (!dup_ack_trigger)
 	{
 		UTP_LOGV("%8p: only %d ACKs in SACK, requires more than %d to trigger fast retransmit\n"
 			, static_cast<void*>(this), dups, dup_ack_limit);
-		num_to_resend = 0;
 	}
 
+	// allow for some packet reordering before declaring a packet lost on
+	// time alone. A quarter of the round-trip time means genuinely reordered
+	// packets would have to be delayed by a quarter RTT relative to their
+	// neighbors to trigger a spurious resend
+	milliseconds const reorder_window(std::max(m_rtt.mean() / 4, 1));
+
 	// now we need to (likely) prune the tail of the resend list, since all
 	// "unacked" packets that weren't followed by an acked one, don't count
 	while (num_to_resend > 0 && !compare_less_wrap(resend[num_to_resend - 1], last_resend, ACK_MASK))
@@ -1149,9 +1170,16 @@ std::pair<std::uint32_t, int> utp_socket_impl::parse_sack(std::uint16_t const pa
 		std::uint16_t const pkt_seq = resend[i];
 
 		packet* p = m_outbuf.at(pkt_seq);
+		if (!p) continue;
+
+		// without enough duplicate ACKs, only resend the packet if a packet
+		// sent at least a reordering window later has been acked
+		if (!dup_ack_trigger
+			&& p->send_time + reorder_window > rack_time)
+			continue;
+
 		UTP_LOGV("%8p: Packet %d lost. (fast_resend_seq_nr:%d trigger fast-resend)\n"
 			, static_cast<void*>(this), pkt_seq, m_fast_resend_seq_nr);
-		if (!p) continue;
 
 		// don't cut cwnd if the packet we lost was the MTU probe
 		// the logic to handle a lost MTU probe is in resend_packet()
@@ -1172,7 +1200,14 @@ std::pair<std::uint32_t, int> utp_socket_impl::parse_sack(std::uint16_t const pa
 }
 
 // copies data from the write buffer into the packet
-// pointed to by ptr
+// pointed to by ptr.
+// This copy is deliberate. A packet must stay valid until it's acked, to
+// serve retransmissions, while the source buffers (e.g. disk buffers when
+// seeding) are returned to their owner as soon as the write completes.
+// Referencing the source buffers from the packet instead would pin disk
+// buffers for a full round-trip (plus any retransmission timeline), and the
+// resend path needs header and payload contiguous to hand a single flat
+// buffer to sendto()
 void utp_socket_impl::write_payload(std::uint8_t* ptr, int size)
 {
 	INVARIANT_CHECK;
@@ -1906,6 +1941,7 @@ void utp_socket_impl::maybe_inc_acked_seq_nr()
 std::uint32_t utp_socket_impl::ack_packet(packet_ptr p, time_point const receive_time
 	, std::uint16_t seq_nr)
 {
+	TORRENT_PROBE1(utp_ack_packet, seq_nr);
 #ifdef TORRENT_EXPENSIVE_INVARIANT_CHECKS
 	INVARIANT_CHECK;
 #endif
@@ -2703,7 +2739,7 @@ bool utp_socket_impl::incoming_packet(span<char const> b
 				// sure to clamp it as a sanity check
 				if (delay > min_rtt) delay = min_rtt;
 
-				do_ledbat(acked_bytes, int(delay), prev_bytes_in_flight);
+				cwnd_adjust(acked_bytes, int(delay), prev_bytes_in_flight);
 				m_send_delay = std::int32_t(delay);
 			}
 
@@ -2943,6 +2979,15 @@ bool utp_socket_impl::incoming_packet(span<char const> b
 	return true;
 }
 
+void utp_socket_impl::cwnd_adjust(const int acked_bytes, const int delay
+	, const int in_flight)
+{
+	if (m_sm.congestion_control() == settings_pack::utp_ledbat_pp)
+		do_ledbat_pp(acked_bytes, delay, in_flight);
+	else
+		do_ledbat(acked_bytes, delay, in_flight);
+}
+
 void utp_socket_impl::do_ledbat(const int acked_bytes, const int delay
 	, const int in_flight)
 {
@@ -3062,6 +3107,163 @@ void utp_socket_impl::do_ledbat(const int acked_bytes, const int delay
 */
 }
 
+void utp_socket_impl::do_ledbat_pp(const int acked_bytes, const int delay
+	, const int in_flight)
+{
+	INVARIANT_CHECK;
+
+	TORRENT_ASSERT(in_flight > 0);
+	TORRENT_ASSERT(acked_bytes > 0);
+
+	// LEDBAT++ aims lower than the classic LEDBAT target. The full
+	// configured target builds a standing queue large enough to inflate
+	// our own delay measurements
+	const int target_delay = std::max(1, m_sm.target_delay() * 3 / 5);
+
+	time_point const now = clock_type::now();
+
+	// the round-trip time in milliseconds, with a floor to keep the
+	// slowdown scheduling sane before we have enough samples
+	int const rtt = std::max(m_rtt.mean(), 50);
+
+	if (m_slowdown_until != min_time())
+	{
+		if (now < m_slowdown_until)
+		{
+			// we're in a periodic slowdown, holding the window at two
+			// packets. Don't touch cwnd until it's over
+			return;
+		}
+
+		// the slowdown is over. Grow back towards the window we had
+		// before, using slow-start
+		m_slowdown_until = min_time();
+		m_slow_start = true;
+		m_next_slowdown = now + milliseconds(rtt * 9);
+		UTP_LOGV("%8p: slowdown over ssthres:%d slow_start -> 1\n"
+			, static_cast<void*>(this), m_ssthres);
+	}
+	else if (!m_slow_start)
+	{
+		if (m_next_slowdown == min_time())
+		{
+			// we just left slow-start (whichever path took us out of it).
+			// schedule the first periodic slowdown
+			m_next_slowdown = now + milliseconds(rtt * 9);
+		}
+		else if (now >= m_next_slowdown)
+		{
+			// enter a periodic slowdown. Remember the current window and
+			// drop to two packets for two round-trips. This drains the
+			// queue we built ourselves, so the one-way delay samples taken
+			// afterwards reflect the actual base delay again
+			m_ssthres = std::int32_t(m_cwnd >> 16);
+			m_cwnd = std::int64_t(m_mtu) * 2 * (1 << 16);
+			m_slowdown_until = now + milliseconds(rtt * 2);
+			UTP_LOGV("%8p: periodic slowdown cwnd:%d ssthres:%d\n"
+				, static_cast<void*>(this), int(m_cwnd >> 16), m_ssthres);
+			return;
+		}
+	}
+
+	// true if the upper layer is pushing enough data down the socket to be
+	// limited by the cwnd. If this is not the case, we should not adjust cwnd.
+	const bool cwnd_saturated = (m_bytes_in_flight + acked_bytes + m_mtu > (m_cwnd >> 16));
+
+	// all of these are fixed points with 16 bits fraction portion
+	const std::int64_t window_factor = (std::int64_t(acked_bytes) * (1 << 16)) / in_flight;
+	const std::int64_t delay_factor = (std::int64_t(target_delay - delay) * (1 << 16)) / target_delay;
+	std::int64_t scaled_gain;
+
+	// leave slow-start well before the queueing delay reaches the target.
+	// by the time it does, we have already overshot the link
+	if (delay >= target_delay * 3 / 4)
+	{
+		if (m_slow_start)
+		{
+			UTP_LOGV("%8p: off_target: %d slow_start -> 0\n"
+				, static_cast<void*>(this), target_delay - delay);
+			m_ssthres = std::int32_t((m_cwnd >> 16) / 2);
+			m_slow_start = false;
+		}
+	}
+
+	if (delay >= target_delay)
+		m_sm.inc_stats_counter(counters::utp_samples_above_target);
+	else
+		m_sm.inc_stats_counter(counters::utp_samples_below_target);
+
+	std::int64_t const linear_gain = ((window_factor * delay_factor) >> 16)
+		* std::int64_t(m_sm.gain_factor());
+
+	// if the user is not saturating the link (i.e. not filling the
+	// congestion window), don't adjust it at all.
+	if (cwnd_saturated)
+	{
+		std::int64_t const exponential_gain = std::int64_t(acked_bytes) * (1 << 16);
+		if (m_slow_start)
+		{
+			// mimic TCP slow-start by adding the number of acked
+			// bytes to cwnd
+			if (m_ssthres != 0 && ((m_cwnd + exponential_gain) >> 16) > m_ssthres)
+			{
+				// if we would exceed the slow start threshold by growing the cwnd
+				// exponentially, don't do it, and leave slow-start mode. This
+				// make us avoid causing more delay and/or packet loss by being too
+				// aggressive
+				m_slow_start = false;
+				scaled_gain = linear_gain;
+				UTP_LOGV("%8p: cwnd > ssthres (%d) slow_start -> 0\n"
+					, static_cast<void*>(this), m_ssthres);
+			}
+			else
+			{
+				scaled_gain = std::max(exponential_gain, linear_gain);
+			}
+		}
+		else
+		{
+			scaled_gain = linear_gain;
+		}
+	}
+	else
+	{
+		scaled_gain = 0;
+	}
+
+	// make sure we don't wrap the cwnd
+	if (scaled_gain >= std::numeric_limits<std::int64_t>::max() - m_cwnd)
+		scaled_gain = std::numeric_limits<std::int64_t>::max() - m_cwnd - 1;
+
+	UTP_LOGV("%8p: do_ledbat_pp delay:%d off_target: %d window_factor:%f target_factor:%f "
+		"scaled_gain:%f cwnd:%d slow_start:%d\n"
+		, static_cast<void*>(this), delay, target_delay - delay, window_factor / double(1 << 16)
+		, delay_factor / double(1 << 16)
+		, scaled_gain / double(1 << 16), int(m_cwnd >> 16)
+		, int(m_slow_start));
+
+	// if scaled_gain + m_cwnd <= 0, set m_cwnd to 0
+	if (-scaled_gain >= m_cwnd)
+	{
+		m_cwnd = 0;
+	}
+	else
+	{
+		m_cwnd += scaled_gain;
+		TORRENT_ASSERT(m_cwnd > 0);
+	}
+
+	TORRENT_ASSERT(m_cwnd >= 0);
+
+	int const window_size_left = std::min(int(m_cwnd >> 16), int(m_adv_wnd)) - in_flight + acked_bytes;
+	if (window_size_left >= m_mtu)
+	{
+		UTP_LOGV("%8p: mtu:%d in_flight:%d adv_wnd:%d cwnd:%d acked_bytes:%d cwnd_full -> 0\n"
+			, static_cast<void*>(this), m_mtu, in_flight, int(m_adv_wnd), int(m_cwnd >> 16), acked_bytes);
+		m_cwnd_full = false;
+	}
+}
+
 void utp_stream::bind(endpoint_type const&, error_code&) { }
 
 void utp_stream::cancel_handlers(error_code const& ec)
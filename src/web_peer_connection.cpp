@@ -189,7 +189,7 @@ void web_peer_connection::on_connected()
 		}
 		else
 		{
-			incoming_bitfield(have);
+			incoming_bitfield(std::move(have));
 		}
 	}
 
@@ -47,6 +47,17 @@ namespace libtorrent {
 
 	entry write_resume_data(add_torrent_params const& atp)
 	{
+		// building this tree costs a few dozen small allocations per
+		// torrent (map nodes and strings). Constructing it in a monotonic
+		// arena has been considered and rejected: entry is a public value
+		// type whose dictionary and string types are part of the API, so a
+		// caller-provided allocator would have to parameterize the whole
+		// class and everything that touches it. A separate streaming
+		// bencoder for this path would duplicate the resume format in two
+		// places that could drift apart. The lists and strings below
+		// reserve() their final sizes, and write_resume_data_buf() encodes
+		// into a single exactly-sized buffer, which are the cheap parts of
+		// that idea
 		entry ret;
 
 		using namespace libtorrent::aux; // for write_*_endpoint()
@@ -220,6 +231,20 @@ namespace libtorrent {
 			++piece;
 		}
 
+		// write per-file fingerprints
+		if (!atp.file_sizes.empty())
+		{
+			entry::list_type& sizes = ret["file sizes"].list();
+			sizes.reserve(atp.file_sizes.size());
+			for (auto const& fp : atp.file_sizes)
+			{
+				entry::list_type fingerprint;
+				fingerprint.emplace_back(fp.first);
+				fingerprint.emplace_back(fp.second);
+				sizes.emplace_back(std::move(fingerprint));
+			}
+		}
+
 		// write renamed files
 		if (!atp.renamed_files.empty())
 		{
@@ -287,9 +312,13 @@ namespace libtorrent {
 
 	std::vector<char> write_resume_data_buf(add_torrent_params const& atp)
 	{
-		std::vector<char> ret;
-		entry rd = write_resume_data(atp);
-		bencode(std::back_inserter(ret), rd);
+		entry const rd = write_resume_data(atp);
+		// size the buffer in one allocation and fill it linearly, instead
+		// of growing it through a back_inserter
+		std::vector<char> ret(std::size_t(bencoded_size(rd)));
+		int const written = bencode(span<char>(ret), rd);
+		TORRENT_ASSERT(written == int(ret.size()));
+		TORRENT_UNUSED(written);
 		return ret;
 	}
 }
@@ -313,6 +313,61 @@ TORRENT_TEST(dropped_alerts)
 	TEST_CHECK(d.test(torrent_finished_alert::alert_type));
 }
 
+TORRENT_TEST(alert_type_stats)
+{
+	aux::alert_manager mgr(100, alert_category::all);
+
+	for (piece_index_t i{0}; i < piece_index_t{10}; ++i)
+		mgr.emplace_alert<piece_finished_alert>(torrent_handle(), i);
+
+	// an alert carrying variable length content
+	mgr.emplace_alert<log_alert>("a log message");
+
+	auto st = mgr.alert_type_stats(piece_finished_alert::alert_type);
+	TEST_EQUAL(st.posted, 10);
+	TEST_EQUAL(st.dropped, 0);
+	TEST_EQUAL(st.queued, 10);
+	TEST_EQUAL(st.peak_queued, 10);
+	TEST_EQUAL(st.bytes, 0);
+
+	TEST_CHECK(mgr.alert_type_stats(log_alert::alert_type).bytes > 0);
+
+	std::vector<alert*> alerts;
+	mgr.get_all(alerts);
+
+	// handing the queue to the client resets residency, but not the
+	// cumulative counts nor the high-water mark
+	st = mgr.alert_type_stats(piece_finished_alert::alert_type);
+	TEST_EQUAL(st.queued, 0);
+	TEST_EQUAL(st.posted, 10);
+	TEST_EQUAL(st.peak_queued, 10);
+}
+
+TORRENT_TEST(alert_type_queue_limit)
+{
+	aux::alert_manager mgr(1000, alert_category::all);
+	mgr.set_alert_type_queue_limit(piece_finished_alert::alert_type, 5);
+
+	for (piece_index_t i{0}; i < piece_index_t{20}; ++i)
+		mgr.emplace_alert<piece_finished_alert>(torrent_handle(), i);
+
+	// the cap only applies to piece_finished_alert
+	mgr.emplace_alert<torrent_finished_alert>(torrent_handle());
+
+	auto const st = mgr.alert_type_stats(piece_finished_alert::alert_type);
+	TEST_EQUAL(st.posted, 5);
+	TEST_EQUAL(st.queued, 5);
+	TEST_EQUAL(st.dropped, 15);
+
+	std::vector<alert*> alerts;
+	mgr.get_all(alerts);
+
+	// 5 piece_finished + torrent_finished + alerts_dropped
+	TEST_EQUAL(alerts.size(), 7);
+	auto const d = alert_cast<alerts_dropped_alert>(alerts.back())->dropped_alerts;
+	TEST_CHECK(d.test(piece_finished_alert::alert_type));
+}
+
 TORRENT_TEST(alerts_dropped_alert)
 {
 	aux::alert_manager mgr(1, alert_category::all);
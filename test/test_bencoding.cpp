@@ -126,6 +126,26 @@ TORRENT_TEST(undefined_node)
 	TEST_EQUAL(encode(e), "0:");
 }
 
+TORRENT_TEST(bencoded_size)
+{
+	entry e(entry::dictionary_t);
+	e["spam"] = entry("eggs");
+	e["cow"] = entry("moo");
+	e["ints"] = entry::list_type{entry(0), entry(-1), entry(1234567890)};
+	e["undefined"] = entry(entry::undefined_t);
+	char const str[] = "foobar";
+	e["pre"] = entry::preformatted_type(str, str + sizeof(str) - 1);
+
+	std::string const flat = encode(e);
+	TEST_EQUAL(bencoded_size(e), std::int64_t(flat.size()));
+
+	// the sized, single-pass writer produces the same output
+	std::vector<char> buf(std::size_t(bencoded_size(e)));
+	int const written = bencode(span<char>(buf), e);
+	TEST_EQUAL(written, int(flat.size()));
+	TEST_CHECK(std::equal(buf.begin(), buf.end(), flat.begin()));
+}
+
 TORRENT_TEST(undefined_node2)
 {
 	entry e(entry::dictionary_t);
@@ -300,6 +300,35 @@ TORRENT_TEST(find_first_set_late)
 	TEST_EQUAL(test1.find_first_set(), 98);
 }
 
+TORRENT_TEST(find_first_set_from_index)
+{
+	bitfield test1(100, false);
+	test1.set_bit(4);
+	test1.set_bit(33);
+	test1.set_bit(98);
+	TEST_EQUAL(test1.find_first_set(0), 4);
+	TEST_EQUAL(test1.find_first_set(4), 4);
+	TEST_EQUAL(test1.find_first_set(5), 33);
+	TEST_EQUAL(test1.find_first_set(33), 33);
+	TEST_EQUAL(test1.find_first_set(34), 98);
+	TEST_EQUAL(test1.find_first_set(98), 98);
+	TEST_EQUAL(test1.find_first_set(99), -1);
+	TEST_EQUAL(test1.find_first_set(100), -1);
+}
+
+TORRENT_TEST(find_first_set_from_index_iterate)
+{
+	bitfield test1(75, true);
+	int num = 0;
+	for (int i = test1.find_first_set(0); i != -1;
+		i = test1.find_first_set(i + 1))
+	{
+		TEST_EQUAL(i, num);
+		++num;
+	}
+	TEST_EQUAL(num, 75);
+}
+
 TORRENT_TEST(find_last_clear_empty)
 {
 	bitfield test1(0);
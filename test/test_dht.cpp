@@ -3469,6 +3469,27 @@ TORRENT_TEST(node_id_bucket_distribution)
 	}
 }
 
+TORRENT_TEST(node_id_compare_ref)
+{
+	// make sure the word-wise compare_ref agrees with comparing the full
+	// XOR distances
+	for (int i = 0; i < 1000; ++i)
+	{
+		node_id const ref = generate_random_id();
+		node_id const n1 = generate_random_id();
+		node_id const n2 = generate_random_id();
+		TEST_EQUAL(compare_ref(n1, n2, ref), (n1 ^ ref) < (n2 ^ ref));
+	}
+
+	// ties in the high bits must be broken by the low bits
+	node_id const ref = to_hash("ffffffffffffffffffffffffffffffffffffffff");
+	node_id const n1 = to_hash("0000000000000000000000000000000000000001");
+	node_id const n2 = to_hash("0000000000000000000000000000000000000002");
+	TEST_EQUAL(compare_ref(n1, n2, ref), false);
+	TEST_EQUAL(compare_ref(n2, n1, ref), true);
+	TEST_EQUAL(compare_ref(n1, n1, ref), false);
+}
+
 TORRENT_TEST(node_id_min_distance_exp)
 {
 	node_id const n1 = to_hash("0000000000000000000000000000000000000002");
@@ -3653,6 +3674,10 @@ TORRENT_TEST(dht_state)
 	s.nids.emplace_back(make_address("1.1.1.1"), to_hash("0000000000000000000000000000000000000001"));
 	s.nodes.push_back(uep("1.1.1.1", 1));
 	s.nodes.push_back(uep("2.2.2.2", 2));
+	s.table_nodes.emplace_back(to_hash("0000000000000000000000000000000000000003")
+		, uep("3.3.3.3", 3));
+	s.table_nodes.emplace_back(to_hash("0000000000000000000000000000000000000004")
+		, uep("4.4.4.4", 4));
 	// remove these for now because they will only get used if the host system has IPv6 support
 	// hopefully in the future we can rely on the test system supporting IPv6
 	//s.nids.emplace_back(make_address("1::1"), to_hash("0000000000000000000000000000000000000002"));
@@ -3672,6 +3697,7 @@ TORRENT_TEST(dht_state)
 	dht_state const s1 = read_dht_state(n);
 	TEST_CHECK(s1.nids == s.nids);
 	TEST_CHECK(s1.nodes == s.nodes);
+	TEST_CHECK(s1.table_nodes == s.table_nodes);
 
 	// empty
 	bdecode_node n1;
@@ -532,6 +532,40 @@ TORRENT_TEST(only_pick_have_pieces)
 	TEST_EQUAL(picked[2].count, 0);
 }
 
+TORRENT_TEST(no_repick_received_hashes)
+{
+	file_storage fs;
+	fs.set_piece_length(4 * 16 * 1024);
+
+	fs.add_file("test/tmp1", 4 * 1024 * 16 * 1024);
+
+	aux::vector<aux::merkle_tree, file_index_t> trees;
+	auto const full_tree = build_tree(4 * 1024);
+	sha256_hash const root = full_tree[0];
+	trees.emplace_back(4 * 1024, 4, root.data());
+
+	hash_picker picker(fs, trees);
+
+	typed_bitfield<piece_index_t> const pieces(1024, true);
+
+	auto const picked = picker.pick_hashes(pieces);
+	TEST_EQUAL(picked.index, 0);
+	TEST_EQUAL(picked.count, 512);
+
+	auto const pieces_start = full_tree.begin() + merkle_num_nodes(1024) - 1024;
+	std::vector<sha256_hash> hashes;
+	std::copy(pieces_start, pieces_start + 512, std::back_inserter(hashes));
+	hashes.push_back(full_tree[2]);
+	add_hashes_result const result = picker.add_hashes(picked, hashes);
+	TEST_CHECK(result.valid);
+
+	// the span was delivered, picking again must move on to the second
+	// span instead of requesting the first one from another peer
+	auto const picked2 = picker.pick_hashes(pieces);
+	TEST_EQUAL(picked2.index, 512);
+	TEST_EQUAL(picked2.count, 512);
+}
+
 TORRENT_TEST(validate_hash_request)
 {
 	file_storage fs;
@@ -258,3 +258,20 @@ TORRENT_TEST(port_filter)
 	TEST_CHECK(pf.access(65535) == 0);
 }
 
+
+TORRENT_TEST(interleaved_add_and_access)
+{
+	// access() maintains a cached, flattened copy of the rules. Make sure
+	// it's refreshed when rules are added between lookups
+	ip_filter f;
+	TEST_CHECK(f.access(addr("1.0.0.5")) == 0);
+
+	f.add_rule(addr("1.0.0.0"), addr("1.255.255.255"), ip_filter::blocked);
+	TEST_CHECK(f.access(addr("1.0.0.5")) == ip_filter::blocked);
+	TEST_CHECK(f.access(addr("2.0.0.1")) == 0);
+
+	f.add_rule(addr("1.0.1.0"), addr("1.0.2.255"), 0);
+	TEST_CHECK(f.access(addr("1.0.1.5")) == 0);
+	TEST_CHECK(f.access(addr("1.0.0.5")) == ip_filter::blocked);
+	TEST_CHECK(f.access(addr("1.0.3.0")) == ip_filter::blocked);
+}
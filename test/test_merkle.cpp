@@ -371,6 +371,95 @@ TORRENT_TEST(merkle_fill_tree)
 	}
 }
 
+TORRENT_TEST(merkle_update_tree)
+{
+	// update a pair of leaves in an otherwise complete tree
+	{
+		v tree{
+		       ah,
+		   ad,     eh,
+		 ab, cd, ef, gh,
+		a,b,c,d,e,f,g,h};
+
+		tree[11] = a;
+		tree[12] = b;
+		merkle_update_tree(tree, 8, 7, 4, 6);
+
+		TEST_CHECK((tree ==
+		     v{
+		       H(ad, H(ab, gh)),
+		   ad,     H(ab, gh),
+		 ab, cd, ab, gh,
+		a,b,c,d,a,b,g,h}));
+	}
+
+	// a dirty leaf whose sibling falls outside the range reads the sibling
+	{
+		v tree{
+		       ah,
+		   ad,     eh,
+		 ab, cd, ef, gh,
+		a,b,c,d,e,f,g,h};
+
+		tree[8] = a;
+		merkle_update_tree(tree, 8, 7, 1, 2);
+
+		TEST_CHECK((tree ==
+		     v{
+		       H(H(H(a, a), cd), eh),
+		   H(H(a, a), cd),     eh,
+		 H(a, a), cd, ef, gh,
+		a,a,c,d,e,f,g,h}));
+	}
+}
+
+TORRENT_TEST(merkle_fill_pad)
+{
+	// padding the right half of the leaf layer, combined with
+	// merkle_update_tree() over the payload, is equivalent to filling in the
+	// pad leaves and calling merkle_fill_tree()
+	{
+		v tree{
+		       o,
+		   o,      o,
+		 o,  o,   o, o,
+		a,b,c,d,o,o,o,o};
+
+		merkle_fill_pad(tree, 8, 7, 4, e);
+		merkle_update_tree(tree, 8, 7, 0, 4);
+
+		v expect{
+		       o,
+		   o,      o,
+		 o,  o,   o, o,
+		a,b,c,d,e,e,e,e};
+		merkle_fill_tree(expect, 8, 7);
+
+		TEST_CHECK(tree == expect);
+	}
+
+	// padding that doesn't start at a sibling boundary
+	{
+		v tree{
+		       o,
+		   o,      o,
+		 o,  o,   o, o,
+		a,b,c,o,o,o,o,o};
+
+		merkle_fill_pad(tree, 8, 7, 3, e);
+		merkle_update_tree(tree, 8, 7, 0, 3);
+
+		v expect{
+		       o,
+		   o,      o,
+		 o,  o,   o, o,
+		a,b,c,e,e,e,e,e};
+		merkle_fill_tree(expect, 8, 7);
+
+		TEST_CHECK(tree == expect);
+	}
+}
+
 TORRENT_TEST(merkle_fill_partial_tree)
 {
 	// fill whole tree
@@ -184,3 +184,37 @@ TORRENT_TEST(reverse_wrap)
 
 	pb.insert(0xffff, make_pkt(pool, 3));
 }
+
+TORRENT_TEST(shrink)
+{
+	// after a deep-window burst, a mostly-empty buffer should
+	// eventually give back its large slot array
+	packet_pool pool;
+	packet_buffer pb;
+
+	// grow the buffer to 256 slots
+	for (int i = 0; i < 256; ++i)
+		pb.insert(packet_buffer::index_type(i), make_pkt(pool, i & 0xff));
+	TEST_EQUAL(pb.capacity(), 256);
+
+	// drain it down to a small window again
+	for (int i = 0; i < 250; ++i)
+		pb.remove(packet_buffer::index_type(i));
+	TEST_EQUAL(pb.size(), 6);
+
+	// keep the window shallow; removals (with re-inserts) should
+	// eventually trigger shrinking, one halving at a time
+	int idx = 256;
+	for (int i = 0; i < 3000; ++i)
+	{
+		pb.insert(packet_buffer::index_type(idx), make_pkt(pool, idx & 0xff));
+		++idx;
+		pb.remove(pb.cursor());
+	}
+	TEST_EQUAL(pb.size(), 6);
+	TEST_EQUAL(pb.capacity(), packet_buffer::default_capacity);
+
+	// the remaining packets are still there
+	for (int i = idx - 6; i < idx; ++i)
+		TEST_EQUAL(get_val(pb.at(packet_buffer::index_type(i))), i & 0xff);
+}
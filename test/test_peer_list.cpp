@@ -201,8 +201,6 @@ void connect_peer(peer_list& p, mock_torrent& t, torrent_state& st)
 	TEST_CHECK(tp->connection);
 }
 
-static torrent_peer_allocator allocator;
-
 } // anonymous namespace
 
 // test multiple peers with the same IP
@@ -211,6 +209,7 @@ TORRENT_TEST(multiple_ips_disallowed)
 {
 	torrent_state st = init_state();
 	mock_torrent t(&st);
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 	TEST_EQUAL(p.num_connect_candidates(), 0);
@@ -234,6 +233,7 @@ TORRENT_TEST(multiple_ips_allowed)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = true;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 	torrent_peer* peer1 = p.add_peer(ep("10.0.0.2", 3000), {}, {}, &st);
@@ -256,6 +256,7 @@ TORRENT_TEST(multiple_ips_allowed2)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = true;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 	torrent_peer* peer1 = p.add_peer(ep("10.0.0.2", 3000), {}, {}, &st);
@@ -295,6 +296,7 @@ TORRENT_TEST(multiple_ips_disallowed2)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 	torrent_peer* peer1 = p.add_peer(ep("10.0.0.2", 3000), {}, {}, &st);
@@ -329,6 +331,7 @@ TORRENT_TEST(update_peer_port)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 	TEST_EQUAL(p.num_connect_candidates(), 0);
@@ -352,6 +355,7 @@ TORRENT_TEST(update_peer_port_collide)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = true;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -390,6 +394,7 @@ TORRENT_TEST(ip_filter)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -428,6 +433,7 @@ TORRENT_TEST(port_filter)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -466,6 +472,7 @@ TORRENT_TEST(ban_peers)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -507,6 +514,7 @@ TORRENT_TEST(erase_peers)
 	mock_torrent t(&st);
 	st.max_peerlist_size = 100;
 	st.allow_multiple_connections_per_ip = true;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -540,6 +548,7 @@ TORRENT_TEST(set_ip_filter)
 	std::vector<address> banned;
 
 	mock_torrent t(&st);
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -570,6 +579,7 @@ TORRENT_TEST(set_port_filter)
 	std::vector<address> banned;
 
 	mock_torrent t(&st);
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -600,6 +610,7 @@ TORRENT_TEST(set_max_failcount)
 	torrent_state st = init_state();
 
 	mock_torrent t(&st);
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -630,6 +641,7 @@ TORRENT_TEST(set_seed)
 	torrent_state st = init_state();
 
 	mock_torrent t(&st);
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -665,6 +677,7 @@ TORRENT_TEST(has_peer)
 	std::vector<address> banned;
 
 	mock_torrent t(&st);
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -697,6 +710,7 @@ TORRENT_TEST(connect_candidates_finish)
 	std::vector<address> banned;
 
 	mock_torrent t(&st);
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -735,6 +749,7 @@ TORRENT_TEST(self_connection)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -765,6 +780,7 @@ TORRENT_TEST(double_connection)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -793,6 +809,7 @@ TORRENT_TEST(double_connection_loose)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -826,6 +843,7 @@ TORRENT_TEST(double_connection_random)
 		torrent_state st = init_state();
 		mock_torrent t(&st);
 		st.allow_multiple_connections_per_ip = false;
+		torrent_peer_allocator allocator;
 		peer_list p(allocator);
 		t.m_p = &p;
 
@@ -859,6 +877,7 @@ TORRENT_TEST(double_connection_win)
 	torrent_state st = init_state();
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -889,6 +908,7 @@ TORRENT_TEST(incoming_size_limit)
 	st.max_peerlist_size = 5;
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -934,6 +954,7 @@ TORRENT_TEST(new_peer_size_limit)
 	st.max_peerlist_size = 5;
 	mock_torrent t(&st);
 	st.allow_multiple_connections_per_ip = false;
+	torrent_peer_allocator allocator;
 	peer_list p(allocator);
 	t.m_p = &p;
 
@@ -306,6 +306,13 @@ TORRENT_TEST(round_trip_unfinished)
 	test_roundtrip(atp);
 }
 
+TORRENT_TEST(round_trip_file_sizes)
+{
+	add_torrent_params atp;
+	atp.file_sizes = {{16384, 1234567890}, {-1, 0}, {3, 1600000000}};
+	test_roundtrip(atp);
+}
+
 TORRENT_TEST(round_trip_trackers)
 {
 	add_torrent_params atp;
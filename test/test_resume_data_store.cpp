@@ -0,0 +1,263 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#include "test.hpp"
+
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include "libtorrent/aux_/path.hpp"
+#include "libtorrent/resume_data_store.hpp"
+
+using namespace lt;
+
+namespace {
+
+	info_hash_t test_hash(int const i)
+	{
+		sha1_hash h;
+		h[0] = std::uint8_t(i & 0xff);
+		h[1] = std::uint8_t((i >> 8) & 0xff);
+		return info_hash_t(h);
+	}
+
+	std::vector<char> test_blob(int const i, int const len = 100)
+	{
+		std::vector<char> ret(static_cast<std::size_t>(len));
+		for (int k = 0; k < len; ++k)
+			ret[std::size_t(k)] = char((i + k) & 0xff);
+		return ret;
+	}
+
+	std::string test_path()
+	{
+		std::string const p = "resume_store_journal";
+		error_code ec;
+		remove(p, ec);
+		return p;
+	}
+} // anonymous namespace
+
+TORRENT_TEST(store_roundtrip)
+{
+	std::string const p = test_path();
+	resume_data_store store;
+	error_code ec;
+	store.open(p, ec);
+	TEST_CHECK(!ec);
+
+	for (int i = 0; i < 10; ++i)
+	{
+		store.put(test_hash(i), test_blob(i), ec);
+		TEST_CHECK(!ec);
+	}
+	TEST_EQUAL(store.size(), 10);
+
+	for (int i = 0; i < 10; ++i)
+	{
+		std::vector<char> const blob = store.get(test_hash(i), ec);
+		TEST_CHECK(!ec);
+		TEST_CHECK(blob == test_blob(i));
+	}
+
+	// a missing info-hash reports an error and an empty buffer
+	std::vector<char> const blob = store.get(test_hash(1000), ec);
+	TEST_CHECK(ec);
+	TEST_CHECK(blob.empty());
+}
+
+TORRENT_TEST(store_replace_and_remove)
+{
+	std::string const p = test_path();
+	resume_data_store store;
+	error_code ec;
+	store.open(p, ec);
+	TEST_CHECK(!ec);
+
+	store.put(test_hash(1), test_blob(1), ec);
+	store.put(test_hash(2), test_blob(2), ec);
+
+	// the most recent record wins
+	store.put(test_hash(1), test_blob(42), ec);
+	TEST_CHECK(!ec);
+	TEST_EQUAL(store.size(), 2);
+	TEST_CHECK(store.get(test_hash(1), ec) == test_blob(42));
+
+	store.remove(test_hash(2), ec);
+	TEST_CHECK(!ec);
+	TEST_EQUAL(store.size(), 1);
+	store.get(test_hash(2), ec);
+	TEST_CHECK(ec);
+
+	// removing something that isn't there is a no-op
+	store.remove(test_hash(1000), ec);
+	TEST_CHECK(!ec);
+	TEST_EQUAL(store.size(), 1);
+}
+
+TORRENT_TEST(store_reload)
+{
+	std::string const p = test_path();
+	error_code ec;
+	{
+		resume_data_store store;
+		store.open(p, ec);
+		for (int i = 0; i < 10; ++i)
+			store.put(test_hash(i), test_blob(i), ec);
+		store.put(test_hash(3), test_blob(33), ec);
+		store.remove(test_hash(7), ec);
+		store.flush(ec);
+		TEST_CHECK(!ec);
+	}
+
+	// replacements and tombstones survive a reload
+	resume_data_store store;
+	store.open(p, ec);
+	TEST_CHECK(!ec);
+	TEST_EQUAL(store.size(), 9);
+	TEST_CHECK(store.get(test_hash(3), ec) == test_blob(33));
+	store.get(test_hash(7), ec);
+	TEST_CHECK(ec);
+
+	std::map<int, bool> seen;
+	store.for_each([&](info_hash_t const& ih, std::vector<char> blob)
+	{
+		int const i = int(ih.v1[0]) | (int(ih.v1[1]) << 8);
+		seen[i] = (blob == test_blob(i == 3 ? 33 : i));
+	}, ec);
+	TEST_CHECK(!ec);
+	TEST_EQUAL(int(seen.size()), 9);
+	for (auto const& e : seen) TEST_CHECK(e.second);
+}
+
+TORRENT_TEST(store_torn_tail)
+{
+	std::string const p = test_path();
+	error_code ec;
+	{
+		resume_data_store store;
+		store.open(p, ec);
+		for (int i = 0; i < 5; ++i)
+			store.put(test_hash(i), test_blob(i), ec);
+		TEST_CHECK(!ec);
+	}
+
+	// simulate a crash mid-append: a truncated record at the end of the
+	// journal
+	{
+		FILE* f = std::fopen(p.c_str(), "ab");
+		TEST_CHECK(f != nullptr);
+		char const garbage[] = { 1, 60, 0, 0, 0, 'x', 'y', 'z' };
+		std::fwrite(garbage, 1, sizeof(garbage), f);
+		std::fclose(f);
+	}
+
+	// the torn record is dropped, everything before it is intact
+	resume_data_store store;
+	store.open(p, ec);
+	TEST_CHECK(!ec);
+	TEST_EQUAL(store.size(), 5);
+	for (int i = 0; i < 5; ++i)
+		TEST_CHECK(store.get(test_hash(i), ec) == test_blob(i));
+
+	// and appending to the repaired journal works
+	store.put(test_hash(5), test_blob(5), ec);
+	TEST_CHECK(!ec);
+	TEST_EQUAL(store.size(), 6);
+}
+
+TORRENT_TEST(store_corrupt_record)
+{
+	std::string const p = test_path();
+	error_code ec;
+	resume_data_store store;
+	store.open(p, ec);
+
+	for (int i = 0; i < 3; ++i)
+		store.put(test_hash(i), test_blob(i), ec);
+	store.flush(ec);
+	TEST_CHECK(!ec);
+
+	// flip a byte in the payload of the second record, behind the store's
+	// back. The journal is an 8 byte tag followed by records of 61 bytes
+	// of framing plus the 100 byte payload, which starts 57 bytes in
+	{
+		FILE* f = std::fopen(p.c_str(), "rb+");
+		TEST_CHECK(f != nullptr);
+		std::fseek(f, 8 + 161 + 57 + 10, SEEK_SET);
+		int const c = std::fgetc(f);
+		std::fseek(f, -1, SEEK_CUR);
+		std::fputc(c ^ 0xff, f);
+		std::fclose(f);
+	}
+
+	// the damaged record is reported as a miss, not returned corrupted
+	store.get(test_hash(1), ec);
+	TEST_CHECK(ec);
+
+	// the records around it are unaffected
+	TEST_CHECK(store.get(test_hash(0), ec) == test_blob(0));
+	TEST_CHECK(!ec);
+	TEST_CHECK(store.get(test_hash(2), ec) == test_blob(2));
+	TEST_CHECK(!ec);
+}
+
+TORRENT_TEST(store_compact)
+{
+	std::string const p = test_path();
+	error_code ec;
+	resume_data_store store;
+	store.open(p, ec);
+
+	for (int i = 0; i < 20; ++i)
+		store.put(test_hash(i), test_blob(i), ec);
+	for (int i = 10; i < 20; ++i)
+		store.remove(test_hash(i), ec);
+	TEST_CHECK(!ec);
+
+	std::int64_t const before = file_size(p);
+	store.compact(ec);
+	TEST_CHECK(!ec);
+	std::int64_t const after = file_size(p);
+	TEST_CHECK(after < before);
+
+	TEST_EQUAL(store.size(), 10);
+	for (int i = 0; i < 10; ++i)
+		TEST_CHECK(store.get(test_hash(i), ec) == test_blob(i));
+
+	// the compacted journal loads back
+	resume_data_store reloaded;
+	reloaded.open(p, ec);
+	TEST_CHECK(!ec);
+	TEST_EQUAL(reloaded.size(), 10);
+}
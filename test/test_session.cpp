@@ -229,6 +229,24 @@ TORRENT_TEST(session_stats)
 		, lt::counters::incoming_connections);
 }
 
+TORRENT_TEST(session_stats_prometheus)
+{
+	std::vector<std::int64_t> values(lt::counters::num_counters, 0);
+	values[lt::counters::incoming_connections] = 42;
+
+	std::string const out = lt::prometheus_session_stats(values);
+
+	// counters and gauges are declared with their sanitized names
+	TEST_CHECK(out.find("# TYPE libtorrent_peer_incoming_connections counter\n")
+		!= std::string::npos);
+	TEST_CHECK(out.find("libtorrent_peer_incoming_connections 42\n")
+		!= std::string::npos);
+	TEST_CHECK(out.find("# TYPE libtorrent_peer_num_peers_connected gauge\n")
+		!= std::string::npos);
+	// metric names must not contain dots in the prometheus rendering
+	TEST_CHECK(out.find('.') == std::string::npos);
+}
+
 TORRENT_TEST(paused_session)
 {
 	lt::session s(settings());
@@ -0,0 +1,318 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+// benchmark for comparing disk I/O back-ends (mmap_disk_io and
+// posix_disk_io) on specific hardware. It drives a disk_interface
+// directly with a configurable mix of read, write and hash jobs at a
+// configurable queue depth, and reports throughput and latency
+// percentiles per job type
+
+#include "libtorrent/session.hpp" // for default_disk_io_constructor
+#include "libtorrent/disk_interface.hpp"
+#include "libtorrent/mmap_disk_io.hpp"
+#include "libtorrent/posix_disk_io.hpp"
+#include "libtorrent/settings_pack.hpp"
+#include "libtorrent/file_storage.hpp"
+#include "libtorrent/performance_counters.hpp"
+#include "libtorrent/add_torrent_params.hpp"
+#include "libtorrent/time.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes> // for PRId64
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::mt19937 random_engine(std::random_device{}());
+
+// latency samples for one job type, in microseconds
+struct job_stats
+{
+	std::vector<std::int64_t> latencies;
+	std::int64_t bytes = 0;
+
+	void add(lt::time_point const start, int const num_bytes)
+	{
+		latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+			lt::clock_type::now() - start).count());
+		bytes += num_bytes;
+	}
+};
+
+std::int64_t percentile(std::vector<std::int64_t>& v, double const p)
+{
+	if (v.empty()) return 0;
+	auto const idx = std::min(v.size() - 1
+		, std::size_t(double(v.size()) * p));
+	std::nth_element(v.begin(), v.begin() + std::ptrdiff_t(idx), v.end());
+	return v[idx];
+}
+
+void print_stats(char const* name, job_stats& st, double const elapsed)
+{
+	if (st.latencies.empty()) return;
+	std::printf("%8s: %8d jobs %9.1f MB/s  p50: %6" PRId64 " us  p90: %6" PRId64
+		" us  p99: %6" PRId64 " us  max: %6" PRId64 " us\n"
+		, name
+		, int(st.latencies.size())
+		, double(st.bytes) / 1000000.0 / elapsed
+		, percentile(st.latencies, 0.5)
+		, percentile(st.latencies, 0.9)
+		, percentile(st.latencies, 0.99)
+		, *std::max_element(st.latencies.begin(), st.latencies.end()));
+}
+
+[[noreturn]] void usage()
+{
+	std::fputs("usage: bench_disk [options]\n"
+		"OPTIONS:\n"
+		"--disk=<mmap|posix|default> disk I/O back-end to benchmark (default)\n"
+		"--size=<n>                  total size of the test data, in MiB (256)\n"
+		"--piece-size=<n>            piece size, in KiB (256)\n"
+		"--threads=<n>               number of aio threads (8)\n"
+		"--queue=<n>                 number of outstanding jobs (64)\n"
+		"--reads=<n>                 weight of read jobs in the mix (2)\n"
+		"--writes=<n>                weight of write jobs in the mix (1)\n"
+		"--hashes=<n>                weight of hash jobs in the mix (1)\n"
+		"--jobs=<n>                  number of jobs in the mixed phase (20000)\n"
+		"--save-path=<path>          directory to create the test files in (.)\n"
+		, stderr);
+	std::exit(1);
+}
+
+} // anonymous namespace
+
+int main(int argc, char const* argv[]) try
+{
+	std::string backend = "default";
+	std::int64_t total_size = 256 * 1024 * 1024;
+	int piece_size = 256 * 1024;
+	int num_threads = 8;
+	int queue_depth = 64;
+	int read_weight = 2;
+	int write_weight = 1;
+	int hash_weight = 1;
+	int num_jobs = 20000;
+	std::string save_path = ".";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string const arg(argv[i]);
+		auto const eq = arg.find('=');
+		if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) usage();
+		std::string const name = arg.substr(2, eq - 2);
+		std::string const value = arg.substr(eq + 1);
+
+		if (name == "disk") backend = value;
+		else if (name == "size") total_size = std::stoll(value) * 1024 * 1024;
+		else if (name == "piece-size") piece_size = std::stoi(value) * 1024;
+		else if (name == "threads") num_threads = std::stoi(value);
+		else if (name == "queue") queue_depth = std::stoi(value);
+		else if (name == "reads") read_weight = std::stoi(value);
+		else if (name == "writes") write_weight = std::stoi(value);
+		else if (name == "hashes") hash_weight = std::stoi(value);
+		else if (name == "jobs") num_jobs = std::stoi(value);
+		else if (name == "save-path") save_path = value;
+		else usage();
+	}
+
+	lt::io_context ioc;
+	lt::counters cnt;
+	lt::settings_pack pack;
+	pack.set_int(lt::settings_pack::aio_threads, num_threads);
+
+	std::unique_ptr<lt::disk_interface> disk_io;
+	if (backend == "mmap")
+	{
+#if TORRENT_HAVE_MMAP || TORRENT_HAVE_MAP_VIEW_OF_FILE
+		disk_io = lt::mmap_disk_io_constructor(ioc, pack, cnt);
+#else
+		std::fputs("mmap_disk_io is not supported on this platform\n", stderr);
+		return 1;
+#endif
+	}
+	else if (backend == "posix")
+		disk_io = lt::posix_disk_io_constructor(ioc, pack, cnt);
+	else if (backend == "default")
+		disk_io = lt::default_disk_io_constructor(ioc, pack, cnt);
+	else usage();
+
+	int const blocks_per_piece = piece_size / lt::default_block_size;
+	int const num_pieces = int((total_size + piece_size - 1) / piece_size);
+
+	lt::file_storage fs;
+	fs.add_file("bench_disk_scratch/data", std::int64_t(num_pieces) * piece_size);
+	fs.set_num_pieces(num_pieces);
+	fs.set_piece_length(piece_size);
+
+	lt::aux::vector<lt::download_priority_t, lt::file_index_t> prios;
+	lt::storage_params params(fs, nullptr
+		, save_path
+		, lt::storage_mode_sparse
+		, prios
+		, lt::sha1_hash("01234567890123456789"));
+
+	lt::storage_holder t = disk_io->new_torrent(params, {});
+
+	int outstanding = 0;
+	lt::add_torrent_params atp;
+	disk_io->async_check_files(t, &atp, lt::aux::vector<std::string, lt::file_index_t>{}
+		, [&](lt::status_t, lt::storage_error const&) { --outstanding; });
+	++outstanding;
+	disk_io->submit_jobs();
+	while (outstanding > 0)
+	{
+		ioc.run_one();
+		ioc.restart();
+	}
+
+	std::vector<char> write_buffer(lt::default_block_size);
+	for (std::size_t i = 0; i < write_buffer.size(); ++i)
+		write_buffer[i] = char(i * 13);
+
+	job_stats write_st, read_st, hash_st;
+	std::uniform_int_distribution<int> rand_piece(0, num_pieces - 1);
+	std::uniform_int_distribution<int> rand_block(0, blocks_per_piece - 1);
+	std::uniform_int_distribution<int> rand_weight(0
+		, read_weight + write_weight + hash_weight - 1);
+
+	auto const drain = [&](int const limit)
+	{
+		disk_io->submit_jobs();
+		while (outstanding > limit)
+		{
+			ioc.run_one();
+			ioc.restart();
+		}
+		ioc.poll();
+		ioc.restart();
+	};
+
+	// fill phase. Write every block once, so that the read and hash jobs in
+	// the mixed phase below have data to work on. This also reports the
+	// sequential write characteristics of the back-end
+	auto const fill_start = lt::clock_type::now();
+	for (int p = 0; p < num_pieces; ++p)
+	{
+		for (int b = 0; b < blocks_per_piece; ++b)
+		{
+			lt::peer_request const req{lt::piece_index_t{p}
+				, b * lt::default_block_size, lt::default_block_size};
+			auto const start = lt::clock_type::now();
+			disk_io->async_write(t, req, write_buffer.data(), {}
+				, [&, start](lt::storage_error const& ec)
+				{
+					--outstanding;
+					if (ec) throw std::runtime_error("async_write failed: " + ec.ec.message());
+					write_st.add(start, lt::default_block_size);
+				});
+			++outstanding;
+			if (outstanding >= queue_depth) drain(queue_depth - 1);
+		}
+	}
+	drain(0);
+	double const fill_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		lt::clock_type::now() - fill_start).count() / 1000.0;
+
+	std::printf("fill phase (%.2f s):\n", fill_elapsed);
+	print_stats("write", write_st, fill_elapsed);
+	write_st = job_stats();
+
+	// mixed phase. Random single-block reads and writes and whole-piece hash
+	// jobs, drawn according to the configured weights
+	auto const mix_start = lt::clock_type::now();
+	for (int j = 0; j < num_jobs; ++j)
+	{
+		int const which = rand_weight(random_engine);
+		lt::piece_index_t const piece(rand_piece(random_engine));
+		int const offset = rand_block(random_engine) * lt::default_block_size;
+		auto const start = lt::clock_type::now();
+
+		if (which < read_weight)
+		{
+			disk_io->async_read(t, {piece, offset, lt::default_block_size}
+				, [&, start](lt::disk_buffer_holder, lt::storage_error const& ec)
+				{
+					--outstanding;
+					if (ec) throw std::runtime_error("async_read failed: " + ec.ec.message());
+					read_st.add(start, lt::default_block_size);
+				});
+		}
+		else if (which < read_weight + write_weight)
+		{
+			disk_io->async_write(t, {piece, offset, lt::default_block_size}
+				, write_buffer.data(), {}
+				, [&, start](lt::storage_error const& ec)
+				{
+					--outstanding;
+					if (ec) throw std::runtime_error("async_write failed: " + ec.ec.message());
+					write_st.add(start, lt::default_block_size);
+				});
+		}
+		else
+		{
+			disk_io->async_hash(t, piece, {}, lt::disk_interface::v1_hash
+				, [&, start](lt::piece_index_t, lt::sha1_hash const&
+					, lt::storage_error const& ec)
+				{
+					--outstanding;
+					if (ec) throw std::runtime_error("async_hash failed: " + ec.ec.message());
+					hash_st.add(start, piece_size);
+				});
+		}
+		++outstanding;
+		if (outstanding >= queue_depth) drain(queue_depth - 1);
+	}
+	drain(0);
+	double const mix_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		lt::clock_type::now() - mix_start).count() / 1000.0;
+
+	std::printf("mixed phase (%.2f s, queue depth %d, %d threads):\n"
+		, mix_elapsed, queue_depth, num_threads);
+	print_stats("read", read_st, mix_elapsed);
+	print_stats("write", write_st, mix_elapsed);
+	print_stats("hash", hash_st, mix_elapsed);
+
+	disk_io->remove_torrent(t);
+	disk_io->abort(true);
+	return 0;
+}
+catch (std::exception const& e)
+{
+	std::cerr << "FAILED WITH EXCEPTION: " << e.what() << '\n';
+	return 1;
+}
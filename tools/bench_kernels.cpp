@@ -0,0 +1,210 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+// micro-benchmarks for hot algorithmic kernels, to catch regressions that
+// whole-client transfer benchmarks are too noisy to see. All inputs are
+// generated deterministically, so numbers are comparable across runs and
+// revisions on the same machine. The output is one tab-separated line per
+// benchmark (name, iterations, nanoseconds per iteration), suitable for CI
+// trend tracking
+
+#include "libtorrent/bdecode.hpp"
+#include "libtorrent/bencode.hpp"
+#include "libtorrent/bitfield.hpp"
+#include "libtorrent/entry.hpp"
+#include "libtorrent/peer_list.hpp"
+#include "libtorrent/performance_counters.hpp"
+#include "libtorrent/piece_picker.hpp"
+#include "libtorrent/torrent_peer_allocator.hpp"
+#include "libtorrent/aux_/merkle.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using lt::piece_index_t;
+
+namespace {
+
+template <typename F>
+void bench(char const* name, int const iterations, F f)
+{
+	// warm up caches and let lazy initialization happen outside the
+	// measurement
+	for (int i = 0; i < 10; ++i) f();
+
+	auto const start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) f();
+	auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start).count();
+
+	std::printf("%s\t%d\t%.1f\n", name, iterations
+		, double(elapsed) / iterations);
+}
+
+void bench_pick_pieces()
+{
+	int const num_pieces = 2000;
+	lt::piece_picker picker(4, 4, num_pieces);
+
+	// a deterministic, skewed availability distribution, so rarest-first
+	// has real work to do
+	for (piece_index_t p{0}; p != piece_index_t{num_pieces}; ++p)
+	{
+		int const avail = (static_cast<int>(p) * 7919) % 13 + 1;
+		for (int k = 0; k < avail; ++k)
+			picker.inc_refcount(p, nullptr);
+	}
+
+	lt::typed_bitfield<piece_index_t> peer_has(num_pieces, true);
+	std::vector<lt::piece_block> picked;
+	std::vector<piece_index_t> const suggested;
+	lt::counters cnt;
+
+	bench("piece_picker::pick_pieces", 20000, [&]
+	{
+		picked.clear();
+		picker.pick_pieces(peer_has, picked, 16, 0, nullptr
+			, lt::piece_picker::rarest_first, suggested, 10, cnt);
+	});
+}
+
+lt::entry make_corpus_entry()
+{
+	lt::entry e(lt::entry::dictionary_t);
+	lt::entry::list_type peers;
+	for (int i = 0; i < 200; ++i)
+		peers.push_back(lt::entry(std::string(6, char(i))));
+	e["peers"] = lt::entry(peers);
+	for (int i = 0; i < 500; ++i)
+	{
+		std::string const key = "key-" + std::to_string(i);
+		if (i % 3 == 0) e[key] = lt::entry(std::int64_t(i) * 0x1000);
+		else e[key] = lt::entry(std::string(std::size_t(i % 40 + 1), 'x'));
+	}
+	return e;
+}
+
+void bench_bencoding()
+{
+	lt::entry const e = make_corpus_entry();
+
+	std::vector<char> buf;
+	bench("bencode", 10000, [&]
+	{
+		buf.clear();
+		lt::bencode(std::back_inserter(buf), e);
+	});
+
+	lt::error_code ec;
+	bench("bdecode", 10000, [&]
+	{
+		lt::bdecode_node n = lt::bdecode({buf.data(), std::ptrdiff_t(buf.size())}, ec);
+		if (ec) std::abort();
+	});
+}
+
+void bench_merkle_root()
+{
+	std::vector<lt::sha256_hash> leaves(2048);
+	for (std::size_t i = 0; i < leaves.size(); ++i)
+		for (std::size_t b = 0; b < 32; ++b)
+			leaves[i][b] = char((i * 31 + b * 7) & 0xff);
+
+	bench("merkle_root", 2000, [&]
+	{
+		volatile char sink = lt::merkle_root(leaves)[0];
+		(void)sink;
+	});
+}
+
+void bench_bitfield_count()
+{
+	lt::bitfield bits(1000000);
+	for (int i = 0; i < bits.size(); i += 3) bits.set_bit(i);
+
+	bench("bitfield::count", 50000, [&]
+	{
+		volatile int sink = bits.count();
+		(void)sink;
+	});
+}
+
+void bench_connect_candidates()
+{
+	lt::torrent_peer_allocator allocator;
+	lt::peer_list peers(allocator);
+
+	lt::torrent_state st;
+	st.is_finished = false;
+	st.is_paused = false;
+	st.max_peerlist_size = 10000;
+	st.allow_multiple_connections_per_ip = false;
+	st.port = 6881;
+
+	for (int i = 0; i < 5000; ++i)
+	{
+		lt::tcp::endpoint const ep(
+			lt::make_address_v4(std::uint32_t(0x0a000000 + i * 7))
+			, std::uint16_t(1024 + i % 50000));
+		peers.add_peer(ep, {}, {}, &st);
+		st.erased.clear();
+	}
+
+	int next = 5000;
+	// each added peer invalidates the candidate cache, so every iteration
+	// re-runs the find_connect_candidates pass over the full list. The
+	// returned candidates are deliberately left unconnected
+	bench("peer_list::find_connect_candidates", 500, [&]
+	{
+		lt::tcp::endpoint const ep(
+			lt::make_address_v4(std::uint32_t(0x0a000000 + next * 7))
+			, std::uint16_t(1024 + next % 50000));
+		++next;
+		peers.add_peer(ep, {}, {}, &st);
+		peers.connect_one_peer(0, &st);
+		st.erased.clear();
+	});
+}
+
+} // anonymous namespace
+
+int main()
+{
+	bench_pick_pieces();
+	bench_bencoding();
+	bench_merkle_root();
+	bench_bitfield_count();
+	bench_connect_candidates();
+	return 0;
+}
@@ -0,0 +1,178 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+// replays a corpus of input files through one of the parsers in a timed
+// loop and reports throughput. The corpora maintained for the fuzzers
+// (fuzzers/corpus/*) make good inputs, as do real-world .torrent files.
+// The fuzzers only prove the parsers don't crash; this makes their
+// throughput visible per commit, in the same TSV style as bench_kernels.
+// Invalid inputs are parsed and counted too; rejecting garbage quickly is
+// part of parser performance
+
+#include "libtorrent/bdecode.hpp"
+#include "libtorrent/http_parser.hpp"
+#include "libtorrent/torrent_info.hpp"
+#include "libtorrent/error_code.hpp"
+#include "libtorrent/span.hpp"
+#include "libtorrent/aux_/directory.hpp"
+#include "libtorrent/aux_/path.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<char> load_file(std::string const& path)
+{
+	std::fstream f(path, std::ios_base::in | std::ios_base::binary);
+	f.seekg(0, std::ios_base::end);
+	auto const size = f.tellg();
+	if (size <= 0) return {};
+	f.seekg(0, std::ios_base::beg);
+	std::vector<char> ret(static_cast<std::size_t>(size));
+	f.read(ret.data(), size);
+	if (f.fail()) return {};
+	return ret;
+}
+
+// each argument may be a file or a directory of corpus files (not
+// recursed into)
+std::vector<std::vector<char>> load_corpus(char const** paths, int const num_paths)
+{
+	std::vector<std::vector<char>> ret;
+	for (int i = 0; i < num_paths; ++i)
+	{
+		lt::error_code ec;
+		lt::aux::directory dir(paths[i], ec);
+		if (ec)
+		{
+			std::vector<char> buf = load_file(paths[i]);
+			if (!buf.empty()) ret.push_back(std::move(buf));
+			continue;
+		}
+		for (; !dir.done(); dir.next(ec))
+		{
+			std::string const name = dir.file();
+			if (name == "." || name == "..") continue;
+			std::vector<char> buf = load_file(lt::combine_path(paths[i], name));
+			if (!buf.empty()) ret.push_back(std::move(buf));
+		}
+	}
+	return ret;
+}
+
+template <typename F>
+void run_bench(char const* name
+	, std::vector<std::vector<char>> const& corpus, F parse)
+{
+	std::int64_t corpus_bytes = 0;
+	for (auto const& buf : corpus) corpus_bytes += std::int64_t(buf.size());
+
+	// repeat small corpora until there's enough work to time reliably
+	std::int64_t const target_bytes = 256 * 1024 * 1024;
+	int const passes = int(std::min<std::int64_t>(1000
+		, std::max<std::int64_t>(1, target_bytes / std::max<std::int64_t>(1, corpus_bytes))));
+
+	// warm-up pass, to page in the corpus outside the measurement
+	for (auto const& buf : corpus)
+		parse({buf.data(), std::ptrdiff_t(buf.size())});
+
+	auto const start = std::chrono::steady_clock::now();
+	for (int i = 0; i < passes; ++i)
+		for (auto const& buf : corpus)
+			parse({buf.data(), std::ptrdiff_t(buf.size())});
+	double const seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count() / 1000000.0;
+
+	double const mb = double(corpus_bytes) * passes / 1024.0 / 1024.0;
+	std::printf("%s\t%d files\t%d passes\t%.1f MB/s\n"
+		, name, int(corpus.size()), passes, mb / seconds);
+}
+
+int usage()
+{
+	std::fputs("usage: bench_parsers bdecode|torrent_info|http_parser "
+		"<file-or-directory> ...\n", stderr);
+	return 1;
+}
+
+} // anonymous namespace
+
+int main(int argc, char const** argv)
+{
+	if (argc < 3) return usage();
+
+	char const* mode = argv[1];
+	std::vector<std::vector<char>> const corpus = load_corpus(argv + 2, argc - 2);
+	if (corpus.empty())
+	{
+		std::fputs("no corpus files loaded\n", stderr);
+		return 1;
+	}
+
+	if (std::strcmp(mode, "bdecode") == 0)
+	{
+		run_bench("bdecode", corpus, [](lt::span<char const> buf)
+		{
+			lt::error_code ec;
+			lt::bdecode(buf, ec);
+		});
+	}
+	else if (std::strcmp(mode, "torrent_info") == 0)
+	{
+		run_bench("torrent_info", corpus, [](lt::span<char const> buf)
+		{
+			lt::error_code ec;
+			lt::torrent_info ti(buf, ec, lt::from_span);
+		});
+	}
+	else if (std::strcmp(mode, "http_parser") == 0)
+	{
+		lt::http_parser p;
+		run_bench("http_parser", corpus, [&p](lt::span<char const> buf)
+		{
+			p.reset();
+			bool error = false;
+			p.incoming(buf, error);
+		});
+	}
+	else
+	{
+		return usage();
+	}
+	return 0;
+}
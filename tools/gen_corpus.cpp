@@ -0,0 +1,228 @@
+/*
+
+Copyright (c) 2020, Arvid Norberg
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in
+      the documentation and/or other materials provided with the distribution.
+    * Neither the name of the author nor the names of its
+      contributors may be used to endorse or promote products derived
+      from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+// synthesizes parameterized datasets and builds .torrent files from them,
+// with timing output for each phase. The data files are written sparse
+// (only the last byte of each file is touched), so a multi-terabyte
+// dataset costs almost no disk space but still drives the full
+// enumeration, hashing and bencoding pipeline of create_torrent. This
+// doubles as the create_torrent performance benchmark and as a generator
+// of realistic giant v2/hybrid torrents for other benchmarks to chew on.
+// All file sizes are derived deterministically from the parameters, so
+// two runs with the same arguments produce identical torrents
+
+#include "libtorrent/create_torrent.hpp"
+#include "libtorrent/file_storage.hpp"
+#include "libtorrent/bencode.hpp"
+#include "libtorrent/error_code.hpp"
+#include "libtorrent/aux_/path.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using clock_t_ = std::chrono::steady_clock;
+
+double seconds_since(clock_t_::time_point const start)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		clock_t_::now() - start).count() / 1000000.0;
+}
+
+// the file sizes of the synthesized dataset. "uniform" splits the total
+// evenly, "skewed" follows a power law where a few files hold most of the
+// bytes (the shape of most real-world bulk datasets)
+std::vector<std::int64_t> file_sizes(int const num_files
+	, std::int64_t const total_size, bool const skewed)
+{
+	std::vector<std::int64_t> sizes(static_cast<std::size_t>(num_files));
+	if (!skewed)
+	{
+		for (auto& s : sizes) s = total_size / num_files;
+	}
+	else
+	{
+		double sum = 0.0;
+		for (int i = 0; i < num_files; ++i)
+			sum += 1.0 / double(i + 1);
+		for (int i = 0; i < num_files; ++i)
+			sizes[std::size_t(i)] = std::int64_t(
+				double(total_size) / double(i + 1) / sum);
+	}
+	// no zero-sized files; they don't exercise the hasher
+	for (auto& s : sizes) if (s == 0) s = 1;
+	return sizes;
+}
+
+bool write_sparse_file(std::string const& path, std::int64_t const size)
+{
+	std::ofstream f(path, std::ios_base::binary | std::ios_base::trunc);
+	if (!f) return false;
+	f.seekp(size - 1);
+	f.write("", 1);
+	return bool(f);
+}
+
+int usage()
+{
+	std::fputs(
+		"usage: gen_corpus [OPTIONS] <output-directory>\n\n"
+		"generates a sparse dataset under <output-directory>/<name> and a\n"
+		"<name>.torrent next to it, printing per-phase timings\n\n"
+		"OPTIONS:\n"
+		"  --name <s>        dataset name (default: corpus)\n"
+		"  --files <n>       number of files (default: 100)\n"
+		"  --size <n>        total dataset size in MiB (default: 1024)\n"
+		"  --skewed          power-law file size distribution instead of uniform\n"
+		"  --piece-size <n>  piece size in KiB, 0 = automatic (default: 0)\n"
+		"  --v1              generate v1-only metadata\n"
+		"  --v2              generate v2-only metadata\n"
+		"                    (the default is a hybrid torrent)\n"
+		, stderr);
+	return 1;
+}
+
+} // anonymous namespace
+
+int main(int argc, char const* argv[])
+{
+	std::string name = "corpus";
+	int num_files = 100;
+	std::int64_t total_size = 1024 * std::int64_t(1024 * 1024);
+	bool skewed = false;
+	int piece_size = 0;
+	lt::create_flags_t flags = {};
+	std::string out_dir;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--name") == 0 && i + 1 < argc)
+			name = argv[++i];
+		else if (std::strcmp(argv[i], "--files") == 0 && i + 1 < argc)
+			num_files = std::atoi(argv[++i]);
+		else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+			total_size = std::int64_t(std::atoll(argv[++i])) * 1024 * 1024;
+		else if (std::strcmp(argv[i], "--skewed") == 0)
+			skewed = true;
+		else if (std::strcmp(argv[i], "--piece-size") == 0 && i + 1 < argc)
+			piece_size = std::atoi(argv[++i]) * 1024;
+		else if (std::strcmp(argv[i], "--v1") == 0)
+			flags |= lt::create_torrent::v1_only;
+		else if (std::strcmp(argv[i], "--v2") == 0)
+			flags |= lt::create_torrent::v2_only;
+		else if (argv[i][0] == '-')
+			return usage();
+		else
+			out_dir = argv[i];
+	}
+
+	if (out_dir.empty() || num_files <= 0 || total_size <= 0) return usage();
+
+	std::string const root = lt::combine_path(out_dir, name);
+
+	// phase 1: synthesize the sparse dataset
+	auto start = clock_t_::now();
+	std::vector<std::int64_t> const sizes = file_sizes(num_files, total_size, skewed);
+	{
+		lt::error_code ec;
+		lt::create_directories(root, ec);
+		if (ec)
+		{
+			std::fprintf(stderr, "failed to create \"%s\": %s\n"
+				, root.c_str(), ec.message().c_str());
+			return 1;
+		}
+		for (int i = 0; i < num_files; ++i)
+		{
+			char filename[50];
+			std::snprintf(filename, sizeof(filename), "file-%05d.bin", i);
+			std::string const path = lt::combine_path(root, filename);
+			if (!write_sparse_file(path, sizes[std::size_t(i)]))
+			{
+				std::fprintf(stderr, "failed to write \"%s\"\n", path.c_str());
+				return 1;
+			}
+		}
+	}
+	std::printf("synthesize dataset\t%.2fs\n", seconds_since(start));
+
+	// phase 2: enumerate the files
+	start = clock_t_::now();
+	lt::file_storage fs;
+	lt::add_files(fs, root, flags);
+	std::printf("add_files\t\t%.2fs (%d files)\n"
+		, seconds_since(start), fs.num_files());
+
+	// phase 3: hash the pieces. With a sparse dataset this measures the
+	// hashing pipeline (v1 SHA-1, v2 merkle trees, or both for hybrid)
+	// without being bottlenecked on disk reads
+	start = clock_t_::now();
+	lt::create_torrent t(fs, piece_size, flags);
+	lt::error_code ec;
+	lt::set_piece_hashes(t, out_dir, ec);
+	if (ec)
+	{
+		std::fprintf(stderr, "set_piece_hashes failed: %s\n"
+			, ec.message().c_str());
+		return 1;
+	}
+	double const hash_time = seconds_since(start);
+	std::printf("set_piece_hashes\t%.2fs (%.1f MB/s, piece size: %d)\n"
+		, hash_time
+		, double(fs.total_size()) / 1024.0 / 1024.0 / hash_time
+		, t.piece_length());
+
+	// phase 4: bencode the metadata
+	start = clock_t_::now();
+	std::vector<char> torrent;
+	lt::bencode(std::back_inserter(torrent), t.generate());
+	std::printf("generate + bencode\t%.2fs (%d bytes)\n"
+		, seconds_since(start), int(torrent.size()));
+
+	std::string const torrent_path = lt::combine_path(out_dir, name + ".torrent");
+	std::ofstream out(torrent_path, std::ios_base::binary | std::ios_base::trunc);
+	out.write(torrent.data(), std::streamsize(torrent.size()));
+	if (!out)
+	{
+		std::fprintf(stderr, "failed to write \"%s\"\n", torrent_path.c_str());
+		return 1;
+	}
+	std::printf("wrote %s\n", torrent_path.c_str());
+	return 0;
+}